@@ -0,0 +1,64 @@
+#include <APHTML/CommandExecutor/APCCancellationToken.h>
+
+void aperture::core::APCCancellationToken::Cancel()
+{
+  // Only the first call propagates, this also ends the recursion for cyclic dependents.
+  if (m_bCanceled.exchange(true, std::memory_order_acq_rel))
+    return;
+
+  NS_LOCK(m_DependentsMutex);
+  for (APCCancellationToken* pDependent : m_Dependents)
+  {
+    pDependent->Cancel();
+  }
+}
+
+void aperture::core::APCCancellationToken::AddDependent(APCCancellationToken& p_dependent)
+{
+  {
+    NS_LOCK(m_DependentsMutex);
+    if (!m_Dependents.Contains(&p_dependent))
+    {
+      m_Dependents.PushBack(&p_dependent);
+    }
+  }
+
+  if (IsCanceled())
+  {
+    p_dependent.Cancel();
+  }
+}
+
+void aperture::core::APCCancellationToken::RemoveDependent(APCCancellationToken& p_dependent)
+{
+  NS_LOCK(m_DependentsMutex);
+  m_Dependents.RemoveAndSwap(&p_dependent);
+}
+
+void aperture::core::APCCancellationToken::RecordSkippedQueue(nsUInt32 p_uiCommands)
+{
+  m_uiSkippedQueues.fetch_add(1, std::memory_order_relaxed);
+  m_uiSkippedCommands.fetch_add(p_uiCommands, std::memory_order_relaxed);
+}
+
+void aperture::core::APCCancellationToken::RecordInterruptedQueue(nsUInt32 p_uiSkippedCommands)
+{
+  m_uiInterruptedQueues.fetch_add(1, std::memory_order_relaxed);
+  m_uiSkippedCommands.fetch_add(p_uiSkippedCommands, std::memory_order_relaxed);
+}
+
+aperture::core::APCCancellationStats aperture::core::APCCancellationToken::GetStats() const
+{
+  APCCancellationStats stats;
+  stats.m_uiSkippedQueues = m_uiSkippedQueues.load(std::memory_order_relaxed);
+  stats.m_uiInterruptedQueues = m_uiInterruptedQueues.load(std::memory_order_relaxed);
+  stats.m_uiSkippedCommands = m_uiSkippedCommands.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void aperture::core::APCCancellationToken::ResetStats()
+{
+  m_uiSkippedQueues.store(0, std::memory_order_relaxed);
+  m_uiInterruptedQueues.store(0, std::memory_order_relaxed);
+  m_uiSkippedCommands.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,106 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+#include <APHTML/APEngineDLL.h>
+#include <APHTML/APEngineCommonIncludes.h>
+#include <Foundation/Threading/Mutex.h>
+
+#include <atomic>
+
+namespace aperture::core
+{
+  /// @brief How much work an APCCancellationToken saved.
+  struct APCCancellationStats
+  {
+    /// Queues that were dropped before they started.
+    nsUInt32 m_uiSkippedQueues = 0;
+    /// Queues that noticed the cancellation while running and stopped early.
+    nsUInt32 m_uiInterruptedQueues = 0;
+    /// Commands that never ran, from skipped and interrupted queues.
+    nsUInt32 m_uiSkippedCommands = 0;
+  };
+
+  /**
+   * @class APCCancellationToken
+   * @brief Cooperative cancellation flag shared by queues, CommandGroups and long running commands.
+   *
+   * Queues bound to a canceled token are skipped when a thread pops them, without searching any deque. Queues that are already
+   * running stop before their next command, and long running commands can poll IAPCCommand::IsCancellationRequested() to stop
+   * in the middle of their work.
+   *
+   * Cancel() also cancels every dependent token, e.g. the script compilation of a view depends on its parsing. Cycles are fine.
+   *
+   * @note The token is owned by the caller and has to outlive every queue and token that refers to it.
+   */
+  class NS_APERTURE_DLL APCCancellationToken
+  {
+  public:
+    APCCancellationToken() = default;
+
+    APCCancellationToken(const APCCancellationToken&) = delete;
+    APCCancellationToken& operator=(const APCCancellationToken&) = delete;
+
+    /// @brief Requests cancellation of everything bound to this token and its dependents. Thread-safe, cancelling twice does nothing.
+    void Cancel();
+
+    bool IsCanceled() const { return m_bCanceled.load(std::memory_order_acquire); }
+
+    /// @brief Makes the token usable again, e.g. when the view gets loaded again. Dependents and stats are kept.
+    void Reset() { m_bCanceled.store(false, std::memory_order_release); }
+
+    /// @brief p_dependent gets canceled together with this token. Cancels it right away if this token already is.
+    void AddDependent(APCCancellationToken& p_dependent);
+    void RemoveDependent(APCCancellationToken& p_dependent);
+
+    /// @brief Called by whoever drops a queue of this token before it ran.
+    void RecordSkippedQueue(nsUInt32 p_uiCommands);
+    /// @brief Called by a queue that stopped early because of this token.
+    void RecordInterruptedQueue(nsUInt32 p_uiSkippedCommands);
+
+    APCCancellationStats GetStats() const;
+    void ResetStats();
+
+  private:
+    std::atomic<bool> m_bCanceled = false;
+
+    nsMutex m_DependentsMutex;
+    nsHybridArray<APCCancellationToken*, 2> m_Dependents;
+
+    std::atomic<nsUInt32> m_uiSkippedQueues = 0;
+    std::atomic<nsUInt32> m_uiInterruptedQueues = 0;
+    std::atomic<nsUInt32> m_uiSkippedCommands = 0;
+  };
+} // namespace aperture::core
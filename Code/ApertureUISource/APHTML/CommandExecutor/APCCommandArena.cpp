@@ -0,0 +1,47 @@
+#include <APHTML/CommandExecutor/APCCommandArena.h>
+
+aperture::core::APCCommandArena::~APCCommandArena()
+{
+  NS_ASSERT_DEV(!HasPendingJobs(), "APCCommandArena destroyed while {0} of its queues are still in flight.", m_uiPendingQueues.load());
+}
+
+aperture::core::IAPCCommand* aperture::core::APCCommandArena::AllocateCommand(CommandType type, Runtype runtype)
+{
+  IAPCCommand* pCommand = m_Commands.Acquire();
+  pCommand->Reset(type, runtype);
+  return pCommand;
+}
+
+aperture::core::IAPCCommandList* aperture::core::APCCommandArena::AllocateCommandList(IAPCCommandQueue& queue, CommandType type, Runtype runtype)
+{
+  IAPCCommandList* pList = m_Lists.Acquire();
+  pList->Reset(&queue, type, runtype);
+  return pList;
+}
+
+aperture::core::IAPCCommandQueue* aperture::core::APCCommandArena::AllocateCommandQueue(CommandType type, Runtype runtype)
+{
+  IAPCCommandQueue* pQueue = m_Queues.Acquire();
+  pQueue->Reset(type, runtype);
+  pQueue->SetCompletionCallback(&APCCommandArena::OnQueueCompleted, this);
+  m_uiPendingQueues.fetch_add(1, std::memory_order_relaxed);
+  return pQueue;
+}
+
+void aperture::core::APCCommandArena::Reset()
+{
+  NS_ASSERT_DEV(!HasPendingJobs(), "APCCommandArena reset while {0} of its queues are still in flight.", m_uiPendingQueues.load());
+
+  // Functions may own what they work on, e.g. a V8 task, which is released here even if its queue got canceled.
+  m_Commands.ForEachUsed([](IAPCCommand& ref_command)
+    { ref_command.Reset(ref_command.GetCommandType(), ref_command.GetRunType()); });
+
+  m_Commands.Reset();
+  m_Lists.Reset();
+  m_Queues.Reset();
+}
+
+void aperture::core::APCCommandArena::OnQueueCompleted(IAPCCommandQueue& queue, nsTime executionTime, void* pUserData)
+{
+  static_cast<APCCommandArena*>(pUserData)->m_uiPendingQueues.fetch_sub(1, std::memory_order_release);
+}
@@ -0,0 +1,157 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+#include <APHTML/APEngineDLL.h>
+#include <APHTML/APEngineCommonIncludes.h>
+#include <APHTML/CommandExecutor/IAPCCommand.h>
+#include <APHTML/CommandExecutor/IAPCCommandList.h>
+#include <APHTML/CommandExecutor/IAPCCommandQueue.h>
+
+#include <atomic>
+
+namespace aperture::core
+{
+  /**
+   * @class APCCommandArena
+   * @brief Per-frame storage for the commands, command lists and queues of submitted jobs.
+   *
+   * Objects are handed out by bumping an atomic counter, Reset() rewinds the counters. Nothing is destroyed on reset, the next
+   * frame reuses the same objects and re-initializes them through their Reset() methods, so command lists keep the capacity they
+   * grew to. Once the arena has seen its busiest frame, allocating from it no longer touches the heap. Only the functions of the
+   * commands are dropped on reset, so whatever they own is released even if the command never ran.
+   *
+   * Every queue handed out counts as pending until the job system reports it finished, see HasPendingJobs().
+   *
+   * @note Allocation is thread-safe. Reset() is not, and must only be called once no queue of the arena is in flight.
+   * @warning Every queue allocated from the arena has to be submitted, and its completion callback must not be replaced.
+   */
+  class NS_APERTURE_DLL APCCommandArena
+  {
+  public:
+    APCCommandArena() = default;
+    ~APCCommandArena();
+
+    APCCommandArena(const APCCommandArena&) = delete;
+    APCCommandArena& operator=(const APCCommandArena&) = delete;
+
+    IAPCCommand* AllocateCommand(CommandType type, Runtype runtype);
+    IAPCCommandList* AllocateCommandList(IAPCCommandQueue& queue, CommandType type, Runtype runtype);
+    IAPCCommandQueue* AllocateCommandQueue(CommandType type, Runtype runtype);
+
+    /// @brief Hands all objects back to the arena and drops the functions of its commands. Asserts that no queue is still pending.
+    void Reset();
+
+    /// @brief True while any queue allocated since the last Reset() has not finished yet.
+    bool HasPendingJobs() const { return m_uiPendingQueues.load(std::memory_order_acquire) > 0; }
+
+    /// @brief Number of queues allocated since the last Reset().
+    nsUInt32 GetNumQueues() const { return m_Queues.GetNumUsed(); }
+
+  private:
+    /// @brief Grows in chunks of doubling size that are never freed or moved, so handed out pointers stay valid.
+    template <typename T>
+    class Store
+    {
+    public:
+      ~Store()
+      {
+        for (nsUInt32 c = 0; c < MaxChunks; ++c)
+        {
+          if (T* pChunk = m_Chunks[c].load(std::memory_order_relaxed))
+          {
+            nsArrayPtr<T> chunk(pChunk, GetChunkSize(c));
+            NS_DEFAULT_DELETE_ARRAY(chunk);
+          }
+        }
+      }
+
+      T* Acquire()
+      {
+        const nsUInt32 uiIndex = m_uiUsed.fetch_add(1, std::memory_order_relaxed);
+        const nsUInt32 uiChunk = nsMath::Log2i(uiIndex / FirstChunkSize + 1);
+        NS_ASSERT_DEV(uiChunk < MaxChunks, "APCCommandArena ran out of chunks.");
+
+        T* pChunk = m_Chunks[uiChunk].load(std::memory_order_acquire);
+        if (pChunk == nullptr)
+        {
+          NS_LOCK(m_GrowMutex);
+          pChunk = m_Chunks[uiChunk].load(std::memory_order_relaxed);
+          if (pChunk == nullptr)
+          {
+            pChunk = NS_DEFAULT_NEW_ARRAY(T, GetChunkSize(uiChunk)).GetPtr();
+            m_Chunks[uiChunk].store(pChunk, std::memory_order_release);
+          }
+        }
+        return &pChunk[uiIndex - FirstChunkSize * ((1u << uiChunk) - 1)];
+      }
+
+      /// @brief Calls func for every object handed out since the last Reset(). Not thread-safe.
+      template <typename Func>
+      void ForEachUsed(Func func)
+      {
+        const nsUInt32 uiUsed = m_uiUsed.load(std::memory_order_relaxed);
+        for (nsUInt32 uiChunk = 0, uiFirst = 0; uiFirst < uiUsed; uiFirst += GetChunkSize(uiChunk), ++uiChunk)
+        {
+          T* pChunk = m_Chunks[uiChunk].load(std::memory_order_relaxed);
+          const nsUInt32 uiCount = nsMath::Min(uiUsed - uiFirst, GetChunkSize(uiChunk));
+          for (nsUInt32 i = 0; i < uiCount; ++i)
+          {
+            func(pChunk[i]);
+          }
+        }
+      }
+
+      void Reset() { m_uiUsed.store(0, std::memory_order_relaxed); }
+      nsUInt32 GetNumUsed() const { return m_uiUsed.load(std::memory_order_relaxed); }
+
+    private:
+      static constexpr nsUInt32 FirstChunkSize = 64;
+      static constexpr nsUInt32 MaxChunks = 24;
+      static constexpr nsUInt32 GetChunkSize(nsUInt32 uiChunk) { return FirstChunkSize << uiChunk; }
+
+      std::atomic<T*> m_Chunks[MaxChunks] = {};
+      std::atomic<nsUInt32> m_uiUsed = 0;
+      nsMutex m_GrowMutex;
+    };
+
+    static void OnQueueCompleted(IAPCCommandQueue& queue, nsTime executionTime, void* pUserData);
+
+    Store<IAPCCommand> m_Commands;
+    Store<IAPCCommandList> m_Lists;
+    Store<IAPCCommandQueue> m_Queues;
+    std::atomic<nsUInt32> m_uiPendingQueues = 0;
+  };
+} // namespace aperture::core
@@ -18,6 +18,11 @@ nsResult aperture::core::IAPCCommand::RequestCommandQueueUnlock()
   m_parentCommandList->GetQueue()->ReleaseLock();
   return NS_SUCCESS;
 }
+bool aperture::core::IAPCCommand::IsCancellationRequested() const
+{
+  return m_parentCommandList != nullptr && m_parentCommandList->GetQueue() != nullptr && m_parentCommandList->GetQueue()->IsCancellationRequested();
+}
+
 void aperture::core::IAPCCommand::SetRunType(Runtype runtype)
 {
   if (!IsExecuting())
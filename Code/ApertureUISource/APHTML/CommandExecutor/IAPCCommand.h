@@ -3,12 +3,17 @@
 #include <APHTML/APEngineDLL.h>
 #include <APHTML/CommandExecutor/IAPCCommandCommon.h>
 #include <APHTML/APEngineCommonIncludes.h>
-#include <functional>
-#include <future>
+#include <Foundation/Time/Time.h>
+#include <Foundation/Types/Delegate.h>
 
 namespace aperture::core
 {
   class IAPCCommandList;
+
+  /// @brief The work of a command. Captures up to 40 bytes are stored inline, anything bigger falls back to the heap.
+  /// @note Copying or moving a command copies or moves the captures through their own constructors. Captures must be copy
+  /// constructible if the command is ever copied, move only captures work as long as the command is only moved.
+  using APCCommandFunction = nsDelegate<void(), 48>;
   /**
    * @class IAPCCommand
    * @brief Interface for defining and executing commands within the Aperture SDK.
@@ -41,15 +46,37 @@ namespace aperture::core
 
     nsVariant GetEndResult() const { return endresult; }
 
+    CommandPriority GetPriority() const { return m_priority; }
+    void SetPriority(CommandPriority priority) { m_priority = priority; }
+
+    /// @brief The point in time (on the nsTime::Now() clock) the command should have run by. Zero means no deadline.
+    /// @note A deferrable command whose deadline is due runs even when the frame budget is used up.
+    nsTime GetDeadline() const { return m_deadline; }
+    void SetDeadline(nsTime deadline) { m_deadline = deadline; }
+    bool HasDeadline() const { return m_deadline.IsPositive(); }
+
     template <typename Func>
     void SetFunction(Func&& func)
     {
-      m_function = std::forward<Func>(func);
+      m_function = APCCommandFunction(std::forward<Func>(func));
+    }
+
+    /// @brief Puts a recycled command back into its freshly constructed state, keeping no reference to its old work.
+    void Reset(CommandType type, Runtype runtype)
+    {
+      m_internaltype = type;
+      m_internalruntype = runtype;
+      m_barewexecuting = false;
+      m_priority = CommandPriority::FrameCritical;
+      m_deadline = nsTime::MakeZero();
+      m_function.Invalidate();
+      m_parentCommandList = nullptr;
+      m_uiCarriedOverPass = 0;
     }
 
     void Execute()
     {
-      if (m_function)
+      if (m_function.IsValid())
       {
         m_barewexecuting = true;
         m_function();
@@ -59,12 +86,21 @@ namespace aperture::core
 
     bool IsExecuting() const { return m_barewexecuting; }
 
+    /// @brief For long running commands to poll. True once the queue executing this command, or its token, got canceled.
+    bool IsCancellationRequested() const;
+
   private:
     bool m_barewexecuting;
     nsVariant endresult;
     CommandType m_internaltype;
     Runtype m_internalruntype;
-    std::function<void()> m_function;
+    CommandPriority m_priority = CommandPriority::FrameCritical;
+    nsTime m_deadline;
+    APCCommandFunction m_function;
     IAPCCommandList* m_parentCommandList = nullptr;
+
+    friend class IAPCCommandQueue;
+    /// The scheduling pass that took this command over as carried over work, so that its list does not schedule it again.
+    nsUInt32 m_uiCarriedOverPass = 0;
   };
 } // namespace aperture::core
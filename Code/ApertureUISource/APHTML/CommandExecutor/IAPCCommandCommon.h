@@ -65,6 +65,15 @@ namespace aperture::core
     FreeThread_Custom
   };
 
+  /// @brief How urgently a command has to run. Queues executed with respect to priority run the classes in this order.
+  enum class CommandPriority : nsUInt8
+  {
+    InputCritical, ///< Reacts to user input, always runs first.
+    FrameCritical, ///< Needed to present the current frame. The default.
+    Deferrable,    ///< May be pushed to a later frame when the frame budget is used up.
+    Count
+  };
+
   // Conversion functions for CommandType
   static NS_ALWAYS_INLINE const char* CommandTypeToString(CommandType type)
   {
@@ -80,6 +89,8 @@ namespace aperture::core
         return "Layout";
       case CommandType::Rendering:
         return "Rendering";
+      case CommandType::Scripting:
+        return "Scripting";
       case CommandType::Presentation:
         return "Presentation";
       case CommandType::Custom:
@@ -123,6 +134,8 @@ namespace aperture::core
         return "FreeThread_Layout";
       case Runtype::FreeThread_Rendering:
         return "FreeThread_Rendering";
+      case Runtype::FreeThread_Scripting:
+        return "FreeThread_Scripting";
       case Runtype::FreeThread_Presentation:
         return "FreeThread_Presentation";
       case Runtype::FreeThread_Custom:
@@ -132,6 +145,21 @@ namespace aperture::core
     }
   }
 
+  static NS_ALWAYS_INLINE const char* CommandPriorityToString(CommandPriority priority)
+  {
+    switch (priority)
+    {
+      case CommandPriority::InputCritical:
+        return "InputCritical";
+      case CommandPriority::FrameCritical:
+        return "FrameCritical";
+      case CommandPriority::Deferrable:
+        return "Deferrable";
+      default:
+        return "Unknown";
+    }
+  }
+
   static NS_ALWAYS_INLINE Runtype StringToRuntype(const std::string& str)
   {
     if (str == "AnyThread")
@@ -144,6 +172,8 @@ namespace aperture::core
       return Runtype::FreeThread_Layout;
     if (str == "FreeThread_Rendering")
       return Runtype::FreeThread_Rendering;
+    if (str == "FreeThread_Scripting")
+      return Runtype::FreeThread_Scripting;
     if (str == "FreeThread_Presentation")
       return Runtype::FreeThread_Presentation;
     if (str == "FreeThread_Custom")
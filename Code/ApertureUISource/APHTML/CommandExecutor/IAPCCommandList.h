@@ -41,10 +41,19 @@ namespace aperture::core
 
     nsHybridArray<IAPCCommand*, 1>& GetCommands() { return m_commands; }
 
+    /// @brief Empties a recycled list and binds it to a new queue. The command array keeps its capacity.
+    void Reset(IAPCCommandQueue* in_queue, CommandType type, Runtype runtype)
+    {
+      m_queue = in_queue;
+      m_type = type;
+      m_runtype = runtype;
+      m_commands.Clear();
+    }
+
   private:
-    core::CommandType m_type;
-    core::Runtype m_runtype;
+    core::CommandType m_type = core::CommandType::Unknown;
+    core::Runtype m_runtype = core::Runtype::AnyThread;
     nsHybridArray<IAPCCommand*, 1> m_commands;
-    IAPCCommandQueue* m_queue;
+    IAPCCommandQueue* m_queue = nullptr;
   };
 } // namespace aperture::core
@@ -20,7 +20,7 @@ void aperture::core::IAPCCommandQueue::AddCommandList(IAPCCommandList& commandLi
 {
   if (commandList.VerifyAndCommitCommands() && commandList.GetRunType() == GetRunType())
   {
-    ExecuteLoneCommandList(commandList);
+    // Only verified here, the list runs when the queue is executed.
     m_commandLists.PushBack(&commandList);
   }
   else
@@ -34,54 +34,264 @@ void aperture::core::IAPCCommandQueue::ExecuteLoneCommandList(IAPCCommandList& c
 {
   for (auto& command : commandList.GetCommands())
   {
-    if (command && command->GetCommandType() == commandList.GetType())
-    {
-      command->SetParentCommandList(commandList);
-      command->Execute();
-    }
-    else
-    {
-      nsLog::Error("CommandQueue Execution Failure: Command of Type: {0}, Failed to execute/failed, Has a bad function, is locked somehow, or has a bad CommandType.", CommandTypeToString(command->GetCommandType()));
-      // Break here, so we can debug.
-      NS_DEBUG_BREAK;
-    }
+    ExecuteCommand(command, commandList);
   }
 }
 void aperture::core::IAPCCommandQueue::ExecuteResidentCommandList(nsUInt8 m_iIndex)
 {
+  if (m_iIndex >= m_commandLists.GetCount())
+  {
+    nsLog::Error("CommandQueue of Type: {0} has no resident CommandList at index {1}, it only holds {2}.", CommandTypeToString(GetType()), m_iIndex, m_commandLists.GetCount());
+    return;
+  }
+  ExecuteCommandList(*m_commandLists[m_iIndex]);
 }
 void aperture::core::IAPCCommandQueue::ClearQueue()
 {
+  m_commandLists.Clear();
+}
+void aperture::core::IAPCCommandQueue::Reset(core::CommandType type, core::Runtype runtype)
+{
+  NS_ASSERT_DEV(GetJobState() == APCJobState::Idle, "Cannot reset a queue that is still in flight.");
+
+  ClearQueue();
+  m_deferredCommands.Clear();
+  m_type = type;
+  m_runtype = runtype;
+  m_JobID = nsUuid::MakeInvalid();
+  m_completionCallback = nullptr;
+  m_pCompletionUserData = nullptr;
+  m_executionBudget = nsTime::MakeZero();
+  m_lastExecutionStats = APCQueueExecutionStats();
+  m_pCancellationToken = nullptr;
+  m_bCancellationRequested = false;
+  m_uiLastCanceledCommands = 0;
 }
 nsResult aperture::core::IAPCCommandQueue::Execute(bool m_bExecWithRespectiveOfPriority)
 {
-  for (auto& commandList : m_commandLists)
+  m_uiLastCanceledCommands = 0;
+
+  if (!m_bExecWithRespectiveOfPriority)
+  {
+    nsUInt32 uiCommandCount = 0;
+    nsUInt32 uiExecuted = 0;
+    for (auto& commandList : m_commandLists)
+    {
+      uiCommandCount += commandList->GetCommands().GetCount();
+      uiExecuted += ExecuteCommandList(*commandList);
+    }
+    if (IsCancellationRequested() && uiExecuted < uiCommandCount)
+    {
+      OnExecutionCanceled(uiCommandCount - uiExecuted);
+    }
+    return NS_SUCCESS;
+  }
+
+  if (m_executionBudget.IsPositive())
+  {
+    return ExecuteBudgeted(m_executionBudget);
+  }
+
+  ScheduleCommands();
+  const nsUInt32 uiNumScheduled = m_scheduledCommands.GetCount();
+  for (nsUInt32 i = 0; i < uiNumScheduled; ++i)
+  {
+    if (IsCancellationRequested())
+    {
+      OnExecutionCanceled(uiNumScheduled - i);
+      break;
+    }
+
+    ExecuteCommand(m_scheduledCommands[i].m_pCommand, *m_scheduledCommands[i].m_pList);
+  }
+  return NS_SUCCESS;
+}
+
+nsResult aperture::core::IAPCCommandQueue::ExecuteBudgeted(nsTime budget, APCQueueExecutionStats* out_pStats)
+{
+  const nsTime startTime = nsTime::Now();
+  APCQueueExecutionStats stats;
+
+  m_uiLastCanceledCommands = 0;
+
+  ScheduleCommands();
+  const nsUInt32 uiNumScheduled = m_scheduledCommands.GetCount();
+  for (nsUInt32 i = 0; i < uiNumScheduled; ++i)
   {
-    if (commandList->VerifyAndCommitCommands() && commandList->GetRunType() == GetRunType())
+    if (IsCancellationRequested())
+    {
+      // Work carried over from a canceled execution would only run for nothing next time.
+      stats.m_uiCanceledCommands = uiNumScheduled - i + m_deferredCommands.GetCount();
+      m_deferredCommands.Clear();
+      OnExecutionCanceled(stats.m_uiCanceledCommands);
+      break;
+    }
+
+    const ScheduledCommand& scheduled = m_scheduledCommands[i];
+    IAPCCommand* pCommand = scheduled.m_pCommand;
+    const bool bDeferrable = pCommand->GetPriority() == CommandPriority::Deferrable;
+    if (bDeferrable || pCommand->HasDeadline())
     {
-      for (auto& command : commandList->GetCommands())
+      const nsTime now = nsTime::Now();
+      const bool bDeadlineDue = pCommand->HasDeadline() && pCommand->GetDeadline() <= now;
+      if (bDeferrable && !bDeadlineDue && now - startTime >= budget)
       {
-        if (command && command->GetCommandType() == commandList->GetType())
-        {
-          command->SetParentCommandList(*commandList);
-          command->Execute();
-        }
-        else
-        {
-          nsLog::Error("CommandQueue Execution Failure: Command of Type: {0}, Failed to execute/failed, Has a bad function, is locked somehow, or has a bad CommandType.", CommandTypeToString(command->GetCommandType()));
-          // Break here, so we can debug.
-          NS_DEBUG_BREAK;
-        }
+        m_deferredCommands.PushBack(scheduled);
+        continue;
+      }
+      if (pCommand->HasDeadline() && pCommand->GetDeadline() < now)
+      {
+        ++stats.m_uiMissedDeadlines;
       }
     }
-    else
+
+    if (ExecuteCommand(pCommand, *scheduled.m_pList))
     {
-      nsLog::Error("CommandList of Type: {0}, Has a bad command, is locked somehow or has a bad Run Type.", CommandTypeToString(m_commandLists[m_commandLists.IndexOf(commandList)]->GetType()));
+      ++stats.m_uiExecutedCommands;
+    }
+  }
+
+  stats.m_uiDeferredCommands = m_deferredCommands.GetCount();
+  stats.m_ExecutionTime = nsTime::Now() - startTime;
+  m_lastExecutionStats = stats;
+  if (out_pStats != nullptr)
+  {
+    *out_pStats = stats;
+  }
+  return NS_SUCCESS;
+}
+
+bool aperture::core::IAPCCommandQueue::ExecuteCommand(IAPCCommand* pCommand, IAPCCommandList& commandList)
+{
+  if (pCommand && pCommand->GetCommandType() == commandList.GetType())
+  {
+    pCommand->SetParentCommandList(commandList);
+    pCommand->Execute();
+    return true;
+  }
+
+  nsLog::Error("CommandQueue Execution Failure: Command of Type: {0}, Failed to execute/failed, Has a bad function, is locked somehow, or has a bad CommandType.", CommandTypeToString(pCommand ? pCommand->GetCommandType() : CommandType::Unknown));
+  // Break here, so we can debug.
+  NS_DEBUG_BREAK;
+  return false;
+}
+
+nsUInt32 aperture::core::IAPCCommandQueue::ExecuteCommandList(IAPCCommandList& commandList)
+{
+  if (!commandList.VerifyAndCommitCommands() || commandList.GetRunType() != GetRunType())
+  {
+    nsLog::Error("CommandList of Type: {0}, Has a bad command, is locked somehow or has a bad Run Type.", CommandTypeToString(commandList.GetType()));
+    // Break here, so we can debug.
+    NS_DEBUG_BREAK;
+    return 0;
+  }
+
+  nsUInt32 uiExecuted = 0;
+  for (auto& command : commandList.GetCommands())
+  {
+    if (IsCancellationRequested())
+      break;
+
+    ExecuteCommand(command, commandList);
+    ++uiExecuted;
+  }
+  return uiExecuted;
+}
+
+void aperture::core::IAPCCommandQueue::OnExecutionCanceled(nsUInt32 uiSkippedCommands)
+{
+  m_uiLastCanceledCommands = uiSkippedCommands;
+
+  // The token only counts what it canceled itself, not queues canceled one by one.
+  if (m_pCancellationToken != nullptr && m_pCancellationToken->IsCanceled())
+  {
+    m_pCancellationToken->RecordInterruptedQueue(uiSkippedCommands);
+  }
+}
+
+nsUInt32 aperture::core::IAPCCommandQueue::GetCommandCount() const
+{
+  nsUInt32 uiCount = 0;
+  for (IAPCCommandList* pCommandList : m_commandLists)
+  {
+    uiCount += pCommandList->GetCommands().GetCount();
+  }
+
+  // Carried over commands whose list is still in the queue are counted with it already.
+  for (const ScheduledCommand& deferred : m_deferredCommands)
+  {
+    if (!m_commandLists.Contains(deferred.m_pList))
+    {
+      ++uiCount;
+    }
+  }
+  return uiCount;
+}
+
+void aperture::core::IAPCCommandQueue::ScheduleCommands()
+{
+  m_scheduledCommands.Clear();
+
+  // Unique across all queues, so a stamp left on a command by an earlier pass or another queue never matches.
+  static std::atomic<nsUInt32> s_uiNextPass = 1;
+  const nsUInt32 uiPass = s_uiNextPass.fetch_add(1, std::memory_order_relaxed);
+
+  // Carried over work is older than anything in the lists, so it goes first within its class.
+  for (const ScheduledCommand& deferred : m_deferredCommands)
+  {
+    deferred.m_pCommand->m_uiCarriedOverPass = uiPass;
+    m_scheduledCommands.PushBack({deferred.m_pCommand, deferred.m_pList, m_scheduledCommands.GetCount()});
+  }
+  m_deferredCommands.Clear();
+
+  bool bNeedsSorting = !m_scheduledCommands.IsEmpty();
+  for (auto& commandList : m_commandLists)
+  {
+    if (!commandList->VerifyAndCommitCommands() || commandList->GetRunType() != GetRunType())
+    {
+      nsLog::Error("CommandList of Type: {0}, Has a bad command, is locked somehow or has a bad Run Type.", CommandTypeToString(commandList->GetType()));
       // Break here, so we can debug.
       NS_DEBUG_BREAK;
+      continue;
+    }
+
+    for (auto& command : commandList->GetCommands())
+    {
+      // A list that stayed in the queue still holds the commands that were carried over from it, they are scheduled once.
+      if (command->m_uiCarriedOverPass == uiPass)
+        continue;
+
+      bNeedsSorting |= command->GetPriority() != CommandPriority::FrameCritical || command->HasDeadline();
+      m_scheduledCommands.PushBack({command, commandList, m_scheduledCommands.GetCount()});
     }
   }
-  return NS_SUCCESS;
+
+  // The common case is all frame critical without deadlines, which is already in order.
+  if (bNeedsSorting)
+  {
+    struct ScheduleOrder
+    {
+      NS_ALWAYS_INLINE static nsTime GetSortDeadline(const IAPCCommand* pCommand)
+      {
+        return pCommand->HasDeadline() ? pCommand->GetDeadline() : nsTime::MakeFromSeconds(nsMath::MaxValue<double>());
+      }
+
+      NS_ALWAYS_INLINE bool Less(const ScheduledCommand& a, const ScheduledCommand& b) const
+      {
+        if (a.m_pCommand->GetPriority() != b.m_pCommand->GetPriority())
+          return a.m_pCommand->GetPriority() < b.m_pCommand->GetPriority();
+
+        const nsTime deadlineA = GetSortDeadline(a.m_pCommand);
+        const nsTime deadlineB = GetSortDeadline(b.m_pCommand);
+        if (deadlineA != deadlineB)
+          return deadlineA < deadlineB;
+
+        return a.m_uiOrder < b.m_uiOrder;
+      }
+    };
+
+    m_scheduledCommands.Sort(ScheduleOrder());
+  }
 }
 
 nsResult aperture::core::IAPCCommandQueue::RequestLock()
@@ -35,12 +35,45 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 #include <APHTML/APEngineDLL.h>
+#include <APHTML/CommandExecutor/APCCancellationToken.h>
 #include <APHTML/CommandExecutor/IAPCCommandCommon.h>
 #include <APHTML/APEngineCommonIncludes.h>
+#include <Foundation/Time/Time.h>
+#include <Foundation/Types/Uuid.h>
 
 namespace aperture::core
 {
   class IAPCCommandList;
+
+  /// @brief Lifecycle of a queue that was handed to the job system.
+  enum class APCJobState : nsUInt8
+  {
+    Idle,     ///< Not submitted, or submitted and completely done.
+    Queued,   ///< Sitting in a worker deque or an injector, waiting for a worker.
+    Running,  ///< A worker is currently executing the queue.
+    Canceled, ///< Canceled before a worker picked it up. The thread that pops it skips it.
+  };
+
+  class IAPCCommand;
+  class IAPCCommandQueue;
+
+  /// @brief What a budgeted execution of a queue did.
+  struct APCQueueExecutionStats
+  {
+    nsUInt32 m_uiExecutedCommands = 0;
+    /// Deferrable commands that did not fit into the budget and were carried over to the next execution.
+    nsUInt32 m_uiDeferredCommands = 0;
+    /// Commands that started after their deadline had passed.
+    nsUInt32 m_uiMissedDeadlines = 0;
+    /// Commands that did not run because the queue got canceled, including carried over ones, which are dropped.
+    nsUInt32 m_uiCanceledCommands = 0;
+    nsTime m_ExecutionTime;
+  };
+
+  /// @brief Called by the job system once a submitted queue leaves it, executed or skipped.
+  /// @param executionTime How long Execute() took, zero if the queue was skipped.
+  using APCJobCompletionCallback = void (*)(IAPCCommandQueue& queue, nsTime executionTime, void* pUserData);
+
   /**
    * @class IAPCCommandQueue
    * @brief Interface for a command queue in the Aperture Core Engine.
@@ -85,7 +118,7 @@ namespace aperture::core
     /**
      * @brief Executes a resident command list by index.
      *
-     * This function executes a command list from the queue based on its index.
+     * This function executes a command list from the queue based on its index, in insertion order.
      *
      * @param m_iIndex The index of the command list to be executed.
      */
@@ -94,19 +127,66 @@ namespace aperture::core
     /**
      * @brief Clears the command queue.
      *
-     * This function removes all command lists from the queue.
+     * This function removes all command lists from the queue. The list array keeps its capacity.
+     * @note Commands carried over by ExecuteBudgeted() are kept, they still run on the next execution.
      */
     void ClearQueue();
+
+    /// @brief Clears a recycled queue and gives it a new type. Also drops carried over commands. The queue must not be in flight.
+    void Reset(core::CommandType type, core::Runtype runtype);
     /**
      * @brief Executes the command queue.
      *
      * This function executes all command lists in the queue, optionally respecting their priority.
+     * With priority, commands of all lists run by CommandPriority class first, then by earliest deadline, then in insertion order.
+     * If an execution budget is set, this runs ExecuteBudgeted() with it.
      *
      * @param m_bExecWithRespectiveOfPriority If true, executes command lists with respect to their priority.
      * @return The result of the execution.
      */
     nsResult Execute(bool m_bExecWithRespectiveOfPriority = true);
 
+    /**
+     * @brief Executes the queue with respect to priority, within a time budget.
+     *
+     * Input and frame critical commands always run. Deferrable commands stop being dispatched once the budget is used up,
+     * unless their deadline is due. The ones that did not run are carried over and run before any new deferrable work on the
+     * next execution of this queue. If their list is still in the queue by then, they run only once, as the carried over command.
+     *
+     * @note Carried over commands and their lists must stay alive until they ran, or until the queue is Reset().
+     */
+    nsResult ExecuteBudgeted(nsTime budget, APCQueueExecutionStats* out_pStats = nullptr);
+
+    /// @brief Makes Execute() run budgeted, e.g. when the job system executes the queue. Zero disables the budget.
+    void SetExecutionBudget(nsTime budget) { m_executionBudget = budget; }
+    nsTime GetExecutionBudget() const { return m_executionBudget; }
+
+    /// @brief Stats of the last budgeted execution started through Execute().
+    const APCQueueExecutionStats& GetLastExecutionStats() const { return m_lastExecutionStats; }
+
+    /// @brief Number of deferrable commands waiting for the next execution.
+    nsUInt32 GetDeferredCommandCount() const { return m_deferredCommands.GetCount(); }
+
+    /// @brief Number of commands the next execution would run, carried over ones included.
+    nsUInt32 GetCommandCount() const;
+
+    /// @brief Binds the queue to a token, nullptr unbinds it. Several queues, e.g. those of a CommandGroup, can share one token.
+    void SetCancellationToken(APCCancellationToken* pToken) { m_pCancellationToken = pToken; }
+    APCCancellationToken* GetCancellationToken() const { return m_pCancellationToken; }
+
+    /// @brief Cancels only this queue, its token is not touched. Cleared when the queue gets submitted again.
+    void RequestCancellation() { m_bCancellationRequested.store(true, std::memory_order_release); }
+    void ClearCancellationRequest() { m_bCancellationRequested.store(false, std::memory_order_relaxed); }
+
+    /// @brief True if the queue or its token got canceled. Execution checks this before every command and stops once it is set.
+    bool IsCancellationRequested() const
+    {
+      return m_bCancellationRequested.load(std::memory_order_acquire) || (m_pCancellationToken != nullptr && m_pCancellationToken->IsCanceled());
+    }
+
+    /// @brief Commands the last execution skipped because it got canceled.
+    nsUInt32 GetLastCanceledCommandCount() const { return m_uiLastCanceledCommands; }
+
     nsResult RequestLock();
 
     void ReleaseLock();
@@ -117,15 +197,79 @@ namespace aperture::core
     core::Runtype GetRunType() const { return m_runtype; }
     void SetRunType(core::Runtype runtype) { m_runtype = runtype; }
 
+    /// @brief The ID the job system assigned to this queue when it was last submitted.
+    const nsUuid& GetJobID() const { return m_JobID; }
+    void SetJobID(const nsUuid& jobID) { m_JobID = jobID; }
+
+    /// @brief When the queue was last submitted to the job system.
+    nsTime GetEnqueueTime() const { return m_enqueueTime; }
+    void SetEnqueueTime(nsTime time) { m_enqueueTime = time; }
+
+    APCJobState GetJobState() const { return m_jobState.load(std::memory_order_acquire); }
+    void SetJobState(APCJobState state) { m_jobState.store(state, std::memory_order_release); }
+    /// @brief Atomically moves the queue from one job state into another. Used by the job system to claim or cancel queued work.
+    bool TransitionJobState(APCJobState from, APCJobState to) { return m_jobState.compare_exchange_strong(from, to, std::memory_order_acq_rel); }
+
+    /// @brief Installs a callback the job system invokes every time this queue finishes. Used by APCFrameGraph to release dependents.
+    void SetCompletionCallback(APCJobCompletionCallback callback, void* pUserData)
+    {
+      m_completionCallback = callback;
+      m_pCompletionUserData = pUserData;
+    }
+
+    /// @brief The user data the completion callback was installed with.
+    void* GetCompletionUserData() const { return m_pCompletionUserData; }
+
+    /// @brief Invokes the completion callback, if any.
+    void NotifyJobCompleted(nsTime executionTime)
+    {
+      if (m_completionCallback != nullptr)
+      {
+        m_completionCallback(*this, executionTime, m_pCompletionUserData);
+      }
+    }
+
     bool operator==(const IAPCCommandQueue& other) const
     {
       return m_type == other.m_type && m_runtype == other.m_runtype && m_commandLists == other.m_commandLists;
     }
 
   private:
-    core::CommandType m_type;
-    core::Runtype m_runtype;
+    /// @brief A command together with the list it came from, in the order it was added.
+    struct ScheduledCommand
+    {
+      IAPCCommand* m_pCommand = nullptr;
+      IAPCCommandList* m_pList = nullptr;
+      nsUInt32 m_uiOrder = 0;
+      NS_DECLARE_POD_TYPE();
+    };
+
+    bool ExecuteCommand(IAPCCommand* pCommand, IAPCCommandList& commandList);
+    /// @brief Runs the commands of a list until the queue gets canceled. Returns how many ran.
+    nsUInt32 ExecuteCommandList(IAPCCommandList& commandList);
+    /// @brief Records that an execution stopped early and skipped the given number of commands.
+    void OnExecutionCanceled(nsUInt32 uiSkippedCommands);
+    /// @brief Fills m_scheduledCommands with the carried over commands, then the other commands of the lists, sorted by priority. Bad lists are skipped.
+    void ScheduleCommands();
+
+    core::CommandType m_type = core::CommandType::Unknown;
+    core::Runtype m_runtype = core::Runtype::AnyThread;
     nsHybridArray<IAPCCommandList*, 1> m_commandLists; ///< The command lists in the queue.
+    nsUuid m_JobID;
+    nsTime m_enqueueTime;
+    std::atomic<APCJobState> m_jobState = APCJobState::Idle;
+    APCJobCompletionCallback m_completionCallback = nullptr;
+    void* m_pCompletionUserData = nullptr;
+    APCCancellationToken* m_pCancellationToken = nullptr;
+    std::atomic<bool> m_bCancellationRequested = false;
+    nsUInt32 m_uiLastCanceledCommands = 0;
+
+    nsTime m_executionBudget;
+    APCQueueExecutionStats m_lastExecutionStats;
+    /// Kept as members, so their capacity is reused from execution to execution.
+    nsHybridArray<ScheduledCommand, 4> m_scheduledCommands;
+    nsHybridArray<ScheduledCommand, 4> m_deferredCommands;
+
   public:
     nsMutex m_mutex;
   };
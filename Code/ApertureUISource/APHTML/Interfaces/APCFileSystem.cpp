@@ -22,6 +22,23 @@ nsOSFileData aperture::core::IAPCFileSystem::GetRawFileHandle(const char* in_fil
   return nsOSFileData();
 }
 
+aperture::core::CoreBuffer<nsUInt8> aperture::core::IAPCFileSystem::GetFileData(const char* in_filepath)
+{
+  core::CoreBuffer<nsUInt8> data;
+
+  nsOSFile apcfile;
+  nsStringBuilder filep(m_uiresources);
+  filep.Append(in_filepath);
+  if (apcfile.Open(filep, nsFileOpenMode::Read) == NS_SUCCESS)
+  {
+    // one read into storage of the right size, instead of growing while reading
+    data.resize(static_cast<size_t>(apcfile.GetFileSize()));
+    data.resize(static_cast<size_t>(apcfile.Read(data.data(), data.size())));
+  }
+
+  return data;
+}
+
 nsString aperture::core::IAPCFileSystem::FileCharset(const nsString& in_filepath)
 {
   // TODO: I will implement this later.
@@ -55,12 +55,9 @@ namespace aperture::core
     }
 
     /// @brief Gets the buffer of the file's data.
-    /// @param in_filepath Path to the file.
-    /// @return Buffer of the file's data.
-    virtual core::CoreBuffer<nsUInt8> GetFileData(const char* in_filepath)
-    {
-      return core::CoreBuffer<nsUInt8>();
-    }
+    /// @param in_filepath Path to the file, relative to the UI resources.
+    /// @return Buffer of the file's data, empty if the file could not be read. Its memory is recycled through the CoreBufferPool.
+    virtual core::CoreBuffer<nsUInt8> GetFileData(const char* in_filepath);
     virtual const char* GetFileMimeType(const char* in_filepath);
     /// @brief Checks if a file exists.
     /// @param in_filepath Path to the file.
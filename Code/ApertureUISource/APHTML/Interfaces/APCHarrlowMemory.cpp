@@ -0,0 +1,95 @@
+#include <APHTML/Interfaces/APCHarrlowMemory.h>
+#include <APHarrlow/VectorEngine/Core/BufferStore.hpp>
+#include <APHarrlow/VectorEngine/Core/Text.hpp>
+#include <Foundation/Threading/Lock.h>
+
+aperture::core::APCHarrlowMemory::APCHarrlowMemory(APCMemoryBudgets& ref_budgets)
+  : m_Budgets(ref_budgets)
+{
+  const APCMemoryBudgets::BudgetId budget = m_Budgets.GetBudget(APCMemorySubsystem::TextAndAtlases);
+
+  m_Budgets.SetUsageCallback(budget, APCMemoryBudgets::UsageCallback(&APCHarrlowMemory::GetUsage, this));
+  // cached texts are cheap to rebuild, an atlas is only released once no font uses it
+  m_uiTextCacheEviction = m_Budgets.AddEvictionCallback(budget, 0, APCMemoryBudgets::EvictionCallback(&APCHarrlowMemory::EvictTextCaches, this));
+  m_uiAtlasEviction = m_Budgets.AddEvictionCallback(budget, 10, APCMemoryBudgets::EvictionCallback(&APCHarrlowMemory::ReleaseEmptyAtlases, this));
+}
+
+aperture::core::APCHarrlowMemory::~APCHarrlowMemory()
+{
+  m_Budgets.RemoveEvictionCallback(m_uiTextCacheEviction);
+  m_Budgets.RemoveEvictionCallback(m_uiAtlasEviction);
+  m_Budgets.SetUsageCallback(m_Budgets.GetBudget(APCMemorySubsystem::TextAndAtlases), APCMemoryBudgets::UsageCallback());
+}
+
+void aperture::core::APCHarrlowMemory::AddBufferStore(harrlow::vector::BufferStore* p_pBufferStore)
+{
+  NS_LOCK(m_Mutex);
+  m_BufferStores.PushBack(p_pBufferStore);
+}
+
+void aperture::core::APCHarrlowMemory::RemoveBufferStore(harrlow::vector::BufferStore* p_pBufferStore)
+{
+  NS_LOCK(m_Mutex);
+  m_BufferStores.RemoveAndSwap(p_pBufferStore);
+}
+
+void aperture::core::APCHarrlowMemory::AddText(harrlow::vector::Text* p_pText)
+{
+  NS_LOCK(m_Mutex);
+  m_Texts.PushBack(p_pText);
+}
+
+void aperture::core::APCHarrlowMemory::RemoveText(harrlow::vector::Text* p_pText)
+{
+  NS_LOCK(m_Mutex);
+  m_Texts.RemoveAndSwap(p_pText);
+}
+
+nsUInt64 aperture::core::APCHarrlowMemory::GetUsage()
+{
+  NS_LOCK(m_Mutex);
+
+  nsUInt64 uiUsage = 0;
+  for (harrlow::vector::BufferStore* pBufferStore : m_BufferStores)
+  {
+    uiUsage += pBufferStore->GetTextCacheSize();
+  }
+
+#ifndef APHARRLOW_DISABLE_TEXT_SUPPORT
+  for (harrlow::vector::Text* pText : m_Texts)
+  {
+    uiUsage += pText->GetAtlasSize();
+  }
+#endif
+
+  return uiUsage;
+}
+
+nsUInt64 aperture::core::APCHarrlowMemory::EvictTextCaches(nsUInt64 p_uiBytes)
+{
+  NS_LOCK(m_Mutex);
+
+  nsUInt64 uiFreed = 0;
+  for (nsUInt32 i = 0; i < m_BufferStores.GetCount() && uiFreed < p_uiBytes; ++i)
+  {
+    uiFreed += m_BufferStores[i]->EvictTextCache(static_cast<size_t>(p_uiBytes - uiFreed));
+  }
+
+  return uiFreed;
+}
+
+nsUInt64 aperture::core::APCHarrlowMemory::ReleaseEmptyAtlases(nsUInt64 p_uiBytes)
+{
+  NS_IGNORE_UNUSED(p_uiBytes);
+  NS_LOCK(m_Mutex);
+
+  nsUInt64 uiFreed = 0;
+#ifndef APHARRLOW_DISABLE_TEXT_SUPPORT
+  for (harrlow::vector::Text* pText : m_Texts)
+  {
+    uiFreed += pText->ReleaseEmptyAtlases();
+  }
+#endif
+
+  return uiFreed;
+}
@@ -0,0 +1,88 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <APHTML/APEngineDLL.h>
+#include <APHTML/Interfaces/APCMemoryBudgets.h>
+#include <Foundation/Containers/HybridArray.h>
+#include <Foundation/Threading/Mutex.h>
+
+namespace aperture::harrlow::vector
+{
+  class BufferStore;
+  class Text;
+} // namespace aperture::harrlow::vector
+
+namespace aperture::core
+{
+  /**
+   * @brief Feeds the APCMemorySubsystem::TextAndAtlases budget from Harrlow.
+   *
+   * The text caches of the added buffer stores and the glyph atlases of the added text systems count towards the budget. When it
+   * is over, cached texts are dropped first, they are rebuilt the next time they are drawn, then the atlases that no font uses
+   * anymore are destroyed.
+   *
+   * The callbacks run in APCMemoryBudgets::Update(), so the buffer stores and text systems must be used on the thread that updates
+   * the budgets. Remove them before they are destroyed.
+   */
+  class NS_APERTURE_DLL APCHarrlowMemory
+  {
+  public:
+    explicit APCHarrlowMemory(APCMemoryBudgets& ref_budgets);
+    ~APCHarrlowMemory();
+
+    APCHarrlowMemory(const APCHarrlowMemory&) = delete;
+    APCHarrlowMemory& operator=(const APCHarrlowMemory&) = delete;
+
+    void AddBufferStore(harrlow::vector::BufferStore* p_pBufferStore);
+    void RemoveBufferStore(harrlow::vector::BufferStore* p_pBufferStore);
+
+    void AddText(harrlow::vector::Text* p_pText);
+    void RemoveText(harrlow::vector::Text* p_pText);
+
+  private:
+    nsUInt64 GetUsage();
+    nsUInt64 EvictTextCaches(nsUInt64 p_uiBytes);
+    nsUInt64 ReleaseEmptyAtlases(nsUInt64 p_uiBytes);
+
+    APCMemoryBudgets& m_Budgets;
+    nsUInt32 m_uiTextCacheEviction = 0;
+    nsUInt32 m_uiAtlasEviction = 0;
+
+    nsMutex m_Mutex;
+    nsHybridArray<harrlow::vector::BufferStore*, 2> m_BufferStores;
+    nsHybridArray<harrlow::vector::Text*, 2> m_Texts;
+  };
+} // namespace aperture::core
@@ -35,6 +35,8 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <APHTML/Interfaces/APCMemoryAllocator.h>
+#include <APHTML/Interfaces/APCMemoryBudgets.h>
+#include <APHTML/Interfaces/APCViewHeap.h>
 
 
 void* aperture::core::IAPCMemoryAllocator::Alloc(size_t uiSize, size_t uiAlign)
@@ -51,3 +53,35 @@ void* aperture::core::IAPCMemoryAllocator::Realloc(void* pMemory, size_t uiCurre
 {
   return nsFoundation::GetAlignedAllocator()->Reallocate(pMemory, uiCurrentSize, uiSize, uiAlign);
 }
+
+nsAllocator* aperture::core::IAPCMemoryAllocator::CreateViewHeap(nsStringView sName)
+{
+  if (m_HeapMode == APCHeapMode::PerView)
+  {
+    APCViewHeap* pViewHeap = NS_DEFAULT_NEW(APCViewHeap, sName);
+
+    if (m_pMemoryBudgets != nullptr)
+    {
+      m_pMemoryBudgets->AddAllocator(m_pMemoryBudgets->GetBudget(APCMemorySubsystem::DOMAndStyle), pViewHeap->GetId());
+    }
+
+    return pViewHeap;
+  }
+
+  return nsFoundation::GetAlignedAllocator();
+}
+
+void aperture::core::IAPCMemoryAllocator::DestroyViewHeap(nsAllocator* pHeap)
+{
+  if (pHeap != nsFoundation::GetAlignedAllocator())
+  {
+    APCViewHeap* pViewHeap = static_cast<APCViewHeap*>(pHeap);
+
+    if (m_pMemoryBudgets != nullptr)
+    {
+      m_pMemoryBudgets->RemoveAllocator(m_pMemoryBudgets->GetBudget(APCMemorySubsystem::DOMAndStyle), pViewHeap->GetId());
+    }
+
+    NS_DEFAULT_DELETE(pViewHeap);
+  }
+}
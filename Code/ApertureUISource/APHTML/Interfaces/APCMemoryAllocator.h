@@ -38,16 +38,49 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace aperture::core
 {
+  class APCMemoryBudgets;
+
+  /// @brief Where the allocations of a view or document go.
+  enum class APCHeapMode : nsUInt8
+  {
+    /// Everything is allocated through Alloc()/Free() and released one by one.
+    Shared,
+    /// Every view gets an APCViewHeap of its own, which is released in one call when the view is unloaded.
+    PerView,
+  };
+
   /// @brief Interface for applications to provide a memory allocator to APUI. Is used by APCCoreLibrary &.
   class NS_APERTURE_DLL IAPCMemoryAllocator
   {
   public:
     IAPCMemoryAllocator() = default;
+    virtual ~IAPCMemoryAllocator() = default;
 
     virtual void* Alloc(size_t uiSize, size_t uiAlign);
 
     virtual void Free(void* pMemory);
 
     virtual void* Realloc(void* pMemory, size_t uiCurrentSize, size_t uiSize, size_t uiAlign);
+
+    /// @brief Returns the allocator for the DOM, style and layout data of one view or document.
+    ///
+    /// In APCHeapMode::PerView this is a new APCViewHeap, registered with the nsMemoryTracker under sName.
+    /// Otherwise it is the allocator that Alloc() uses. Hand it back with DestroyViewHeap() when the view is unloaded.
+    /// View heaps count towards the APCMemorySubsystem::DOMAndStyle budget of SetMemoryBudgets() until then.
+    /// Override both functions or neither.
+    virtual nsAllocator* CreateViewHeap(nsStringView sName);
+
+    /// @brief Releases everything that is left in a heap from CreateViewHeap(), in one call if the heap is a view heap.
+    virtual void DestroyViewHeap(nsAllocator* pHeap);
+
+    void SetHeapMode(APCHeapMode mode) { m_HeapMode = mode; }
+    APCHeapMode GetHeapMode() const { return m_HeapMode; }
+
+    /// @brief The budgets that view heaps are counted in, usually V8EEngineMain::GetMemoryBudgets(). Set it before the first view heap is created.
+    void SetMemoryBudgets(APCMemoryBudgets* pBudgets) { m_pMemoryBudgets = pBudgets; }
+
+  private:
+    APCHeapMode m_HeapMode = APCHeapMode::Shared;
+    APCMemoryBudgets* m_pMemoryBudgets = nullptr;
   };
 } // namespace aperture::core
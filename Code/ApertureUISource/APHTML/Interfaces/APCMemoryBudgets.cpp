@@ -0,0 +1,241 @@
+#include <APHTML/Interfaces/APCMemoryBudgets.h>
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Memory/MemoryTracker.h>
+#include <Foundation/Threading/Lock.h>
+#include <Foundation/Utilities/Stats.h>
+
+const char* aperture::core::MemorySubsystemToString(APCMemorySubsystem p_subsystem)
+{
+  switch (p_subsystem)
+  {
+    case APCMemorySubsystem::DOMAndStyle:
+      return "DOM and Style";
+    case APCMemorySubsystem::Layout:
+      return "Layout";
+    case APCMemorySubsystem::TextAndAtlases:
+      return "Text and Atlases";
+    case APCMemorySubsystem::DecodedImages:
+      return "Decoded Images";
+    case APCMemorySubsystem::VideoFrames:
+      return "Video Frames";
+    case APCMemorySubsystem::V8Heap:
+      return "V8 Heap";
+    default:
+      return "Unknown";
+  }
+}
+
+aperture::core::APCMemoryBudgets::APCMemoryBudgets()
+{
+  for (nsUInt32 i = 0; i < static_cast<nsUInt32>(APCMemorySubsystem::Count); ++i)
+  {
+    AddBudget(MemorySubsystemToString(static_cast<APCMemorySubsystem>(i)), 0);
+  }
+}
+
+aperture::core::APCMemoryBudgets::BudgetId aperture::core::APCMemoryBudgets::AddBudget(nsStringView p_sName, nsUInt64 p_uiBudgetBytes)
+{
+  NS_LOCK(m_Mutex);
+  NS_ASSERT_DEV(FindBudget(p_sName) == InvalidBudget, "There is a memory budget '{}' already.", p_sName);
+
+  Budget& budget = m_Budgets.ExpandAndGetRef();
+  budget.m_sName = p_sName;
+  budget.m_uiBudgetBytes = p_uiBudgetBytes;
+  return m_Budgets.GetCount() - 1;
+}
+
+aperture::core::APCMemoryBudgets::BudgetId aperture::core::APCMemoryBudgets::FindBudget(nsStringView p_sName) const
+{
+  NS_LOCK(m_Mutex);
+
+  for (nsUInt32 i = 0; i < m_Budgets.GetCount(); ++i)
+  {
+    if (m_Budgets[i].m_sName == p_sName)
+      return i;
+  }
+
+  return InvalidBudget;
+}
+
+void aperture::core::APCMemoryBudgets::SetBudgetBytes(BudgetId p_budget, nsUInt64 p_uiBudgetBytes)
+{
+  NS_LOCK(m_Mutex);
+  m_Budgets[p_budget].m_uiBudgetBytes = p_uiBudgetBytes;
+}
+
+void aperture::core::APCMemoryBudgets::AddAllocator(BudgetId p_budget, nsAllocatorId p_allocator)
+{
+  NS_LOCK(m_Mutex);
+  m_Budgets[p_budget].m_Allocators.PushBack(p_allocator);
+}
+
+void aperture::core::APCMemoryBudgets::RemoveAllocator(BudgetId p_budget, nsAllocatorId p_allocator)
+{
+  NS_LOCK(m_Mutex);
+  m_Budgets[p_budget].m_Allocators.RemoveAndSwap(p_allocator);
+}
+
+void aperture::core::APCMemoryBudgets::SetUsageCallback(BudgetId p_budget, UsageCallback p_callback)
+{
+  NS_LOCK(m_Mutex);
+  m_Budgets[p_budget].m_UsageCallback = p_callback;
+}
+
+nsUInt32 aperture::core::APCMemoryBudgets::AddEvictionCallback(BudgetId p_budget, nsInt32 p_iPriority, EvictionCallback p_callback)
+{
+  NS_LOCK(m_Mutex);
+
+  EvictionEntry entry;
+  entry.m_uiId = m_uiNextCallbackId++;
+  entry.m_iPriority = p_iPriority;
+  entry.m_Callback = p_callback;
+
+  // kept sorted, callbacks of the same priority are asked in the order they were added
+  auto& callbacks = m_Budgets[p_budget].m_EvictionCallbacks;
+  nsUInt32 uiInsertAt = callbacks.GetCount();
+  while (uiInsertAt > 0 && callbacks[uiInsertAt - 1].m_iPriority > p_iPriority)
+    --uiInsertAt;
+
+  callbacks.InsertAt(uiInsertAt, entry);
+  return entry.m_uiId;
+}
+
+void aperture::core::APCMemoryBudgets::RemoveEvictionCallback(nsUInt32 p_uiCallbackId)
+{
+  // a running Update() may still call the callback from its copy of the budgets
+  NS_LOCK(m_UpdateMutex);
+  NS_LOCK(m_Mutex);
+
+  for (Budget& budget : m_Budgets)
+  {
+    for (nsUInt32 i = 0; i < budget.m_EvictionCallbacks.GetCount(); ++i)
+    {
+      if (budget.m_EvictionCallbacks[i].m_uiId == p_uiCallbackId)
+      {
+        budget.m_EvictionCallbacks.RemoveAtAndCopy(i);
+        return;
+      }
+    }
+  }
+}
+
+bool aperture::core::APCMemoryBudgets::IsEvictionCallbackRegistered(BudgetId p_budget, nsUInt32 p_uiCallbackId) const
+{
+  NS_LOCK(m_Mutex);
+  for (const EvictionEntry& callback : m_Budgets[p_budget].m_EvictionCallbacks)
+  {
+    if (callback.m_uiId == p_uiCallbackId)
+      return true;
+  }
+  return false;
+}
+
+void aperture::core::APCMemoryBudgets::Update()
+{
+  NS_LOCK(m_UpdateMutex);
+
+  // the callbacks run without the lock, so that they may free memory of other budgets or change the registrations
+  nsDynamicArray<Budget> budgets;
+  {
+    NS_LOCK(m_Mutex);
+    budgets = m_Budgets;
+  }
+
+  nsDynamicArray<APCMemoryBudgetReport> report;
+  report.SetCount(budgets.GetCount());
+
+  for (nsUInt32 i = 0; i < budgets.GetCount(); ++i)
+  {
+    const Budget& budget = budgets[i];
+    APCMemoryBudgetReport& entry = report[i];
+
+    entry.m_sName = budget.m_sName;
+    entry.m_uiBudgetBytes = budget.m_uiBudgetBytes;
+
+    for (nsAllocatorId allocator : budget.m_Allocators)
+    {
+      entry.m_uiUsedBytes += nsMemoryTracker::GetAllocatorStats(allocator).m_uiAllocationSize;
+    }
+
+    if (budget.m_UsageCallback.IsValid())
+    {
+      entry.m_uiUsedBytes += budget.m_UsageCallback();
+    }
+
+    if (entry.m_uiBudgetBytes == 0 || entry.m_uiUsedBytes <= entry.m_uiBudgetBytes)
+      continue;
+
+    const nsUInt64 uiExcess = entry.m_uiUsedBytes - entry.m_uiBudgetBytes;
+    for (const EvictionEntry& callback : budget.m_EvictionCallbacks)
+    {
+      if (entry.m_uiEvictedBytes >= uiExcess)
+        break;
+
+      // an earlier callback may have removed it
+      if (!IsEvictionCallbackRegistered(i, callback.m_uiId))
+        continue;
+
+      entry.m_uiEvictedBytes += callback.m_Callback(uiExcess - entry.m_uiEvictedBytes);
+      ++entry.m_uiEvictionCalls;
+    }
+  }
+
+  NS_LOCK(m_Mutex);
+
+  // budgets that were added in the meantime show up in the next report
+  for (nsUInt32 i = 0; i < report.GetCount(); ++i)
+  {
+    Budget& budget = m_Budgets[i];
+    APCMemoryBudgetReport& entry = report[i];
+
+    budget.m_uiPeakBytes = nsMath::Max(budget.m_uiPeakBytes, entry.m_uiUsedBytes);
+    entry.m_uiPeakBytes = budget.m_uiPeakBytes;
+
+    const bool bStillOver = entry.IsOverBudget();
+    if (bStillOver && !budget.m_bWasOverBudget)
+    {
+      nsLog::Warning("Memory budget '{}' exceeded: {} of {}, eviction freed {}.", entry.m_sName, nsArgFileSize(entry.m_uiUsedBytes),
+        nsArgFileSize(entry.m_uiBudgetBytes), nsArgFileSize(entry.m_uiEvictedBytes));
+    }
+    budget.m_bWasOverBudget = bStillOver;
+
+    nsStringBuilder sStat;
+    sStat.SetFormat("APCMemoryBudgets/{0}/Used", entry.m_sName);
+    nsStats::SetStat(sStat, entry.m_uiUsedBytes);
+    sStat.SetFormat("APCMemoryBudgets/{0}/Budget", entry.m_sName);
+    nsStats::SetStat(sStat, entry.m_uiBudgetBytes);
+    sStat.SetFormat("APCMemoryBudgets/{0}/Peak", entry.m_sName);
+    nsStats::SetStat(sStat, entry.m_uiPeakBytes);
+    sStat.SetFormat("APCMemoryBudgets/{0}/Evicted", entry.m_sName);
+    nsStats::SetStat(sStat, entry.m_uiEvictedBytes);
+  }
+
+  m_LastReport.Swap(report);
+}
+
+void aperture::core::APCMemoryBudgets::WriteReport(nsStringBuilder& out_sReport) const
+{
+  NS_LOCK(m_Mutex);
+
+  out_sReport.Clear();
+
+  for (const APCMemoryBudgetReport& entry : m_LastReport)
+  {
+    if (entry.m_uiBudgetBytes > 0)
+    {
+      out_sReport.AppendFormat("{0}: {1} of {2} ({3}%%), peak {4}", entry.m_sName, nsArgFileSize(entry.m_uiUsedBytes), nsArgFileSize(entry.m_uiBudgetBytes),
+        nsArgF(100.0 * entry.m_uiUsedBytes / entry.m_uiBudgetBytes, 0), nsArgFileSize(entry.m_uiPeakBytes));
+    }
+    else
+    {
+      out_sReport.AppendFormat("{0}: {1}, unlimited, peak {2}", entry.m_sName, nsArgFileSize(entry.m_uiUsedBytes), nsArgFileSize(entry.m_uiPeakBytes));
+    }
+
+    if (entry.m_uiEvictionCalls > 0)
+    {
+      out_sReport.AppendFormat(", evicted {0}", nsArgFileSize(entry.m_uiEvictedBytes));
+    }
+
+    out_sReport.Append(entry.IsOverBudget() ? " OVER BUDGET\n" : "\n");
+  }
+}
@@ -0,0 +1,163 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <APHTML/APEngineDLL.h>
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Containers/HybridArray.h>
+#include <Foundation/Memory/Allocator.h>
+#include <Foundation/Strings/String.h>
+#include <Foundation/Threading/Mutex.h>
+#include <Foundation/Types/Delegate.h>
+
+namespace aperture::core
+{
+  /// @brief The UI subsystems that get a memory budget by default.
+  enum class APCMemorySubsystem : nsUInt8
+  {
+    DOMAndStyle,
+    Layout,
+    /// The Harrlow text cache and glyph atlases.
+    TextAndAtlases,
+    DecodedImages,
+    /// Decoded WDVideo frames.
+    VideoFrames,
+    V8Heap,
+    Count
+  };
+
+  NS_APERTURE_DLL const char* MemorySubsystemToString(APCMemorySubsystem p_subsystem);
+
+  /// @brief How one budget did during the last APCMemoryBudgets::Update().
+  struct APCMemoryBudgetReport
+  {
+    nsString m_sName;
+    /// Usage when the frame was measured, before eviction.
+    nsUInt64 m_uiUsedBytes = 0;
+    /// Zero means unlimited.
+    nsUInt64 m_uiBudgetBytes = 0;
+    nsUInt64 m_uiPeakBytes = 0;
+    /// What the eviction callbacks reported to have freed.
+    nsUInt64 m_uiEvictedBytes = 0;
+    nsUInt32 m_uiEvictionCalls = 0;
+
+    /// @brief Whether the budget was still exceeded after eviction.
+    bool IsOverBudget() const { return m_uiBudgetBytes > 0 && m_uiUsedBytes > m_uiBudgetBytes + m_uiEvictedBytes; }
+  };
+
+  /**
+   * @brief Named memory budgets for the UI subsystems, with eviction when a budget is exceeded.
+   *
+   * A budget counts the nsMemoryTracker stats of the allocators added to it, plus what its usage callback reports for memory that
+   * no nsAllocator sees, e.g. the V8 heap or atlas textures. Child allocators that get their memory from an added allocator are
+   * counted by it already and should not be added as well.
+   *
+   * Update() is meant to be called once per frame, from one thread. The engine's instance is updated by V8EEngineMain::EndFrame(),
+   * right after the job system published its frame stats. It measures every budget, and for each one that is over, calls the
+   * eviction callbacks of the budget in priority order until they freed the excess. The results are kept for GetLastReport() and published through nsStats under "APCMemoryBudgets/<name>".
+   */
+  class NS_APERTURE_DLL APCMemoryBudgets
+  {
+  public:
+    using BudgetId = nsUInt32;
+    /// Returns the current usage in bytes.
+    using UsageCallback = nsDelegate<nsUInt64()>;
+    /// Gets the number of bytes the budget is over, frees what it can and returns how many bytes it freed.
+    using EvictionCallback = nsDelegate<nsUInt64(nsUInt64)>;
+
+    static constexpr BudgetId InvalidBudget = 0xFFFFFFFFu;
+
+    /// @brief Adds a budget for every APCMemorySubsystem. They are unlimited until SetBudgetBytes() is called.
+    APCMemoryBudgets();
+
+    BudgetId GetBudget(APCMemorySubsystem p_subsystem) const { return static_cast<BudgetId>(p_subsystem); }
+    BudgetId AddBudget(nsStringView p_sName, nsUInt64 p_uiBudgetBytes);
+    BudgetId FindBudget(nsStringView p_sName) const;
+
+    /// @brief Zero means unlimited.
+    void SetBudgetBytes(BudgetId p_budget, nsUInt64 p_uiBudgetBytes);
+
+    /// @brief Counts an allocator towards the budget. It must be removed again before it is destroyed.
+    void AddAllocator(BudgetId p_budget, nsAllocatorId p_allocator);
+    void RemoveAllocator(BudgetId p_budget, nsAllocatorId p_allocator);
+
+    /// @brief Counts memory that no nsAllocator sees towards the budget.
+    void SetUsageCallback(BudgetId p_budget, UsageCallback p_callback);
+
+    /// @brief Registers a callback that frees memory of the budget. Callbacks with a lower priority are asked first.
+    /// @return An id for RemoveEvictionCallback().
+    nsUInt32 AddEvictionCallback(BudgetId p_budget, nsInt32 p_iPriority, EvictionCallback p_callback);
+    /// @brief Once this returns, the callback is not called anymore. Waits for an Update() on another thread, so an eviction
+    /// callback must not wait for a thread that removes a callback. Removing callbacks from within a callback is fine.
+    void RemoveEvictionCallback(nsUInt32 p_uiCallbackId);
+
+    /// @brief Measures all budgets, evicts from the ones that are over and publishes the report.
+    void Update();
+
+    /// @brief The budgets as measured by the last Update().
+    const nsDynamicArray<APCMemoryBudgetReport>& GetLastReport() const { return m_LastReport; }
+
+    /// @brief Writes the last report as one line per budget, e.g. for a debug overlay or the log.
+    void WriteReport(nsStringBuilder& out_sReport) const;
+
+  private:
+    struct EvictionEntry
+    {
+      nsUInt32 m_uiId = 0;
+      nsInt32 m_iPriority = 0;
+      EvictionCallback m_Callback;
+    };
+
+    struct Budget
+    {
+      nsString m_sName;
+      nsUInt64 m_uiBudgetBytes = 0;
+      nsUInt64 m_uiPeakBytes = 0;
+      bool m_bWasOverBudget = false;
+      nsHybridArray<nsAllocatorId, 4> m_Allocators;
+      UsageCallback m_UsageCallback;
+      nsHybridArray<EvictionEntry, 4> m_EvictionCallbacks;
+    };
+
+    bool IsEvictionCallbackRegistered(BudgetId p_budget, nsUInt32 p_uiCallbackId) const;
+
+    /// Held by Update() while the callbacks run without m_Mutex, always locked before m_Mutex.
+    nsMutex m_UpdateMutex;
+    mutable nsMutex m_Mutex;
+    nsDynamicArray<Budget> m_Budgets;
+    nsUInt32 m_uiNextCallbackId = 1;
+    nsDynamicArray<APCMemoryBudgetReport> m_LastReport;
+  };
+} // namespace aperture::core
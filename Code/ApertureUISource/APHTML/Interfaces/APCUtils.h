@@ -1,4 +1,8 @@
 #pragma once
+
+/// @brief Size of a cache line on every platform APUI ships on. Hot atomics that are written by different threads get padded to this.
+#define APC_CACHE_LINE_SIZE 64
+
 namespace aperture::core
 {
   template <class T>
@@ -0,0 +1,121 @@
+#include <APHTML/Interfaces/APCViewHeap.h>
+#include <Foundation/Memory/MemoryTracker.h>
+
+#include <mimalloc.h>
+
+namespace
+{
+  /// The nsMemoryTracker locks globally, so the heap only reports to it every this many allocations.
+  constexpr nsUInt64 s_uiTrackerUpdateInterval = 4096;
+} // namespace
+
+aperture::core::APCViewHeap::APCViewHeap(nsStringView sName, nsAllocator* pParent)
+  : m_pHeap(mi_heap_new())
+  , m_OwnerThread(nsThreadUtils::GetCurrentThreadID())
+{
+  m_Id = nsMemoryTracker::RegisterAllocator(sName, nsAllocatorTrackingMode::Basics, pParent != nullptr ? pParent->GetId() : nsAllocatorId());
+}
+
+aperture::core::APCViewHeap::~APCViewHeap()
+{
+  NS_ASSERT_DEV(m_OwnerThread == nsThreadUtils::GetCurrentThreadID(), "A view heap must be destroyed by the thread that created it.");
+
+  mi_heap_destroy(m_pHeap);
+  nsMemoryTracker::DeregisterAllocator(m_Id);
+}
+
+void* aperture::core::APCViewHeap::Allocate(size_t uiSize, size_t uiAlign, nsMemoryUtils::DestructorFunction destructorFunc)
+{
+  NS_IGNORE_UNUSED(destructorFunc);
+  NS_ASSERT_DEV(m_OwnerThread == nsThreadUtils::GetCurrentThreadID(), "Only the thread that created a view heap may allocate from it.");
+
+  // zero size allocations always return nullptr without tracking (since deallocate nullptr is ignored)
+  if (uiSize == 0)
+    return nullptr;
+
+  void* pPtr = mi_heap_malloc_aligned(m_pHeap, uiSize, nsMath::Max<size_t>(uiAlign, 1));
+  NS_ASSERT_DEV(pPtr != nullptr, "Could not allocate {0} bytes. Out of memory?", uiSize);
+
+  OnAllocated(mi_usable_size(pPtr));
+  return pPtr;
+}
+
+void aperture::core::APCViewHeap::Deallocate(void* pPtr)
+{
+  if (pPtr == nullptr)
+    return;
+
+  m_uiAllocationSize.fetch_sub(mi_usable_size(pPtr), std::memory_order_relaxed);
+  const nsUInt64 uiNumDeallocations = m_uiNumDeallocations.fetch_add(1, std::memory_order_relaxed) + 1;
+
+  mi_free(pPtr);
+
+  // otherwise a view that mostly frees keeps showing its peak in the tracker
+  if (uiNumDeallocations % s_uiTrackerUpdateInterval == 0)
+  {
+    UpdateTrackerStats();
+  }
+}
+
+void* aperture::core::APCViewHeap::Reallocate(void* pPtr, size_t uiCurrentSize, size_t uiNewSize, size_t uiAlign)
+{
+  NS_IGNORE_UNUSED(uiCurrentSize);
+  NS_ASSERT_DEV(m_OwnerThread == nsThreadUtils::GetCurrentThreadID(), "Only the thread that created a view heap may reallocate from it.");
+
+  if (pPtr == nullptr)
+    return Allocate(uiNewSize, uiAlign);
+
+  const size_t uiOldSize = mi_usable_size(pPtr);
+
+  void* pNewPtr = mi_heap_realloc_aligned(m_pHeap, pPtr, uiNewSize, nsMath::Max<size_t>(uiAlign, 1));
+  NS_ASSERT_DEV(pNewPtr != nullptr, "Could not reallocate {0} bytes. Out of memory?", uiNewSize);
+
+  // counted as a deallocation and a new allocation, like the default nsAllocator::Reallocate()
+  m_uiNumDeallocations.fetch_add(1, std::memory_order_relaxed);
+  m_uiAllocationSize.fetch_sub(uiOldSize, std::memory_order_relaxed);
+  OnAllocated(mi_usable_size(pNewPtr));
+
+  return pNewPtr;
+}
+
+size_t aperture::core::APCViewHeap::AllocatedSize(const void* pPtr)
+{
+  return mi_usable_size(pPtr);
+}
+
+nsAllocator::Stats aperture::core::APCViewHeap::GetStats() const
+{
+  Stats stats;
+  stats.m_uiNumAllocations = m_uiNumAllocations.load(std::memory_order_relaxed);
+  stats.m_uiNumDeallocations = m_uiNumDeallocations.load(std::memory_order_relaxed);
+  stats.m_uiAllocationSize = m_uiAllocationSize.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void aperture::core::APCViewHeap::Reset()
+{
+  NS_ASSERT_DEV(m_OwnerThread == nsThreadUtils::GetCurrentThreadID(), "Only the thread that created a view heap may reset it.");
+
+  mi_heap_destroy(m_pHeap);
+  m_pHeap = mi_heap_new();
+
+  m_uiNumDeallocations.store(m_uiNumAllocations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  m_uiAllocationSize.store(0, std::memory_order_relaxed);
+
+  UpdateTrackerStats();
+}
+
+void aperture::core::APCViewHeap::UpdateTrackerStats()
+{
+  nsMemoryTracker::SetAllocatorStats(m_Id, GetStats());
+}
+
+void aperture::core::APCViewHeap::OnAllocated(size_t uiSize)
+{
+  m_uiAllocationSize.fetch_add(uiSize, std::memory_order_relaxed);
+
+  if ((m_uiNumAllocations.fetch_add(1, std::memory_order_relaxed) + 1) % s_uiTrackerUpdateInterval == 0)
+  {
+    UpdateTrackerStats();
+  }
+}
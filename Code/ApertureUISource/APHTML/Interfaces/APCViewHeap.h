@@ -0,0 +1,91 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <APHTML/APEngineDLL.h>
+#include <Foundation/Memory/Allocator.h>
+#include <Foundation/Threading/ThreadUtils.h>
+
+#include <atomic>
+
+struct mi_heap_s;
+
+namespace aperture::core
+{
+  /**
+   * @brief An allocator with a heap of its own, for everything that lives exactly as long as one view or document.
+   *
+   * DOM, style and layout data of a view is allocated from its heap. When the view is unloaded, Reset() or the destructor
+   * releases all of it in one call, instead of one free per node, rule and box. Destructors do not run then, so only data that
+   * does not own memory elsewhere may be left in the heap.
+   *
+   * The heap is a mimalloc heap. Only the thread that created it may allocate from it, reallocate or reset it. Any thread may
+   * deallocate. The heap is registered with the nsMemoryTracker, its stats are updated there every few thousand allocations
+   * or deallocations and on Reset().
+   */
+  class NS_APERTURE_DLL APCViewHeap : public nsAllocator
+  {
+  public:
+    APCViewHeap(nsStringView sName, nsAllocator* pParent = nullptr);
+    ~APCViewHeap();
+
+    APCViewHeap(const APCViewHeap&) = delete;
+    APCViewHeap& operator=(const APCViewHeap&) = delete;
+
+    virtual void* Allocate(size_t uiSize, size_t uiAlign, nsMemoryUtils::DestructorFunction destructorFunc = nullptr) override;
+    virtual void Deallocate(void* pPtr) override;
+    virtual void* Reallocate(void* pPtr, size_t uiCurrentSize, size_t uiNewSize, size_t uiAlign) override;
+    virtual size_t AllocatedSize(const void* pPtr) override;
+    virtual nsAllocatorId GetId() const override { return m_Id; }
+    virtual Stats GetStats() const override;
+
+    /// @brief Releases every allocation of the heap at once. The heap can be used again afterwards.
+    void Reset();
+
+    /// @brief Writes the current stats to the nsMemoryTracker.
+    void UpdateTrackerStats();
+
+  private:
+    void OnAllocated(size_t uiSize);
+
+    mi_heap_s* m_pHeap = nullptr;
+    nsAllocatorId m_Id;
+    nsThreadID m_OwnerThread;
+
+    std::atomic<nsUInt64> m_uiNumAllocations = 0;
+    std::atomic<nsUInt64> m_uiNumDeallocations = 0;
+    std::atomic<nsUInt64> m_uiAllocationSize = 0;
+  };
+} // namespace aperture::core
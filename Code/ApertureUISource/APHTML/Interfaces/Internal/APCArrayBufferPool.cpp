@@ -0,0 +1,271 @@
+#include <APHTML/Interfaces/Internal/APCArrayBufferPool.h>
+#include <Foundation/Configuration/Startup.h>
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Memory/AllocatorWrapper.h>
+#include <Foundation/Memory/MemoryTracker.h>
+#include <Foundation/System/SystemInformation.h>
+#include <Foundation/Threading/Lock.h>
+#include <Foundation/Threading/Mutex.h>
+
+#if NS_ENABLED(NS_PLATFORM_WINDOWS)
+#  include <Foundation/Platform/Win/Utils/IncludeWindows.h>
+#else
+#  include <sys/mman.h>
+#endif
+
+#include <atomic>
+
+namespace
+{
+  /// The nsMemoryTracker locks globally, so the pool only reports to it every this many allocations.
+  constexpr nsUInt64 s_uiTrackerUpdateInterval = 4096;
+
+  struct ArrayBufferFreeBlock
+  {
+    ArrayBufferFreeBlock* m_pNext;
+  };
+
+  struct ArrayBufferSizeClass
+  {
+    nsMutex m_Mutex;
+    ArrayBufferFreeBlock* m_pFreeList = nullptr;
+    nsUInt8* m_pChunkPos = nullptr;
+    nsUInt8* m_pChunkEnd = nullptr;
+  };
+
+  struct ArrayBufferPoolState
+  {
+    ArrayBufferSizeClass m_Classes[aperture::core::APCArrayBufferPool::NumClasses];
+
+    nsMutex m_ChunkMutex;
+    nsDynamicArray<void*, nsStaticsAllocatorWrapper> m_Chunks;
+
+    std::atomic<nsUInt64> m_uiAllocations = 0;
+    std::atomic<nsUInt64> m_uiDeallocations = 0;
+    std::atomic<nsUInt64> m_uiLiveBytes = 0;
+    std::atomic<nsUInt64> m_uiPooledBytes = 0;
+    std::atomic<nsUInt64> m_uiReservedBytes = 0;
+  };
+
+  ArrayBufferPoolState s_ArrayBufferPool;
+
+  /// Returns the size class of a buffer size, or NumClasses if the buffer gets pages of its own.
+  nsUInt32 GetSizeClass(size_t uiBytes)
+  {
+    using aperture::core::APCArrayBufferPool;
+
+    if (uiBytes <= (size_t(1) << APCArrayBufferPool::MinClassBits))
+      return 0;
+
+    if (uiBytes > (size_t(1) << APCArrayBufferPool::MaxClassBits))
+      return APCArrayBufferPool::NumClasses;
+
+    return nsMath::FirstBitHigh(static_cast<nsUInt64>(uiBytes - 1)) + 1 - APCArrayBufferPool::MinClassBits;
+  }
+
+  size_t GetPageAlignedSize(size_t uiBytes)
+  {
+    return nsMemoryUtils::AlignSize<size_t>(uiBytes, nsSystemInformation::Get().GetMemoryPageSize());
+  }
+
+  /// Fresh pages from the OS are always zeroed, so nothing that comes from here has to be cleared. Returns nullptr if the OS has
+  /// no memory left, V8 turns that into a RangeError.
+  void* AllocateZeroedPages(size_t uiBytes)
+  {
+#if NS_ENABLED(NS_PLATFORM_WINDOWS)
+    void* pPages = ::VirtualAlloc(nullptr, uiBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (pPages == nullptr)
+    {
+      nsLog::Error("Could not allocate {0} bytes of ArrayBuffer pages. Error Code '{1}'", uiBytes, nsArgErrorCode(::GetLastError()));
+      return nullptr;
+    }
+#else
+    void* pPages = mmap(nullptr, uiBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pPages == MAP_FAILED)
+    {
+      nsLog::Error("Could not allocate {0} bytes of ArrayBuffer pages. Out of memory?", uiBytes);
+      return nullptr;
+    }
+#endif
+
+    s_ArrayBufferPool.m_uiReservedBytes.fetch_add(uiBytes, std::memory_order_relaxed);
+    return pPages;
+  }
+
+  void FreePages(void* pPages, size_t uiBytes)
+  {
+#if NS_ENABLED(NS_PLATFORM_WINDOWS)
+    NS_IGNORE_UNUSED(uiBytes);
+    NS_VERIFY(::VirtualFree(pPages, 0, MEM_RELEASE), "Could not free ArrayBuffer pages. Error Code '{0}'", nsArgErrorCode(::GetLastError()));
+#else
+    NS_VERIFY(munmap(pPages, uiBytes) == 0, "Could not free ArrayBuffer pages.");
+#endif
+
+    s_ArrayBufferPool.m_uiReservedBytes.fetch_sub(uiBytes, std::memory_order_relaxed);
+  }
+
+  /// Takes back what Allocate() counted before it knew that it gets no memory.
+  void* OnAllocationFailed(size_t uiBytes)
+  {
+    s_ArrayBufferPool.m_uiAllocations.fetch_sub(1, std::memory_order_relaxed);
+    s_ArrayBufferPool.m_uiLiveBytes.fetch_sub(uiBytes, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  void ReleaseChunks()
+  {
+    // blocks of live buffers are still carved from the chunks
+    if (s_ArrayBufferPool.m_uiLiveBytes.load(std::memory_order_relaxed) != 0)
+      return;
+
+    for (ArrayBufferSizeClass& sizeClass : s_ArrayBufferPool.m_Classes)
+    {
+      NS_LOCK(sizeClass.m_Mutex);
+      sizeClass.m_pFreeList = nullptr;
+      sizeClass.m_pChunkPos = nullptr;
+      sizeClass.m_pChunkEnd = nullptr;
+    }
+
+    NS_LOCK(s_ArrayBufferPool.m_ChunkMutex);
+
+    for (void* pChunk : s_ArrayBufferPool.m_Chunks)
+    {
+      FreePages(pChunk, aperture::core::APCArrayBufferPool::ChunkBytes);
+    }
+
+    s_ArrayBufferPool.m_Chunks.Clear();
+    s_ArrayBufferPool.m_Chunks.Compact();
+    s_ArrayBufferPool.m_uiPooledBytes.store(0, std::memory_order_relaxed);
+  }
+} // namespace
+
+// clang-format off
+NS_BEGIN_SUBSYSTEM_DECLARATION(ApertureUI, ArrayBufferPool)
+
+  BEGIN_SUBSYSTEM_DEPENDENCIES
+    "Foundation"
+  END_SUBSYSTEM_DEPENDENCIES
+
+  ON_CORESYSTEMS_SHUTDOWN
+  {
+    ReleaseChunks();
+  }
+
+NS_END_SUBSYSTEM_DECLARATION;
+// clang-format on
+
+void* aperture::core::APCArrayBufferPool::Allocate(size_t uiBytes)
+{
+  // counted up front, so ReleaseChunks() does not release the chunk a block is carved from right now
+  s_ArrayBufferPool.m_uiLiveBytes.fetch_add(uiBytes, std::memory_order_relaxed);
+
+  if ((s_ArrayBufferPool.m_uiAllocations.fetch_add(1, std::memory_order_relaxed) + 1) % s_uiTrackerUpdateInterval == 0)
+  {
+    UpdateTrackerStats();
+  }
+
+  const nsUInt32 uiClass = GetSizeClass(uiBytes);
+
+  if (uiClass == NumClasses)
+  {
+    void* pPages = AllocateZeroedPages(GetPageAlignedSize(uiBytes));
+    return pPages != nullptr ? pPages : OnAllocationFailed(uiBytes);
+  }
+
+  const size_t uiBlockBytes = size_t(1) << (uiClass + MinClassBits);
+
+  ArrayBufferSizeClass& sizeClass = s_ArrayBufferPool.m_Classes[uiClass];
+  NS_LOCK(sizeClass.m_Mutex);
+
+  if (ArrayBufferFreeBlock* pBlock = sizeClass.m_pFreeList)
+  {
+    sizeClass.m_pFreeList = pBlock->m_pNext;
+    s_ArrayBufferPool.m_uiPooledBytes.fetch_sub(uiBlockBytes, std::memory_order_relaxed);
+
+    // the link is the only part of a free block that is not zero
+    pBlock->m_pNext = nullptr;
+    return pBlock;
+  }
+
+  if (sizeClass.m_pChunkPos == sizeClass.m_pChunkEnd)
+  {
+    void* pChunk = AllocateZeroedPages(ChunkBytes);
+    if (pChunk == nullptr)
+      return OnAllocationFailed(uiBytes);
+
+    {
+      NS_LOCK(s_ArrayBufferPool.m_ChunkMutex);
+      s_ArrayBufferPool.m_Chunks.PushBack(pChunk);
+    }
+
+    sizeClass.m_pChunkPos = static_cast<nsUInt8*>(pChunk);
+    sizeClass.m_pChunkEnd = sizeClass.m_pChunkPos + ChunkBytes;
+  }
+
+  void* pBlock = sizeClass.m_pChunkPos;
+  sizeClass.m_pChunkPos += uiBlockBytes;
+  return pBlock;
+}
+
+void aperture::core::APCArrayBufferPool::Free(void* pBuffer, size_t uiBytes)
+{
+  if (pBuffer == nullptr)
+    return;
+
+  s_ArrayBufferPool.m_uiDeallocations.fetch_add(1, std::memory_order_relaxed);
+  s_ArrayBufferPool.m_uiLiveBytes.fetch_sub(uiBytes, std::memory_order_relaxed);
+
+  const nsUInt32 uiClass = GetSizeClass(uiBytes);
+
+  if (uiClass == NumClasses)
+  {
+    FreePages(pBuffer, GetPageAlignedSize(uiBytes));
+    return;
+  }
+
+  // only the first uiBytes of the block can have been written to, the rest is still zero
+  nsMemoryUtils::ZeroFill(static_cast<nsUInt8*>(pBuffer), uiBytes);
+
+  ArrayBufferFreeBlock* pBlock = static_cast<ArrayBufferFreeBlock*>(pBuffer);
+
+  ArrayBufferSizeClass& sizeClass = s_ArrayBufferPool.m_Classes[uiClass];
+  NS_LOCK(sizeClass.m_Mutex);
+
+  pBlock->m_pNext = sizeClass.m_pFreeList;
+  sizeClass.m_pFreeList = pBlock;
+  s_ArrayBufferPool.m_uiPooledBytes.fetch_add(size_t(1) << (uiClass + MinClassBits), std::memory_order_relaxed);
+}
+
+aperture::core::APCArrayBufferPool::Stats aperture::core::APCArrayBufferPool::GetStats()
+{
+  Stats stats;
+  stats.m_uiAllocations = s_ArrayBufferPool.m_uiAllocations.load(std::memory_order_relaxed);
+  stats.m_uiLiveBuffers = stats.m_uiAllocations - s_ArrayBufferPool.m_uiDeallocations.load(std::memory_order_relaxed);
+  stats.m_uiLiveBytes = s_ArrayBufferPool.m_uiLiveBytes.load(std::memory_order_relaxed);
+  stats.m_uiPooledBytes = s_ArrayBufferPool.m_uiPooledBytes.load(std::memory_order_relaxed);
+  stats.m_uiReservedBytes = s_ArrayBufferPool.m_uiReservedBytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+nsAllocatorId aperture::core::APCArrayBufferPool::GetAllocatorId()
+{
+  static nsAllocatorId id;
+
+  if (id.IsInvalidated())
+  {
+    id = nsMemoryTracker::RegisterAllocator("ArrayBuffers", nsAllocatorTrackingMode::Basics, nsAllocatorId());
+  }
+
+  return id;
+}
+
+void aperture::core::APCArrayBufferPool::UpdateTrackerStats()
+{
+  nsAllocator::Stats stats;
+  stats.m_uiNumAllocations = s_ArrayBufferPool.m_uiAllocations.load(std::memory_order_relaxed);
+  stats.m_uiNumDeallocations = s_ArrayBufferPool.m_uiDeallocations.load(std::memory_order_relaxed);
+  stats.m_uiAllocationSize = s_ArrayBufferPool.m_uiLiveBytes.load(std::memory_order_relaxed);
+
+  nsMemoryTracker::SetAllocatorStats(GetAllocatorId(), stats);
+}
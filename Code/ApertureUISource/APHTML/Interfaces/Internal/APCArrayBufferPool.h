@@ -0,0 +1,84 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+#include <APHTML/APEngineDLL.h>
+#include <Foundation/Memory/Allocator.h>
+
+namespace aperture::core
+{
+  /**
+   * @brief Provides zero-initialized memory for script ArrayBuffers.
+   *
+   * Buffers up to 64 KB come from power-of-two size classes. Each class carves its blocks from page chunks and keeps released
+   * blocks in a free list. Larger buffers get pages of their own straight from the OS and give them back on Free().
+   *
+   * All memory the pool hands out is already zero: fresh pages are zeroed by the OS, and Free() clears the used part of a
+   * block before it goes back into its free list. So Allocate() never has to clear memory. Chunks are only given back on core
+   * system shutdown.
+   *
+   * The pool is registered with the nsMemoryTracker as "ArrayBuffers". All functions are thread-safe.
+   */
+  class NS_APERTURE_DLL APCArrayBufferPool
+  {
+  public:
+    static constexpr nsUInt32 MinClassBits = 4;
+    static constexpr nsUInt32 MaxClassBits = 16;
+    static constexpr nsUInt32 NumClasses = MaxClassBits - MinClassBits + 1;
+    static constexpr size_t ChunkBytes = 256 * 1024;
+
+    struct Stats
+    {
+      nsUInt64 m_uiAllocations = 0;   ///< Number of Allocate() calls.
+      nsUInt64 m_uiLiveBuffers = 0;   ///< Number of buffers that were not freed yet.
+      nsUInt64 m_uiLiveBytes = 0;     ///< Sum of the requested sizes of all live buffers.
+      nsUInt64 m_uiPooledBytes = 0;   ///< Bytes in the free lists of the size classes.
+      nsUInt64 m_uiReservedBytes = 0; ///< Bytes that the pool got from the OS, chunks and large buffers.
+    };
+
+    /// @brief Returns uiBytes of zeroed memory, aligned to at least 16 bytes, or nullptr if the OS has no memory left.
+    static void* Allocate(size_t uiBytes);
+
+    /// @brief Hands a buffer from Allocate() back. uiBytes must be the size that was passed to Allocate().
+    static void Free(void* pBuffer, size_t uiBytes);
+
+    static Stats GetStats();
+
+    static nsAllocatorId GetAllocatorId();
+
+    /// @brief Writes the current stats to the nsMemoryTracker. Done automatically every few thousand allocations.
+    static void UpdateTrackerStats();
+  };
+} // namespace aperture::core
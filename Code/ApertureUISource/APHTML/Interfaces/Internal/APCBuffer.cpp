@@ -0,0 +1,151 @@
+#include <APHTML/Interfaces/Internal/APCBuffer.h>
+#include <Foundation/Configuration/Startup.h>
+#include <Foundation/Threading/Lock.h>
+#include <Foundation/Threading/Mutex.h>
+
+#include <atomic>
+
+namespace
+{
+  struct CoreBufferSizeClass
+  {
+    nsMutex m_Mutex;
+    nsStaticArray<void*, aperture::core::CoreBufferPool::MaxBlocksPerClass> m_Blocks;
+  };
+
+  struct CoreBufferPoolState
+  {
+    CoreBufferSizeClass m_Classes[aperture::core::CoreBufferPool::NumClasses];
+
+    std::atomic<size_t> m_uiCachedBytes = 0;
+    std::atomic<size_t> m_uiMaxCachedBytes = 64 * 1024 * 1024;
+
+    std::atomic<nsUInt64> m_uiAllocations = 0;
+    std::atomic<nsUInt64> m_uiHeapAllocations = 0;
+  };
+
+  CoreBufferPoolState s_CoreBufferPool;
+
+  /// Returns the size class of a block size, or NumClasses if the size is too large to be pooled.
+  nsUInt32 GetSizeClass(size_t uiBytes)
+  {
+    using aperture::core::CoreBufferPool;
+
+    if (uiBytes <= (size_t(1) << CoreBufferPool::MinClassBits))
+      return 0;
+
+    if (uiBytes > (size_t(1) << CoreBufferPool::MaxClassBits))
+      return CoreBufferPool::NumClasses;
+
+    return nsMath::FirstBitHigh(static_cast<nsUInt64>(uiBytes - 1)) + 1 - CoreBufferPool::MinClassBits;
+  }
+} // namespace
+
+// clang-format off
+NS_BEGIN_SUBSYSTEM_DECLARATION(ApertureUI, CoreBufferPool)
+
+  BEGIN_SUBSYSTEM_DEPENDENCIES
+    "Foundation"
+  END_SUBSYSTEM_DEPENDENCIES
+
+  ON_CORESYSTEMS_SHUTDOWN
+  {
+    aperture::core::CoreBufferPool::Trim();
+  }
+
+NS_END_SUBSYSTEM_DECLARATION;
+// clang-format on
+
+void* aperture::core::CoreBufferPool::Allocate(size_t uiBytes, size_t& out_uiBlockBytes)
+{
+  s_CoreBufferPool.m_uiAllocations.fetch_add(1, std::memory_order_relaxed);
+
+  const nsUInt32 uiClass = GetSizeClass(uiBytes);
+
+  if (uiClass < NumClasses)
+  {
+    out_uiBlockBytes = size_t(1) << (uiClass + MinClassBits);
+
+    CoreBufferSizeClass& sizeClass = s_CoreBufferPool.m_Classes[uiClass];
+    NS_LOCK(sizeClass.m_Mutex);
+
+    if (!sizeClass.m_Blocks.IsEmpty())
+    {
+      void* pBlock = sizeClass.m_Blocks.PeekBack();
+      sizeClass.m_Blocks.PopBack();
+
+      s_CoreBufferPool.m_uiCachedBytes.fetch_sub(out_uiBlockBytes, std::memory_order_relaxed);
+      return pBlock;
+    }
+  }
+  else
+  {
+    out_uiBlockBytes = nsMemoryUtils::AlignSize(uiBytes, Alignment);
+  }
+
+  s_CoreBufferPool.m_uiHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+  return nsFoundation::GetAlignedAllocator()->Allocate(out_uiBlockBytes, Alignment);
+}
+
+void aperture::core::CoreBufferPool::Release(void* pBlock, size_t uiBlockBytes)
+{
+  if (pBlock == nullptr)
+    return;
+
+  const nsUInt32 uiClass = GetSizeClass(uiBlockBytes);
+
+  if (uiClass < NumClasses)
+  {
+    NS_ASSERT_DEBUG(uiBlockBytes == (size_t(1) << (uiClass + MinClassBits)), "Released a block with a size that Allocate() did not report.");
+
+    // reserve the budget first, so that concurrent releases cannot exceed it together
+    const size_t uiCachedBytes = s_CoreBufferPool.m_uiCachedBytes.fetch_add(uiBlockBytes, std::memory_order_relaxed);
+
+    if (uiCachedBytes + uiBlockBytes <= s_CoreBufferPool.m_uiMaxCachedBytes.load(std::memory_order_relaxed))
+    {
+      CoreBufferSizeClass& sizeClass = s_CoreBufferPool.m_Classes[uiClass];
+      NS_LOCK(sizeClass.m_Mutex);
+
+      if (sizeClass.m_Blocks.GetCount() < MaxBlocksPerClass)
+      {
+        sizeClass.m_Blocks.PushBack(pBlock);
+        return;
+      }
+    }
+
+    s_CoreBufferPool.m_uiCachedBytes.fetch_sub(uiBlockBytes, std::memory_order_relaxed);
+  }
+
+  nsFoundation::GetAlignedAllocator()->Deallocate(pBlock);
+}
+
+void aperture::core::CoreBufferPool::Trim()
+{
+  for (nsUInt32 uiClass = 0; uiClass < NumClasses; ++uiClass)
+  {
+    CoreBufferSizeClass& sizeClass = s_CoreBufferPool.m_Classes[uiClass];
+    NS_LOCK(sizeClass.m_Mutex);
+
+    for (void* pBlock : sizeClass.m_Blocks)
+    {
+      nsFoundation::GetAlignedAllocator()->Deallocate(pBlock);
+    }
+
+    s_CoreBufferPool.m_uiCachedBytes.fetch_sub(sizeClass.m_Blocks.GetCount() * (size_t(1) << (uiClass + MinClassBits)), std::memory_order_relaxed);
+    sizeClass.m_Blocks.Clear();
+  }
+}
+
+void aperture::core::CoreBufferPool::SetMaxCachedBytes(size_t uiBytes)
+{
+  s_CoreBufferPool.m_uiMaxCachedBytes.store(uiBytes, std::memory_order_relaxed);
+}
+
+aperture::core::CoreBufferPool::Stats aperture::core::CoreBufferPool::GetStats()
+{
+  Stats stats;
+  stats.m_uiAllocations = s_CoreBufferPool.m_uiAllocations.load(std::memory_order_relaxed);
+  stats.m_uiHeapAllocations = s_CoreBufferPool.m_uiHeapAllocations.load(std::memory_order_relaxed);
+  stats.m_uiCachedBytes = s_CoreBufferPool.m_uiCachedBytes.load(std::memory_order_relaxed);
+  return stats;
+}
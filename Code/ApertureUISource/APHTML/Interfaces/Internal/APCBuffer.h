@@ -39,75 +39,254 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <Foundation/Logging/Log.h>
 #include <Foundation/Types/Delegate.h>
 
+#include <type_traits>
+
 namespace aperture::core
 {
   /// NOTE: DEPRECATED DONT USE: Use CoreBuffer Instead.
   using APCBuffer = nsDynamicArray<nsUInt8>;
 
-  template <typename T>
-  class CoreBuffer
+  /**
+   * @brief Recycles the heap blocks of CoreBuffers, so that transient buffers (file contents, decode buffers) can reuse each
+   * other's memory instead of going to the heap every time.
+   *
+   * Blocks are grouped in power-of-two size classes from 256 bytes to 16 MB. Released blocks are kept per size class, up to
+   * MaxBlocksPerClass blocks and SetMaxCachedBytes() bytes in total, and handed out again by the next allocation of the same
+   * class. Larger blocks are never kept. All functions are thread-safe.
+   */
+  class NS_APERTURE_DLL CoreBufferPool
   {
-  protected:
-    T* m_data;
-    size_t m_size;
-
   public:
-    explicit CoreBuffer(size_t initialSize = (size_t)128 * 128 * 1024);
-    // @brief The Righthand side of the operator is the data to copy. this will forcefully copy the data into the buffer and resize it.
-    void operator=(const char* r_data);
-    ~CoreBuffer();
+    static constexpr nsUInt32 MinClassBits = 8;
+    static constexpr nsUInt32 MaxClassBits = 24;
+    static constexpr nsUInt32 NumClasses = MaxClassBits - MinClassBits + 1;
+    static constexpr nsUInt32 MaxBlocksPerClass = 32;
+    static constexpr size_t Alignment = 16;
+
+    struct Stats
+    {
+      nsUInt64 m_uiAllocations = 0;     ///< Number of Allocate() calls.
+      nsUInt64 m_uiHeapAllocations = 0; ///< Number of Allocate() calls that could not be served from the pool.
+      nsUInt64 m_uiCachedBytes = 0;     ///< Bytes that the pool currently keeps for reuse.
+    };
+
+    /// @brief Returns a block of at least uiBytes. out_uiBlockBytes receives the size of the whole block, which is the usable size.
+    static void* Allocate(size_t uiBytes, size_t& out_uiBlockBytes);
+
+    /// @brief Hands a block from Allocate() back. uiBlockBytes must be the block size that Allocate() reported.
+    static void Release(void* pBlock, size_t uiBlockBytes);
 
-    void resize(size_t newSize);
+    /// @brief Frees all blocks that the pool keeps. Happens automatically on core system shutdown.
+    static void Trim();
 
-    T* get(size_t size = size());
+    /// @brief How many bytes the pool may keep in total. 64 MB by default.
+    static void SetMaxCachedBytes(size_t uiBytes);
 
-    size_t size() const;
+    static Stats GetStats();
   };
 
-  template <typename T>
-  inline size_t aperture::core::CoreBuffer<T>::size() const
+  /**
+   * @brief A growable buffer of trivially copyable elements, e.g. file contents or decoded audio and video samples.
+   *
+   * size() is the number of valid elements, capacity() the number of elements that fit without reallocating. Growing at least
+   * doubles the capacity and keeps the contents. New elements are not initialized.
+   *
+   * Up to InlineCapacity elements (64 bytes by default) are stored inside the buffer itself. Larger storage comes from the
+   * CoreBufferPool. Buffers can be moved, but not copied.
+   */
+  template <typename T, size_t InlineCapacity = (sizeof(T) < 64 ? 64 / sizeof(T) : 1)>
+  class CoreBuffer
   {
-    return m_size;
-  }
+    static_assert(std::is_trivially_copyable<T>::value, "CoreBuffer only supports trivially copyable element types.");
+    static_assert(alignof(T) <= CoreBufferPool::Alignment, "CoreBuffer does not support over-aligned element types.");
+    static_assert(InlineCapacity > 0, "The inline capacity must be at least one element.");
 
-  template <typename T>
-  inline T* aperture::core::CoreBuffer<T>::get(size_t size)
-  {
-    if (size > m_size)
-      resize(size);
+  public:
+    CoreBuffer() = default;
 
-    return m_data;
-  }
+    /// @brief Creates a buffer with initialSize uninitialized elements.
+    explicit CoreBuffer(size_t initialSize) { resize(initialSize); }
 
-  template <typename T>
-  inline void CoreBuffer<T>::operator=(const char* r_data)
-  {
-    m_data = r_data;
-    resize(sizeof(r_data));
-  }
+    /// @brief Creates a buffer with a copy of the given elements.
+    CoreBuffer(const T* pData, size_t count) { assign(pData, count); }
 
-  template <typename T>
-  inline aperture::core::CoreBuffer<T>::~CoreBuffer()
-  {
-    if (m_data != nullptr)
-      delete[] m_data;
-  }
-
-  template <typename T>
-  inline aperture::core::CoreBuffer<T>::CoreBuffer(size_t initialSize)
-    : m_data(nullptr)
-    , m_size(0)
-  {
-    resize(initialSize);
-  }
+    CoreBuffer(CoreBuffer&& other) noexcept { MoveFrom(other); }
 
-  template <typename T>
-  inline void aperture::core::CoreBuffer<T>::resize(size_t newSize)
-  {
-    if (m_data != nullptr)
-      delete[] m_data;
+    CoreBuffer& operator=(CoreBuffer&& other) noexcept
+    {
+      if (this != &other)
+      {
+        FreeStorage();
+        MoveFrom(other);
+      }
+      return *this;
+    }
+
+    CoreBuffer(const CoreBuffer&) = delete;
+    CoreBuffer& operator=(const CoreBuffer&) = delete;
+
+    ~CoreBuffer() { FreeStorage(); }
+
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+
+    T* data() { return m_pHeap != nullptr ? m_pHeap : reinterpret_cast<T*>(m_inline); }
+    const T* data() const { return m_pHeap != nullptr ? m_pHeap : reinterpret_cast<const T*>(m_inline); }
+
+    T* get() { return data(); }
+
+    /// @brief Grows the buffer to at least minSize elements, if necessary, and returns its data.
+    T* get(size_t minSize)
+    {
+      if (minSize > m_size)
+        resize(minSize);
+
+      return data();
+    }
+
+    T& operator[](size_t index)
+    {
+      NS_ASSERT_DEBUG(index < m_size, "CoreBuffer index {} is out of range ({} elements).", index, m_size);
+      return data()[index];
+    }
+
+    const T& operator[](size_t index) const
+    {
+      NS_ASSERT_DEBUG(index < m_size, "CoreBuffer index {} is out of range ({} elements).", index, m_size);
+      return data()[index];
+    }
 
-    m_data = new T[newSize];
-    m_size = newSize;
-  }
+    T* begin() { return data(); }
+    T* end() { return data() + m_size; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + m_size; }
+
+    nsArrayPtr<T> GetArrayPtr() { return nsArrayPtr<T>(data(), static_cast<nsUInt32>(m_size)); }
+    nsArrayPtr<const T> GetArrayPtr() const { return nsArrayPtr<const T>(data(), static_cast<nsUInt32>(m_size)); }
+
+    /// @brief Changes the number of valid elements. Existing elements are kept, new ones are not initialized.
+    void resize(size_t newSize)
+    {
+      if (newSize > m_capacity)
+      {
+        Reallocate(newSize > m_capacity * 2 ? newSize : m_capacity * 2);
+      }
+
+      m_size = newSize;
+    }
+
+    /// @brief Makes room for at least newCapacity elements without changing the size.
+    void reserve(size_t newCapacity)
+    {
+      if (newCapacity > m_capacity)
+      {
+        Reallocate(newCapacity);
+      }
+    }
+
+    /// @brief Sets the size to zero, but keeps the storage.
+    void clear() { m_size = 0; }
+
+    /// @brief Hands storage that is not needed for the current size back to the pool.
+    void shrink_to_fit()
+    {
+      if (m_pHeap == nullptr)
+        return;
+
+      if (m_size <= InlineCapacity)
+      {
+        T* pHeap = m_pHeap;
+        const size_t blockBytes = m_blockBytes;
+
+        nsMemoryUtils::RawByteCopy(m_inline, pHeap, m_size * sizeof(T));
+        m_pHeap = nullptr;
+        m_blockBytes = 0;
+        m_capacity = InlineCapacity;
+
+        CoreBufferPool::Release(pHeap, blockBytes);
+      }
+      else if (m_size * sizeof(T) <= m_blockBytes / 2)
+      {
+        Reallocate(m_size);
+      }
+    }
+
+    /// @brief Replaces the contents with a copy of the given elements.
+    void assign(const T* pData, size_t count)
+    {
+      m_size = 0;
+      resize(count);
+      nsMemoryUtils::RawByteCopy(data(), pData, count * sizeof(T));
+    }
+
+    /// @brief Appends a copy of the given elements.
+    void append(const T* pData, size_t count)
+    {
+      const size_t oldSize = m_size;
+      resize(oldSize + count);
+      nsMemoryUtils::RawByteCopy(data() + oldSize, pData, count * sizeof(T));
+    }
+
+  private:
+    void Reallocate(size_t newCapacity)
+    {
+      size_t blockBytes = 0;
+      T* pNewHeap = static_cast<T*>(CoreBufferPool::Allocate(newCapacity * sizeof(T), blockBytes));
+
+      if (m_pHeap != nullptr)
+      {
+        nsMemoryUtils::RawByteCopy(pNewHeap, m_pHeap, m_size * sizeof(T));
+        FreeStorage();
+      }
+      else
+      {
+        // the new block is always larger than the inline storage
+        nsMemoryUtils::RawByteCopy(pNewHeap, m_inline, sizeof(m_inline));
+      }
+
+      m_pHeap = pNewHeap;
+      m_blockBytes = blockBytes;
+      m_capacity = blockBytes / sizeof(T);
+    }
+
+    void FreeStorage()
+    {
+      if (m_pHeap != nullptr)
+      {
+        CoreBufferPool::Release(m_pHeap, m_blockBytes);
+        m_pHeap = nullptr;
+        m_blockBytes = 0;
+        m_capacity = InlineCapacity;
+      }
+    }
+
+    void MoveFrom(CoreBuffer& other)
+    {
+      m_size = other.m_size;
+
+      if (other.m_pHeap != nullptr)
+      {
+        m_pHeap = other.m_pHeap;
+        m_blockBytes = other.m_blockBytes;
+        m_capacity = other.m_capacity;
+
+        other.m_pHeap = nullptr;
+        other.m_blockBytes = 0;
+        other.m_capacity = InlineCapacity;
+      }
+      else
+      {
+        nsMemoryUtils::RawByteCopy(m_inline, other.m_inline, sizeof(m_inline));
+      }
+
+      other.m_size = 0;
+    }
+
+    T* m_pHeap = nullptr;
+    size_t m_size = 0;
+    size_t m_capacity = InlineCapacity;
+    size_t m_blockBytes = 0;
+    alignas(T) nsUInt8 m_inline[InlineCapacity * sizeof(T)];
+  };
 } // namespace aperture::core
@@ -0,0 +1,47 @@
+#include <APHTML/Interfaces/Internal/APCConcurrentObjectPool.h>
+
+namespace
+{
+  struct ObjectPoolThreadSlots
+  {
+    nsMutex m_Mutex;
+    nsUInt64 m_uiUsedSlots = 0;
+  };
+
+  ObjectPoolThreadSlots s_ObjectPoolThreadSlots;
+
+  static_assert(aperture::core::APCObjectPoolThreadSlot::MaxSlots <= 64, "The used slots are a 64 bit mask.");
+
+  /// Takes a slot on the first call and gives it back when the thread exits.
+  struct ObjectPoolThreadSlotHolder
+  {
+    ObjectPoolThreadSlotHolder()
+    {
+      NS_LOCK(s_ObjectPoolThreadSlots.m_Mutex);
+
+      const nsUInt64 uiFreeSlots = ~s_ObjectPoolThreadSlots.m_uiUsedSlots;
+      if (uiFreeSlots != 0)
+      {
+        m_uiSlot = nsMath::FirstBitLow(uiFreeSlots);
+        s_ObjectPoolThreadSlots.m_uiUsedSlots |= nsUInt64(1) << m_uiSlot;
+      }
+    }
+
+    ~ObjectPoolThreadSlotHolder()
+    {
+      if (m_uiSlot == aperture::core::APCObjectPoolThreadSlot::InvalidSlot)
+        return;
+
+      NS_LOCK(s_ObjectPoolThreadSlots.m_Mutex);
+      s_ObjectPoolThreadSlots.m_uiUsedSlots &= ~(nsUInt64(1) << m_uiSlot);
+    }
+
+    nsUInt32 m_uiSlot = aperture::core::APCObjectPoolThreadSlot::InvalidSlot;
+  };
+} // namespace
+
+nsUInt32 aperture::core::APCObjectPoolThreadSlot::Get()
+{
+  thread_local ObjectPoolThreadSlotHolder tl_Holder;
+  return tl_Holder.m_uiSlot;
+}
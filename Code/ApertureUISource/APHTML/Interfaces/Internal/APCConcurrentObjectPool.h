@@ -0,0 +1,552 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+#include <APHTML/APEngineDLL.h>
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Threading/ConditionalLock.h>
+#include <Foundation/Threading/Lock.h>
+#include <Foundation/Threading/Mutex.h>
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace aperture::core
+{
+  /**
+   * @brief Gives every thread that uses an APCConcurrentObjectPool a small index, which selects the thread's caches in all pools.
+   *
+   * A slot is released when its thread exits and taken over by the next thread that asks for one, together with the caches.
+   */
+  struct NS_APERTURE_DLL APCObjectPoolThreadSlot
+  {
+    static constexpr nsUInt32 MaxSlots = 64;
+    static constexpr nsUInt32 InvalidSlot = 0xFFFFFFFFu;
+
+    /// @brief Returns the slot of the calling thread, or InvalidSlot if all slots are taken.
+    static nsUInt32 Get();
+  };
+
+  /**
+   * @brief A thread-safe ObjectPool for objects that are created and deleted on several threads, e.g. DOM nodes, events and
+   * layout nodes touched by different Runtypes.
+   *
+   * Memory is allocated in nodes of SlotsPerNode objects. Free objects are kept in magazines of MagazineSize objects: every thread
+   * has two of them and only goes to the shared depot, which locks, when both are empty (or full). Threads beyond
+   * APCObjectPoolThreadSlot::MaxSlots always use the depot. Trim() returns nodes without live objects to the allocator.
+   *
+   * Every object has a generation that changes when it is deleted. A Handle remembers it, Get() returns nullptr once the object
+   * is gone. In debug builds deleting an object twice asserts and deleted objects are overwritten.
+   *
+   * @note Trim() must not run at the same time as Get() with a handle of a deleted object.
+   */
+  template <typename T, nsUInt32 SlotsPerNode = 256, nsUInt32 MagazineSize = 32>
+  class APCConcurrentObjectPool
+  {
+    static_assert(SlotsPerNode % MagazineSize == 0, "SlotsPerNode must be a multiple of MagazineSize.");
+
+  public:
+    struct Handle
+    {
+      nsUInt32 m_uiIndex = 0xFFFFFFFFu;
+      nsUInt32 m_uiGeneration = 0;
+
+      bool IsInvalidated() const { return m_uiIndex == 0xFFFFFFFFu; }
+      bool operator==(const Handle& other) const { return m_uiIndex == other.m_uiIndex && m_uiGeneration == other.m_uiGeneration; }
+      bool operator!=(const Handle& other) const { return !(*this == other); }
+    };
+
+    struct Stats
+    {
+      /// Objects that are allocated right now.
+      nsUInt64 m_uiLiveObjects = 0;
+      /// The most objects that were alive at once. Sampled whenever a thread exchanges a magazine with the depot, so it can miss
+      /// up to two magazines per thread.
+      nsUInt64 m_uiPeakObjects = 0;
+      nsUInt32 m_uiNumNodes = 0;
+      nsUInt64 m_uiCapacity = 0;
+    };
+
+    /// @param uiMaxObjects The pool never holds more objects than this, rounded up to whole nodes.
+    explicit APCConcurrentObjectPool(nsUInt32 uiMaxObjects = 1024 * 1024, nsAllocator* pAllocator = nsFoundation::GetAlignedAllocator())
+      : m_pAllocator(pAllocator)
+      , m_uiMaxNodes((uiMaxObjects + SlotsPerNode - 1) / SlotsPerNode)
+      , m_FullMagazines(pAllocator)
+      , m_EmptyMagazines(pAllocator)
+    {
+      m_pNodes = NS_NEW_ARRAY(m_pAllocator, NodeEntry, m_uiMaxNodes).GetPtr();
+    }
+
+    /// @brief Releases all memory. Objects that are still alive are not destructed.
+    ~APCConcurrentObjectPool()
+    {
+      for (nsUInt32 uiSlot = 0; uiSlot < APCObjectPoolThreadSlot::MaxSlots; ++uiSlot)
+      {
+        if (Cache* pCache = m_Caches[uiSlot].load(std::memory_order_acquire))
+        {
+          ReleaseCache(*pCache);
+          NS_DELETE(m_pAllocator, pCache);
+        }
+      }
+
+      ReleaseCache(m_SharedCache);
+
+      for (Magazine* pMagazine : m_FullMagazines)
+        NS_DELETE(m_pAllocator, pMagazine);
+      for (Magazine* pMagazine : m_EmptyMagazines)
+        NS_DELETE(m_pAllocator, pMagazine);
+
+      for (nsUInt32 uiNode = 0; uiNode < m_uiNodeHighWater; ++uiNode)
+      {
+        if (Slot* pSlots = m_pNodes[uiNode].m_pSlots.load(std::memory_order_relaxed))
+          m_pAllocator->Deallocate(pSlots);
+      }
+
+      nsArrayPtr<NodeEntry> nodes(m_pNodes, m_uiMaxNodes);
+      NS_DELETE_ARRAY(m_pAllocator, nodes);
+    }
+
+    APCConcurrentObjectPool(const APCConcurrentObjectPool&) = delete;
+    APCConcurrentObjectPool& operator=(const APCConcurrentObjectPool&) = delete;
+
+    /// @brief Returns a new object, or nullptr if the pool is full.
+    template <typename... Args>
+    T* New(Args&&... args)
+    {
+      void* pMemory = GetNextWithoutInitializing();
+      return pMemory != nullptr ? new (pMemory) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    void Delete(T* pObject)
+    {
+      pObject->~T();
+      DeleteWithoutDestroying(pObject);
+    }
+
+    /// @brief Deletes the object of a handle. The handle must not be stale.
+    void Delete(const Handle& handle)
+    {
+      T* pObject = Get(handle);
+      NS_ASSERT_DEV(pObject != nullptr, "The object of this handle was deleted already.");
+
+      if (pObject != nullptr)
+        Delete(pObject);
+    }
+
+    /// @brief Returns uninitialized memory for one object, or nullptr if the pool is full. Used with placement new.
+    T* GetNextWithoutInitializing()
+    {
+      Slot* pSlot = nullptr;
+
+      if (Cache* pCache = GetThreadCache())
+      {
+        pSlot = AllocateSlot(*pCache, true);
+
+        if (pSlot != nullptr)
+          pCache->m_iLiveDelta.store(pCache->m_iLiveDelta.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      }
+      else
+      {
+        NS_LOCK(m_DepotMutex);
+        pSlot = AllocateSlot(m_SharedCache, false);
+
+        if (pSlot != nullptr)
+          UpdatePeak(++m_iLiveObjects);
+      }
+
+      NS_ASSERT_DEV(pSlot != nullptr, "The object pool is full ({} objects).", m_uiMaxNodes * SlotsPerNode);
+      if (pSlot == nullptr)
+        return nullptr;
+
+      const nsUInt32 uiGeneration = pSlot->m_uiGeneration.load(std::memory_order_relaxed);
+      NS_ASSERT_DEBUG((uiGeneration & 1) == 0, "The object pool handed out an object that is alive.");
+      pSlot->m_uiGeneration.store(uiGeneration + 1, std::memory_order_release);
+
+      return reinterpret_cast<T*>(pSlot->m_Storage);
+    }
+
+    void DeleteWithoutDestroying(T* pObject)
+    {
+      Slot* pSlot = GetSlot(pObject);
+
+      const nsUInt32 uiGeneration = pSlot->m_uiGeneration.load(std::memory_order_relaxed);
+      NS_ASSERT_DEBUG((uiGeneration & 1) != 0, "The object was deleted twice.");
+      pSlot->m_uiGeneration.store(uiGeneration + 1, std::memory_order_release);
+
+#if NS_ENABLED(NS_COMPILE_FOR_DEBUG)
+      nsMemoryUtils::PatternFill(pSlot->m_Storage, 0xCD, sizeof(T));
+#endif
+
+      if (Cache* pCache = GetThreadCache())
+      {
+        FreeSlot(*pCache, pSlot, true);
+        pCache->m_iLiveDelta.store(pCache->m_iLiveDelta.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+      }
+      else
+      {
+        NS_LOCK(m_DepotMutex);
+        FreeSlot(m_SharedCache, pSlot, false);
+        --m_iLiveObjects;
+      }
+    }
+
+    Handle GetHandle(const T* pObject) const
+    {
+      const Slot* pSlot = GetSlot(const_cast<T*>(pObject));
+
+      Handle handle;
+      handle.m_uiIndex = pSlot->m_uiIndex;
+      handle.m_uiGeneration = pSlot->m_uiGeneration.load(std::memory_order_acquire);
+      return handle;
+    }
+
+    /// @brief Returns the object of a handle, or nullptr if it was deleted.
+    T* Get(const Handle& handle) const
+    {
+      const nsUInt32 uiNode = handle.m_uiIndex / SlotsPerNode;
+      if (uiNode >= m_uiMaxNodes)
+        return nullptr;
+
+      Slot* pSlots = m_pNodes[uiNode].m_pSlots.load(std::memory_order_acquire);
+      if (pSlots == nullptr)
+        return nullptr;
+
+      Slot& slot = pSlots[handle.m_uiIndex % SlotsPerNode];
+      if (slot.m_uiGeneration.load(std::memory_order_acquire) != handle.m_uiGeneration)
+        return nullptr;
+
+      return reinterpret_cast<T*>(slot.m_Storage);
+    }
+
+    /// @brief Returns the free objects that the calling thread caches to the depot, e.g. before the thread goes idle for longer.
+    void FlushThreadCache()
+    {
+      const nsUInt32 uiThreadSlot = APCObjectPoolThreadSlot::Get();
+      if (uiThreadSlot == APCObjectPoolThreadSlot::InvalidSlot)
+        return;
+
+      if (Cache* pCache = m_Caches[uiThreadSlot].load(std::memory_order_acquire))
+      {
+        NS_LOCK(m_DepotMutex);
+        FlushCache(*pCache);
+      }
+    }
+
+    /// @brief Returns every node whose objects are all free, and all spare magazines, to the allocator.
+    ///
+    /// Only free objects in the depot count, objects cached by other threads keep their node alive.
+    void Trim()
+    {
+      NS_LOCK(m_DepotMutex);
+
+      FlushCache(m_SharedCache);
+
+      nsDynamicArray<nsUInt32> freeCounts;
+      freeCounts.SetCount(m_uiNodeHighWater);
+
+      for (Magazine* pMagazine : m_FullMagazines)
+      {
+        for (nsUInt32 i = 0; i < pMagazine->m_uiCount; ++i)
+          ++freeCounts[pMagazine->m_Slots[i]->m_uiIndex / SlotsPerNode];
+      }
+
+      // keep the free objects of the other nodes
+      for (nsUInt32 uiMagazine = m_FullMagazines.GetCount(); uiMagazine-- > 0;)
+      {
+        Magazine* pMagazine = m_FullMagazines[uiMagazine];
+
+        nsUInt32 uiKept = 0;
+        for (nsUInt32 i = 0; i < pMagazine->m_uiCount; ++i)
+        {
+          if (freeCounts[pMagazine->m_Slots[i]->m_uiIndex / SlotsPerNode] != SlotsPerNode)
+            pMagazine->m_Slots[uiKept++] = pMagazine->m_Slots[i];
+        }
+
+        pMagazine->m_uiCount = uiKept;
+
+        if (uiKept == 0)
+        {
+          m_FullMagazines.RemoveAtAndSwap(uiMagazine);
+          m_EmptyMagazines.PushBack(pMagazine);
+        }
+      }
+
+      for (nsUInt32 uiNode = 0; uiNode < m_uiNodeHighWater; ++uiNode)
+      {
+        if (freeCounts[uiNode] != SlotsPerNode)
+          continue;
+
+        NodeEntry& node = m_pNodes[uiNode];
+        Slot* pSlots = node.m_pSlots.load(std::memory_order_relaxed);
+
+        // a node that is created at this index later must not accept the handles of this one
+        for (nsUInt32 i = 0; i < SlotsPerNode; ++i)
+          node.m_uiNextGeneration = nsMath::Max(node.m_uiNextGeneration, pSlots[i].m_uiGeneration.load(std::memory_order_relaxed) + 2);
+
+        node.m_pSlots.store(nullptr, std::memory_order_release);
+        m_pAllocator->Deallocate(pSlots);
+        --m_uiNumNodes;
+      }
+
+      for (Magazine* pMagazine : m_EmptyMagazines)
+        NS_DELETE(m_pAllocator, pMagazine);
+
+      m_EmptyMagazines.Clear();
+      m_EmptyMagazines.Compact();
+    }
+
+    Stats GetStats() const
+    {
+      NS_LOCK(m_DepotMutex);
+
+      nsInt64 iLiveObjects = m_iLiveObjects;
+      for (nsUInt32 uiSlot = 0; uiSlot < APCObjectPoolThreadSlot::MaxSlots; ++uiSlot)
+      {
+        if (const Cache* pCache = m_Caches[uiSlot].load(std::memory_order_acquire))
+          iLiveObjects += pCache->m_iLiveDelta.load(std::memory_order_relaxed);
+      }
+
+      Stats stats;
+      stats.m_uiLiveObjects = static_cast<nsUInt64>(nsMath::Max<nsInt64>(iLiveObjects, 0));
+      stats.m_uiPeakObjects = nsMath::Max(m_uiPeakObjects, stats.m_uiLiveObjects);
+      stats.m_uiNumNodes = m_uiNumNodes;
+      stats.m_uiCapacity = static_cast<nsUInt64>(m_uiNumNodes) * SlotsPerNode;
+      return stats;
+    }
+
+  private:
+    struct Slot
+    {
+      /// Even while the object is free, odd while it is alive.
+      std::atomic<nsUInt32> m_uiGeneration;
+      nsUInt32 m_uiIndex;
+      alignas(T) nsUInt8 m_Storage[sizeof(T)];
+    };
+
+    struct NodeEntry
+    {
+      std::atomic<Slot*> m_pSlots = nullptr;
+      nsUInt32 m_uiNextGeneration = 0;
+    };
+
+    struct Magazine
+    {
+      nsUInt32 m_uiCount = 0;
+      Slot* m_Slots[MagazineSize];
+    };
+
+    struct alignas(64) Cache
+    {
+      Magazine* m_pLoaded = nullptr;
+      Magazine* m_pPrevious = nullptr;
+
+      /// Objects allocated minus objects deleted through this cache, since it last went to the depot. Only the owning thread writes it.
+      std::atomic<nsInt64> m_iLiveDelta = 0;
+    };
+
+    static Slot* GetSlot(T* pObject) { return reinterpret_cast<Slot*>(reinterpret_cast<nsUInt8*>(pObject) - offsetof(Slot, m_Storage)); }
+
+    Cache* GetThreadCache()
+    {
+      const nsUInt32 uiThreadSlot = APCObjectPoolThreadSlot::Get();
+      if (uiThreadSlot == APCObjectPoolThreadSlot::InvalidSlot)
+        return nullptr;
+
+      Cache* pCache = m_Caches[uiThreadSlot].load(std::memory_order_acquire);
+      if (pCache == nullptr)
+      {
+        // only the thread that owns the slot creates its cache
+        pCache = NS_NEW(m_pAllocator, Cache);
+        m_Caches[uiThreadSlot].store(pCache, std::memory_order_release);
+      }
+
+      return pCache;
+    }
+
+    Slot* AllocateSlot(Cache& cache, bool bLockDepot)
+    {
+      if (cache.m_pLoaded == nullptr || cache.m_pLoaded->m_uiCount == 0)
+      {
+        if (cache.m_pPrevious != nullptr && cache.m_pPrevious->m_uiCount > 0)
+        {
+          std::swap(cache.m_pLoaded, cache.m_pPrevious);
+        }
+        else
+        {
+          nsConditionalLock<nsMutex> lock(m_DepotMutex, bLockDepot);
+          FoldStats(cache);
+
+          if (m_FullMagazines.IsEmpty() && !CreateNode())
+            return nullptr;
+
+          if (cache.m_pPrevious != nullptr)
+            m_EmptyMagazines.PushBack(cache.m_pPrevious);
+
+          cache.m_pPrevious = cache.m_pLoaded;
+          cache.m_pLoaded = m_FullMagazines.PeekBack();
+          m_FullMagazines.PopBack();
+        }
+      }
+
+      Magazine* pMagazine = cache.m_pLoaded;
+      return pMagazine->m_Slots[--pMagazine->m_uiCount];
+    }
+
+    void FreeSlot(Cache& cache, Slot* pSlot, bool bLockDepot)
+    {
+      if (cache.m_pLoaded == nullptr || cache.m_pLoaded->m_uiCount == MagazineSize)
+      {
+        if (cache.m_pPrevious != nullptr && cache.m_pPrevious->m_uiCount < MagazineSize)
+        {
+          std::swap(cache.m_pLoaded, cache.m_pPrevious);
+        }
+        else
+        {
+          nsConditionalLock<nsMutex> lock(m_DepotMutex, bLockDepot);
+          FoldStats(cache);
+
+          if (cache.m_pPrevious != nullptr)
+            m_FullMagazines.PushBack(cache.m_pPrevious);
+
+          cache.m_pPrevious = cache.m_pLoaded;
+          cache.m_pLoaded = GetEmptyMagazine();
+        }
+      }
+
+      Magazine* pMagazine = cache.m_pLoaded;
+      pMagazine->m_Slots[pMagazine->m_uiCount++] = pSlot;
+    }
+
+    /// Depot must be locked.
+    Magazine* GetEmptyMagazine()
+    {
+      if (m_EmptyMagazines.IsEmpty())
+        return NS_NEW(m_pAllocator, Magazine);
+
+      Magazine* pMagazine = m_EmptyMagazines.PeekBack();
+      m_EmptyMagazines.PopBack();
+      return pMagazine;
+    }
+
+    /// Depot must be locked. Adds the objects of a new node to the depot.
+    bool CreateNode()
+    {
+      nsUInt32 uiNode = 0;
+      while (uiNode < m_uiNodeHighWater && m_pNodes[uiNode].m_pSlots.load(std::memory_order_relaxed) != nullptr)
+        ++uiNode;
+
+      if (uiNode == m_uiMaxNodes)
+        return false;
+
+      m_uiNodeHighWater = nsMath::Max(m_uiNodeHighWater, uiNode + 1);
+
+      Slot* pSlots = static_cast<Slot*>(m_pAllocator->Allocate(sizeof(Slot) * SlotsPerNode, nsMath::Max<size_t>(alignof(Slot), 64)));
+
+      NodeEntry& node = m_pNodes[uiNode];
+      for (nsUInt32 i = 0; i < SlotsPerNode; ++i)
+      {
+        new (&pSlots[i].m_uiGeneration) std::atomic<nsUInt32>(node.m_uiNextGeneration);
+        pSlots[i].m_uiIndex = uiNode * SlotsPerNode + i;
+      }
+
+      // filled backwards, so that the objects are handed out in address order
+      for (nsUInt32 uiFirst = SlotsPerNode; uiFirst > 0; uiFirst -= MagazineSize)
+      {
+        Magazine* pMagazine = GetEmptyMagazine();
+        for (nsUInt32 i = uiFirst; i-- > uiFirst - MagazineSize;)
+          pMagazine->m_Slots[pMagazine->m_uiCount++] = &pSlots[i];
+
+        m_FullMagazines.PushBack(pMagazine);
+      }
+
+      node.m_pSlots.store(pSlots, std::memory_order_release);
+      ++m_uiNumNodes;
+      return true;
+    }
+
+    /// Depot must be locked.
+    void FlushCache(Cache& cache)
+    {
+      FoldStats(cache);
+
+      for (Magazine* pMagazine : {cache.m_pLoaded, cache.m_pPrevious})
+      {
+        if (pMagazine == nullptr)
+          continue;
+
+        if (pMagazine->m_uiCount > 0)
+          m_FullMagazines.PushBack(pMagazine);
+        else
+          m_EmptyMagazines.PushBack(pMagazine);
+      }
+
+      cache.m_pLoaded = nullptr;
+      cache.m_pPrevious = nullptr;
+    }
+
+    /// Depot must be locked.
+    void FoldStats(Cache& cache)
+    {
+      m_iLiveObjects += cache.m_iLiveDelta.load(std::memory_order_relaxed);
+      cache.m_iLiveDelta.store(0, std::memory_order_relaxed);
+
+      UpdatePeak(m_iLiveObjects);
+    }
+
+    void UpdatePeak(nsInt64 iLiveObjects) { m_uiPeakObjects = nsMath::Max(m_uiPeakObjects, static_cast<nsUInt64>(nsMath::Max<nsInt64>(iLiveObjects, 0))); }
+
+    void ReleaseCache(Cache& cache)
+    {
+      NS_DELETE(m_pAllocator, cache.m_pLoaded);
+      NS_DELETE(m_pAllocator, cache.m_pPrevious);
+    }
+
+    nsAllocator* m_pAllocator;
+    const nsUInt32 m_uiMaxNodes;
+    NodeEntry* m_pNodes = nullptr;
+
+    std::atomic<Cache*> m_Caches[APCObjectPoolThreadSlot::MaxSlots] = {};
+
+    mutable nsMutex m_DepotMutex;
+    nsDynamicArray<Magazine*> m_FullMagazines;
+    nsDynamicArray<Magazine*> m_EmptyMagazines;
+    Cache m_SharedCache;
+    nsUInt32 m_uiNumNodes = 0;
+    nsUInt32 m_uiNodeHighWater = 0;
+    nsInt64 m_iLiveObjects = 0;
+    nsUInt64 m_uiPeakObjects = 0;
+  };
+} // namespace aperture::core
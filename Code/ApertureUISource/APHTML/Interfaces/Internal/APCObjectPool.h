@@ -9,13 +9,14 @@ namespace aperture::core
   public:
     static inline void* Allocate(size_t size)
     {
-      return nsFoundation::GetAlignedAllocator()->Allocate(size,0u);
+      return nsFoundation::GetAlignedAllocator()->Allocate(size, alignof(T) > sizeof(void*) ? alignof(T) : sizeof(void*));
     }
     static inline void Deallocate(void* pointer, size_t size)
     {
-      ::operator delete(pointer);
+      nsFoundation::GetAlignedAllocator()->Deallocate(pointer);
     }
   };
+  /// @brief Single-threaded object pool. Use APCConcurrentObjectPool for objects that several threads create and delete.
   template <typename T, class TMemoryAllocator = InternalMemoryAllocator<T>>
   class ObjectPool
   {
@@ -32,6 +32,7 @@
 #  include <set>
 #  include <stdexcept>
 #  include <string>
+#  include <type_traits>
 
 /// A node in the tree, combining links to other nodes as well as the actual data.
 template <class T>
@@ -127,6 +128,7 @@ public:
   class leaf_iterator;
 
   tree();         // empty constructor
+  explicit tree(const tree_node_allocator&); // empty constructor, nodes come from the given allocator
   tree(const T&); // constructor setting given element as head
   tree(const iterator_base&);
   tree(const tree<T, tree_node_allocator>&); // copy constructor
@@ -135,6 +137,11 @@ public:
   tree<T, tree_node_allocator>& operator=(const tree<T, tree_node_allocator>&); // copy assignment
   tree<T, tree_node_allocator>& operator=(tree<T, tree_node_allocator>&&);      // move assignment
 
+  /// The allocator the nodes come from.
+  tree_node_allocator get_allocator() const;
+  /// Moves all nodes to the given allocator. Copies the elements unless both allocators compare equal.
+  void set_allocator(const tree_node_allocator&);
+
   /// Base class for iterators, only pointers stored, no traversal logic.
 #  ifdef __SGI_STL_PORT
   class iterator_base : public stlport::bidirectional_iterator<T, ptrdiff_t>
@@ -362,6 +369,9 @@ public:
 
   /// Erase all nodes of the tree.
   void clear();
+  /// Detach all nodes from the tree without deallocating them, for allocators that release all of their memory at once afterwards.
+  /// The elements are only destroyed if they are not trivially destructible.
+  void release();
   /// Erase element at position pointed to by iterator, return incremented iterator.
   template <typename iter>
   iter erase(iter);
@@ -561,6 +571,7 @@ private:
   tree_node_allocator alloc_;
   void head_initialise_();
   void copy_(const tree<T, tree_node_allocator>& other);
+  void release_children_(tree_node* node);
 
   /// Comparator class for two nodes of a tree (used for sorting and searching).
   template <class StrictWeakOrdering>
@@ -628,6 +639,13 @@ tree<T, tree_node_allocator>::tree()
   head_initialise_();
 }
 
+template <class T, class tree_node_allocator>
+tree<T, tree_node_allocator>::tree(const tree_node_allocator& alloc)
+  : alloc_(alloc)
+{
+  head_initialise_();
+}
+
 template <class T, class tree_node_allocator>
 tree<T, tree_node_allocator>::tree(const T& x)
 {
@@ -637,6 +655,7 @@ tree<T, tree_node_allocator>::tree(const T& x)
 
 template <class T, class tree_node_allocator>
 tree<T, tree_node_allocator>::tree(tree<T, tree_node_allocator>&& x)
+  : alloc_(x.alloc_)
 {
   head_initialise_();
   if (x.head->next_sibling != x.feet)
@@ -702,6 +721,13 @@ tree<T, tree_node_allocator>& tree<T, tree_node_allocator>::operator=(tree<T, tr
 {
   if (this != &x)
   {
+    if (!(alloc_ == x.alloc_))
+    { // the nodes cannot change hands between allocators
+      copy_(x);
+      x.clear();
+      return *this;
+    }
+
     clear(); // clear any existing data.
 
     head->next_sibling = x.head->next_sibling;
@@ -714,6 +740,28 @@ tree<T, tree_node_allocator>& tree<T, tree_node_allocator>::operator=(tree<T, tr
   return *this;
 }
 
+template <class T, class tree_node_allocator>
+tree_node_allocator tree<T, tree_node_allocator>::get_allocator() const
+{
+  return alloc_;
+}
+
+template <class T, class tree_node_allocator>
+void tree<T, tree_node_allocator>::set_allocator(const tree_node_allocator& alloc)
+{
+  tree<T, tree_node_allocator> other(alloc);
+  other = std::move(*this);
+
+  std::allocator_traits<decltype(alloc_)>::destroy(alloc_, head);
+  std::allocator_traits<decltype(alloc_)>::destroy(alloc_, feet);
+  std::allocator_traits<decltype(alloc_)>::deallocate(alloc_, head, 1);
+  std::allocator_traits<decltype(alloc_)>::deallocate(alloc_, feet, 1);
+
+  alloc_ = alloc;
+  head_initialise_();
+  *this = std::move(other);
+}
+
 template <class T, class tree_node_allocator>
 tree<T, tree_node_allocator>::tree(const tree<T, tree_node_allocator>& other)
 {
@@ -752,6 +800,38 @@ void tree<T, tree_node_allocator>::clear()
       erase(pre_order_iterator(head->next_sibling));
 }
 
+template <class T, class tree_node_allocator>
+void tree<T, tree_node_allocator>::release()
+{
+  if constexpr (!std::is_trivially_destructible_v<tree_node>)
+  {
+    tree_node* cur = head->next_sibling;
+    while (cur != feet)
+    {
+      tree_node* next = cur->next_sibling;
+      release_children_(cur);
+      std::allocator_traits<decltype(alloc_)>::destroy(alloc_, cur);
+      cur = next;
+    }
+  }
+
+  head->next_sibling = feet;
+  feet->prev_sibling = head;
+}
+
+template <class T, class tree_node_allocator>
+void tree<T, tree_node_allocator>::release_children_(tree_node* node)
+{
+  tree_node* cur = node->first_child;
+  while (cur != 0)
+  {
+    tree_node* next = cur->next_sibling;
+    release_children_(cur);
+    std::allocator_traits<decltype(alloc_)>::destroy(alloc_, cur);
+    cur = next;
+  }
+}
+
 template <class T, class tree_node_allocator>
 void tree<T, tree_node_allocator>::erase_children(const iterator_base& it)
 {
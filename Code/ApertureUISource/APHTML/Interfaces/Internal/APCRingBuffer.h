@@ -0,0 +1,221 @@
+#pragma once
+#include <APHTML/APEngineCommonIncludes.h>
+#include <APHTML/Interfaces/APCUtils.h>
+
+#include <atomic>
+#include <utility>
+
+namespace aperture::core
+{
+  /**
+   * @brief Fixed-capacity lock-free ring buffer for exactly one producer and one consumer thread.
+   *
+   * Use this for pairs like a decoder and its reader. Each side caches the other side's index, so a push or pop only touches
+   * the other side's cache line when the buffer looks full or empty.
+   *
+   * @note The capacity is rounded up to the next power of two. Several threads may act as the producer (or consumer) over time,
+   * as long as they are serialized externally, e.g. by a mutex.
+   */
+  template <typename T>
+  class SPSCRingBuffer
+  {
+  public:
+    explicit SPSCRingBuffer(size_t capacity)
+    {
+      const nsUInt64 uiCapacity = nsMath::PowerOfTwo_Ceil(static_cast<nsUInt64>(nsMath::Max<size_t>(capacity, 1)));
+      m_mask = static_cast<size_t>(uiCapacity - 1);
+      m_slots = NS_DEFAULT_NEW_ARRAY(T, static_cast<nsUInt32>(uiCapacity));
+    }
+
+    ~SPSCRingBuffer() { NS_DEFAULT_DELETE_ARRAY(m_slots); }
+
+    SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+    SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+    /// @brief Producer only. Returns false if the buffer is full.
+    template <typename U>
+    bool try_push(U&& val)
+    {
+      const size_t tail = m_tail.load(std::memory_order_relaxed);
+      if (tail - m_cachedHead > m_mask)
+      {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        if (tail - m_cachedHead > m_mask)
+          return false;
+      }
+
+      m_slots[static_cast<nsUInt32>(tail & m_mask)] = std::forward<U>(val);
+      m_tail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    /// @brief Consumer only. Returns false if the buffer is empty.
+    bool try_pop(T& out_val)
+    {
+      const size_t head = m_head.load(std::memory_order_relaxed);
+      if (!HasItem(head))
+        return false;
+
+      out_val = std::move(m_slots[static_cast<nsUInt32>(head & m_mask)]);
+      m_head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    /// @brief Consumer only. Copies the oldest element without removing it. Returns false if the buffer is empty.
+    bool try_front(T& out_val)
+    {
+      const size_t head = m_head.load(std::memory_order_relaxed);
+      if (!HasItem(head))
+        return false;
+
+      out_val = m_slots[static_cast<nsUInt32>(head & m_mask)];
+      return true;
+    }
+
+    /// @brief Only exact while neither side is active.
+    size_t size_approx() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+    bool empty_approx() const { return size_approx() == 0; }
+    size_t capacity() const { return m_mask + 1; }
+
+  private:
+    bool HasItem(size_t head)
+    {
+      if (head == m_cachedTail)
+      {
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        return head != m_cachedTail;
+      }
+      return true;
+    }
+
+    nsArrayPtr<T> m_slots;
+    size_t m_mask = 0;
+
+    // Consumer side.
+    alignas(APC_CACHE_LINE_SIZE) std::atomic<size_t> m_head = 0;
+    size_t m_cachedTail = 0;
+
+    // Producer side.
+    alignas(APC_CACHE_LINE_SIZE) std::atomic<size_t> m_tail = 0;
+    size_t m_cachedHead = 0;
+
+    // Keeps whatever follows the buffer in memory off the producer's cache line.
+    alignas(APC_CACHE_LINE_SIZE) char m_tailPadding = 0;
+  };
+
+  /**
+   * @brief Fixed-capacity lock-free ring buffer for any number of producers and consumers.
+   *
+   * Every slot carries a sequence number that tells producers and consumers whose turn it is (Vyukov's bounded queue), so
+   * try_push and try_pop each cost a single CAS on their own index and never block.
+   *
+   * @note The capacity is rounded up to the next power of two, and is at least 2.
+   */
+  template <typename T>
+  class MPMCRingBuffer
+  {
+  public:
+    explicit MPMCRingBuffer(size_t capacity)
+    {
+      const nsUInt64 uiCapacity = nsMath::PowerOfTwo_Ceil(static_cast<nsUInt64>(nsMath::Max<size_t>(capacity, 2)));
+      m_mask = static_cast<size_t>(uiCapacity - 1);
+      m_cells = NS_DEFAULT_NEW_ARRAY(Cell, static_cast<nsUInt32>(uiCapacity));
+      for (size_t i = 0; i < uiCapacity; ++i)
+      {
+        m_cells[static_cast<nsUInt32>(i)].m_sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    ~MPMCRingBuffer() { NS_DEFAULT_DELETE_ARRAY(m_cells); }
+
+    MPMCRingBuffer(const MPMCRingBuffer&) = delete;
+    MPMCRingBuffer& operator=(const MPMCRingBuffer&) = delete;
+
+    /// @brief Returns false if the buffer is full.
+    template <typename U>
+    bool try_push(U&& val)
+    {
+      size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+      Cell* pCell = nullptr;
+      while (true)
+      {
+        pCell = &m_cells[static_cast<nsUInt32>(pos & m_mask)];
+        const size_t seq = pCell->m_sequence.load(std::memory_order_acquire);
+        const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0)
+        {
+          if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if (diff < 0)
+        {
+          return false;
+        }
+        else
+        {
+          pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+      }
+
+      pCell->m_data = std::forward<U>(val);
+      pCell->m_sequence.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    /// @brief Returns false if the buffer is empty.
+    bool try_pop(T& out_val)
+    {
+      size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+      Cell* pCell = nullptr;
+      while (true)
+      {
+        pCell = &m_cells[static_cast<nsUInt32>(pos & m_mask)];
+        const size_t seq = pCell->m_sequence.load(std::memory_order_acquire);
+        const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+        if (diff == 0)
+        {
+          if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if (diff < 0)
+        {
+          return false;
+        }
+        else
+        {
+          pos = m_dequeuePos.load(std::memory_order_relaxed);
+        }
+      }
+
+      out_val = std::move(pCell->m_data);
+      pCell->m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+      return true;
+    }
+
+    /// @brief Only exact while nobody pushes or pops.
+    size_t size_approx() const
+    {
+      const size_t enqueuePos = m_enqueuePos.load(std::memory_order_acquire);
+      const size_t dequeuePos = m_dequeuePos.load(std::memory_order_acquire);
+      return enqueuePos >= dequeuePos ? enqueuePos - dequeuePos : 0;
+    }
+    bool empty_approx() const { return size_approx() == 0; }
+    size_t capacity() const { return m_mask + 1; }
+
+  private:
+    struct Cell
+    {
+      std::atomic<size_t> m_sequence = 0;
+      T m_data = T();
+    };
+
+    nsArrayPtr<Cell> m_cells;
+    size_t m_mask = 0;
+
+    alignas(APC_CACHE_LINE_SIZE) std::atomic<size_t> m_enqueuePos = 0;
+    alignas(APC_CACHE_LINE_SIZE) std::atomic<size_t> m_dequeuePos = 0;
+
+    // Keeps whatever follows the buffer in memory off the consumers' cache line.
+    alignas(APC_CACHE_LINE_SIZE) char m_tailPadding = 0;
+  };
+} // namespace aperture::core
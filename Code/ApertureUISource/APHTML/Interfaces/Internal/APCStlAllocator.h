@@ -0,0 +1,86 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+#include <APHTML/APEngineDLL.h>
+#include <Foundation/Memory/Allocator.h>
+
+namespace aperture::core
+{
+  /**
+   * @brief Lets standard containers and std::allocate_shared() allocate from an nsAllocator, e.g. a document's view heap.
+   *
+   * Copies share the nsAllocator. Two instances are equal if they use the same nsAllocator, so containers only move nodes
+   * between each other if both allocate from the same heap. Defaults to the nsFoundation default allocator.
+   */
+  template <typename T>
+  class APCStlAllocator
+  {
+  public:
+    using value_type = T;
+
+    APCStlAllocator() = default;
+    explicit APCStlAllocator(nsAllocator* pAllocator)
+      : m_pAllocator(pAllocator)
+    {
+    }
+
+    template <typename U>
+    APCStlAllocator(const APCStlAllocator<U>& other)
+      : m_pAllocator(other.GetAllocator())
+    {
+    }
+
+    T* allocate(size_t uiCount) { return static_cast<T*>(m_pAllocator->Allocate(uiCount * sizeof(T), alignof(T))); }
+    void deallocate(T* pPtr, size_t) { m_pAllocator->Deallocate(pPtr); }
+
+    nsAllocator* GetAllocator() const { return m_pAllocator; }
+
+    template <typename U>
+    bool operator==(const APCStlAllocator<U>& other) const
+    {
+      return m_pAllocator == other.GetAllocator();
+    }
+
+    template <typename U>
+    bool operator!=(const APCStlAllocator<U>& other) const
+    {
+      return m_pAllocator != other.GetAllocator();
+    }
+
+  private:
+    nsAllocator* m_pAllocator = nsFoundation::GetDefaultAllocator();
+  };
+} // namespace aperture::core
@@ -23,6 +23,18 @@ namespace aperture::core
       m_queue.push(val);
     }
 
+    /// @brief Pops the front element in one locked step. Prefer this over size()/front()/pop(), which race against other consumers.
+    bool try_pop(T& out_val)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_queue.empty())
+        return false;
+
+      out_val = std::move(m_queue.front());
+      m_queue.pop();
+      return true;
+    }
+
     void pop()
     {
       std::lock_guard<std::mutex> lock(m_mutex);
@@ -0,0 +1,165 @@
+#include <APHTML/Multithreading/APCAsyncJob.h>
+#include <APHTML/Multithreading/APCJobSystem.h>
+#include <Foundation/IO/OSFile.h>
+#include <Foundation/Threading/TaskSystem.h>
+
+namespace aperture::core::threading
+{
+  void APCAsyncEvent::Signal()
+  {
+    nsHybridArray<APCAsyncJob*, 4> waiters;
+    {
+      NS_LOCK(m_Mutex);
+      m_bSignaled.store(true, std::memory_order_release);
+      waiters = m_Waiters;
+      m_Waiters.Clear();
+    }
+
+    // Outside the lock, a resumed job may wait on this event again right away.
+    for (APCAsyncJob* pJob : waiters)
+    {
+      pJob->Resubmit();
+    }
+  }
+
+  void APCAsyncEvent::Reset()
+  {
+    NS_LOCK(m_Mutex);
+    m_bSignaled.store(false, std::memory_order_release);
+  }
+
+  bool APCAsyncEvent::AddWaiter(APCAsyncJob* pJob)
+  {
+    NS_LOCK(m_Mutex);
+    if (m_bSignaled.load(std::memory_order_relaxed))
+      return false;
+
+    m_Waiters.PushBack(pJob);
+    return true;
+  }
+
+  void APCAsyncEvent::SignalOnCompletion(IAPCCommandQueue& p_queue, APCAsyncEvent& p_event)
+  {
+    p_queue.SetCompletionCallback([](IAPCCommandQueue&, nsTime, void* pUserData)
+      { static_cast<APCAsyncEvent*>(pUserData)->Signal(); }, &p_event);
+  }
+
+  APCAsyncJob::APCAsyncJob(core::CommandType p_type, core::Runtype p_runtype)
+    : m_List(m_Queue)
+    , m_Command(p_type, p_runtype)
+  {
+    m_Queue.SetType(p_type);
+    m_Queue.SetRunType(p_runtype);
+    m_List.SetType(p_type);
+    m_List.SetRunType(p_runtype);
+    m_List.AddCommand(m_Command);
+    m_Command.SetFunction([this]()
+      { Step(); });
+    m_Queue.AddCommandList(m_List);
+    m_Queue.SetCompletionCallback(&APCAsyncJob::OnQueueCompleted, this);
+
+    // A job that never ran counts as finished, so awaiting it doesn't hang.
+    m_Finished.Signal();
+
+    m_pReadTask = NS_DEFAULT_NEW(nsDelegateTask<void>, "APCAsyncJob File Read", nsTaskNesting::Never, [this]()
+      {
+      nsOSFile file;
+      if (file.Open(m_sReadFile, nsFileOpenMode::Read).Failed())
+      {
+        *m_pReadResult = NS_FAILURE;
+        return;
+      }
+      m_pReadData->Clear();
+      file.ReadAll(*m_pReadData);
+      *m_pReadResult = NS_SUCCESS; });
+
+    // Signaled from the finish callback, so the task is done with and can be started again by the resumed job.
+    m_pReadTask->ConfigureTask("APCAsyncJob File Read", nsTaskNesting::Never, [this](const nsSharedPtr<nsTask>&)
+      { m_ReadFinished.Signal(); });
+  }
+
+  APCAsyncJob::~APCAsyncJob()
+  {
+    NS_ASSERT_DEV(!m_bRunning.load(), "An async job was destroyed while it was still running.");
+  }
+
+  nsResult APCAsyncJob::Start(APCJobSystem& p_jobSystem)
+  {
+    if (m_bRunning.exchange(true))
+    {
+      nsLog::Error("Cannot start an async job of type {0} that is still running.", CommandTypeToString(m_Queue.GetType()));
+      return NS_FAILURE;
+    }
+
+    m_pJobSystem = &p_jobSystem;
+    m_uiResumeCount.store(0, std::memory_order_relaxed);
+    m_Finished.Reset();
+    OnStart();
+
+    m_pJobSystem->AddJob(m_Queue);
+    return NS_SUCCESS;
+  }
+
+  APCAsyncStep APCAsyncJob::AwaitFileRead(nsStringView p_sFile, nsDynamicArray<nsUInt8>& out_data, nsResult& out_result)
+  {
+    m_sReadFile = p_sFile;
+    m_pReadData = &out_data;
+    m_pReadResult = &out_result;
+    m_ReadFinished.Reset();
+
+    // All file reads share nsTaskSystem's file access thread, the job's own worker moves on to the next job.
+    nsTaskSystem::StartSingleTask(m_pReadTask, nsTaskPriority::FileAccess);
+    return Await(m_ReadFinished);
+  }
+
+  void APCAsyncJob::Step()
+  {
+    m_LastStep = Resume();
+    m_bStepped = true;
+    m_uiResumeCount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void APCAsyncJob::OnQueueCompleted(IAPCCommandQueue& queue, nsTime executionTime, void* pUserData)
+  {
+    NS_IGNORE_UNUSED(queue);
+    NS_IGNORE_UNUSED(executionTime);
+
+    // The queue is idle again here, so whatever resumes the job can submit it right away.
+    APCAsyncJob& job = *static_cast<APCAsyncJob*>(pUserData);
+    const bool bCanceled = !job.m_bStepped;
+    job.m_bStepped = false;
+
+    if (!bCanceled)
+    {
+      switch (job.m_LastStep.m_Type)
+      {
+        case APCAsyncStep::Type::Yield:
+          job.Resubmit();
+          return;
+
+        case APCAsyncStep::Type::AwaitNextFrame:
+          job.m_pJobSystem->AddFrameWaiter(&job);
+          return;
+
+        case APCAsyncStep::Type::Await:
+          if (!job.m_LastStep.m_pEvent->AddWaiter(&job))
+          {
+            job.Resubmit();
+          }
+          return;
+
+        case APCAsyncStep::Type::Done:
+          break;
+      }
+    }
+
+    // Done, or skipped because the queue got canceled.
+    job.m_bRunning.store(false);
+    job.m_Finished.Signal();
+  }
+
+  void APCAsyncJob::Resubmit()
+  {
+    m_pJobSystem->AddJob(m_Queue);
+  }
+} // namespace aperture::core::threading
@@ -0,0 +1,191 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <APHTML/APEngineDLL.h>
+#include <APHTML/APEngineCommonIncludes.h>
+#include <APHTML/CommandExecutor/IAPCCommand.h>
+#include <APHTML/CommandExecutor/IAPCCommandList.h>
+#include <APHTML/CommandExecutor/IAPCCommandQueue.h>
+#include <Foundation/Threading/DelegateTask.h>
+#include <Foundation/Threading/Mutex.h>
+
+#include <atomic>
+
+namespace aperture::core::threading
+{
+  class APCAsyncJob;
+  class APCJobSystem;
+
+  /**
+   * @brief Something an APCAsyncJob can wait for without holding on to a worker thread.
+   *
+   * Signal() resubmits every job that waits for the event. The event stays signaled until Reset(), a job that starts waiting
+   * on a signaled event continues right away.
+   */
+  class NS_APERTURE_DLL APCAsyncEvent
+  {
+  public:
+    APCAsyncEvent() = default;
+
+    APCAsyncEvent(const APCAsyncEvent&) = delete;
+    APCAsyncEvent& operator=(const APCAsyncEvent&) = delete;
+
+    void Signal();
+    void Reset();
+    bool IsSignaled() const { return m_bSignaled.load(std::memory_order_acquire); }
+
+    /// @brief Signals p_event every time p_queue finished. Takes over the queue's completion callback.
+    static void SignalOnCompletion(IAPCCommandQueue& p_queue, APCAsyncEvent& p_event);
+
+  private:
+    friend class APCAsyncJob;
+
+    /// @brief Returns false if the event is signaled already, the job was not added then.
+    bool AddWaiter(APCAsyncJob* pJob);
+
+    nsMutex m_Mutex;
+    std::atomic<bool> m_bSignaled = false;
+    nsHybridArray<APCAsyncJob*, 4> m_Waiters;
+  };
+
+  /// @brief What an APCAsyncJob wants to do after a call to Resume().
+  struct APCAsyncStep
+  {
+    enum class Type : nsUInt8
+    {
+      /// The job is finished.
+      Done,
+      /// Resume once m_pEvent is signaled.
+      Await,
+      /// Resume once the job system passed the next frame boundary.
+      AwaitNextFrame,
+      /// Let the other jobs of the pool run, then resume.
+      Yield,
+    };
+
+    Type m_Type = Type::Done;
+    APCAsyncEvent* m_pEvent = nullptr;
+  };
+
+  /**
+   * @class APCAsyncJob
+   * @brief A job that suspends while it waits, instead of blocking the worker that runs it.
+   *
+   * Resume() is called on a thread of the job's Runtype and runs until the job has to wait for something, e.g. a file read,
+   * another job or the next frame. It returns what it waits for, and the job is submitted again to the same pool once that
+   * happened. In between the job takes no thread at all, so a small pool can keep many loads in flight.
+   *
+   * This is a coroutine written by hand: the job keeps its own state across calls, usually an index for a switch.
+   * @code
+   *   APCAsyncStep Resume() override
+   *   {
+   *     switch (m_uiState++)
+   *     {
+   *       case 0: return AwaitFileRead(m_sPath, m_Data, m_ReadResult);
+   *       case 1: Parse(m_Data); return AwaitNextFrame();
+   *       default: return Done();
+   *     }
+   *   }
+   * @endcode
+   *
+   * @note The job has to stay alive until IsFinished(). APCJobSystem::Wait() does not wait for suspended jobs.
+   */
+  class NS_APERTURE_DLL APCAsyncJob
+  {
+  public:
+    APCAsyncJob(core::CommandType p_type, core::Runtype p_runtype);
+    virtual ~APCAsyncJob();
+
+    APCAsyncJob(const APCAsyncJob&) = delete;
+    APCAsyncJob& operator=(const APCAsyncJob&) = delete;
+
+    /// @brief Submits the job. Fails if it is still running from a previous start.
+    nsResult Start(APCJobSystem& p_jobSystem);
+
+    bool IsFinished() const { return m_Finished.IsSignaled(); }
+
+    /// @brief Signaled when the job is done, another job can Await() it.
+    APCAsyncEvent& GetFinishedEvent() { return m_Finished; }
+
+    /// @brief How often the job was resumed since its last start.
+    nsUInt32 GetResumeCount() const { return m_uiResumeCount.load(std::memory_order_relaxed); }
+
+    IAPCCommandQueue& GetQueue() { return m_Queue; }
+
+  protected:
+    /// @brief Runs the job until it has to wait. Called on a thread of the job's Runtype.
+    virtual APCAsyncStep Resume() = 0;
+
+    /// @brief Called by Start() before the first Resume(), to reset the job's own state.
+    virtual void OnStart() {}
+
+    static APCAsyncStep Done() { return {APCAsyncStep::Type::Done, nullptr}; }
+    static APCAsyncStep Yield() { return {APCAsyncStep::Type::Yield, nullptr}; }
+    static APCAsyncStep AwaitNextFrame() { return {APCAsyncStep::Type::AwaitNextFrame, nullptr}; }
+    static APCAsyncStep Await(APCAsyncEvent& p_event) { return {APCAsyncStep::Type::Await, &p_event}; }
+    static APCAsyncStep Await(APCAsyncJob& p_job) { return Await(p_job.GetFinishedEvent()); }
+
+    /// @brief Reads a whole file on nsTaskSystem's file access thread and resumes once it is read.
+    /// @note Only one read per job can be in flight, the outputs have to stay alive until the job resumes.
+    APCAsyncStep AwaitFileRead(nsStringView p_sFile, nsDynamicArray<nsUInt8>& out_data, nsResult& out_result);
+
+  private:
+    friend class APCAsyncEvent;
+    friend class APCJobSystem;
+
+    void Step();
+    static void OnQueueCompleted(IAPCCommandQueue& queue, nsTime executionTime, void* pUserData);
+    void Resubmit();
+
+    IAPCCommandQueue m_Queue;
+    IAPCCommandList m_List;
+    IAPCCommand m_Command;
+
+    APCJobSystem* m_pJobSystem = nullptr;
+    APCAsyncStep m_LastStep;
+    bool m_bStepped = false;
+    std::atomic<bool> m_bRunning = false;
+    std::atomic<nsUInt32> m_uiResumeCount = 0;
+    APCAsyncEvent m_Finished;
+
+    nsSharedPtr<nsDelegateTask<void>> m_pReadTask;
+    APCAsyncEvent m_ReadFinished;
+    nsString m_sReadFile;
+    nsDynamicArray<nsUInt8>* m_pReadData = nullptr;
+    nsResult* m_pReadResult = nullptr;
+  };
+} // namespace aperture::core::threading
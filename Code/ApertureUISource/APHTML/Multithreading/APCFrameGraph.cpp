@@ -0,0 +1,423 @@
+#include <APHTML/Multithreading/APCFrameGraph.h>
+
+#include <Foundation/Containers/Set.h>
+
+namespace aperture::core::threading
+{
+  APCFrameGraph::~APCFrameGraph()
+  {
+    if (!IsFrameFinished())
+    {
+      Wait();
+    }
+    Reset();
+  }
+
+  APCFrameGraph::NodeIndex APCFrameGraph::AddGroup(CommandGroup& p_group)
+  {
+    m_bCompiled = false;
+
+    Node& node = m_Nodes.ExpandAndGetRef();
+    node.m_pGroup = &p_group;
+    return m_Nodes.GetCount() - 1;
+  }
+
+  void APCFrameGraph::AddDependency(NodeIndex p_before, NodeIndex p_after)
+  {
+    if (p_before >= m_Nodes.GetCount() || p_after >= m_Nodes.GetCount() || p_before == p_after)
+    {
+      nsLog::Error("Invalid frame graph dependency {0} -> {1}.", p_before, p_after);
+      return;
+    }
+
+    m_bCompiled = false;
+    m_Edges.PushBack({p_before, p_after});
+  }
+
+  nsResult APCFrameGraph::Compile()
+  {
+    if (!IsFrameFinished())
+    {
+      nsLog::Error("Cannot compile a frame graph while a frame is running.");
+      return NS_FAILURE;
+    }
+
+    m_bCompiled = false;
+    UnbindQueues();
+
+    const nsUInt32 uiNumNodes = m_Nodes.GetCount();
+
+    // Flatten the edges into one successor array, each node owns a contiguous range of it.
+    for (Node& node : m_Nodes)
+    {
+      node.m_uiSuccessorCount = 0;
+      node.m_uiInputCount = 0;
+    }
+    for (const Edge& edge : m_Edges)
+    {
+      m_Nodes[edge.m_Before].m_uiSuccessorCount++;
+      m_Nodes[edge.m_After].m_uiInputCount++;
+    }
+
+    nsUInt32 uiFirstSuccessor = 0;
+    for (Node& node : m_Nodes)
+    {
+      node.m_uiFirstSuccessor = uiFirstSuccessor;
+      uiFirstSuccessor += node.m_uiSuccessorCount;
+      node.m_uiSuccessorCount = 0;
+    }
+
+    m_Successors.SetCountUninitialized(m_Edges.GetCount());
+    for (const Edge& edge : m_Edges)
+    {
+      Node& before = m_Nodes[edge.m_Before];
+      m_Successors[before.m_uiFirstSuccessor + before.m_uiSuccessorCount++] = edge.m_After;
+    }
+
+    // Kahn's algorithm, anything that is left over sits on a cycle.
+    nsDynamicArray<nsUInt32> pendingInputs;
+    pendingInputs.SetCountUninitialized(uiNumNodes);
+    m_TopologicalOrder.Clear();
+    m_TopologicalOrder.Reserve(uiNumNodes);
+    for (NodeIndex i = 0; i < uiNumNodes; ++i)
+    {
+      pendingInputs[i] = m_Nodes[i].m_uiInputCount;
+      if (pendingInputs[i] == 0)
+      {
+        m_TopologicalOrder.PushBack(i);
+      }
+    }
+
+    for (nsUInt32 uiCursor = 0; uiCursor < m_TopologicalOrder.GetCount(); ++uiCursor)
+    {
+      const Node& node = m_Nodes[m_TopologicalOrder[uiCursor]];
+      for (nsUInt32 i = 0; i < node.m_uiSuccessorCount; ++i)
+      {
+        const NodeIndex successor = m_Successors[node.m_uiFirstSuccessor + i];
+        if (--pendingInputs[successor] == 0)
+        {
+          m_TopologicalOrder.PushBack(successor);
+        }
+      }
+    }
+
+    if (m_TopologicalOrder.GetCount() != uiNumNodes)
+    {
+      for (NodeIndex i = 0; i < uiNumNodes; ++i)
+      {
+        if (pendingInputs[i] != 0)
+        {
+          nsLog::Error("Frame graph has a cycle through group '{0}'.", m_Nodes[i].m_pGroup->m_sGroupName);
+          break;
+        }
+      }
+      return NS_FAILURE;
+    }
+
+    nsSet<IAPCCommandQueue*> usedQueues;
+    for (const Node& node : m_Nodes)
+    {
+      for (IAPCCommandQueue* pQueue : node.m_pGroup->m_CommandQueues)
+      {
+        if (usedQueues.Contains(pQueue))
+        {
+          nsLog::Error("Queue in group '{0}' is used more than once in the frame graph.", node.m_pGroup->m_sGroupName);
+          return NS_FAILURE;
+        }
+        usedQueues.Insert(pQueue);
+      }
+    }
+
+    // The bindings are referenced by the queues, so they must not move after this.
+    m_QueueBindings.SetCount(uiNumNodes);
+    for (NodeIndex i = 0; i < uiNumNodes; ++i)
+    {
+      m_QueueBindings[i].m_pGraph = this;
+      m_QueueBindings[i].m_Node = i;
+      for (IAPCCommandQueue* pQueue : m_Nodes[i].m_pGroup->m_CommandQueues)
+      {
+        pQueue->SetCompletionCallback(&APCFrameGraph::OnQueueCompleted, &m_QueueBindings[i]);
+        m_BoundQueues.PushBack(pQueue);
+      }
+    }
+
+    NS_DEFAULT_DELETE_ARRAY(m_NodeStates);
+    m_NodeStates = NS_DEFAULT_NEW_ARRAY(NodeState, uiNumNodes);
+
+    m_PathCost.SetCountUninitialized(uiNumNodes);
+    m_PathPredecessor.SetCountUninitialized(uiNumNodes);
+    m_CriticalPath.Clear();
+    m_CriticalPath.Reserve(uiNumNodes);
+
+    m_bCompiled = true;
+    return NS_SUCCESS;
+  }
+
+  void APCFrameGraph::Reset()
+  {
+    NS_ASSERT_DEV(IsFrameFinished(), "Cannot reset a frame graph while a frame is running.");
+
+    UnbindQueues();
+    m_Nodes.Clear();
+    m_Edges.Clear();
+    m_Successors.Clear();
+    m_TopologicalOrder.Clear();
+    m_QueueBindings.Clear();
+    m_BoundQueues.Clear();
+    m_PathCost.Clear();
+    m_PathPredecessor.Clear();
+    m_CriticalPath.Clear();
+    NS_DEFAULT_DELETE_ARRAY(m_NodeStates);
+    m_bCompiled = false;
+  }
+
+  nsResult APCFrameGraph::Submit(APCJobSystem& p_jobSystem)
+  {
+    if (!m_bCompiled)
+    {
+      nsLog::Error("Cannot submit a frame graph that is not compiled.");
+      return NS_FAILURE;
+    }
+
+    if (!IsFrameFinished())
+    {
+      nsLog::Error("Cannot submit a frame graph while its previous frame is still running.");
+      return NS_FAILURE;
+    }
+
+    // A queue that was added to a group after Compile() has no completion callback, its group would never finish.
+    if (!AreQueuesBound() && Compile().Failed())
+    {
+      return NS_FAILURE;
+    }
+
+    // Check everything up front, a queue that AddJob rejects would never finish and stall the whole frame.
+    for (const Node& node : m_Nodes)
+    {
+      for (const IAPCCommandQueue* pQueue : node.m_pGroup->m_CommandQueues)
+      {
+        if (pQueue->GetJobState() != APCJobState::Idle || APCJobSystem::GetPoolIndex(pQueue->GetType()) < 0)
+        {
+          nsLog::Error("Cannot submit frame graph, a queue of group '{0}' is still in flight or has no matching pool.", node.m_pGroup->m_sGroupName);
+          return NS_FAILURE;
+        }
+      }
+    }
+
+    const nsUInt32 uiNumNodes = m_Nodes.GetCount();
+    for (NodeIndex i = 0; i < uiNumNodes; ++i)
+    {
+      m_NodeStates[i].m_uiPendingInputs.store(m_Nodes[i].m_uiInputCount, std::memory_order_relaxed);
+      m_NodeStates[i].m_uiPendingQueues.store(m_Nodes[i].m_pGroup->m_CommandQueues.GetCount(), std::memory_order_relaxed);
+      m_NodeStates[i].m_iCostNs.store(0, std::memory_order_relaxed);
+      m_NodeStates[i].m_bCanceled.store(false, std::memory_order_relaxed);
+    }
+
+    m_pJobSystem = &p_jobSystem;
+    m_iTotalWorkNs.store(0, std::memory_order_relaxed);
+    m_uiCanceledNodes.store(0, std::memory_order_relaxed);
+    m_uiPendingNodes.store(uiNumNodes, std::memory_order_relaxed);
+    m_FrameStartTime = nsTime::Now();
+    m_bFrameRunning.store(true, std::memory_order_release);
+
+    if (uiNumNodes == 0)
+    {
+      FinishFrame();
+      return NS_SUCCESS;
+    }
+
+    // Roots come first in the topological order. Their successors can only be released by finishing nodes, never from here.
+    for (NodeIndex node : m_TopologicalOrder)
+    {
+      if (m_Nodes[node].m_uiInputCount != 0)
+        break;
+
+      ReleaseNode(node);
+    }
+
+    return NS_SUCCESS;
+  }
+
+  void APCFrameGraph::Wait()
+  {
+    while (!IsFrameFinished())
+    {
+      if (!m_pJobSystem->HelpExecuteJob())
+      {
+        m_pJobSystem->SafePoll();
+      }
+    }
+  }
+
+  nsTime APCFrameGraph::GetGroupCost(NodeIndex p_node) const
+  {
+    if (!m_bCompiled || p_node >= m_Nodes.GetCount())
+      return nsTime::MakeZero();
+
+    return nsTime::MakeFromNanoseconds(static_cast<double>(m_NodeStates[p_node].m_iCostNs.load(std::memory_order_relaxed)));
+  }
+
+  void APCFrameGraph::OnQueueCompleted(IAPCCommandQueue& queue, nsTime executionTime, void* pUserData)
+  {
+    const QueueBinding& binding = *static_cast<const QueueBinding*>(pUserData);
+    APCFrameGraph& graph = *binding.m_pGraph;
+    NodeState& state = graph.m_NodeStates[binding.m_Node];
+
+    const nsInt64 iExecutionNs = static_cast<nsInt64>(executionTime.GetNanoseconds());
+    graph.m_iTotalWorkNs.fetch_add(iExecutionNs, std::memory_order_relaxed);
+
+    // The queues of a group run in parallel, so the group costs as much as its slowest queue.
+    nsInt64 iCost = state.m_iCostNs.load(std::memory_order_relaxed);
+    while (iExecutionNs > iCost && !state.m_iCostNs.compare_exchange_weak(iCost, iExecutionNs, std::memory_order_relaxed))
+    {
+    }
+
+    if (queue.IsCancellationRequested())
+    {
+      state.m_bCanceled.store(true, std::memory_order_relaxed);
+    }
+
+    if (state.m_uiPendingQueues.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      graph.FinishNode(binding.m_Node);
+    }
+  }
+
+  void APCFrameGraph::ReleaseNode(NodeIndex node)
+  {
+    const CommandGroup& group = *m_Nodes[node].m_pGroup;
+    NodeState& state = m_NodeStates[node];
+    if (group.m_pCancellationToken != nullptr && group.m_pCancellationToken->IsCanceled())
+    {
+      state.m_bCanceled.store(true, std::memory_order_relaxed);
+      for (const IAPCCommandQueue* pQueue : group.m_CommandQueues)
+      {
+        group.m_pCancellationToken->RecordSkippedQueue(pQueue->GetCommandCount());
+      }
+    }
+
+    if (group.m_CommandQueues.IsEmpty() || state.m_bCanceled.load(std::memory_order_relaxed))
+    {
+      FinishNode(node);
+      return;
+    }
+
+    for (IAPCCommandQueue* pQueue : group.m_CommandQueues)
+    {
+      m_pJobSystem->AddJob(*pQueue);
+    }
+  }
+
+  void APCFrameGraph::FinishNode(NodeIndex node)
+  {
+    const Node& finished = m_Nodes[node];
+    const bool bCanceled = m_NodeStates[node].m_bCanceled.load(std::memory_order_relaxed);
+    if (bCanceled)
+    {
+      m_uiCanceledNodes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    for (nsUInt32 i = 0; i < finished.m_uiSuccessorCount; ++i)
+    {
+      const NodeIndex successor = m_Successors[finished.m_uiFirstSuccessor + i];
+      if (bCanceled)
+      {
+        // Published by the fetch_sub below, the node that releases the successor sees it.
+        m_NodeStates[successor].m_bCanceled.store(true, std::memory_order_relaxed);
+      }
+
+      if (m_NodeStates[successor].m_uiPendingInputs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+        ReleaseNode(successor);
+      }
+    }
+
+    if (m_uiPendingNodes.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      FinishFrame();
+    }
+  }
+
+  void APCFrameGraph::FinishFrame()
+  {
+    m_LastFrameStats.m_FrameTime = nsTime::Now() - m_FrameStartTime;
+    m_LastFrameStats.m_TotalWorkTime = nsTime::MakeFromNanoseconds(static_cast<double>(m_iTotalWorkNs.load(std::memory_order_relaxed)));
+    m_LastFrameStats.m_uiCanceledGroups = m_uiCanceledNodes.load(std::memory_order_relaxed);
+
+    // Longest path through the DAG, weighted by the measured group costs.
+    const nsUInt32 uiNumNodes = m_Nodes.GetCount();
+    for (NodeIndex i = 0; i < uiNumNodes; ++i)
+    {
+      m_PathCost[i] = 0;
+      m_PathPredecessor[i] = InvalidNode;
+    }
+
+    NodeIndex lastNode = InvalidNode;
+    nsInt64 iLongestPath = 0;
+    for (NodeIndex node : m_TopologicalOrder)
+    {
+      m_PathCost[node] += m_NodeStates[node].m_iCostNs.load(std::memory_order_relaxed);
+      if (lastNode == InvalidNode || m_PathCost[node] > iLongestPath)
+      {
+        lastNode = node;
+        iLongestPath = m_PathCost[node];
+      }
+
+      const Node& current = m_Nodes[node];
+      for (nsUInt32 i = 0; i < current.m_uiSuccessorCount; ++i)
+      {
+        const NodeIndex successor = m_Successors[current.m_uiFirstSuccessor + i];
+        if (m_PathPredecessor[successor] == InvalidNode || m_PathCost[node] > m_PathCost[successor])
+        {
+          m_PathCost[successor] = m_PathCost[node];
+          m_PathPredecessor[successor] = node;
+        }
+      }
+    }
+
+    m_CriticalPath.Clear();
+    for (NodeIndex node = lastNode; node != InvalidNode; node = m_PathPredecessor[node])
+    {
+      m_CriticalPath.PushBack(node);
+    }
+    for (nsUInt32 i = 0; i < m_CriticalPath.GetCount() / 2; ++i)
+    {
+      nsMath::Swap(m_CriticalPath[i], m_CriticalPath[m_CriticalPath.GetCount() - 1 - i]);
+    }
+
+    m_LastFrameStats.m_CriticalPathTime = nsTime::MakeFromNanoseconds(static_cast<double>(iLongestPath));
+
+    m_bFrameRunning.store(false, std::memory_order_release);
+  }
+
+  void APCFrameGraph::UnbindQueues()
+  {
+    // Also the queues that were removed from their group since, as long as no other graph took them over.
+    for (IAPCCommandQueue* pQueue : m_BoundQueues)
+    {
+      const void* pUserData = pQueue->GetCompletionUserData();
+      if (m_QueueBindings.GetCount() > 0 && pUserData >= m_QueueBindings.GetData() && pUserData < m_QueueBindings.GetData() + m_QueueBindings.GetCount())
+      {
+        pQueue->SetCompletionCallback(nullptr, nullptr);
+      }
+    }
+    m_BoundQueues.Clear();
+    m_QueueBindings.Clear();
+  }
+
+  bool APCFrameGraph::AreQueuesBound() const
+  {
+    nsUInt32 uiBoundQueue = 0;
+    for (NodeIndex i = 0; i < m_Nodes.GetCount(); ++i)
+    {
+      for (const IAPCCommandQueue* pQueue : m_Nodes[i].m_pGroup->m_CommandQueues)
+      {
+        if (uiBoundQueue >= m_BoundQueues.GetCount() || m_BoundQueues[uiBoundQueue] != pQueue || pQueue->GetCompletionUserData() != &m_QueueBindings[i])
+          return false;
+
+        ++uiBoundQueue;
+      }
+    }
+    return uiBoundQueue == m_BoundQueues.GetCount();
+  }
+} // namespace aperture::core::threading
@@ -0,0 +1,193 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <APHTML/Multithreading/APCJobSystem.h>
+#include <APHTML/APEngineCommonIncludes.h>
+#include <Foundation/Time/Time.h>
+#include <Foundation/Types/ArrayPtr.h>
+
+namespace aperture::core::threading
+{
+  /// @brief Timing of the last frame that ran through an APCFrameGraph.
+  struct NS_APERTURE_DLL APCFrameGraphStats
+  {
+    /// @brief Wall time from Submit() until the last group finished.
+    nsTime m_FrameTime;
+    /// @brief Cost of the longest dependency chain. A group costs as much as its slowest queue, so this is the frame time with unlimited cores.
+    nsTime m_CriticalPathTime;
+    /// @brief Summed execution time of every queue in the frame. Divided by m_CriticalPathTime this is the parallelism the graph offers.
+    nsTime m_TotalWorkTime;
+    /// @brief Groups that were skipped or cut short because they, or one of their inputs, got canceled.
+    nsUInt32 m_uiCanceledGroups = 0;
+  };
+
+  /**
+   * @class APCFrameGraph
+   * @brief Runs CommandGroups as a dependency graph on an APCJobSystem.
+   *
+   * Instead of serializing CSS -> Layout -> Composition -> Rendering by hand, a frame is described once as groups plus edges.
+   * Each group is submitted as soon as all of its inputs finished, so independent views or subtrees overlap, e.g. view A in
+   * layout while view B is already in composition.
+   *
+   * The graph is built once, compiled, and then submitted every frame. Compile() does all allocations, Submit() only resets
+   * counters, so a compiled graph can be reused across frames without touching the heap.
+   *
+   * A canceled group still counts as finished for the frame, but everything that depends on it is skipped without submitting
+   * its queues, so cancelling one group through APCJobSystem::CancelJobGroup() drops the rest of its branch in one go.
+   *
+   * @note A queue can only belong to one group of one graph, the graph owns the queue's completion callback.
+   */
+  class NS_APERTURE_DLL APCFrameGraph
+  {
+  public:
+    using NodeIndex = nsUInt32;
+    static constexpr NodeIndex InvalidNode = 0xFFFFFFFF;
+
+    APCFrameGraph() = default;
+    ~APCFrameGraph();
+
+    APCFrameGraph(const APCFrameGraph&) = delete;
+    APCFrameGraph& operator=(const APCFrameGraph&) = delete;
+
+    /// @brief Adds a group to the graph. The group has to outlive the graph.
+    NodeIndex AddGroup(CommandGroup& p_group);
+
+    /// @brief p_after is only submitted once p_before and all its other inputs are finished.
+    void AddDependency(NodeIndex p_before, NodeIndex p_after);
+
+    /// @brief Validates the graph, orders it and allocates all per-frame state.
+    /// @return NS_FAILURE if the graph has a cycle or a queue is used by more than one group.
+    nsResult Compile();
+
+    bool IsCompiled() const { return m_bCompiled; }
+
+    /// @brief Removes all groups and edges, the graph has to be built and compiled again.
+    void Reset();
+
+    /**
+     * @brief Starts a frame. All groups without inputs are submitted right away, the rest as their inputs finish.
+     *
+     * If queues were added to or removed from a group since Compile(), the graph is compiled again first.
+     * @return NS_FAILURE if the graph isn't compiled, the previous frame is still running, or a queue can't be submitted.
+     */
+    nsResult Submit(APCJobSystem& p_jobSystem);
+
+    /// @brief Waits for the current frame. The calling thread helps executing jobs in the meantime.
+    void Wait();
+
+    /// @brief True once every group of the last submitted frame is done.
+    bool IsFrameFinished() const { return !m_bFrameRunning.load(std::memory_order_acquire); }
+
+    /// @brief Stats of the last finished frame.
+    const APCFrameGraphStats& GetLastFrameStats() const { return m_LastFrameStats; }
+
+    /// @brief The groups on the critical path of the last finished frame, in execution order.
+    nsArrayPtr<const NodeIndex> GetCriticalPath() const { return m_CriticalPath.GetArrayPtr(); }
+
+    /// @brief The measured cost of a group in the last finished frame.
+    nsTime GetGroupCost(NodeIndex p_node) const;
+
+    const CommandGroup& GetGroup(NodeIndex p_node) const { return *m_Nodes[p_node].m_pGroup; }
+    nsUInt32 GetGroupCount() const { return m_Nodes.GetCount(); }
+
+  private:
+    struct Node
+    {
+      CommandGroup* m_pGroup = nullptr;
+      nsUInt32 m_uiFirstSuccessor = 0;
+      nsUInt32 m_uiSuccessorCount = 0;
+      nsUInt32 m_uiInputCount = 0;
+    };
+
+    struct Edge
+    {
+      NS_DECLARE_POD_TYPE();
+
+      NodeIndex m_Before;
+      NodeIndex m_After;
+    };
+
+    /// @brief Per frame counters, reset by Submit().
+    struct NodeState
+    {
+      std::atomic<nsUInt32> m_uiPendingInputs = 0;
+      std::atomic<nsUInt32> m_uiPendingQueues = 0;
+      std::atomic<nsInt64> m_iCostNs = 0;
+      std::atomic<bool> m_bCanceled = false;
+    };
+
+    /// @brief User data of a queue's completion callback.
+    struct QueueBinding
+    {
+      APCFrameGraph* m_pGraph = nullptr;
+      NodeIndex m_Node = InvalidNode;
+    };
+
+    static void OnQueueCompleted(IAPCCommandQueue& queue, nsTime executionTime, void* pUserData);
+
+    void ReleaseNode(NodeIndex node);
+    void FinishNode(NodeIndex node);
+    void FinishFrame();
+    void UnbindQueues();
+    bool AreQueuesBound() const;
+
+    nsDynamicArray<Node> m_Nodes;
+    nsDynamicArray<Edge> m_Edges;
+
+    // Built by Compile().
+    nsDynamicArray<NodeIndex> m_Successors;
+    nsDynamicArray<NodeIndex> m_TopologicalOrder;
+    nsDynamicArray<QueueBinding> m_QueueBindings;
+    /// The queues of all groups as Compile() saw them, in node order.
+    nsDynamicArray<IAPCCommandQueue*> m_BoundQueues;
+    nsArrayPtr<NodeState> m_NodeStates;
+    bool m_bCompiled = false;
+
+    // Scratch for the critical path, sized by Compile() so FinishFrame() doesn't allocate.
+    nsDynamicArray<nsInt64> m_PathCost;
+    nsDynamicArray<NodeIndex> m_PathPredecessor;
+    nsDynamicArray<NodeIndex> m_CriticalPath;
+
+    APCJobSystem* m_pJobSystem = nullptr;
+    nsTime m_FrameStartTime;
+    std::atomic<nsUInt32> m_uiPendingNodes = 0;
+    std::atomic<nsInt64> m_iTotalWorkNs = 0;
+    std::atomic<nsUInt32> m_uiCanceledNodes = 0;
+    std::atomic<bool> m_bFrameRunning = false;
+    APCFrameGraphStats m_LastFrameStats;
+  };
+} // namespace aperture::core::threading
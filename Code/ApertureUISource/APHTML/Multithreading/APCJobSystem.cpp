@@ -1,4 +1,10 @@
+#include <APHTML/Multithreading/APCAsyncJob.h>
 #include <APHTML/Multithreading/APCJobSystem.h>
+#include <Foundation/IO/JSONWriter.h>
+#include <Foundation/Profiling/Profiling.h>
+#include <Foundation/Strings/StringBuilder.h>
+#include <Foundation/Threading/ThreadUtils.h>
+#include <Foundation/Utilities/Stats.h>
 
 #include <condition_variable>
 #include <functional>
@@ -10,12 +16,146 @@
 
 namespace aperture::core::threading
 {
+  namespace
+  {
+    /// The worker the current thread belongs to, nullptr for threads that are not owned by an APCJobSystem.
+    thread_local void* tl_pCurrentWorker = nullptr;
+
+    NS_ALWAYS_INLINE nsUInt32 NextStealIndex(nsUInt32& ref_uiSeed)
+    {
+      // xorshift32, good enough to spread thieves over their siblings.
+      ref_uiSeed ^= ref_uiSeed << 13;
+      ref_uiSeed ^= ref_uiSeed >> 17;
+      ref_uiSeed ^= ref_uiSeed << 5;
+      return ref_uiSeed;
+    }
+  } // namespace
+
+  /// Executes jobs of one pool on an nsTaskSystem thread until the pool is empty.
+  class APCJobSystem::DrainTask final : public nsTask
+  {
+  public:
+    DrainTask(APCJobSystem* pJobSystem, JobPool* pPool)
+      : m_pJobSystem(pJobSystem)
+      , m_pPool(pPool)
+    {
+    }
+
+    /// Claimed by StartDrainTask(), released by OnDrainTaskFinished().
+    std::atomic<bool> m_bInUse = false;
+
+  protected:
+    virtual void Execute() override
+    {
+      IAPCCommandQueue* pJob = nullptr;
+      bool bYielded = false;
+      while (!m_pJobSystem->m_bShutdown.load(std::memory_order_relaxed))
+      {
+        if (m_pJobSystem->TakeJobFromPool(*m_pPool, pJob, 0))
+        {
+          m_pJobSystem->ExecuteJob(pJob);
+          bYielded = false;
+          continue;
+        }
+
+        // Submitters usually push a batch, give them one time slice to catch up before this task ends and a new one has to be started.
+        if (bYielded)
+          break;
+        nsThreadUtils::YieldTimeSlice();
+        bYielded = true;
+      }
+    }
+
+  private:
+    APCJobSystem* m_pJobSystem = nullptr;
+    JobPool* m_pPool = nullptr;
+  };
+
+  APCJobSystem::~APCJobSystem()
+  {
+    StopWorkerThreads();
+  }
+
   void APCJobSystem::InitializeJobSystem(const APCJobSystemConfig& p_config)
   {
     m_MaxThreads = p_config.m_Composition_threadcount + p_config.m_Script_threadcount +
                    p_config.m_Rendering_threadcount + p_config.m_Parsing_threadcount;
 
+    const nsUInt32 uiHardwareThreads = nsMath::Max(std::thread::hardware_concurrency(), 1u);
+    m_uiMaxThreadsPerPool = p_config.m_maxThreadsPerRuntype > 0 ? p_config.m_maxThreadsPerRuntype : uiHardwareThreads;
+    m_uiMaxThreadsPerPool = nsMath::Min(m_uiMaxThreadsPerPool, JobPool::MaxWorkers);
+    m_GrowthBacklogTime = p_config.m_growthBacklogTime;
+    m_IdleRetireTime = p_config.m_idleRetireTime;
+
     m_ActiveThreads = 0;
+    m_bShutdown = false;
+    m_JobIDSeed = nsUuid::MakeUuid();
+    m_LastPublishTime = nsTime::Now();
+
+    m_Pools[Pool_Composition].m_Runtype = core::Runtype::FreeThread_Composition;
+    m_Pools[Pool_Composition].m_pActiveThreadCounter = &m_ActiveCompositionThreads;
+    m_Pools[Pool_Scripting].m_Runtype = core::Runtype::FreeThread_Scripting;
+    m_Pools[Pool_Scripting].m_pActiveThreadCounter = &m_ActiveScriptThreads;
+    m_Pools[Pool_Rendering].m_Runtype = core::Runtype::FreeThread_Rendering;
+    m_Pools[Pool_Rendering].m_pActiveThreadCounter = &m_ActiveRenderingThreads;
+    m_Pools[Pool_Layout].m_Runtype = core::Runtype::FreeThread_Layout;
+    m_Pools[Pool_Layout].m_pActiveThreadCounter = &m_ActiveParsingThreads;
+
+    m_Pools[Pool_Composition].m_Policy = p_config.m_Composition_policy;
+    m_Pools[Pool_Composition].m_szDefaultThreadName = "APC Compose";
+    m_Pools[Pool_Scripting].m_Policy = p_config.m_Script_policy;
+    m_Pools[Pool_Scripting].m_szDefaultThreadName = "APC Script";
+    m_Pools[Pool_Rendering].m_Policy = p_config.m_Rendering_policy;
+    m_Pools[Pool_Rendering].m_szDefaultThreadName = "APC Render";
+    m_Pools[Pool_Layout].m_Policy = p_config.m_Parsing_policy;
+    m_Pools[Pool_Layout].m_szDefaultThreadName = "APC Layout";
+    m_uiReservedCoreMask = p_config.m_reservedCoreMask;
+
+    m_Pools[Pool_Composition].m_uiBaseWorkers = p_config.m_Composition_threadcount;
+    m_Pools[Pool_Scripting].m_uiBaseWorkers = p_config.m_Script_threadcount;
+    m_Pools[Pool_Rendering].m_uiBaseWorkers = p_config.m_Rendering_threadcount;
+    m_Pools[Pool_Layout].m_uiBaseWorkers = p_config.m_Parsing_threadcount;
+
+    m_Backend = p_config.m_backend;
+    if (m_Backend == APCJobSystemBackend::TaskSystem)
+    {
+      for (const JobPool& pool : m_Pools)
+      {
+        if (pool.m_Policy.m_uiAffinityMask != 0 || pool.m_Policy.m_priority != APCThreadPriority::Default || m_uiReservedCoreMask != 0)
+        {
+          nsLog::Warning("Thread policies are ignored with the task system backend, nsTaskSystem owns the threads.");
+          break;
+        }
+      }
+
+      const nsUInt32 uiTaskWorkers = nsMath::Max(nsTaskSystem::GetWorkerThreadCount(nsWorkerThreadType::ShortTasks), 1u);
+      for (JobPool& pool : m_Pools)
+      {
+        pool.m_uiMaxDrainers = nsMath::Min(pool.m_uiBaseWorkers > 0 ? pool.m_uiBaseWorkers : uiTaskWorkers, JobPool::MaxWorkers);
+        pool.m_uiActiveDrainers = 0;
+        pool.m_DrainTasks.Clear();
+
+        nsStringBuilder sTaskName;
+        sTaskName.SetFormat("APCJobSystem {0}", RuntypeToString(pool.m_Runtype));
+        JobPool* pPool = &pool;
+        for (nsUInt32 i = 0; i < pool.m_uiMaxDrainers; ++i)
+        {
+          nsSharedPtr<nsTask> pTask = NS_DEFAULT_NEW(DrainTask, this, pPool);
+          pTask->ConfigureTask(sTaskName, nsTaskNesting::Maybe, [this, pPool](const nsSharedPtr<nsTask>& pFinishedTask)
+            { OnDrainTaskFinished(*pPool, pFinishedTask); });
+          pool.m_DrainTasks.PushBack(std::move(pTask));
+        }
+      }
+
+      m_MaxThreads = static_cast<nsUInt8>(nsMath::Min<nsUInt32>(uiTaskWorkers, 0xFF));
+      if (p_config.m_allowCreationOfNewThreadsOnOverfill)
+      {
+        nsLog::Warning("Dynamic thread creation is not supported with the task system backend, nsTaskSystem owns all threads.");
+      }
+      m_bAllowCreationOfNewThreadsOnOverfill = false;
+      nsLog::Info("Job system runs on nsTaskSystem, {0} short task workers.", uiTaskWorkers);
+      return;
+    }
 
     // Initialize specific thread types
     CreateTypeThread(core::Runtype::FreeThread_Composition, p_config.m_Composition_threadcount);
@@ -23,10 +163,11 @@ namespace aperture::core::threading
     CreateTypeThread(core::Runtype::FreeThread_Rendering, p_config.m_Rendering_threadcount);
     CreateTypeThread(core::Runtype::FreeThread_Layout, p_config.m_Parsing_threadcount);
 
-    if (p_config.m_allowCreationOfNewThreadsOnOverfill)
+    m_bAllowCreationOfNewThreadsOnOverfill = p_config.m_allowCreationOfNewThreadsOnOverfill;
+    if (m_bAllowCreationOfNewThreadsOnOverfill)
     {
-      nsLog::Info("Dynamic thread creation enabled.");
-      m_bAllowCreationOfNewThreadsOnOverfill = true;
+      m_MaxThreads = static_cast<nsUInt8>(nsMath::Min<nsUInt32>(nsMath::Max<nsUInt32>(m_MaxThreads.load(), uiHardwareThreads), 0xFF));
+      nsLog::Info("Dynamic thread creation enabled, up to {0} threads per pool.", m_uiMaxThreadsPerPool);
     }
   }
 
@@ -39,204 +180,98 @@ namespace aperture::core::threading
 
   nsResult APCJobSystem::CancelJob(nsUuid p_jobid, const IAPCCommandQueue& p_queue)
   {
-    // Cancel a specific job within a queue
-    if (p_queue.m_mutex.IsLocked())
+    if (p_queue.GetJobID() != p_jobid)
     {
-      // #34: (Mikael A.): Add Unique ID Names to Queues, would help with debugging.
-      nsLog::Error("Cannot cancel job {0} in queue with Type: {1}. Queue is locked.", p_jobid.ToString(), CommandTypeToString(p_queue.GetType()));
+      nsLog::Error("Cannot cancel job {0} in queue with Type: {1}. The queue belongs to a different job.", p_jobid.ToString(), CommandTypeToString(p_queue.GetType()));
       return NS_FAILURE;
     }
-    for (auto& job : m_CompositionQueues)
+
+    // The queue stays in whatever deque it sits in, the thread that pops it will skip it. A running queue stops before its next command.
+    IAPCCommandQueue& queue = const_cast<IAPCCommandQueue&>(p_queue);
+    queue.RequestCancellation();
+    if (queue.TransitionJobState(APCJobState::Queued, APCJobState::Canceled))
     {
-      if (job.first == p_jobid && job.second == &p_queue)
-      {
-        if (job.second->m_mutex.IsLocked())
-        {
-          nsLog::Error("Cannot cancel job {0} in queue of Type: {1}. Job is locked.", p_jobid.ToString(), CommandTypeToString(p_queue.GetType()));
-          return NS_FAILURE;
-        }
-        m_CompositionQueues.RemoveAndSwap(job);
-        nsLog::Info("Sub Job {0} canceled.", p_jobid);
-      }
+      nsLog::Dev("Job Queue {0} canceled.", p_jobid);
     }
-    nsLog::Info("Job Queue {0} canceled.", p_jobid);
+    else if (queue.GetJobState() == APCJobState::Running)
+    {
+      nsLog::Dev("Job Queue {0} is running, it stops before its next command.", p_jobid);
+    }
+
+    // Already finished or canceled otherwise.
     return NS_SUCCESS;
   }
 
   nsResult APCJobSystem::CancelJobGroup(const CommandGroup& p_group)
   {
-    // Cancel all jobs in a CommandGroup
+    // Cancel all jobs in a CommandGroup, the token reaches running commands and dependent groups as well.
+    if (p_group.m_pCancellationToken != nullptr)
+    {
+      p_group.m_pCancellationToken->Cancel();
+    }
+
+    nsResult result = NS_SUCCESS;
     for (auto queue : p_group.m_CommandQueues)
     {
-      for (auto& job : m_CompositionQueues)
+      if (CancelJob(queue->GetJobID(), *queue).Failed())
       {
-        if (job.second == queue)
-        {
-          return CancelJob(job.first, *queue);
-        }
+        result = NS_FAILURE;
       }
     }
-    nsLog::Info("All jobs in group {0} canceled.", p_group.m_sGroupName);
-    return NS_SUCCESS;
+    nsLog::Dev("All jobs in group {0} canceled.", p_group.m_sGroupName);
+    return result;
   }
 
   nsResult APCJobSystem::CancelAllJobs()
   {
-    // Cancel all jobs in the system
-    m_CompositionQueues.Clear();
-    m_ScriptQueues.Clear();
-    m_RenderingQueues.Clear();
-    m_ParsingQueues.Clear();
+    // Cancel all jobs in the system. Deques are drained through Steal(), which is safe from any thread.
+    for (JobPool& pool : m_Pools)
+    {
+      IAPCCommandQueue* pJob = nullptr;
+      while (TakeJobFromPool(pool, pJob, 0))
+      {
+        pJob->RequestCancellation();
+        ExecuteJob(pJob);
+      }
+    }
     nsLog::Dev("All jobs canceled.");
     return NS_SUCCESS;
   }
 
   void APCJobSystem::CreateTypeThread(const core::Runtype& p_runtype, nsUInt8 p_threadcount)
   {
-    switch (p_runtype)
+    if (m_Backend == APCJobSystemBackend::TaskSystem)
     {
-      case core::Runtype::FreeThread_Composition:
-        for (nsUInt8 i = 0; i < p_threadcount; ++i)
-        {
-          std::thread m_r_CompositionThread([&]()
-            {
-            m_ActiveThreads++;
-            m_ActiveCompositionThreads++;
-            while (true)
-            {
-              if (m_CompositionQueues.IsEmpty() != true)
-              {
-                for (auto& job : m_CompositionQueues)
-                {
-                  if (job.second->Execute() == NS_FAILURE)
-                  {
-                    nsLog::Error("Job of Type: {0} failed to execute.", CommandTypeToString(job.second->GetType()));
-                    continue;
-                  }
-                  m_CompositionQueues.PopBack();
-                }
-              }
-              else
-              {
-                std::unique_lock<std::mutex> lock(wakeMutex);
-                wakeCondition.wait(lock);
-              }
-            } });
-          m_CompositionThreads.PushBack(&m_r_CompositionThread);
-          m_r_CompositionThread.detach();
-        }
-        break;
-      case core::Runtype::FreeThread_Scripting:
-        for (nsUInt8 i = 0; i < p_threadcount; ++i)
-        {
-          std::thread m_r_ScriptThread([&]()
-            {
-            m_ActiveThreads++;
-            m_ActiveScriptThreads++;
-            while (true)
-            {
-              if (m_ScriptQueues.IsEmpty() != true)
-              {
-                for (auto& job : m_ScriptQueues)
-                {
-                  if (job.second->Execute() == NS_FAILURE)
-                  {
-                    nsLog::Error("Job of Type: {0} failed to execute.", CommandTypeToString(job.second->GetType()));
-                    continue;
-                  }
-                  m_ScriptQueues.PopBack();
-                }
-              }
-              else
-              {
-                std::unique_lock<std::mutex> lock(wakeMutex);
-                wakeCondition.wait(lock);
-              }
-            } });
-          m_ScriptThreads.PushBack(&m_r_ScriptThread);
-          m_r_ScriptThread.detach();
-        }
-        break;
-      case core::Runtype::FreeThread_Rendering:
-        for (nsUInt8 i = 0; i < p_threadcount; ++i)
-        {
-          std::thread m_r_RenderingThread([&]()
-            {
-            m_ActiveThreads++;
-            m_ActiveRenderingThreads++;
-            while (true)
-            {
-              if (m_RenderingQueues.IsEmpty() != true)
-              {
-                for (auto& job : m_RenderingQueues)
-                {
-                  if (job.second->Execute() == NS_FAILURE)
-                  {
-                    nsLog::Error("Job of Type: {0} failed to execute.", CommandTypeToString(job.second->GetType()));
-                    continue;
-                  }
-                  m_RenderingQueues.PopBack();
-                }
-              }
-              else
-              {
-                std::unique_lock<std::mutex> lock(wakeMutex);
-                wakeCondition.wait(lock);
-              }
-            } });
-          m_RenderingThreads.PushBack(&m_r_RenderingThread);
-          m_r_RenderingThread.detach();
-        }
-        break;
-      case core::Runtype::FreeThread_Layout:
-        for (nsUInt8 i = 0; i < p_threadcount; ++i)
-        {
-          std::thread m_r_ParsingThread([&]()
-            {
-            m_ActiveThreads++;
-            m_ActiveParsingThreads++;
-            while (true)
-            {
-              if (m_ParsingQueues.IsEmpty() != true)
-              {
-                for (auto& job : m_ParsingQueues)
-                {
-                  if (job.second->Execute() == NS_FAILURE)
-                  {
-                    nsLog::Error("Job of Type: {0} failed to execute.", CommandTypeToString(job.second->GetType()));
-                    continue;
-                  }
-                  m_ParsingQueues.PopBack();
-                }
-              }
-              else
-              {
-                std::unique_lock<std::mutex> lock(wakeMutex);
-                wakeCondition.wait(lock);
-              }
-            } });
-          std::unique_ptr<std::thread> a = std::make_unique<std::thread>();
-          m_ParsingThreads.PushBack(a.get());
-          m_r_ParsingThread.detach();
-        }
-        break;
-      default:
-        nsLog::Error("Invalid runtype: {0}.", static_cast<int>(p_runtype));
-        break;
+      nsLog::Error("Cannot create threads of runtype {0}, the job system runs on nsTaskSystem.", RuntypeToString(p_runtype));
+      return;
     }
-  }
 
-  bool APCJobSystem::IsJobRunning(nsUuid p_jobid, const IAPCCommandQueue& p_queue)
-  {
-    // Check if a specific job is running
-    for (const auto& job : m_CompositionQueues)
+    const nsInt32 iPoolIndex = GetPoolIndex(p_runtype);
+    if (iPoolIndex < 0)
     {
-      if (job.first == p_jobid && job.second == &p_queue)
+      nsLog::Error("Invalid runtype: {0}.", static_cast<int>(p_runtype));
+      return;
+    }
+
+    JobPool& pool = m_Pools[iPoolIndex];
+    NS_LOCK(pool.m_GrowMutex);
+    for (nsUInt8 i = 0; i < p_threadcount; ++i)
+    {
+      if (!SpawnWorker(pool))
       {
-        return true;
+        nsLog::Error("Cannot create more than {0} threads of runtype {1}.", JobPool::MaxWorkers, RuntypeToString(p_runtype));
+        break;
       }
     }
-    return false;
+  }
+
+  bool APCJobSystem::IsJobRunning(nsUuid p_jobid, const IAPCCommandQueue& p_queue)
+  {
+    if (p_queue.GetJobID() != p_jobid)
+      return false;
+
+    const APCJobState state = p_queue.GetJobState();
+    return state == APCJobState::Queued || state == APCJobState::Running;
   }
 
   bool APCJobSystem::IsJobGroupRunning(const CommandGroup& p_group)
@@ -244,12 +279,9 @@ namespace aperture::core::threading
     // Check if any job in the group is running
     for (auto queue : p_group.m_CommandQueues)
     {
-      for (const auto& job : m_CompositionQueues)
+      if (IsJobRunning(queue->GetJobID(), *queue))
       {
-        if (job.second == queue)
-        {
-          return true;
-        }
+        return true;
       }
     }
     return false;
@@ -257,24 +289,36 @@ namespace aperture::core::threading
 
   void APCJobSystem::Wait()
   {
-    while (this->m_ActiveThreads.load() > 0)
+    while (m_uiJobsInFlight.load() > 0)
     {
-      SafePoll();
+      if (HelpExecuteJob())
+        continue;
+
+      if (m_Backend == APCJobSystemBackend::TaskSystem)
+      {
+        // The rest is being executed by drain tasks, help the task system instead of spinning.
+        nsTaskSystem::WaitForCondition([this]()
+          { return m_uiJobsInFlight.load() == 0; });
+      }
+      else
+      {
+        SafePoll();
+      }
     }
   }
 
   void APCJobSystem::Shutdown()
   {
     // Terminate all threads
-    NS_ASSERT_DEBUG(CancelAllJobs() == NS_FAILURE, "APCJobSystem: Failed to shutdown a job. forcing advance.");
+    CancelAllJobs().IgnoreResult();
+    StopWorkerThreads();
     m_MaxThreads = 0;
     nsLog::Info("Job system shut down.");
   }
 
   void APCJobSystem::SafePoll()
   {
-    wakeCondition.notify_one(); // wake one worker thread
-    std::this_thread::yield();  // allow this thread to be rescheduled
+    std::this_thread::yield(); // allow this thread to be rescheduled
   }
 
   nsUInt8 APCJobSystem::ActiveThreads() const
@@ -289,8 +333,12 @@ namespace aperture::core::threading
 
   nsUInt8 APCJobSystem::QueuedJobs() const
   {
-    return m_CompositionQueues.GetCount() + m_ScriptQueues.GetCount() +
-           m_RenderingQueues.GetCount() + m_ParsingQueues.GetCount();
+    nsUInt32 uiQueued = 0;
+    for (const JobPool& pool : m_Pools)
+    {
+      uiQueued += pool.m_uiQueuedJobs.load(std::memory_order_relaxed);
+    }
+    return static_cast<nsUInt8>(nsMath::Min<nsUInt32>(uiQueued, 0xFF));
   }
 
   nsUInt8 APCJobSystem::ActiveCompositionThreads() const
@@ -318,156 +366,865 @@ namespace aperture::core::threading
     m_CommandGroups.PushBack(p_group);
     nsLog::Info("Added command group: {0}", p_group.m_sGroupName);
   }
+
   void APCJobSystem::RunGeneral()
   {
-    // Run the job system
-    for (auto& job : m_CompositionQueues)
+    // Run the job system on the calling thread until every pool is drained.
+    nsLog::Info("Job system running.");
+    while (HelpExecuteJob())
     {
-      if (job.second->Execute() == NS_FAILURE)
-      {
-        nsLog::Error("Job of Type: {0} failed to execute.", CommandTypeToString(job.second->GetType()));
-        continue;
-      }
     }
-    for (auto& job : m_ScriptQueues)
+  }
+
+  void APCJobSystem::RunThreadsOfType(const core::CommandType& p_runtype)
+  {
+    const nsInt32 iPoolIndex = GetPoolIndex(p_runtype);
+    if (iPoolIndex < 0)
+    {
+      nsLog::Error("Invalid command type: {0}.", static_cast<int>(p_runtype));
+      return;
+    }
+    RunThreadsOfType(m_Pools[iPoolIndex].m_Runtype);
+  }
+
+  void APCJobSystem::RunThreadsOfType(const core::Runtype& p_runtype)
+  {
+    const nsInt32 iPoolIndex = GetPoolIndex(p_runtype);
+    if (iPoolIndex < 0)
+    {
+      nsLog::Error("Invalid runtype: {0}.", static_cast<int>(p_runtype));
+      return;
+    }
+
+    if (!m_bAllowCreationOfNewThreadsOnOverfill)
+    {
+      nsLog::Warning("Dynamic thread creation disabled. Running All Jobs To Complete Overruled ones");
+    }
+
+    // Help the pool on the calling thread until its backlog is gone.
+    JobPool& pool = m_Pools[iPoolIndex];
+    IAPCCommandQueue* pJob = nullptr;
+    while (TakeJobFromPool(pool, pJob, 0))
+    {
+      ExecuteJob(pJob);
+    }
+  }
+
+  void APCJobSystem::AddJob(const IAPCCommandQueue& p_uJob)
+  {
+    // Add a job to the system
+    const nsInt32 iPoolIndex = GetPoolIndex(p_uJob.GetType());
+    if (iPoolIndex < 0)
+    {
+      nsLog::Error("Cannot add job to queue with Type: {0}. No pool handles this type.", CommandTypeToString(p_uJob.GetType()));
+      return;
+    }
+
+    IAPCCommandQueue* pJob = const_cast<IAPCCommandQueue*>(&p_uJob);
+    if (!pJob->TransitionJobState(APCJobState::Idle, APCJobState::Queued))
+    {
+      nsLog::Error("Cannot add job to queue with Type: {0}. The queue is already submitted.", CommandTypeToString(p_uJob.GetType()));
+      return;
+    }
+    pJob->ClearCancellationRequest();
+    nsUuid jobID(0, m_uiNextJobID.fetch_add(1, std::memory_order_relaxed) + 1);
+    jobID.CombineWithSeed(m_JobIDSeed);
+    pJob->SetJobID(jobID);
+    pJob->SetEnqueueTime(nsTime::Now());
+
+    JobPool& pool = m_Pools[iPoolIndex];
+    m_uiJobsInFlight.fetch_add(1);
+
+    // Counted before the job is published, a thief that takes it right away must not decrement the count below zero.
+    // Must be sequentially consistent with the sleep check in WorkerLoop, see there.
+    const nsUInt32 uiQueueDepth = pool.m_uiQueuedJobs.fetch_add(1, std::memory_order_seq_cst) + 1;
+    nsUInt32 uiMaxQueueDepth = pool.m_uiMaxQueueDepth.load(std::memory_order_relaxed);
+    while (uiQueueDepth > uiMaxQueueDepth && !pool.m_uiMaxQueueDepth.compare_exchange_weak(uiMaxQueueDepth, uiQueueDepth, std::memory_order_relaxed))
+    {
+    }
+
+    JobWorker* pCurrentWorker = static_cast<JobWorker*>(tl_pCurrentWorker);
+    if (pCurrentWorker != nullptr && pCurrentWorker->m_pPool == &pool)
+    {
+      pCurrentWorker->m_Deque.Push(pJob);
+    }
+    else if (!pool.m_Injector.try_push(pJob))
+    {
+      NS_LOCK(pool.m_OverflowMutex);
+      pool.m_Overflow.PushBack(pJob);
+      pool.m_uiOverflowCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (m_Backend == APCJobSystemBackend::TaskSystem)
+    {
+      StartDrainTask(pool);
+      return;
+    }
+
+    WakeOneWorker(pool);
+    MaybeGrowPool(pool);
+  }
+
+  nsInt32 APCJobSystem::GetPoolIndex(core::Runtype runtype)
+  {
+    switch (runtype)
+    {
+      case core::Runtype::FreeThread_Composition:
+        return Pool_Composition;
+      case core::Runtype::FreeThread_Scripting:
+        return Pool_Scripting;
+      case core::Runtype::FreeThread_Rendering:
+        return Pool_Rendering;
+      case core::Runtype::FreeThread_Layout:
+        return Pool_Layout;
+      default:
+        return -1;
+    }
+  }
+
+  nsInt32 APCJobSystem::GetPoolIndex(core::CommandType commandType)
+  {
+    switch (commandType)
+    {
+      case core::CommandType::Composition:
+        return Pool_Composition;
+      case core::CommandType::Scripting:
+        return Pool_Scripting;
+      case core::CommandType::Rendering:
+        return Pool_Rendering;
+      case core::CommandType::Layout:
+        return Pool_Layout;
+      default:
+        return -1;
+    }
+  }
+
+  void APCJobSystem::WorkerLoop(JobWorker* pWorker)
+  {
+    tl_pCurrentWorker = pWorker;
+    JobPool& pool = *pWorker->m_pPool;
+
     {
-      if (job.second->Execute() == NS_FAILURE)
+      nsStringBuilder sThreadName;
+      sThreadName.SetFormat("{0} {1}", pool.m_Policy.m_sThreadName.IsEmpty() ? nsStringView(pool.m_szDefaultThreadName) : pool.m_Policy.m_sThreadName.GetView(), pWorker->m_uiWorkerIndex);
+      pWorker->m_uiAffinityMask.store(pool.m_Policy.ApplyToCurrentThread(m_uiReservedCoreMask, sThreadName), std::memory_order_relaxed);
+      pWorker->m_uiLastPreemptions = APCThreadPolicy::GetCurrentThreadPreemptions();
+    }
+
+    m_ActiveThreads++;
+    (*pool.m_pActiveThreadCounter)++;
+
+    nsUInt32 uiJobsSinceSample = 0;
+    while (!m_bShutdown.load(std::memory_order_relaxed))
+    {
+      IAPCCommandQueue* pJob = nullptr;
+      if (FindJob(pWorker, pJob))
       {
-        nsLog::Error("Job of Type: {0} failed to execute.", CommandTypeToString(job.second->GetType()));
+        ExecuteJob(pJob);
+        MaybeGrowPool(pool);
+        if ((++uiJobsSinceSample & 63) == 0)
+        {
+          SamplePreemptions(pWorker);
+        }
         continue;
       }
+
+      // Announce that we are about to sleep, then re-check for work. Together with the seq_cst increment in AddJob this
+      // guarantees that either we see the new job, or the submitter sees us sleeping and wakes us.
+      pWorker->m_bSleeping.store(true, std::memory_order_seq_cst);
+      if (pool.m_uiQueuedJobs.load(std::memory_order_seq_cst) > 0 || m_bShutdown.load())
+      {
+        if (pWorker->m_bSleeping.exchange(false))
+        {
+          // Job not published yet or taken by a sibling, try again.
+          std::this_thread::yield();
+          continue;
+        }
+      }
+
+      SamplePreemptions(pWorker);
+      const nsTime sleepStart = nsTime::Now();
+      bool bWoken = true;
+      {
+        std::unique_lock<std::mutex> lock(pWorker->m_SleepMutex);
+        auto wakePredicate = [pWorker]()
+        { return pWorker->m_bWakeRequested; };
+        if (m_bAllowCreationOfNewThreadsOnOverfill && pool.m_uiRunningWorkers.load(std::memory_order_relaxed) > pool.m_uiBaseWorkers)
+        {
+          bWoken = pWorker->m_SleepCondition.wait_for(lock, std::chrono::nanoseconds(static_cast<nsInt64>(m_IdleRetireTime.GetNanoseconds())), wakePredicate);
+        }
+        else
+        {
+          pWorker->m_SleepCondition.wait(lock, wakePredicate);
+        }
+        pWorker->m_bWakeRequested = false;
+      }
+      const nsTime sleepEnd = nsTime::Now();
+      pWorker->m_Counters.m_uiSleepNanoseconds.fetch_add(static_cast<nsUInt64>((sleepEnd - sleepStart).GetNanoseconds()), std::memory_order_relaxed);
+      nsProfilingSystem::AddCPUScope("APCJobSystem Sleep", nullptr, sleepStart, sleepEnd, nsTime::MakeZero());
+
+      if (!bWoken && TryRetireWorker(pWorker))
+      {
+        break;
+      }
     }
-    for (auto& job : m_RenderingQueues)
+
+    (*pool.m_pActiveThreadCounter)--;
+    m_ActiveThreads--;
+    tl_pCurrentWorker = nullptr;
+    nsProfilingSystem::RemoveThread();
+  }
+
+  void APCJobSystem::SamplePreemptions(JobWorker* pWorker)
+  {
+    // A syscall on Linux, so this runs before sleeping and every few jobs instead of after each one.
+    const nsUInt32 uiPreemptions = APCThreadPolicy::GetCurrentThreadPreemptions();
+    pWorker->m_Counters.m_uiPreemptions.fetch_add(uiPreemptions - pWorker->m_uiLastPreemptions, std::memory_order_relaxed);
+    pWorker->m_uiLastPreemptions = uiPreemptions;
+  }
+
+  bool APCJobSystem::FindJob(JobWorker* pWorker, IAPCCommandQueue*& out_pJob)
+  {
+    JobPool& pool = *pWorker->m_pPool;
+
+    if (pWorker->m_Deque.Pop(out_pJob))
+    {
+      pool.m_uiQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    return TakeJobFromPool(pool, out_pJob, NextStealIndex(pWorker->m_uiStealSeed));
+  }
+
+  bool APCJobSystem::TakeJobFromPool(JobPool& pool, IAPCCommandQueue*& out_pJob, nsUInt32 uiStealStart)
+  {
+    if (pool.m_uiQueuedJobs.load(std::memory_order_relaxed) == 0)
+      return false;
+
+    if (pool.m_Injector.try_pop(out_pJob))
     {
-      if (job.second->Execute() == NS_FAILURE)
+      pool.m_uiQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    if (pool.m_uiOverflowCount.load(std::memory_order_relaxed) > 0)
+    {
+      NS_LOCK(pool.m_OverflowMutex);
+      if (!pool.m_Overflow.IsEmpty())
       {
-        nsLog::Error("Job of Type: {0} failed to execute.", CommandTypeToString(job.second->GetType()));
-        continue;
+        out_pJob = pool.m_Overflow.PeekFront();
+        pool.m_Overflow.PopFront();
+        pool.m_uiOverflowCount.fetch_sub(1, std::memory_order_relaxed);
+        pool.m_uiQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return true;
       }
     }
-    for (auto& job : m_ParsingQueues)
+
+    const nsArrayPtr<JobWorker* const> workers = pool.GetWorkers();
+    const nsUInt32 uiNumWorkers = workers.GetCount();
+    for (nsUInt32 i = 0; i < uiNumWorkers; ++i)
     {
-      if (job.second->Execute() == NS_FAILURE)
+      JobWorker* pVictim = workers[(uiStealStart + i) % uiNumWorkers];
+      if (pVictim != tl_pCurrentWorker && pVictim->m_Deque.Steal(out_pJob))
       {
-        nsLog::Error("Job of Type: {0} failed to execute. continuing.", CommandTypeToString(job.second->GetType()));
-        continue;
+        pool.m_uiQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        GetCurrentCounters(pool).m_uiSteals.fetch_add(1, std::memory_order_relaxed);
+        return true;
       }
     }
-    nsLog::Info("Job system running.");
+
+    return false;
   }
-  void APCJobSystem::RunThreadsOfType(const core::CommandType& p_runtype)
+
+  void APCJobSystem::ExecuteJob(IAPCCommandQueue* pJob)
   {
-    nsHybridArray<std::thread*, 1> m_r_TypeThreads;
-    if (m_bAllowCreationOfNewThreadsOnOverfill)
+    JobCounters& counters = GetCurrentCounters(m_Pools[GetPoolIndex(pJob->GetType())]);
+    nsTime executionTime = nsTime::MakeZero();
+    if (!pJob->TransitionJobState(APCJobState::Queued, APCJobState::Running))
     {
-      switch (p_runtype)
+      // Canceled through CancelJob() while it was queued.
+      SkipCanceledJob(pJob, counters);
+    }
+    else if (pJob->IsCancellationRequested())
+    {
+      // Its token got canceled, one check here instead of searching the deques when cancelling.
+      SkipCanceledJob(pJob, counters);
+    }
+    else
+    {
+      NS_PROFILE_SCOPE(CommandTypeToString(pJob->GetType()));
+
+      const nsTime startTime = nsTime::Now();
+      if (pJob->Execute() == NS_FAILURE)
       {
-        case core::CommandType::Composition:
-          m_r_TypeThreads = m_CompositionThreads;
-          break;
-        case core::CommandType::Scripting:
-          m_r_TypeThreads = m_ScriptThreads;
-          break;
-        case core::CommandType::Rendering:
-          m_r_TypeThreads = m_RenderingThreads;
-          break;
-        case core::CommandType::Layout:
-          m_r_TypeThreads = m_ParsingThreads;
-          break;
-        default:
-          nsLog::Error("Invalid command type: {0}.", static_cast<int>(p_runtype));
-          return;
+        nsLog::Error("Job of Type: {0} failed to execute.", CommandTypeToString(pJob->GetType()));
       }
-      for (auto& thread : m_r_TypeThreads)
+      executionTime = nsTime::Now() - startTime;
+
+      counters.m_Latency.Add(startTime - pJob->GetEnqueueTime());
+      counters.m_Execution.Add(executionTime);
+      if (pJob->GetLastCanceledCommandCount() > 0)
+      {
+        counters.m_uiInterruptedJobs.fetch_add(1, std::memory_order_relaxed);
+        counters.m_uiCanceledCommands.fetch_add(pJob->GetLastCanceledCommandCount(), std::memory_order_relaxed);
+      }
+    }
+
+    // Finished or skipped because it got canceled, either way the queue can be submitted again.
+    pJob->SetJobState(APCJobState::Idle);
+
+    // Dependents get submitted from here, so this has to happen before the job stops counting as in flight, or Wait() could return early.
+    pJob->NotifyJobCompleted(executionTime);
+    m_uiJobsInFlight.fetch_sub(1);
+  }
+
+  void APCJobSystem::SkipCanceledJob(IAPCCommandQueue* pJob, JobCounters& ref_counters)
+  {
+    const nsUInt32 uiCommands = pJob->GetCommandCount();
+    ref_counters.m_uiCanceledJobs.fetch_add(1, std::memory_order_relaxed);
+    ref_counters.m_uiCanceledCommands.fetch_add(uiCommands, std::memory_order_relaxed);
+
+    APCCancellationToken* pToken = pJob->GetCancellationToken();
+    if (pToken != nullptr && pToken->IsCanceled())
+    {
+      pToken->RecordSkippedQueue(uiCommands);
+    }
+  }
+
+  void APCJobSystem::WakeOneWorker(JobPool& pool)
+  {
+    for (JobWorker* pWorker : pool.GetWorkers())
+    {
+      bool bSleeping = true;
+      if (pWorker->m_bSleeping.load(std::memory_order_seq_cst) && pWorker->m_bSleeping.compare_exchange_strong(bSleeping, false))
       {
-        if (thread->joinable())
         {
-          thread->join();
+          std::scoped_lock<std::mutex> lock(pWorker->m_SleepMutex);
+          pWorker->m_bWakeRequested = true;
         }
-        else
+        pWorker->m_SleepCondition.notify_one();
+        return;
+      }
+    }
+  }
+
+  void APCJobSystem::WakeAllWorkers()
+  {
+    for (JobPool& pool : m_Pools)
+    {
+      for (JobWorker* pWorker : pool.GetWorkers())
+      {
+        pWorker->m_bSleeping = false;
         {
-          nsLog::Error("Local Thread not joinable.");
-          continue;
+          std::scoped_lock<std::mutex> lock(pWorker->m_SleepMutex);
+          pWorker->m_bWakeRequested = true;
         }
-        std::thread m_r_OverfillThread([&]()
-          {
-          nsLog::BroadcastLoggingEvent(nullptr, nsLogMsgType::WarningMsg, "ALERT: Overfill thread Created! Attempting to run overflowed tasks!");
-          RunGeneral(); });
+        pWorker->m_SleepCondition.notify_one();
       }
     }
-    else
+  }
+
+  bool APCJobSystem::HelpExecuteJob()
+  {
+    JobWorker* pCurrentWorker = GetCurrentWorker();
+    if (pCurrentWorker != nullptr)
     {
-      nsLog::Warning("Dynamic thread creation disabled. Running All Jobs To Complete Overruled ones");
+      IAPCCommandQueue* pJob = nullptr;
+      if (FindJob(pCurrentWorker, pJob))
+      {
+        ExecuteJob(pJob);
+        return true;
+      }
     }
+
+    for (JobPool& pool : m_Pools)
+    {
+      IAPCCommandQueue* pJob = nullptr;
+      if (TakeJobFromPool(pool, pJob, 0))
+      {
+        ExecuteJob(pJob);
+        return true;
+      }
+    }
+    return false;
   }
 
-  void APCJobSystem::RunThreadsOfType(const core::Runtype& p_runtype)
+  bool APCJobSystem::SpawnWorker(JobPool& pool)
   {
-    nsHybridArray<std::thread*, 1> m_r_TypeThreads;
-    if (m_bAllowCreationOfNewThreadsOnOverfill)
+    JobWorker* pWorker = nullptr;
+    for (JobWorker* pSlot : pool.GetWorkers())
     {
-      switch (p_runtype)
-      {
-        case core::Runtype::FreeThread_Composition:
-          m_r_TypeThreads = m_CompositionThreads;
-        case core::Runtype::FreeThread_Scripting:
-          m_r_TypeThreads = m_ScriptThreads;
-        case core::Runtype::FreeThread_Rendering:
-          m_r_TypeThreads = m_RenderingThreads;
-        case core::Runtype::FreeThread_Layout:
-          m_r_TypeThreads = m_ParsingThreads;
-        default:
-          for (auto& thread : m_r_TypeThreads)
-          {
-            if (thread->joinable())
-            {
-              thread->join();
-            }
-            else
-            {
-              nsLog::Error("Local Thread not joinable.");
-              continue;
-            }
-            std::thread m_r_OverfillThread([&]()
-              {
-                nsLog::BroadcastLoggingEvent(nullptr, nsLogMsgType::WarningMsg, "ALERT: Overfill thread Created! Attempting to run overflowed tasks!");
-                RunGeneral(); });
-          }
-          break;
+      if (pSlot->m_bRetired.load(std::memory_order_acquire))
+      {
+        pWorker = pSlot;
+        break;
       }
     }
+
+    if (pWorker != nullptr)
+    {
+      // The retired thread left WorkerLoop already, or is about to.
+      pWorker->m_Thread.join();
+      pWorker->m_bRetired = false;
+      pWorker->m_bWakeRequested = false;
+    }
     else
     {
-      nsLog::Warning("Dynamic thread creation disabled. Running All Jobs To Complete Overruled ones");
+      const nsUInt32 uiSlot = pool.m_uiNumWorkers.load(std::memory_order_relaxed);
+      if (uiSlot >= JobPool::MaxWorkers)
+        return false;
+
+      pWorker = NS_NEW(nsFoundation::GetAlignedAllocator(), JobWorker);
+      pWorker->m_pPool = &pool;
+      pWorker->m_uiWorkerIndex = uiSlot;
+      pWorker->m_uiStealSeed = 0x9E3779B9u ^ (uiSlot + 1) * 0x85EBCA6Bu;
+      pool.m_Workers[uiSlot] = pWorker;
+
+      // Publish the slot before anyone can see the new count, siblings iterate the slots while stealing.
+      pool.m_uiNumWorkers.store(uiSlot + 1, std::memory_order_release);
     }
+
+    pool.m_uiRunningWorkers.fetch_add(1);
+    m_uiRunningThreads.fetch_add(1);
+    pWorker->m_Thread = std::thread([this, pWorker]()
+      { WorkerLoop(pWorker); });
+    return true;
   }
-  void APCJobSystem::AddJob(const IAPCCommandQueue& p_uJob)
+
+  void APCJobSystem::MaybeGrowPool(JobPool& pool)
   {
-    // Add a job to the system
-    if (p_uJob.m_mutex.IsLocked())
+    if (!m_bAllowCreationOfNewThreadsOnOverfill)
+      return;
+
+    const nsUInt32 uiRunning = pool.m_uiRunningWorkers.load(std::memory_order_relaxed);
+    if (pool.m_uiQueuedJobs.load(std::memory_order_relaxed) <= uiRunning)
     {
-      nsLog::Error("Cannot add job to queue with Type: {0}. Queue is locked.", CommandTypeToString(p_uJob.GetType()));
+      if (pool.m_iBacklogSinceNanoseconds.load(std::memory_order_relaxed) != 0)
+      {
+        pool.m_iBacklogSinceNanoseconds.store(0, std::memory_order_relaxed);
+      }
       return;
     }
-    nsUuid sUuid = sUuid.MakeUuid();
-    switch (p_uJob.GetType())
+
+    if (uiRunning >= m_uiMaxThreadsPerPool || m_uiRunningThreads.load(std::memory_order_relaxed) >= nsMath::Max(std::thread::hardware_concurrency(), 1u))
+      return;
+
+    const nsInt64 iNow = static_cast<nsInt64>(nsTime::Now().GetNanoseconds());
+    nsInt64 iBacklogSince = pool.m_iBacklogSinceNanoseconds.load(std::memory_order_relaxed);
+    if (iBacklogSince == 0)
     {
-      case CommandType::Composition:
-        m_CompositionQueues.PushBack(std::make_pair(sUuid, (IAPCCommandQueue*)&p_uJob));
-        break;
-      case CommandType::Scripting:
-        m_ScriptQueues.PushBack(std::make_pair(sUuid, (IAPCCommandQueue*)&p_uJob));
-        break;
-      case CommandType::Rendering:
-        m_RenderingQueues.PushBack(std::make_pair(sUuid, (IAPCCommandQueue*)&p_uJob));
-        break;
-      case aperture::core::CommandType::Layout:
-        m_ParsingQueues.PushBack(std::make_pair(sUuid, (IAPCCommandQueue*)&p_uJob));
-        break;
+      pool.m_iBacklogSinceNanoseconds.compare_exchange_strong(iBacklogSince, iNow, std::memory_order_relaxed);
+      // A pool without any thread would never see its backlog again, so it grows right away.
+      if (uiRunning > 0)
+        return;
+    }
+    else if (uiRunning > 0 && nsTime::MakeFromNanoseconds(static_cast<double>(iNow - iBacklogSince)) < m_GrowthBacklogTime)
+    {
+      return;
+    }
+
+    if (pool.m_GrowMutex.TryLock().Failed())
+      return;
+
+    if (!m_bShutdown.load() && pool.m_uiRunningWorkers.load() < m_uiMaxThreadsPerPool && SpawnWorker(pool))
+    {
+      // The next thread needs another full backlog period.
+      pool.m_iBacklogSinceNanoseconds.store(iNow, std::memory_order_relaxed);
+      nsLog::Dev("Job pool {0} grew to {1} threads.", RuntypeToString(pool.m_Runtype), pool.m_uiRunningWorkers.load());
+    }
+    pool.m_GrowMutex.Unlock();
+  }
+
+  bool APCJobSystem::TryRetireWorker(JobWorker* pWorker)
+  {
+    JobPool& pool = *pWorker->m_pPool;
+
+    // A submitter that claimed us to wake us up expects us to look for its job.
+    if (!pWorker->m_bSleeping.exchange(false) || pool.m_uiQueuedJobs.load() > 0 || m_bShutdown.load())
+      return false;
+
+    nsUInt32 uiRunning = pool.m_uiRunningWorkers.load();
+    while (uiRunning > pool.m_uiBaseWorkers)
+    {
+      if (pool.m_uiRunningWorkers.compare_exchange_weak(uiRunning, uiRunning - 1))
+      {
+        m_uiRunningThreads.fetch_sub(1);
+        pWorker->m_bRetired.store(true, std::memory_order_release);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void APCJobSystem::StopWorkerThreads()
+  {
+    m_bShutdown = true;
+    WakeAllWorkers();
+
+    // Drain tasks exit as soon as they see the shutdown flag, but they reference the pools until their finish callback ran.
+    if (m_uiDrainTasksAlive.load() > 0)
+    {
+      nsTaskSystem::WaitForCondition([this]()
+        { return m_uiDrainTasksAlive.load() == 0; });
+    }
+    for (JobPool& pool : m_Pools)
+    {
+      pool.m_DrainTasks.Clear();
+      pool.m_uiActiveDrainers = 0;
+    }
+
+    for (JobPool& pool : m_Pools)
+    {
+      NS_LOCK(pool.m_GrowMutex);
+      for (JobWorker* pWorker : pool.GetWorkers())
+      {
+        if (pWorker->m_Thread.joinable())
+        {
+          pWorker->m_Thread.join();
+        }
+      }
+    }
+
+    // Only free the workers once all threads are gone, a thread still running could be stealing from any of them.
+    for (JobPool& pool : m_Pools)
+    {
+      NS_LOCK(pool.m_GrowMutex);
+      for (JobWorker* pWorker : pool.GetWorkers())
+      {
+        NS_DELETE(nsFoundation::GetAlignedAllocator(), pWorker);
+      }
+      pool.m_uiNumWorkers = 0;
+      pool.m_uiRunningWorkers = 0;
+      pool.m_iBacklogSinceNanoseconds = 0;
+    }
+    m_uiRunningThreads = 0;
+  }
+
+  APCJobSystem::JobWorker* APCJobSystem::GetCurrentWorker() const
+  {
+    // The thread local is shared by all job systems, a worker of another one must not touch our pools.
+    JobWorker* pCurrentWorker = static_cast<JobWorker*>(tl_pCurrentWorker);
+    if (pCurrentWorker != nullptr && pCurrentWorker->m_pPool >= m_Pools && pCurrentWorker->m_pPool < m_Pools + Pool_Count)
+    {
+      return pCurrentWorker;
+    }
+    return nullptr;
+  }
+
+  APCJobSystem::JobCounters& APCJobSystem::GetCurrentCounters(JobPool& pool)
+  {
+    if (JobWorker* pCurrentWorker = GetCurrentWorker())
+    {
+      return pCurrentWorker->m_Counters;
+    }
+    return pool.m_ExternalCounters;
+  }
+
+  void APCJobSystem::StartDrainTask(JobPool& pool)
+  {
+    // Must be sequentially consistent with the decrement in OnDrainTaskFinished, see there.
+    nsUInt32 uiActive = pool.m_uiActiveDrainers.load(std::memory_order_seq_cst);
+    do
+    {
+      // Every running drainer picks up one more job before it exits, so only start one if there are more jobs than drainers.
+      if (uiActive >= pool.m_uiMaxDrainers || pool.m_uiQueuedJobs.load(std::memory_order_seq_cst) <= uiActive)
+        return;
+    } while (!pool.m_uiActiveDrainers.compare_exchange_weak(uiActive, uiActive + 1, std::memory_order_seq_cst));
+
+    // A slot is released before the count drops, so there are never more claimed slots than active drainers and one pass
+    // normally finds one.
+    for (const nsSharedPtr<nsTask>& pTask : pool.m_DrainTasks)
+    {
+      DrainTask* pDrainTask = static_cast<DrainTask*>(pTask.Borrow());
+      bool bInUse = false;
+      if (!pDrainTask->m_bInUse.load(std::memory_order_relaxed) && pDrainTask->m_bInUse.compare_exchange_strong(bInUse, true, std::memory_order_acquire))
+      {
+        m_uiDrainTasksAlive.fetch_add(1);
+        nsTaskSystem::StartSingleTask(pTask, GetTaskPriority(pool.m_Runtype));
+        return;
+      }
+    }
+
+    // Only misses when the slots changed hands while we scanned them. Give the count back and decide again from scratch.
+    pool.m_uiActiveDrainers.fetch_sub(1, std::memory_order_seq_cst);
+    StartDrainTask(pool);
+  }
+
+  void APCJobSystem::OnDrainTaskFinished(JobPool& pool, const nsSharedPtr<nsTask>& pTask)
+  {
+    static_cast<DrainTask*>(pTask.Borrow())->m_bInUse.store(false, std::memory_order_release);
+
+    // Together with the seq_cst increment in AddJob either the submitter sees this drainer gone and starts a new one,
+    // or we see the job it submitted after our drainer found the pool empty.
+    pool.m_uiActiveDrainers.fetch_sub(1, std::memory_order_seq_cst);
+    if (!m_bShutdown.load())
+    {
+      StartDrainTask(pool);
+    }
+
+    // Last access to the job system, StopWorkerThreads() may return right after this.
+    m_uiDrainTasksAlive.fetch_sub(1);
+  }
+
+  nsTaskPriority::Enum APCJobSystem::GetTaskPriority(core::Runtype p_runtype)
+  {
+    switch (p_runtype)
+    {
+      case core::Runtype::FreeThread_Composition:
+      case core::Runtype::FreeThread_Rendering:
+        return nsTaskPriority::EarlyThisFrame;
+      case core::Runtype::FreeThread_Layout:
+        return nsTaskPriority::ThisFrame;
+      case core::Runtype::FreeThread_Scripting:
+        return nsTaskPriority::LateThisFrame;
       default:
-        nsLog::Error("Cannot add job to queue with Type: {0}. Queue is locked.", CommandTypeToString(p_uJob.GetType()));
-        break;
+        return nsTaskPriority::ThisFrame;
+    }
+  }
+
+  nsUInt32 APCJobSystem::GetQueuedJobCount(core::Runtype p_runtype) const
+  {
+    const nsInt32 iPoolIndex = GetPoolIndex(p_runtype);
+    return iPoolIndex >= 0 ? m_Pools[iPoolIndex].m_uiQueuedJobs.load(std::memory_order_relaxed) : 0;
+  }
+
+  nsUInt32 APCJobSystem::GetThreadCount(core::Runtype p_runtype) const
+  {
+    const nsInt32 iPoolIndex = GetPoolIndex(p_runtype);
+    if (iPoolIndex < 0)
+      return 0;
+
+    const JobPool& pool = m_Pools[iPoolIndex];
+    return m_Backend == APCJobSystemBackend::TaskSystem ? pool.m_uiActiveDrainers.load(std::memory_order_relaxed) : pool.m_uiRunningWorkers.load(std::memory_order_relaxed);
+  }
+
+  void APCJobSystem::PublishFrameStats()
+  {
+    NS_PROFILE_SCOPE("APCJobSystem::PublishFrameStats");
+    static_assert(APCJobSystemFrameStats::NumPools == Pool_Count);
+
+    const nsTime now = nsTime::Now();
+    APCJobSystemFrameStats& stats = m_LastFrameStats;
+    stats.m_uiFrame = m_uiPublishedFrames++;
+    stats.m_FrameStart = m_LastPublishTime;
+    stats.m_FrameDuration = now - m_LastPublishTime;
+    stats.m_Workers.Clear();
+    m_LastPublishTime = now;
+
+    APCTimeHistogram histogram;
+    for (nsUInt32 uiPool = 0; uiPool < Pool_Count; ++uiPool)
+    {
+      JobPool& pool = m_Pools[uiPool];
+      APCJobPoolFrameStats& poolStats = stats.m_Pools[uiPool];
+      poolStats = APCJobPoolFrameStats();
+      poolStats.m_Runtype = pool.m_Runtype;
+      poolStats.m_uiThreads = GetThreadCount(pool.m_Runtype);
+      poolStats.m_uiMaxQueueDepth = pool.m_uiMaxQueueDepth.exchange(pool.m_uiQueuedJobs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+      auto harvest = [&](JobCounters& ref_counters, APCJobWorkerFrameStats* pWorkerStats)
+      {
+        ref_counters.m_Latency.Harvest(histogram);
+        poolStats.m_Latency.Merge(histogram);
+
+        ref_counters.m_Execution.Harvest(histogram);
+        poolStats.m_Execution.Merge(histogram);
+        poolStats.m_uiJobsExecuted += histogram.m_uiCount;
+
+        const nsUInt32 uiSteals = ref_counters.m_uiSteals.exchange(0, std::memory_order_relaxed);
+        poolStats.m_uiSteals += uiSteals;
+        poolStats.m_uiCanceledJobs += ref_counters.m_uiCanceledJobs.exchange(0, std::memory_order_relaxed);
+        poolStats.m_uiInterruptedJobs += ref_counters.m_uiInterruptedJobs.exchange(0, std::memory_order_relaxed);
+        poolStats.m_uiCanceledCommands += ref_counters.m_uiCanceledCommands.exchange(0, std::memory_order_relaxed);
+
+        const nsTime sleepTime = nsTime::MakeFromNanoseconds(static_cast<double>(ref_counters.m_uiSleepNanoseconds.exchange(0, std::memory_order_relaxed)));
+        if (pWorkerStats != nullptr)
+        {
+          pWorkerStats->m_uiJobsExecuted = histogram.m_uiCount;
+          pWorkerStats->m_uiSteals = uiSteals;
+          pWorkerStats->m_BusyTime = histogram.m_Total;
+          pWorkerStats->m_SleepTime = sleepTime;
+          pWorkerStats->m_IdleTime = nsMath::Max(stats.m_FrameDuration - histogram.m_Total - sleepTime, nsTime::MakeZero());
+          pWorkerStats->m_fUtilization = stats.m_FrameDuration.IsPositive() ? static_cast<float>(histogram.m_Total.GetSeconds() / stats.m_FrameDuration.GetSeconds()) : 0.0f;
+          pWorkerStats->m_uiPreemptions = ref_counters.m_uiPreemptions.exchange(0, std::memory_order_relaxed);
+        }
+        else
+        {
+          ref_counters.m_uiPreemptions.store(0, std::memory_order_relaxed);
+        }
+      };
+
+      harvest(pool.m_ExternalCounters, nullptr);
+      for (JobWorker* pWorker : pool.GetWorkers())
+      {
+        if (pWorker->m_bRetired.load(std::memory_order_relaxed))
+        {
+          harvest(pWorker->m_Counters, nullptr);
+          continue;
+        }
+
+        APCJobWorkerFrameStats& workerStats = stats.m_Workers.ExpandAndGetRef();
+        workerStats.m_Runtype = pool.m_Runtype;
+        workerStats.m_uiWorkerIndex = pWorker->m_uiWorkerIndex;
+        workerStats.m_uiAffinityMask = pWorker->m_uiAffinityMask.load(std::memory_order_relaxed);
+        workerStats.m_Priority = pool.m_Policy.m_priority;
+        harvest(pWorker->m_Counters, &workerStats);
+      }
+
+      if (pool.GetWorkers().IsEmpty() && pool.m_DrainTasks.IsEmpty() && poolStats.m_uiJobsExecuted == 0 && poolStats.m_uiCanceledJobs == 0)
+        continue;
+
+      nsStringBuilder sStat;
+      const char* szPool = RuntypeToString(pool.m_Runtype);
+      sStat.SetFormat("APCJobSystem/{0}/Threads", szPool);
+      nsStats::SetStat(sStat, poolStats.m_uiThreads);
+      sStat.SetFormat("APCJobSystem/{0}/Jobs", szPool);
+      nsStats::SetStat(sStat, poolStats.m_uiJobsExecuted);
+      sStat.SetFormat("APCJobSystem/{0}/Steals", szPool);
+      nsStats::SetStat(sStat, poolStats.m_uiSteals);
+      sStat.SetFormat("APCJobSystem/{0}/MaxQueueDepth", szPool);
+      nsStats::SetStat(sStat, poolStats.m_uiMaxQueueDepth);
+      sStat.SetFormat("APCJobSystem/{0}/CanceledJobs", szPool);
+      nsStats::SetStat(sStat, poolStats.m_uiCanceledJobs + poolStats.m_uiInterruptedJobs);
+      sStat.SetFormat("APCJobSystem/{0}/CanceledCommands", szPool);
+      nsStats::SetStat(sStat, poolStats.m_uiCanceledCommands);
+      sStat.SetFormat("APCJobSystem/{0}/LatencyP95", szPool);
+      nsStats::SetStat(sStat, poolStats.m_Latency.GetPercentile(0.95));
+      sStat.SetFormat("APCJobSystem/{0}/ExecutionP95", szPool);
+      nsStats::SetStat(sStat, poolStats.m_Execution.GetPercentile(0.95));
+    }
+
+    for (const APCJobWorkerFrameStats& workerStats : stats.m_Workers)
+    {
+      nsStringBuilder sStat;
+      sStat.SetFormat("APCJobSystem/{0}/Worker {1}/Utilization", RuntypeToString(workerStats.m_Runtype), workerStats.m_uiWorkerIndex);
+      nsStats::SetStat(sStat, workerStats.m_fUtilization);
+      sStat.SetFormat("APCJobSystem/{0}/Worker {1}/Preemptions", RuntypeToString(workerStats.m_Runtype), workerStats.m_uiWorkerIndex);
+      nsStats::SetStat(sStat, workerStats.m_uiPreemptions);
+    }
+
+    if (m_uiFrameStatsHistorySize > 0)
+    {
+      if (m_FrameStatsHistory.GetCount() >= m_uiFrameStatsHistorySize)
+      {
+        m_FrameStatsHistory.PopFront();
+      }
+      m_FrameStatsHistory.PushBack(stats);
     }
-    nsLog::Info("Job added to queue with Type: {0}.", CommandTypeToString(p_uJob.GetType()));
+
+    AdvanceFrame();
+  }
+
+  void APCJobSystem::AdvanceFrame()
+  {
+    nsHybridArray<APCAsyncJob*, 16> waiters;
+    {
+      NS_LOCK(m_FrameWaitersMutex);
+      waiters = m_FrameWaiters;
+      m_FrameWaiters.Clear();
+    }
+
+    // Jobs that await the next frame again from here go into the fresh list, they wait for the following boundary.
+    for (APCAsyncJob* pJob : waiters)
+    {
+      pJob->Resubmit();
+    }
+  }
+
+  void APCJobSystem::AddFrameWaiter(APCAsyncJob* p_pJob)
+  {
+    NS_LOCK(m_FrameWaitersMutex);
+    m_FrameWaiters.PushBack(p_pJob);
+  }
+
+  void APCJobSystem::SetFrameStatsHistorySize(nsUInt32 p_uiFrames)
+  {
+    m_uiFrameStatsHistorySize = p_uiFrames;
+    while (m_FrameStatsHistory.GetCount() > m_uiFrameStatsHistorySize)
+    {
+      m_FrameStatsHistory.PopFront();
+    }
+  }
+
+  nsResult APCJobSystem::WriteChromeTrace(nsStreamWriter& ref_outputStream) const
+  {
+    nsStandardJSONWriter writer;
+    writer.SetWhitespaceMode(nsJSONWriter::WhitespaceMode::None);
+    writer.SetOutputStream(&ref_outputStream);
+
+    auto beginCounter = [&writer](nsStringView sName, nsTime timestamp)
+    {
+      writer.BeginObject();
+      writer.AddVariableString("name", sName);
+      writer.AddVariableString("cat", "APCJobSystem");
+      writer.AddVariableString("ph", "C");
+      writer.AddVariableUInt32("pid", 0);
+      writer.AddVariableDouble("ts", timestamp.GetMicroseconds());
+      writer.BeginObject("args");
+    };
+    auto endCounter = [&writer]()
+    {
+      writer.EndObject();
+      writer.EndObject();
+    };
+
+    writer.BeginObject();
+    writer.BeginArray("traceEvents");
+
+    nsStringBuilder sName;
+    for (const APCJobSystemFrameStats& stats : m_FrameStatsHistory)
+    {
+      // Counters are sampled at the end of the frame they describe.
+      const nsTime timestamp = stats.m_FrameStart + stats.m_FrameDuration;
+
+      for (const APCJobPoolFrameStats& poolStats : stats.m_Pools)
+      {
+        if (poolStats.m_uiJobsExecuted == 0 && poolStats.m_uiMaxQueueDepth == 0 && poolStats.m_uiCanceledJobs == 0)
+          continue;
+
+        sName.SetFormat("{0} Jobs", RuntypeToString(poolStats.m_Runtype));
+        beginCounter(sName, timestamp);
+        writer.AddVariableUInt32("threads", poolStats.m_uiThreads);
+        writer.AddVariableUInt32("executed", poolStats.m_uiJobsExecuted);
+        writer.AddVariableUInt32("steals", poolStats.m_uiSteals);
+        writer.AddVariableUInt32("maxQueueDepth", poolStats.m_uiMaxQueueDepth);
+        writer.AddVariableUInt32("canceled", poolStats.m_uiCanceledJobs + poolStats.m_uiInterruptedJobs);
+        endCounter();
+
+        sName.SetFormat("{0} Latency (us)", RuntypeToString(poolStats.m_Runtype));
+        beginCounter(sName, timestamp);
+        writer.AddVariableDouble("p50", poolStats.m_Latency.GetPercentile(0.5).GetMicroseconds());
+        writer.AddVariableDouble("p95", poolStats.m_Latency.GetPercentile(0.95).GetMicroseconds());
+        writer.AddVariableDouble("max", poolStats.m_Latency.m_Max.GetMicroseconds());
+        endCounter();
+
+        sName.SetFormat("{0} Execution (us)", RuntypeToString(poolStats.m_Runtype));
+        beginCounter(sName, timestamp);
+        writer.AddVariableDouble("p50", poolStats.m_Execution.GetPercentile(0.5).GetMicroseconds());
+        writer.AddVariableDouble("p95", poolStats.m_Execution.GetPercentile(0.95).GetMicroseconds());
+        writer.AddVariableDouble("max", poolStats.m_Execution.m_Max.GetMicroseconds());
+        endCounter();
+      }
+
+      for (const APCJobWorkerFrameStats& workerStats : stats.m_Workers)
+      {
+        sName.SetFormat("{0} Worker {1}", RuntypeToString(workerStats.m_Runtype), workerStats.m_uiWorkerIndex);
+        beginCounter(sName, timestamp);
+        writer.AddVariableDouble("utilization", workerStats.m_fUtilization);
+        writer.AddVariableDouble("busyMs", workerStats.m_BusyTime.GetMilliseconds());
+        writer.AddVariableDouble("sleepMs", workerStats.m_SleepTime.GetMilliseconds());
+        writer.AddVariableDouble("idleMs", workerStats.m_IdleTime.GetMilliseconds());
+        writer.AddVariableUInt32("preemptions", workerStats.m_uiPreemptions);
+        endCounter();
+      }
+
+      if (writer.HadWriteError())
+      {
+        return NS_FAILURE;
+      }
+    }
+
+    writer.EndArray();
+    writer.EndObject();
+    return writer.HadWriteError() ? NS_FAILURE : NS_SUCCESS;
   }
 } // namespace aperture::core::threading
@@ -36,10 +36,20 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <APHTML/CommandExecutor/IAPCCommandQueue.h>
+#include <APHTML/Interfaces/Internal/APCRingBuffer.h>
+#include <APHTML/Multithreading/APCJobSystemStats.h>
+#include <APHTML/Multithreading/APCThreadPolicy.h>
+#include <APHTML/Multithreading/APCWorkStealingDeque.h>
 #include <APHTML/APEngineCommonIncludes.h>
+#include <Foundation/Containers/Deque.h>
+#include <Foundation/Threading/TaskSystem.h>
+
+class nsStreamWriter;
 
 namespace aperture::core::threading
 {
+  class APCAsyncJob;
+
   /**
    * @brief Represents a group of commands to be executed by the job system.
    *
@@ -57,11 +67,23 @@ namespace aperture::core::threading
     core::Runtype m_runtype = core::Runtype::AnyThread;
     nsHybridArray<IAPCCommandQueue*, 1> m_CommandQueues;
     nsUuid m_GroupID;
+    /// @brief Optional, owned by the caller. APCJobSystem::CancelJobGroup() cancels it, which also cancels its dependents.
+    APCCancellationToken* m_pCancellationToken = nullptr;
 
     CommandGroup() {
         m_GroupID = m_GroupID.MakeUuid();
     }
 
+    /// @brief Sets the group's token and binds every queue that is currently in the group to it.
+    void SetCancellationToken(APCCancellationToken* p_pToken)
+    {
+      m_pCancellationToken = p_pToken;
+      for (IAPCCommandQueue* pQueue : m_CommandQueues)
+      {
+        pQueue->SetCancellationToken(p_pToken);
+      }
+    }
+
     bool operator==(const CommandGroup& p_other) const
     {
       return m_sGroupName == p_other.m_sGroupName && m_runtype == p_other.m_runtype && m_CommandQueues == p_other.m_CommandQueues && m_bRequired == p_other.m_bRequired && m_GroupID == p_other.m_GroupID;
@@ -76,30 +98,82 @@ namespace aperture::core::threading
     }
   };
 
+  /// @brief Which threads execute the jobs of an APCJobSystem.
+  enum class APCJobSystemBackend : nsUInt8
+  {
+    /// Every Runtype owns its own worker threads.
+    DedicatedThreads,
+    /// Runtype queues are drained by nsTaskSystem tasks, so the job system starts no threads of its own.
+    TaskSystem,
+  };
+
   struct NS_APERTURE_DLL APCJobSystemConfig
   {
     nsUInt8 m_Composition_threadcount = 0;
     nsUInt8 m_Script_threadcount = 0;
     nsUInt8 m_Rendering_threadcount = 0;
     nsUInt8 m_Parsing_threadcount = 0;
+    /// Lets every pool grow beyond its thread count above under sustained backlog, and shrink back once the extra threads idle.
     bool m_allowCreationOfNewThreadsOnOverfill = false;
+    /// Ceiling for a single pool when growing. 0 means std::thread::hardware_concurrency().
+    nsUInt8 m_maxThreadsPerRuntype = 0;
+    /// How long a pool has to have more queued jobs than threads before it grows by one thread.
+    nsTime m_growthBacklogTime = nsTime::MakeFromMilliseconds(2);
+    /// Threads above a pool's configured count exit after being idle for this long.
+    nsTime m_idleRetireTime = nsTime::MakeFromSeconds(5);
+    /// With APCJobSystemBackend::TaskSystem the thread counts above limit how many tasks drain a Runtype at the same time.
+    /// 0 means as many as nsTaskSystem has short task workers. Growing is not supported with this backend.
+    APCJobSystemBackend m_backend = APCJobSystemBackend::DedicatedThreads;
+    /// Name, priority and core affinity of each Runtype's threads, in the order of the thread counts above.
+    /// Ignored with APCJobSystemBackend::TaskSystem, nsTaskSystem owns those threads.
+    APCThreadPolicy m_Composition_policy;
+    APCThreadPolicy m_Script_policy;
+    APCThreadPolicy m_Rendering_policy;
+    APCThreadPolicy m_Parsing_policy;
+    /// Cores the host keeps for itself, e.g. for the game's render thread. Bit i is logical core i, no worker runs on them.
+    nsUInt64 m_reservedCoreMask = 0;
   };
   /*
    * @class APCJobSystem
    * @brief An custom made Job System for the Aperture SDK.
    * @note The Job System can take both CommandQueues, and Raw Functions if needed.
    * It is also possible for Queued Job to be executed by the User Directly.
+   *
+   * Every Runtype owns a pool of workers. Each worker owns a Chase-Lev deque (APCWorkStealingDeque), jobs submitted from a worker
+   * of the same Runtype go to that worker's deque, everything else goes to the pool's injector queue. Idle workers first drain
+   * their own deque, then the injector, and then steal from their siblings. Workers sleep on their own condition variable, so
+   * a submission wakes at most one of them.
+   *
+   * With m_allowCreationOfNewThreadsOnOverfill a pool whose backlog exceeds its thread count for m_growthBacklogTime gets one more
+   * worker, up to m_maxThreadsPerRuntype, and never beyond std::thread::hardware_concurrency() threads across all pools. A grown
+   * worker that found nothing to do for m_idleRetireTime exits again, its slot (and deque) is kept for the next growth.
+   *
+   * Every thread counts latency, execution time, steals and sleep time into its own counters. PublishFrameStats() collects them
+   * once per frame into an APCJobSystemFrameStats, publishes the interesting numbers through nsStats and keeps a short history
+   * that WriteChromeTrace() exports. Every job and every worker sleep is a profiling scope, so an nsProfilingSystem capture
+   * shows the matching timeline in the same format.
+   *
+   * With APCJobSystemBackend::TaskSystem no worker is created. Submitting a job starts a drain task on nsTaskSystem with the
+   * priority of its Runtype (see GetTaskPriority()), which executes jobs of that pool until the pool is empty. That way the
+   * game's tasks and the UI's jobs share one set of threads sized to the machine, instead of competing for the same cores.
+   * Drain tasks are allocated once per pool and reused, at most one per allowed concurrent drainer.
    */
   class NS_APERTURE_DLL APCJobSystem
   {
+    friend class APCFrameGraph;
+    friend class APCAsyncJob;
+
   public:
+    APCJobSystem() = default;
+    ~APCJobSystem();
+
     /// @brief Initializes the Job System with a set amount of threads.
     /// @param p_threadcount The amount of threads to use for the Job System.
     /// @param p_allowCreationOfNewThreadsOnOverfill If the Job System should create new threads if the Job Queue is full.
     void InitializeJobSystem(const APCJobSystemConfig& p_config);
 
     /// @brief Runs All Jobs in the Job System. This is meant for FreeThreads, that are not locked to a specific type of work.
-		void RunGeneral();
+    void RunGeneral();
 
     void RunThreadsOfType(const core::CommandType& p_runtype);
     void RunThreadsOfType(const core::Runtype& p_runtype);
@@ -110,14 +184,19 @@ namespace aperture::core::threading
 
     /**
      * @brief Cancels a specific job.
+     *
+     * A queued job is skipped by whichever thread pops it. A running job stops before its next command, long running
+     * commands can poll IAPCCommand::IsCancellationRequested() to stop earlier.
      * @param p_jobid The ID of the job to cancel.
      * @param p_queue The command queue where the job is located.
-     * @return Result of the cancellation operation.
+     * @return NS_FAILURE if the queue belongs to a different job.
      */
     nsResult CancelJob(nsUuid p_jobid, const IAPCCommandQueue& p_queue);
 
     /**
      * @brief Cancels all jobs in a specific command group.
+     *
+     * Cancels the group's token first, if it has one, which also reaches the tokens that depend on it.
      * @param p_group The command group whose jobs should be canceled.
      * @return Result of the cancellation operation.
      */
@@ -144,8 +223,8 @@ namespace aperture::core::threading
     template <typename T>
     void AddLifetimeObject(T* p_object)
     {
-      std::scoped_lock<std::mutex> lock(wakeMutex);
-      m_LifetimeObjects.PushBack(p_object);
+      std::scoped_lock<std::mutex> lock(m_LifetimeMutex);
+      m_LifetimeObjects<T*>.PushBack(p_object);
     }
 
     /**
@@ -172,6 +251,7 @@ namespace aperture::core::threading
 
     /**
      * @brief Waits for all jobs to complete.
+     * @note The calling thread helps executing queued jobs while it waits.
      */
     void Wait();
 
@@ -189,7 +269,7 @@ namespace aperture::core::threading
 
     /**
      * @brief Gets the maximum number of threads allowed.
-     * @return The maximum number of threads.
+     * @return The maximum number of threads. With elastic pools this is the growth ceiling across all pools.
      */
     nsUInt8 MaxThreads() const;
 
@@ -229,40 +309,230 @@ namespace aperture::core::threading
      */
     void AddCommandGroup(const CommandGroup& p_group);
 
-		void AddJob(const IAPCCommandQueue& p_uJob);
+    /**
+     * @brief Submits a queue to the pool that matches its CommandType.
+     *
+     * If called from a worker of that pool, the queue is pushed to the worker's own deque, otherwise to the pool's injector.
+     * At most one sleeping worker is woken up.
+     */
+    void AddJob(const IAPCCommandQueue& p_uJob);
+
+    /// @brief Number of jobs of one Runtype that were submitted and not yet picked up by any thread.
+    nsUInt32 GetQueuedJobCount(core::Runtype p_runtype) const;
+
+    /// @brief Number of worker threads a pool currently runs, including grown ones. With the task system backend the number of drain tasks in flight.
+    nsUInt32 GetThreadCount(core::Runtype p_runtype) const;
+
+    APCJobSystemBackend GetBackend() const { return m_Backend; }
+
+    /// @brief The nsTaskSystem priority that drain tasks of a Runtype run with.
+    static nsTaskPriority::Enum GetTaskPriority(core::Runtype p_runtype);
+
+    /**
+     * @brief Collects the counters of all threads into a new APCJobSystemFrameStats and publishes it through nsStats.
+     *
+     * Meant to be called once per frame, from one thread. The frame spans the time since the previous call.
+     * Jobs executed by non-worker threads (e.g. while waiting) count towards the pool of the job.
+     * Also calls AdvanceFrame().
+     */
+    void PublishFrameStats();
+
+    /// @brief Marks a frame boundary, every APCAsyncJob that awaits the next frame is submitted again.
+    void AdvanceFrame();
+
+    /// @brief The stats of the last PublishFrameStats() call.
+    const APCJobSystemFrameStats& GetLastFrameStats() const { return m_LastFrameStats; }
+
+    /// @brief How many published frames are kept for WriteChromeTrace(). Defaults to 300, zero disables the history.
+    void SetFrameStatsHistorySize(nsUInt32 p_uiFrames);
+
+    /**
+     * @brief Writes the frame stats history as counter events in the Chrome trace JSON format (chrome://tracing, Perfetto).
+     *
+     * One counter track per pool (jobs, steals, queue depth, latency and execution percentiles) and one per worker
+     * (utilization, busy and sleep time).
+     */
+    nsResult WriteChromeTrace(nsStreamWriter& ref_outputStream) const;
+
   protected:
+    enum PoolIndex : nsUInt8
+    {
+      Pool_Composition,
+      Pool_Scripting,
+      Pool_Rendering,
+      Pool_Layout,
+      Pool_Count
+    };
+
+    struct JobPool;
+    class DrainTask;
+
+    /// @brief Counters of one thread, or of all non-worker threads for a pool. Harvested by PublishFrameStats().
+    struct JobCounters
+    {
+      APCAtomicTimeHistogram m_Latency;
+      APCAtomicTimeHistogram m_Execution;
+      std::atomic<nsUInt32> m_uiSteals = 0;
+      std::atomic<nsUInt64> m_uiSleepNanoseconds = 0;
+      std::atomic<nsUInt32> m_uiCanceledJobs = 0;
+      std::atomic<nsUInt32> m_uiInterruptedJobs = 0;
+      std::atomic<nsUInt32> m_uiCanceledCommands = 0;
+      std::atomic<nsUInt32> m_uiPreemptions = 0;
+    };
+
+    /// @brief A single worker thread, owning its deque and its own sleep/wake primitives.
+    /// @note Workers are never freed before shutdown. A retired worker keeps its slot and can be restarted by the next growth.
+    struct JobWorker
+    {
+      /// Only written by the worker itself, so its cache line is never shared while counting.
+      alignas(APC_CACHE_LINE_SIZE) JobCounters m_Counters;
+
+      APCWorkStealingDeque<IAPCCommandQueue*> m_Deque;
+      JobPool* m_pPool = nullptr;
+      nsUInt32 m_uiWorkerIndex = 0;
+      nsUInt32 m_uiStealSeed = 0;
+      std::thread m_Thread;
+      /// What APCThreadPolicy::ApplyToCurrentThread() returned when the thread started.
+      std::atomic<nsUInt64> m_uiAffinityMask = 0;
+      /// The thread's preemption count when it was last added to m_Counters.
+      nsUInt32 m_uiLastPreemptions = 0;
+
+      std::mutex m_SleepMutex;
+      std::condition_variable m_SleepCondition;
+      bool m_bWakeRequested = false;
+      std::atomic<bool> m_bSleeping = false;
+      std::atomic<bool> m_bRetired = false;
+    };
+
+    /// @brief All workers of one Runtype plus the injector used by non-worker threads.
+    struct JobPool
+    {
+      JobPool()
+        : m_Injector(InjectorCapacity)
+      {
+      }
+
+      static constexpr size_t InjectorCapacity = 1024;
+
+      static constexpr nsUInt32 MaxWorkers = 64;
+
+      /// @brief The worker slots in use. Slots are only ever appended, so this can be iterated while the pool grows.
+      nsArrayPtr<JobWorker* const> GetWorkers() const { return nsArrayPtr<JobWorker* const>(m_Workers, m_uiNumWorkers.load(std::memory_order_acquire)); }
+
+      core::Runtype m_Runtype = core::Runtype::AnyThread;
+      APCThreadPolicy m_Policy;
+      /// Thread name prefix when the policy has none, short enough to survive Linux' 15 character limit with the index.
+      const char* m_szDefaultThreadName = "";
+      JobWorker* m_Workers[MaxWorkers] = {};
+      std::atomic<nsUInt32> m_uiNumWorkers = 0;
+      std::atomic<nsUInt8>* m_pActiveThreadCounter = nullptr;
+
+      /// Workers whose thread runs. Never drops below m_uiBaseWorkers through retirement.
+      std::atomic<nsUInt32> m_uiRunningWorkers = 0;
+      nsUInt32 m_uiBaseWorkers = 0;
+      nsMutex m_GrowMutex;
+      /// When the pool's backlog started to exceed its thread count, in nanoseconds of nsTime::Now(). Zero while there is none.
+      std::atomic<nsInt64> m_iBacklogSinceNanoseconds = 0;
+
+      /// Lock-free, so submitting from outside the pool never allocates. Only when it is full, jobs spill into the overflow deque.
+      MPMCRingBuffer<IAPCCommandQueue*> m_Injector;
+      nsMutex m_OverflowMutex;
+      nsDeque<IAPCCommandQueue*> m_Overflow;
+      std::atomic<nsUInt32> m_uiOverflowCount = 0;
+
+      /// Jobs that were submitted to this pool and not yet taken by anyone.
+      alignas(APC_CACHE_LINE_SIZE) std::atomic<nsUInt32> m_uiQueuedJobs = 0;
+      std::atomic<nsUInt32> m_uiMaxQueueDepth = 0;
+
+      /// Jobs of this pool executed or stolen by threads that are not workers of this job system.
+      alignas(APC_CACHE_LINE_SIZE) JobCounters m_ExternalCounters;
+
+      /// Task system backend only. One preallocated DrainTask per drainer that may run at the same time.
+      nsHybridArray<nsSharedPtr<nsTask>, 4> m_DrainTasks;
+      std::atomic<nsUInt32> m_uiActiveDrainers = 0;
+      nsUInt32 m_uiMaxDrainers = 0;
+    };
+
+    static nsInt32 GetPoolIndex(core::Runtype runtype);
+    static nsInt32 GetPoolIndex(core::CommandType commandType);
+
+    void WorkerLoop(JobWorker* pWorker);
+    bool FindJob(JobWorker* pWorker, IAPCCommandQueue*& out_pJob);
+    bool TakeJobFromPool(JobPool& pool, IAPCCommandQueue*& out_pJob, nsUInt32 uiStealStart);
+    void ExecuteJob(IAPCCommandQueue* pJob);
+    /// @brief p_pJob is submitted again by the next AdvanceFrame().
+    void AddFrameWaiter(APCAsyncJob* p_pJob);
+    /// @brief Adds the preemptions since the last sample to the worker's counters. Worker thread only.
+    void SamplePreemptions(JobWorker* pWorker);
+    /// @brief Drops a canceled job that was popped before it ran.
+    void SkipCanceledJob(IAPCCommandQueue* pJob, JobCounters& ref_counters);
+    void WakeOneWorker(JobPool& pool);
+    void WakeAllWorkers();
+    bool HelpExecuteJob();
+    void StopWorkerThreads();
+    /// @brief Starts one more worker in the pool, reusing a retired slot if there is one. Expects m_GrowMutex to be locked.
+    bool SpawnWorker(JobPool& pool);
+    /// @brief Grows the pool by one worker if its backlog outlasted m_growthBacklogTime and the ceilings allow it. Cheap when not.
+    void MaybeGrowPool(JobPool& pool);
+    /// @brief Called by an idle worker whose sleep timed out. Returns true if the worker has to exit.
+    bool TryRetireWorker(JobWorker* pWorker);
+    /// @brief The calling thread's worker, or nullptr if the thread is not a worker of this job system.
+    JobWorker* GetCurrentWorker() const;
+    /// @brief The counters of the calling thread, or the pool's external counters if it is not one of our workers.
+    JobCounters& GetCurrentCounters(JobPool& pool);
+    /// @brief Task system backend. Starts another drain task for the pool unless the pool already has its maximum running.
+    void StartDrainTask(JobPool& pool);
+    /// @brief Task system backend. Runs on the task system thread once a drain task finished, releases its slot.
+    void OnDrainTaskFinished(JobPool& pool, const nsSharedPtr<nsTask>& pTask);
+
     /// @brief The list of GENERAL lifetime objects managed by the job system.
     template <typename T>
-    static nsHybridArray<T, 1> m_LifetimeObjects;
+    static inline nsHybridArray<T, 1> m_LifetimeObjects;
 
     template <typename T>
-    static nsHybridArray<T, 1> m_ScriptLifetimeObjects;
+    static inline nsHybridArray<T, 1> m_ScriptLifetimeObjects;
 
     template <typename T>
-    static nsHybridArray<T, 1> m_RenderingLifetimeObjects;
+    static inline nsHybridArray<T, 1> m_RenderingLifetimeObjects;
 
     template <typename T>
-    static nsHybridArray<T, 1> m_ParsingLifetimeObjects;
+    static inline nsHybridArray<T, 1> m_ParsingLifetimeObjects;
 
-    std::mutex wakeMutex;
-    std::condition_variable wakeCondition;
+    std::mutex m_LifetimeMutex;
     nsDeque<CommandGroup> m_CommandGroups;
-    nsDeque<std::pair<nsUuid, IAPCCommandQueue*>> m_CompositionQueues;
-    nsDeque<std::pair<nsUuid, IAPCCommandQueue*>> m_ScriptQueues;
-    nsDeque<std::pair<nsUuid, IAPCCommandQueue*>> m_RenderingQueues;
-    nsDeque<std::pair<nsUuid, IAPCCommandQueue*>> m_ParsingQueues;
 
-    nsHybridArray<std::thread*, 1> m_CompositionThreads;
-    nsHybridArray<std::thread*, 1> m_ScriptThreads;
-    nsHybridArray<std::thread*, 1> m_RenderingThreads;
-    nsHybridArray<std::thread*, 1> m_ParsingThreads;
+    JobPool m_Pools[Pool_Count];
 
+    std::atomic<bool> m_bShutdown = false;
+    APCJobSystemBackend m_Backend = APCJobSystemBackend::DedicatedThreads;
+    /// Drain tasks started and not yet done with their finish callback. Shutdown waits for this to reach zero.
+    std::atomic<nsUInt32> m_uiDrainTasksAlive = 0;
     bool m_bAllowCreationOfNewThreadsOnOverfill = false;
-    std::atomic<nsUInt8> m_ActiveThreads;
-    std::atomic<nsUInt8> m_MaxThreads;
-    std::atomic<nsUInt8> m_ActiveCompositionThreads;
-    std::atomic<nsUInt8> m_ActiveScriptThreads;
-    std::atomic<nsUInt8> m_ActiveRenderingThreads;
-    std::atomic<nsUInt8> m_ActiveParsingThreads;
+    nsUInt32 m_uiMaxThreadsPerPool = 0;
+    nsTime m_GrowthBacklogTime;
+    nsTime m_IdleRetireTime;
+    nsUInt64 m_uiReservedCoreMask = 0;
+
+    nsMutex m_FrameWaitersMutex;
+    nsDynamicArray<APCAsyncJob*> m_FrameWaiters;
+    /// Worker threads running across all pools, growth stops at std::thread::hardware_concurrency().
+    std::atomic<nsUInt32> m_uiRunningThreads = 0;
+    /// Job IDs are this seed combined with a running counter. Generating a random Uuid per submission is far too slow for AddJob.
+    nsUuid m_JobIDSeed;
+    std::atomic<nsUInt64> m_uiNextJobID = 0;
+    /// Jobs that were submitted and neither finished nor skipped yet.
+    alignas(APC_CACHE_LINE_SIZE) std::atomic<nsUInt32> m_uiJobsInFlight = 0;
+    std::atomic<nsUInt8> m_ActiveThreads = 0;
+    std::atomic<nsUInt8> m_MaxThreads = 0;
+    std::atomic<nsUInt8> m_ActiveCompositionThreads = 0;
+    std::atomic<nsUInt8> m_ActiveScriptThreads = 0;
+    std::atomic<nsUInt8> m_ActiveRenderingThreads = 0;
+    std::atomic<nsUInt8> m_ActiveParsingThreads = 0;
+
+    nsTime m_LastPublishTime;
+    nsUInt64 m_uiPublishedFrames = 0;
+    APCJobSystemFrameStats m_LastFrameStats;
+    nsUInt32 m_uiFrameStatsHistorySize = 300;
+    nsDeque<APCJobSystemFrameStats> m_FrameStatsHistory;
   };
 } // namespace aperture::core::threading
@@ -0,0 +1,81 @@
+#include <APHTML/Multithreading/APCJobSystemStats.h>
+
+namespace aperture::core::threading
+{
+  nsUInt32 APCTimeHistogram::GetBucketIndex(nsTime duration)
+  {
+    const double fMicroseconds = duration.GetMicroseconds();
+    if (fMicroseconds < 1.0)
+      return 0;
+
+    const nsUInt32 uiMicroseconds = static_cast<nsUInt32>(nsMath::Min(fMicroseconds, 4294967295.0));
+    return nsMath::Min(nsMath::Log2i(uiMicroseconds) + 1, NumBuckets - 1);
+  }
+
+  nsTime APCTimeHistogram::GetBucketUpperBound(nsUInt32 uiBucket)
+  {
+    return nsTime::MakeFromMicroseconds(static_cast<double>(1ull << uiBucket));
+  }
+
+  void APCTimeHistogram::Add(nsTime duration)
+  {
+    ++m_Buckets[GetBucketIndex(duration)];
+    ++m_uiCount;
+    m_Total += duration;
+    m_Max = nsMath::Max(m_Max, duration);
+  }
+
+  void APCTimeHistogram::Merge(const APCTimeHistogram& other)
+  {
+    for (nsUInt32 i = 0; i < NumBuckets; ++i)
+    {
+      m_Buckets[i] += other.m_Buckets[i];
+    }
+    m_uiCount += other.m_uiCount;
+    m_Total += other.m_Total;
+    m_Max = nsMath::Max(m_Max, other.m_Max);
+  }
+
+  nsTime APCTimeHistogram::GetPercentile(double fFraction) const
+  {
+    if (m_uiCount == 0)
+      return nsTime::MakeZero();
+
+    const double fTarget = nsMath::Clamp(fFraction, 0.0, 1.0) * m_uiCount;
+    nsUInt32 uiSum = 0;
+    for (nsUInt32 i = 0; i < NumBuckets; ++i)
+    {
+      uiSum += m_Buckets[i];
+      if (uiSum > 0 && uiSum >= fTarget)
+      {
+        return nsMath::Min(GetBucketUpperBound(i), m_Max);
+      }
+    }
+    return m_Max;
+  }
+
+  void APCAtomicTimeHistogram::Add(nsTime duration)
+  {
+    const nsUInt64 uiNanoseconds = static_cast<nsUInt64>(nsMath::Max(duration.GetNanoseconds(), 0.0));
+    m_Buckets[APCTimeHistogram::GetBucketIndex(duration)].fetch_add(1, std::memory_order_relaxed);
+    m_uiCount.fetch_add(1, std::memory_order_relaxed);
+    m_uiTotalNanoseconds.fetch_add(uiNanoseconds, std::memory_order_relaxed);
+
+    nsUInt64 uiMax = m_uiMaxNanoseconds.load(std::memory_order_relaxed);
+    while (uiNanoseconds > uiMax && !m_uiMaxNanoseconds.compare_exchange_weak(uiMax, uiNanoseconds, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  void APCAtomicTimeHistogram::Harvest(APCTimeHistogram& out_histogram)
+  {
+    out_histogram.Clear();
+    for (nsUInt32 i = 0; i < APCTimeHistogram::NumBuckets; ++i)
+    {
+      out_histogram.m_Buckets[i] = m_Buckets[i].exchange(0, std::memory_order_relaxed);
+    }
+    out_histogram.m_uiCount = m_uiCount.exchange(0, std::memory_order_relaxed);
+    out_histogram.m_Total = nsTime::MakeFromNanoseconds(static_cast<double>(m_uiTotalNanoseconds.exchange(0, std::memory_order_relaxed)));
+    out_histogram.m_Max = nsTime::MakeFromNanoseconds(static_cast<double>(m_uiMaxNanoseconds.exchange(0, std::memory_order_relaxed)));
+  }
+} // namespace aperture::core::threading
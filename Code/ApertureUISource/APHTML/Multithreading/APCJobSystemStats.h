@@ -0,0 +1,142 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <APHTML/APEngineDLL.h>
+#include <APHTML/APEngineCommonIncludes.h>
+#include <APHTML/CommandExecutor/IAPCCommandCommon.h>
+#include <APHTML/Multithreading/APCThreadPolicy.h>
+#include <Foundation/Time/Time.h>
+
+#include <atomic>
+
+namespace aperture::core::threading
+{
+  /**
+   * @brief Histogram of durations with power of two microsecond buckets.
+   *
+   * Bucket 0 holds everything below 1us, bucket i everything in [2^(i-1), 2^i) us, the last bucket everything above.
+   * Percentiles are therefore only accurate to a factor of two, which is plenty to tell a stall from noise.
+   */
+  struct NS_APERTURE_DLL APCTimeHistogram
+  {
+    static constexpr nsUInt32 NumBuckets = 24;
+
+    nsUInt32 m_Buckets[NumBuckets] = {};
+    nsUInt32 m_uiCount = 0;
+    nsTime m_Total;
+    nsTime m_Max;
+
+    static nsUInt32 GetBucketIndex(nsTime duration);
+    /// @brief The smallest duration that no longer falls into the bucket.
+    static nsTime GetBucketUpperBound(nsUInt32 uiBucket);
+
+    void Add(nsTime duration);
+    void Merge(const APCTimeHistogram& other);
+    void Clear() { *this = APCTimeHistogram(); }
+
+    /// @brief Upper bound of the bucket that contains the given fraction (0..1) of all samples, clamped to the maximum.
+    nsTime GetPercentile(double fFraction) const;
+    nsTime GetAverage() const { return m_uiCount > 0 ? m_Total / static_cast<double>(m_uiCount) : nsTime::MakeZero(); }
+  };
+
+  /// @brief Lock-free APCTimeHistogram the job system counts into. Harvest() moves the samples out and starts over.
+  struct NS_APERTURE_DLL APCAtomicTimeHistogram
+  {
+    std::atomic<nsUInt32> m_Buckets[APCTimeHistogram::NumBuckets] = {};
+    std::atomic<nsUInt32> m_uiCount = 0;
+    std::atomic<nsUInt64> m_uiTotalNanoseconds = 0;
+    std::atomic<nsUInt64> m_uiMaxNanoseconds = 0;
+
+    void Add(nsTime duration);
+    void Harvest(APCTimeHistogram& out_histogram);
+  };
+
+  /// @brief What all threads of one Runtype did during a frame.
+  struct NS_APERTURE_DLL APCJobPoolFrameStats
+  {
+    core::Runtype m_Runtype = core::Runtype::AnyThread;
+    /// Worker threads running when the frame was published.
+    nsUInt32 m_uiThreads = 0;
+    nsUInt32 m_uiJobsExecuted = 0;
+    nsUInt32 m_uiSteals = 0;
+    nsUInt32 m_uiMaxQueueDepth = 0;
+    /// Jobs that were dropped because they got canceled before they ran.
+    nsUInt32 m_uiCanceledJobs = 0;
+    /// Jobs that got canceled while running and stopped early.
+    nsUInt32 m_uiInterruptedJobs = 0;
+    /// Commands that never ran, from canceled and interrupted jobs.
+    nsUInt32 m_uiCanceledCommands = 0;
+    /// Time from AddJob until a thread started executing the job.
+    APCTimeHistogram m_Latency;
+    APCTimeHistogram m_Execution;
+  };
+
+  /// @brief What a single worker thread did during a frame.
+  struct NS_APERTURE_DLL APCJobWorkerFrameStats
+  {
+    core::Runtype m_Runtype = core::Runtype::AnyThread;
+    nsUInt32 m_uiWorkerIndex = 0;
+    nsUInt32 m_uiJobsExecuted = 0;
+    nsUInt32 m_uiSteals = 0;
+    nsTime m_BusyTime;
+    nsTime m_SleepTime;
+    /// Neither executing nor sleeping, i.e. searching for work.
+    nsTime m_IdleTime;
+    /// m_BusyTime relative to the frame duration.
+    float m_fUtilization = 0.0f;
+    /// Times the OS took the core away from the worker, e.g. for a higher priority thread sharing its core. Linux only.
+    nsUInt32 m_uiPreemptions = 0;
+    /// The cores the worker is pinned to, 0 if it may run anywhere.
+    nsUInt64 m_uiAffinityMask = 0;
+    APCThreadPriority m_Priority = APCThreadPriority::Default;
+  };
+
+  /// @brief Everything APCJobSystem::PublishFrameStats() collected for one frame.
+  struct NS_APERTURE_DLL APCJobSystemFrameStats
+  {
+    enum : nsUInt32
+    {
+      NumPools = 4
+    };
+
+    nsUInt64 m_uiFrame = 0;
+    nsTime m_FrameStart;
+    nsTime m_FrameDuration;
+    APCJobPoolFrameStats m_Pools[NumPools];
+    nsHybridArray<APCJobWorkerFrameStats, 16> m_Workers;
+  };
+} // namespace aperture::core::threading
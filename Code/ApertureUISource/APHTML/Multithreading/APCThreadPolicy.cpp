@@ -0,0 +1,195 @@
+#include <APHTML/Multithreading/APCThreadPolicy.h>
+#include <Foundation/Profiling/Profiling.h>
+#include <Foundation/Strings/StringBuilder.h>
+
+#include <thread>
+
+#if NS_ENABLED(NS_PLATFORM_WINDOWS)
+#  include <Foundation/Platform/Win/Utils/IncludeWindows.h>
+#elif NS_ENABLED(NS_PLATFORM_LINUX)
+#  include <pthread.h>
+#  include <sched.h>
+#  include <sys/resource.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+namespace aperture::core::threading
+{
+  namespace
+  {
+    nsUInt64 GetAllCoresMask()
+    {
+      const nsUInt32 uiCores = nsMath::Min(nsMath::Max(std::thread::hardware_concurrency(), 1u), 64u);
+      return uiCores == 64 ? ~0ull : (1ull << uiCores) - 1;
+    }
+
+    void SetOSThreadName(nsStringView sName)
+    {
+#if NS_ENABLED(NS_PLATFORM_WINDOWS)
+      using pfnSetThreadDescription = HRESULT(WINAPI*)(HANDLE, PCWSTR);
+      static pfnSetThreadDescription s_pSetThreadDescription = []()
+      {
+        HMODULE hKernel32 = GetModuleHandleW(L"kernel32.dll");
+        return hKernel32 != nullptr ? reinterpret_cast<pfnSetThreadDescription>(GetProcAddress(hKernel32, "SetThreadDescription")) : nullptr;
+      }();
+      if (s_pSetThreadDescription != nullptr)
+      {
+        s_pSetThreadDescription(GetCurrentThread(), nsStringWChar(sName).GetData());
+      }
+#elif NS_ENABLED(NS_PLATFORM_LINUX)
+      // pthread names are limited to 15 characters plus the terminator.
+      char szName[16] = {};
+      nsStringUtils::Copy(szName, NS_ARRAY_SIZE(szName), sName.GetStartPointer(), sName.GetEndPointer());
+      pthread_setname_np(pthread_self(), szName);
+#else
+      NS_IGNORE_UNUSED(sName);
+#endif
+    }
+
+    bool SetOSThreadPriority(APCThreadPriority priority)
+    {
+#if NS_ENABLED(NS_PLATFORM_WINDOWS)
+      int iPriority = THREAD_PRIORITY_NORMAL;
+      switch (priority)
+      {
+        case APCThreadPriority::Lowest:
+          iPriority = THREAD_PRIORITY_LOWEST;
+          break;
+        case APCThreadPriority::BelowNormal:
+          iPriority = THREAD_PRIORITY_BELOW_NORMAL;
+          break;
+        case APCThreadPriority::AboveNormal:
+          iPriority = THREAD_PRIORITY_ABOVE_NORMAL;
+          break;
+        case APCThreadPriority::Highest:
+          iPriority = THREAD_PRIORITY_HIGHEST;
+          break;
+        default:
+          break;
+      }
+      return SetThreadPriority(GetCurrentThread(), iPriority) != FALSE;
+#elif NS_ENABLED(NS_PLATFORM_LINUX)
+      int iNice = 0;
+      switch (priority)
+      {
+        case APCThreadPriority::Lowest:
+          iNice = 10;
+          break;
+        case APCThreadPriority::BelowNormal:
+          iNice = 5;
+          break;
+        case APCThreadPriority::AboveNormal:
+          iNice = -5;
+          break;
+        case APCThreadPriority::Highest:
+          iNice = -10;
+          break;
+        default:
+          break;
+      }
+      // Linux keeps the nice value per thread, PRIO_PROCESS with a thread ID only touches that thread.
+      return setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), iNice) == 0;
+#else
+      NS_IGNORE_UNUSED(priority);
+      return false;
+#endif
+    }
+
+    bool SetOSThreadAffinity(nsUInt64 uiMask)
+    {
+#if NS_ENABLED(NS_PLATFORM_WINDOWS)
+      return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(uiMask)) != 0;
+#elif NS_ENABLED(NS_PLATFORM_LINUX)
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      for (nsUInt32 i = 0; i < 64 && i < CPU_SETSIZE; ++i)
+      {
+        if ((uiMask & (1ull << i)) != 0)
+        {
+          CPU_SET(i, &cpuSet);
+        }
+      }
+      return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+      NS_IGNORE_UNUSED(uiMask);
+      return false;
+#endif
+    }
+  } // namespace
+
+  nsUInt64 APCThreadPolicy::ApplyToCurrentThread(nsUInt64 p_uiReservedCores, nsStringView p_sThreadName) const
+  {
+    nsProfilingSystem::SetThreadName(p_sThreadName);
+    SetOSThreadName(p_sThreadName);
+
+    if (m_priority != APCThreadPriority::Default && !SetOSThreadPriority(m_priority))
+    {
+      nsLog::Warning("Could not change the priority of thread '{0}'.", p_sThreadName);
+    }
+
+    // Threads inherit the affinity of the thread that created them, which may be a pinned host thread. So as soon as any
+    // placement is configured, the mask is always set explicitly.
+    if (m_uiAffinityMask == 0 && p_uiReservedCores == 0)
+      return 0;
+
+    const nsUInt64 uiMask = (m_uiAffinityMask != 0 ? m_uiAffinityMask : GetAllCoresMask()) & ~p_uiReservedCores;
+    if (uiMask == 0)
+    {
+      nsLog::Warning("The affinity of thread '{0}' only contains reserved cores, it runs on any core.", p_sThreadName);
+      return 0;
+    }
+
+    if (!SetOSThreadAffinity(uiMask))
+    {
+      nsLog::Warning("Could not set the affinity of thread '{0}' to {1}.", p_sThreadName, nsArgU(uiMask, 1, false, 16));
+      return 0;
+    }
+    return uiMask;
+  }
+
+  nsUInt64 APCThreadPolicy::GetCurrentThreadAffinity()
+  {
+#if NS_ENABLED(NS_PLATFORM_WINDOWS)
+    // There is no getter for a thread's mask, setting one returns the previous mask.
+    DWORD_PTR uiProcessMask = 0;
+    DWORD_PTR uiSystemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &uiProcessMask, &uiSystemMask))
+      return 0;
+
+    const DWORD_PTR uiThreadMask = SetThreadAffinityMask(GetCurrentThread(), uiProcessMask);
+    if (uiThreadMask != 0)
+    {
+      SetThreadAffinityMask(GetCurrentThread(), uiThreadMask);
+    }
+    return static_cast<nsUInt64>(uiThreadMask);
+#elif NS_ENABLED(NS_PLATFORM_LINUX)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0)
+      return 0;
+
+    nsUInt64 uiMask = 0;
+    for (nsUInt32 i = 0; i < 64 && i < CPU_SETSIZE; ++i)
+    {
+      if (CPU_ISSET(i, &cpuSet))
+      {
+        uiMask |= 1ull << i;
+      }
+    }
+    return uiMask;
+#else
+    return 0;
+#endif
+  }
+
+  nsUInt32 APCThreadPolicy::GetCurrentThreadPreemptions()
+  {
+#if NS_ENABLED(NS_PLATFORM_LINUX)
+    rusage usage = {};
+    if (getrusage(RUSAGE_THREAD, &usage) == 0)
+      return static_cast<nsUInt32>(usage.ru_nivcsw);
+#endif
+    return 0;
+  }
+} // namespace aperture::core::threading
@@ -0,0 +1,85 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <APHTML/APEngineDLL.h>
+#include <APHTML/APEngineCommonIncludes.h>
+#include <Foundation/Strings/String.h>
+
+namespace aperture::core::threading
+{
+  /// @brief OS priority of a worker thread. Maps to a nice value on Linux and to a thread priority on Windows.
+  enum class APCThreadPriority : nsUInt8
+  {
+    /// Keeps whatever the thread inherited from the thread that created it.
+    Default,
+    Lowest,
+    BelowNormal,
+    Normal,
+    /// Needs CAP_SYS_NICE on Linux, the thread keeps its priority without it.
+    AboveNormal,
+    /// Needs CAP_SYS_NICE on Linux, the thread keeps its priority without it.
+    Highest,
+  };
+
+  /**
+   * @brief Where and how the worker threads of one Runtype run.
+   *
+   * Workers apply their policy themselves, right after they started, so a thread that the pool grows later gets the same
+   * placement as the ones created by InitializeJobSystem().
+   */
+  struct NS_APERTURE_DLL APCThreadPolicy
+  {
+    /// Bit i allows logical core i. 0 allows every core that is not reserved by the host.
+    nsUInt64 m_uiAffinityMask = 0;
+    APCThreadPriority m_priority = APCThreadPriority::Default;
+    /// Thread name prefix, the worker index is appended. Empty uses a short name of the Runtype. Linux keeps 15 characters.
+    nsString m_sThreadName;
+
+    /**
+     * @brief Names the calling thread and applies the priority and affinity.
+     * @param p_uiReservedCores Cores the host keeps for itself, e.g. for its render thread. They are removed from the affinity mask.
+     * @return The affinity mask the thread runs with, 0 if it was left alone.
+     */
+    nsUInt64 ApplyToCurrentThread(nsUInt64 p_uiReservedCores, nsStringView p_sThreadName) const;
+
+    /// @brief The cores the calling thread may run on, 0 where the platform can't tell.
+    static nsUInt64 GetCurrentThreadAffinity();
+
+    /// @brief How often the calling thread was preempted so far, 0 where the platform doesn't count it.
+    static nsUInt32 GetCurrentThreadPreemptions();
+  };
+} // namespace aperture::core::threading
@@ -0,0 +1,415 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <APHTML/APEngineCommonIncludes.h>
+#include <Foundation/Time/Time.h>
+
+#include <cmath>
+
+namespace aperture::core::threading
+{
+  /// @brief Refers to one timer of an APCTimerWheel. Stays safe to use after the timer fired, the wheel then just does not know it anymore.
+  struct APCTimerHandle
+  {
+    static constexpr nsUInt32 InvalidIndex = 0xFFFFFFFFu;
+
+    nsUInt32 m_uiIndex = InvalidIndex;
+    nsUInt32 m_uiGeneration = 0;
+
+    bool IsValid() const { return m_uiIndex != InvalidIndex; }
+    bool operator==(const APCTimerHandle& other) const { return m_uiIndex == other.m_uiIndex && m_uiGeneration == other.m_uiGeneration; }
+    bool operator!=(const APCTimerHandle& other) const { return !(*this == other); }
+  };
+
+  /**
+   * @brief A hierarchical timer wheel: 4 levels of 64 slots, each level 64 times coarser than the one below.
+   *
+   * Insert() and Cancel() are O(1). Timers live in an intrusive list inside a node array that is recycled through a free list, so
+   * after warm up no timer allocates. Advance() cascades timers of the coarser levels down as time passes and hands every due
+   * payload to a callback, batched per call. Empty stretches are skipped a whole level at a time.
+   *
+   * With the default 1 ms resolution the wheel spans about 4.6 hours, later timers are parked in the last level and re-placed
+   * whenever it comes around. Timers never fire early, at most one resolution step late.
+   *
+   * @note Not thread-safe, owners that share it between threads lock around it.
+   * @note Callbacks may insert and cancel timers. Timers inserted from a callback fire in the next Advance() at the earliest.
+   */
+  template <typename T>
+  class APCTimerWheel
+  {
+  public:
+    static constexpr nsUInt32 SlotBits = 6;
+    static constexpr nsUInt32 SlotsPerLevel = 1u << SlotBits;
+    static constexpr nsUInt32 Levels = 4;
+
+    explicit APCTimerWheel(nsTime resolution = nsTime::MakeFromMilliseconds(1), nsTime startTime = nsTime::MakeZero())
+      : m_Resolution(resolution)
+    {
+      NS_ASSERT_DEV(resolution.IsPositive(), "APCTimerWheel: The resolution has to be positive.");
+      Clear(startTime);
+    }
+
+    APCTimerWheel(const APCTimerWheel&) = delete;
+    APCTimerWheel& operator=(const APCTimerWheel&) = delete;
+
+    /// @brief Drops all timers and restarts the wheel at p_startTime.
+    void Clear(nsTime p_startTime = nsTime::MakeZero())
+    {
+      m_Nodes.Clear();
+      for (List& list : m_Lists)
+      {
+        list = List();
+      }
+      for (nsUInt64& uiOccupied : m_uiOccupied)
+      {
+        uiOccupied = 0;
+      }
+      m_uiFreeList = InvalidIndex;
+      m_uiCount = 0;
+      m_uiWheelCount = 0;
+      m_StartTime = p_startTime;
+      m_uiCurrentTick = 0;
+    }
+
+    /// @brief Makes room for p_uiTimers timers, so the wheel does not allocate until it holds more.
+    void Reserve(nsUInt32 p_uiTimers) { m_Nodes.Reserve(p_uiTimers); }
+
+    /// @brief Adds a timer that fires at the first Advance() at or after p_dueTime.
+    APCTimerHandle Insert(nsTime p_dueTime, T&& p_payload)
+    {
+      const nsUInt32 uiIndex = AllocateNode();
+      Node& node = m_Nodes[uiIndex];
+      node.m_Payload = std::move(p_payload);
+      node.m_uiDueTick = ToTick(p_dueTime, true);
+      Place(uiIndex);
+      ++m_uiCount;
+      return {uiIndex, node.m_uiGeneration};
+    }
+
+    /// @brief Removes a timer that did not fire yet. Its payload is moved to out_pPayload, if given.
+    /// @return False if the timer already fired or was canceled before.
+    bool Cancel(APCTimerHandle p_handle, T* out_pPayload = nullptr)
+    {
+      if (!IsPending(p_handle))
+        return false;
+
+      Unlink(p_handle.m_uiIndex);
+      if (out_pPayload != nullptr)
+      {
+        *out_pPayload = std::move(m_Nodes[p_handle.m_uiIndex].m_Payload);
+      }
+      FreeNode(p_handle.m_uiIndex);
+      --m_uiCount;
+      return true;
+    }
+
+    bool IsPending(APCTimerHandle p_handle) const
+    {
+      return p_handle.m_uiIndex < m_Nodes.GetCount() && m_Nodes[p_handle.m_uiIndex].m_uiGeneration == p_handle.m_uiGeneration && m_Nodes[p_handle.m_uiIndex].m_uiList != FreeList;
+    }
+
+    /// @brief The payload of a pending timer, nullptr otherwise.
+    T* GetPayload(APCTimerHandle p_handle) { return IsPending(p_handle) ? &m_Nodes[p_handle.m_uiIndex].m_Payload : nullptr; }
+
+    /**
+     * @brief Moves the wheel to p_now and calls p_callback(T&) for every timer that became due, in order of their due time step.
+     * @return How many timers fired.
+     */
+    template <typename Callback>
+    nsUInt32 Advance(nsTime p_now, Callback&& p_callback)
+    {
+      const nsUInt64 uiTargetTick = ToTick(p_now, false);
+
+      SpliceInto(ReadyList, FiringList);
+      while (m_uiCurrentTick < uiTargetTick)
+      {
+        if (m_uiWheelCount == 0)
+        {
+          m_uiCurrentTick = uiTargetTick;
+          break;
+        }
+
+        // Levels below the first occupied one have nothing to fire or cascade, jump to the next tick that could.
+        nsUInt32 uiEmptyLevels = 0;
+        while (uiEmptyLevels < Levels && m_uiOccupied[uiEmptyLevels] == 0)
+        {
+          ++uiEmptyLevels;
+        }
+        const nsUInt64 uiStep = 1ull << (SlotBits * nsMath::Min(uiEmptyLevels, Levels - 1));
+        const nsUInt64 uiNextTick = nsMath::Min((m_uiCurrentTick / uiStep + 1) * uiStep, uiTargetTick);
+        m_uiCurrentTick = uiNextTick;
+
+        // Coarser levels first, so their timers can still end up in the slot fired below.
+        for (nsUInt32 uiLevel = Levels - 1; uiLevel > 0; --uiLevel)
+        {
+          if ((uiNextTick & ((1ull << (SlotBits * uiLevel)) - 1)) == 0)
+          {
+            Cascade(GetListIndex(uiLevel, uiNextTick));
+          }
+        }
+        SpliceInto(GetListIndex(0, uiNextTick), FiringList);
+        SpliceInto(ReadyList, FiringList);
+      }
+
+      nsUInt32 uiFired = 0;
+      while (m_Lists[FiringList].m_uiHead != InvalidIndex)
+      {
+        const nsUInt32 uiIndex = m_Lists[FiringList].m_uiHead;
+        Unlink(uiIndex);
+        T payload = std::move(m_Nodes[uiIndex].m_Payload);
+        FreeNode(uiIndex);
+        --m_uiCount;
+        ++uiFired;
+        p_callback(payload);
+      }
+      return uiFired;
+    }
+
+    /// @brief Number of timers that did not fire yet.
+    nsUInt32 GetCount() const { return m_uiCount; }
+    bool IsEmpty() const { return m_uiCount == 0; }
+
+    nsTime GetResolution() const { return m_Resolution; }
+
+    /// @brief The time the wheel was last advanced to, rounded down to the resolution.
+    nsTime GetCurrentTime() const { return m_StartTime + m_Resolution * static_cast<double>(m_uiCurrentTick); }
+
+  private:
+    static constexpr nsUInt32 InvalidIndex = APCTimerHandle::InvalidIndex;
+    static constexpr nsUInt16 WheelLists = Levels * SlotsPerLevel;
+    /// Due before or at the current tick, fires in the next Advance().
+    static constexpr nsUInt16 ReadyList = WheelLists;
+    /// Collected by the running Advance().
+    static constexpr nsUInt16 FiringList = WheelLists + 1;
+    static constexpr nsUInt16 FreeList = WheelLists + 2;
+    static constexpr nsUInt64 WheelSpan = 1ull << (SlotBits * Levels);
+
+    struct Node
+    {
+      T m_Payload = {};
+      nsUInt64 m_uiDueTick = 0;
+      nsUInt32 m_uiPrev = InvalidIndex;
+      nsUInt32 m_uiNext = InvalidIndex;
+      nsUInt32 m_uiGeneration = 0;
+      nsUInt16 m_uiList = FreeList;
+    };
+
+    struct List
+    {
+      nsUInt32 m_uiHead = InvalidIndex;
+      nsUInt32 m_uiTail = InvalidIndex;
+    };
+
+    static nsUInt16 GetListIndex(nsUInt32 uiLevel, nsUInt64 uiTick)
+    {
+      return static_cast<nsUInt16>(uiLevel * SlotsPerLevel + ((uiTick >> (SlotBits * uiLevel)) & (SlotsPerLevel - 1)));
+    }
+
+    nsUInt64 ToTick(nsTime time, bool bRoundUp) const
+    {
+      // The tolerance keeps times that are exact multiples of the resolution from landing a step off after rounding.
+      constexpr double fTolerance = 1e-4;
+      const double fTicks = (time - m_StartTime).GetSeconds() / m_Resolution.GetSeconds();
+      if (fTicks <= 0.0)
+        return 0;
+      return static_cast<nsUInt64>(bRoundUp ? std::ceil(fTicks - fTolerance) : std::floor(fTicks + fTolerance));
+    }
+
+    nsUInt32 AllocateNode()
+    {
+      if (m_uiFreeList != InvalidIndex)
+      {
+        const nsUInt32 uiIndex = m_uiFreeList;
+        m_uiFreeList = m_Nodes[uiIndex].m_uiNext;
+        return uiIndex;
+      }
+      m_Nodes.ExpandAndGetRef();
+      return m_Nodes.GetCount() - 1;
+    }
+
+    void FreeNode(nsUInt32 uiIndex)
+    {
+      Node& node = m_Nodes[uiIndex];
+      node.m_Payload = T();
+      node.m_uiGeneration++;
+      node.m_uiList = FreeList;
+      node.m_uiPrev = InvalidIndex;
+      node.m_uiNext = m_uiFreeList;
+      m_uiFreeList = uiIndex;
+    }
+
+    /// Puts a timer into the slot that matches its distance to the current tick.
+    void Place(nsUInt32 uiIndex)
+    {
+      const nsUInt64 uiDueTick = m_Nodes[uiIndex].m_uiDueTick;
+      if (uiDueTick <= m_uiCurrentTick)
+      {
+        Link(uiIndex, ReadyList);
+        return;
+      }
+
+      const nsUInt64 uiDelta = uiDueTick - m_uiCurrentTick;
+      for (nsUInt32 uiLevel = 0; uiLevel < Levels; ++uiLevel)
+      {
+        if (uiDelta < (1ull << (SlotBits * (uiLevel + 1))))
+        {
+          Link(uiIndex, GetListIndex(uiLevel, uiDueTick));
+          return;
+        }
+      }
+
+      // Beyond the wheel, park it in the farthest slot. Cascading places it again from its real due tick.
+      Link(uiIndex, GetListIndex(Levels - 1, m_uiCurrentTick + WheelSpan - 1));
+    }
+
+    void Link(nsUInt32 uiIndex, nsUInt16 uiList)
+    {
+      Node& node = m_Nodes[uiIndex];
+      List& list = m_Lists[uiList];
+      node.m_uiList = uiList;
+      node.m_uiPrev = list.m_uiTail;
+      node.m_uiNext = InvalidIndex;
+      if (list.m_uiTail != InvalidIndex)
+      {
+        m_Nodes[list.m_uiTail].m_uiNext = uiIndex;
+      }
+      else
+      {
+        list.m_uiHead = uiIndex;
+      }
+      list.m_uiTail = uiIndex;
+
+      if (uiList < WheelLists)
+      {
+        m_uiOccupied[uiList / SlotsPerLevel] |= 1ull << (uiList % SlotsPerLevel);
+        ++m_uiWheelCount;
+      }
+    }
+
+    void Unlink(nsUInt32 uiIndex)
+    {
+      Node& node = m_Nodes[uiIndex];
+      List& list = m_Lists[node.m_uiList];
+      if (node.m_uiPrev != InvalidIndex)
+      {
+        m_Nodes[node.m_uiPrev].m_uiNext = node.m_uiNext;
+      }
+      else
+      {
+        list.m_uiHead = node.m_uiNext;
+      }
+      if (node.m_uiNext != InvalidIndex)
+      {
+        m_Nodes[node.m_uiNext].m_uiPrev = node.m_uiPrev;
+      }
+      else
+      {
+        list.m_uiTail = node.m_uiPrev;
+      }
+
+      if (node.m_uiList < WheelLists)
+      {
+        if (list.m_uiHead == InvalidIndex)
+        {
+          m_uiOccupied[node.m_uiList / SlotsPerLevel] &= ~(1ull << (node.m_uiList % SlotsPerLevel));
+        }
+        --m_uiWheelCount;
+      }
+      node.m_uiPrev = InvalidIndex;
+      node.m_uiNext = InvalidIndex;
+    }
+
+    /// Moves a whole list to the end of another one, keeping its order.
+    void SpliceInto(nsUInt16 uiFrom, nsUInt16 uiTo)
+    {
+      List& from = m_Lists[uiFrom];
+      if (from.m_uiHead == InvalidIndex)
+        return;
+
+      nsUInt32 uiMoved = 0;
+      for (nsUInt32 uiIndex = from.m_uiHead; uiIndex != InvalidIndex; uiIndex = m_Nodes[uiIndex].m_uiNext)
+      {
+        m_Nodes[uiIndex].m_uiList = uiTo;
+        ++uiMoved;
+      }
+
+      List& to = m_Lists[uiTo];
+      if (to.m_uiTail != InvalidIndex)
+      {
+        m_Nodes[to.m_uiTail].m_uiNext = from.m_uiHead;
+        m_Nodes[from.m_uiHead].m_uiPrev = to.m_uiTail;
+      }
+      else
+      {
+        to.m_uiHead = from.m_uiHead;
+      }
+      to.m_uiTail = from.m_uiTail;
+      from = List();
+
+      if (uiFrom < WheelLists)
+      {
+        m_uiOccupied[uiFrom / SlotsPerLevel] &= ~(1ull << (uiFrom % SlotsPerLevel));
+        m_uiWheelCount -= uiMoved;
+      }
+    }
+
+    /// Places every timer of a coarse slot again, relative to the current tick.
+    void Cascade(nsUInt16 uiList)
+    {
+      nsUInt32 uiIndex = m_Lists[uiList].m_uiHead;
+      while (uiIndex != InvalidIndex)
+      {
+        const nsUInt32 uiNext = m_Nodes[uiIndex].m_uiNext;
+        Unlink(uiIndex);
+        Place(uiIndex);
+        uiIndex = uiNext;
+      }
+    }
+
+    nsTime m_Resolution;
+    nsTime m_StartTime;
+    nsUInt64 m_uiCurrentTick = 0;
+    nsDynamicArray<Node> m_Nodes;
+    List m_Lists[WheelLists + 2];
+    nsUInt64 m_uiOccupied[Levels] = {};
+    nsUInt32 m_uiFreeList = InvalidIndex;
+    /// All timers that did not fire yet.
+    nsUInt32 m_uiCount = 0;
+    /// Timers in the wheel slots, without the ready and firing lists.
+    nsUInt32 m_uiWheelCount = 0;
+  };
+} // namespace aperture::core::threading
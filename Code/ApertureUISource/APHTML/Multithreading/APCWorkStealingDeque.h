@@ -0,0 +1,199 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <APHTML/APEngineCommonIncludes.h>
+#include <APHTML/Interfaces/APCUtils.h>
+
+#include <type_traits>
+
+namespace aperture::core::threading
+{
+  /**
+   * @brief A Chase-Lev work-stealing deque.
+   *
+   * The owning worker pushes and pops at the bottom (LIFO, cache friendly), every other thread may steal from the top (FIFO).
+   * Push/Pop are wait-free for the owner unless the ring has to grow, Steal is lock-free.
+   *
+   * @note Only the owning thread may call Push() and Pop(). Steal(), IsEmpty() and GetCount() are safe from any thread.
+   * @note Rings that were replaced while growing are kept alive until the deque is destroyed, since a thief may still read from them.
+   */
+  template <typename T>
+  class APCWorkStealingDeque
+  {
+    static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(void*), "APCWorkStealingDeque only supports pointer sized, trivially copyable items.");
+
+  public:
+    explicit APCWorkStealingDeque(nsUInt32 uiInitialCapacity = 256)
+    {
+      m_pRing.store(CreateRing(nsMath::PowerOfTwo_Ceil(nsMath::Max(uiInitialCapacity, 2u))), std::memory_order_relaxed);
+    }
+
+    ~APCWorkStealingDeque()
+    {
+      DestroyRing(m_pRing.load(std::memory_order_relaxed));
+      for (Ring* pRing : m_RetiredRings)
+      {
+        DestroyRing(pRing);
+      }
+    }
+
+    APCWorkStealingDeque(const APCWorkStealingDeque&) = delete;
+    APCWorkStealingDeque& operator=(const APCWorkStealingDeque&) = delete;
+
+    /// @brief Pushes an item to the bottom of the deque. Owner only.
+    void Push(T item)
+    {
+      const nsInt64 iBottom = m_iBottom.load(std::memory_order_relaxed);
+      const nsInt64 iTop = m_iTop.load(std::memory_order_acquire);
+      Ring* pRing = m_pRing.load(std::memory_order_relaxed);
+
+      if (iBottom - iTop > pRing->m_iMask)
+      {
+        pRing = Grow(pRing, iTop, iBottom);
+      }
+
+      pRing->Store(iBottom, item);
+      std::atomic_thread_fence(std::memory_order_release);
+      m_iBottom.store(iBottom + 1, std::memory_order_relaxed);
+    }
+
+    /// @brief Pops the most recently pushed item. Owner only.
+    /// @return False if the deque was empty or the last item was stolen concurrently.
+    bool Pop(T& out_item)
+    {
+      const nsInt64 iBottom = m_iBottom.load(std::memory_order_relaxed) - 1;
+      Ring* pRing = m_pRing.load(std::memory_order_relaxed);
+      m_iBottom.store(iBottom, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      nsInt64 iTop = m_iTop.load(std::memory_order_relaxed);
+
+      if (iTop > iBottom)
+      {
+        // Empty, restore bottom.
+        m_iBottom.store(iBottom + 1, std::memory_order_relaxed);
+        return false;
+      }
+
+      out_item = pRing->Load(iBottom);
+      if (iTop != iBottom)
+      {
+        // More than one item left, no race with thieves possible.
+        return true;
+      }
+
+      // Last item, race against thieves for it.
+      const bool bWon = m_iTop.compare_exchange_strong(iTop, iTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      m_iBottom.store(iBottom + 1, std::memory_order_relaxed);
+      return bWon;
+    }
+
+    /// @brief Steals the oldest item. Safe from any thread.
+    /// @return False if the deque was empty or another thread won the race for the item.
+    bool Steal(T& out_item)
+    {
+      nsInt64 iTop = m_iTop.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const nsInt64 iBottom = m_iBottom.load(std::memory_order_acquire);
+
+      if (iTop >= iBottom)
+        return false;
+
+      Ring* pRing = m_pRing.load(std::memory_order_acquire);
+      const T item = pRing->Load(iTop);
+      if (!m_iTop.compare_exchange_strong(iTop, iTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return false;
+
+      out_item = item;
+      return true;
+    }
+
+    /// @brief Approximate number of items. Exact only when called by the owner without concurrent thieves.
+    nsUInt32 GetCount() const
+    {
+      const nsInt64 iBottom = m_iBottom.load(std::memory_order_relaxed);
+      const nsInt64 iTop = m_iTop.load(std::memory_order_relaxed);
+      return iBottom > iTop ? static_cast<nsUInt32>(iBottom - iTop) : 0u;
+    }
+
+    bool IsEmpty() const { return GetCount() == 0; }
+
+  private:
+    struct Ring
+    {
+      nsInt64 m_iMask = 0;
+      std::atomic<T>* m_pItems = nullptr;
+
+      NS_ALWAYS_INLINE void Store(nsInt64 iIndex, T item) { m_pItems[iIndex & m_iMask].store(item, std::memory_order_relaxed); }
+      NS_ALWAYS_INLINE T Load(nsInt64 iIndex) const { return m_pItems[iIndex & m_iMask].load(std::memory_order_relaxed); }
+    };
+
+    static Ring* CreateRing(nsUInt32 uiCapacity)
+    {
+      Ring* pRing = NS_DEFAULT_NEW(Ring);
+      pRing->m_iMask = static_cast<nsInt64>(uiCapacity) - 1;
+      pRing->m_pItems = NS_DEFAULT_NEW_RAW_BUFFER(std::atomic<T>, uiCapacity);
+      for (nsUInt32 i = 0; i < uiCapacity; ++i)
+      {
+        new (&pRing->m_pItems[i]) std::atomic<T>(T{});
+      }
+      return pRing;
+    }
+
+    static void DestroyRing(Ring* pRing)
+    {
+      NS_DEFAULT_DELETE_RAW_BUFFER(pRing->m_pItems);
+      NS_DEFAULT_DELETE(pRing);
+    }
+
+    Ring* Grow(Ring* pOldRing, nsInt64 iTop, nsInt64 iBottom)
+    {
+      Ring* pNewRing = CreateRing(static_cast<nsUInt32>((pOldRing->m_iMask + 1) * 2));
+      for (nsInt64 i = iTop; i < iBottom; ++i)
+      {
+        pNewRing->Store(i, pOldRing->Load(i));
+      }
+      m_RetiredRings.PushBack(pOldRing);
+      m_pRing.store(pNewRing, std::memory_order_release);
+      return pNewRing;
+    }
+
+    alignas(APC_CACHE_LINE_SIZE) std::atomic<nsInt64> m_iTop = 0;
+    alignas(APC_CACHE_LINE_SIZE) std::atomic<nsInt64> m_iBottom = 0;
+    alignas(APC_CACHE_LINE_SIZE) std::atomic<Ring*> m_pRing = nullptr;
+    nsHybridArray<Ring*, 4> m_RetiredRings;
+  };
+} // namespace aperture::core::threading
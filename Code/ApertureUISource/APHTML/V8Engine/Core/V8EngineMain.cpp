@@ -2,6 +2,14 @@
 #include <APHTML/V8Engine/Core/V8EngineMain.h>
 #include "V8EngineMain.h"
 
+aperture::v8::V8EEngineMain::V8EEngineMain()
+  : m_HarrlowMemory(m_MemoryBudgets)
+{
+  const core::APCMemoryBudgets::BudgetId budget = m_MemoryBudgets.GetBudget(core::APCMemorySubsystem::V8Heap);
+  m_MemoryBudgets.SetUsageCallback(budget, core::APCMemoryBudgets::UsageCallback(&V8EEngineMain::GetV8HeapUsage, this));
+  m_MemoryBudgets.AddEvictionCallback(budget, 0, core::APCMemoryBudgets::EvictionCallback(&V8EEngineMain::CollectV8Garbage, this));
+}
+
 bool aperture::v8::V8EEngineMain::InitializeV8Engine(const char* p_ccResources)
 {
   nsStringBuilder* finalResourceDir = nullptr;
@@ -31,7 +39,7 @@ bool aperture::v8::V8EEngineMain::InitializeV8Engine(const char* p_ccResources)
     ::v8::V8::InitializePlatform(m_pV8EPlatform.get());
     if (::v8::V8::Initialize())
     {
-      
+      m_FrameStart = nsTime::Now();
       nsLog::Success("V8Engine: Successfully Initialized V8.");
       return true;
     }
@@ -48,6 +56,38 @@ void aperture::v8::V8EEngineMain::ShutdownV8Engine()
   m_pV8EPlatform.reset();
   nsLog::Success("V8Engine: Successfully Shutdown V8.");
 }
+void aperture::v8::V8EEngineMain::EndFrame()
+{
+  NS_PROFILE_SCOPE("V8EEngineMain::EndFrame");
+
+  // The isolates are used on this thread, so V8's idle tasks may run here.
+  const nsTime idleTime = nsMath::Max(m_FrameBudget - (nsTime::Now() - m_FrameStart), nsTime::MakeZero());
+  m_pV8EJobManager->EndFrame(idleTime);
+
+  // right after the job system stats, so both describe the same frame
+  m_MemoryBudgets.Update();
+
+  NS_LOCK(m_IsolatesMutex);
+  for (V8EThreadSafeIsolate* pIsolate : m_Isolates)
+  {
+    pIsolate->ReportExternalMemory();
+  }
+
+  m_FrameStart = nsTime::Now();
+}
+
+void aperture::v8::V8EEngineMain::AddIsolate(V8EThreadSafeIsolate* pIsolate)
+{
+  NS_LOCK(m_IsolatesMutex);
+  m_Isolates.PushBack(pIsolate);
+}
+
+void aperture::v8::V8EEngineMain::RemoveIsolate(V8EThreadSafeIsolate* pIsolate)
+{
+  NS_LOCK(m_IsolatesMutex);
+  m_Isolates.RemoveAndSwap(pIsolate);
+}
+
 aperture::v8::jobsystem::V8EJobManager* aperture::v8::V8EEngineMain::GetV8EJobManager()
 {
   return m_pV8EJobManager.get();
@@ -57,3 +97,38 @@ aperture::v8::jobsystem::V8EPlatform* aperture::v8::V8EEngineMain::GetV8EEngineP
 {
   return m_pV8EPlatform.get();
 }
+
+aperture::core::APCMemoryBudgets& aperture::v8::V8EEngineMain::GetMemoryBudgets()
+{
+  return m_MemoryBudgets;
+}
+
+aperture::core::APCHarrlowMemory& aperture::v8::V8EEngineMain::GetHarrlowMemory()
+{
+  return m_HarrlowMemory;
+}
+
+nsUInt64 aperture::v8::V8EEngineMain::GetV8HeapUsage()
+{
+  // m_MemoryBudgets.Update() runs in EndFrame(), on the isolates' thread
+  NS_LOCK(m_IsolatesMutex);
+
+  nsUInt64 uiUsage = 0;
+  for (V8EThreadSafeIsolate* pIsolate : m_Isolates)
+  {
+    uiUsage += pIsolate->GetUsedHeapSize();
+  }
+  return uiUsage;
+}
+
+nsUInt64 aperture::v8::V8EEngineMain::CollectV8Garbage(nsUInt64 p_uiBytes)
+{
+  NS_LOCK(m_IsolatesMutex);
+
+  nsUInt64 uiFreed = 0;
+  for (nsUInt32 i = 0; i < m_Isolates.GetCount() && uiFreed < p_uiBytes; ++i)
+  {
+    uiFreed += m_Isolates[i]->CollectGarbage();
+  }
+  return uiFreed;
+}
@@ -36,7 +36,10 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <APHTML/APEngineCommonIncludes.h>
+#include <APHTML/Interfaces/APCHarrlowMemory.h>
+#include <APHTML/Interfaces/APCMemoryBudgets.h>
 #include <APHTML/V8Engine/System/JobSystem/V8EJobManager.h>
+#include <APHTML/V8Engine/System/Utils/Multithreading/V8EThreadSafeIsolate.h>
 #include <APHTML/V8Engine/V8EngineDLL.h>
 
 namespace aperture::v8
@@ -44,14 +47,44 @@ namespace aperture::v8
   class NS_V8ENGINE_DLL V8EEngineMain
   {
   public:
+    /// @brief Counts the heaps of the added isolates towards the APCMemorySubsystem::V8Heap budget, over budget they are garbage collected.
+    V8EEngineMain();
+
     bool InitializeV8Engine(const char* p_ccResources = nullptr);
 
     void ShutdownV8Engine();
-    
+
+    /// @brief Called by the host once per frame on the main thread, after the frame's work was submitted. Runs V8's idle tasks in
+    /// the time that is left of the frame budget, recycles the job arena of the previous frame, publishes the job system stats,
+    /// updates the memory budgets and reports the ArrayBuffer memory of the added isolates to V8.
+    void EndFrame();
+
+    /// @brief The time one frame may take, 1/60 s by default. A frame is measured from the end of the previous EndFrame().
+    void SetFrameBudget(nsTime p_budget) { m_FrameBudget = p_budget; }
+    nsTime GetFrameBudget() const { return m_FrameBudget; }
+
+    /// @brief Adds an isolate whose ArrayBuffer memory EndFrame() reports and whose heap counts towards the V8 heap budget.
+    /// Isolates are created on the main thread, like EndFrame() runs.
+    void AddIsolate(V8EThreadSafeIsolate* pIsolate);
+    void RemoveIsolate(V8EThreadSafeIsolate* pIsolate);
+
     jobsystem::V8EJobManager* GetV8EJobManager();
     jobsystem::V8EPlatform* GetV8EEnginePlatform();
+    /// @brief Hand them to IAPCMemoryAllocator::SetMemoryBudgets(), so that view heaps count towards the DOM and style budget.
+    core::APCMemoryBudgets& GetMemoryBudgets();
+    /// @brief Add the Harrlow buffer stores and text systems to it that the host draws with.
+    core::APCHarrlowMemory& GetHarrlowMemory();
 
   private:
+    nsUInt64 GetV8HeapUsage();
+    nsUInt64 CollectV8Garbage(nsUInt64 p_uiBytes);
+
+    nsTime m_FrameBudget = nsTime::MakeFromSeconds(1.0 / 60.0);
+    nsTime m_FrameStart;
+    core::APCMemoryBudgets m_MemoryBudgets;
+    core::APCHarrlowMemory m_HarrlowMemory;
+    nsMutex m_IsolatesMutex;
+    nsHybridArray<V8EThreadSafeIsolate*, 4> m_Isolates;
     std::unique_ptr<jobsystem::V8EJobManager> m_pV8EJobManager;
     std::unique_ptr<jobsystem::V8EPlatform> m_pV8EPlatform;
   };
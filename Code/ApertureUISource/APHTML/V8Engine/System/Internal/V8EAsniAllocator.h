@@ -38,79 +38,135 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <APHTML/Interfaces/APCPlatform.h>
 #include <Foundation/Math/Math.h>
 
+#include <type_traits>
+#include <utility>
+
 namespace aperture::core
 {
+  /// @brief Element storage for the containers of the script bindings, e.g. the object handle tables (v8::internal::SArray).
   struct AnsiAllocator
   {
-    struct AnyType
+    /// @brief A block of capacity() elements of type T.
+    ///
+    /// All elements are constructed: new ones are value-initialized, which zeroes trivial types. When the block has to move,
+    /// trivially copyable elements are reallocated, which extends the block in place when the heap has room behind it. Other
+    /// elements are move-constructed into the new block and destroyed in the old one.
+    ///
+    /// How much to grow is up to the container, resize() allocates exactly the requested number of elements.
+    template <typename T>
+    struct ForType
     {
-    };
+      ForType() = default;
 
-    template <size_t kSizeOfElement>
-    struct AnyTypeAllocator
-    {
-      AnyTypeAllocator()
-        : data(nullptr)
-        , num(0)
-      {
-      }
-
-      ~AnyTypeAllocator()
-      {
-        if (data)
-        {
-          nsFoundation::GetDefaultAllocator()->Deallocate(data);
-        }
-      }
+      ~ForType() { release(); }
 
-      AnyTypeAllocator(AnyTypeAllocator&& other) noexcept
+      ForType(ForType&& other) noexcept
+        : data(other.data)
+        , num(other.num)
       {
-        data = other.data;
-        num = other.num;
         other.data = nullptr;
         other.num = 0;
       }
 
-      AnyTypeAllocator& operator=(AnyTypeAllocator&& other) noexcept
+      ForType& operator=(ForType&& other) noexcept
       {
-        data = other.data;
-        num = other.num;
-        other.data = nullptr;
-        other.num = 0;
+        if (this != &other)
+        {
+          release();
+          data = other.data;
+          num = other.num;
+          other.data = nullptr;
+          other.num = 0;
+        }
         return *this;
       }
 
-      AnyTypeAllocator(const AnyTypeAllocator& other) = delete;
-      AnyTypeAllocator& operator=(const AnyTypeAllocator& other) = delete;
+      ForType(const ForType& other) = delete;
+      ForType& operator=(const ForType& other) = delete;
 
-      void resize(size_t p_last_num, size_t p_num)
+      /// @brief Changes the capacity to p_num elements. The first min(capacity(), p_num) elements are kept.
+      void resize(size_t p_num)
       {
-        data = (AnyType*)nsFoundation::GetDefaultAllocator()->Allocate((std::size_t)data, nsMath::Pow2((int)(p_num * kSizeOfElement)));
-        NS_ISE_JSI_CHECK(data);
-        const size_t added_count = p_num - p_last_num;
-        memset((void*)((unsigned char*)data + p_last_num * kSizeOfElement), 0,
-          added_count * kSizeOfElement);
+        if (p_num == num)
+          return;
+
+        if (p_num == 0)
+        {
+          release();
+          return;
+        }
+
+        nsAllocator* pAllocator = nsFoundation::GetDefaultAllocator();
+        const size_t keep_num = nsMath::Min(num, p_num);
+
+        if constexpr (std::is_trivially_copyable_v<T>)
+        {
+          data = static_cast<T*>(data != nullptr ? pAllocator->Reallocate(data, num * sizeof(T), p_num * sizeof(T), alignof(T))
+                                                 : pAllocator->Allocate(p_num * sizeof(T), alignof(T)));
+        }
+        else
+        {
+          T* new_data = static_cast<T*>(pAllocator->Allocate(p_num * sizeof(T), alignof(T)));
+
+          for (size_t i = 0; i < keep_num; ++i)
+          {
+            new (new_data + i) T(std::move(data[i]));
+          }
+
+          if (data != nullptr)
+          {
+            destroy(0, num);
+            pAllocator->Deallocate(data);
+          }
+          data = new_data;
+        }
+
+        for (size_t i = keep_num; i < p_num; ++i)
+        {
+          new (data + i) T();
+        }
+
         num = p_num;
       }
 
-      AnyType* get_data() const
+      /// @brief Makes room for at least p_num elements.
+      void reserve(size_t p_num)
       {
-        return data;
+        if (p_num > num)
+        {
+          resize(p_num);
+        }
       }
 
+      T* get_data() const { return data; }
+
       size_t capacity() const { return num; }
 
-      AnyType* data;
-      size_t num;
-    };
+    private:
+      void destroy(size_t p_first, size_t p_end)
+      {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+          for (size_t i = p_first; i < p_end; ++i)
+          {
+            data[i].~T();
+          }
+        }
+      }
 
-    template <typename T>
-    struct ForType : AnyTypeAllocator<sizeof(T)>
-    {
-      T* get_data() const
+      void release()
       {
-        return (T*)AnyTypeAllocator<sizeof(T)>::get_data();
+        if (data != nullptr)
+        {
+          destroy(0, num);
+          nsFoundation::GetDefaultAllocator()->Deallocate(data);
+          data = nullptr;
+          num = 0;
+        }
       }
+
+      T* data = nullptr;
+      size_t num = 0;
     };
   };
 } // namespace aperture::core
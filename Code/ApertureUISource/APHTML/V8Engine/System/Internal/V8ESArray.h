@@ -37,6 +37,7 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <APHTML/V8Engine/System/Internal/V8EAsniAllocator.h>
 #include <APHTML/V8Engine/System/Internal/V8ESIndex.h>
+#include <algorithm>
 #include <type_traits>
 
 namespace aperture::v8
@@ -44,20 +45,24 @@ namespace aperture::v8
 #ifdef DEBUG_ENABLED
 // ensure list items not reallocated when a scope is alive
 #  define jsb_address_guard(list, scope_name) const auto scope_name = (list).address_scope()
-#  define NDEBUG 1
 #else
 #  define jsb_address_guard(list, scope_name) (void)0
-#  define NDEBUG 0
+#endif
+
+// walks all slots, so only affordable in debug builds
+#if NS_ENABLED(NS_COMPILE_FOR_DEBUG)
+#  define jsb_check_consistency() NS_ISE_JSI_CHECK(is_consistent())
+#else
+#  define jsb_check_consistency() (void)0
 #endif
 
   namespace internal
   {
-    // NOTE some types (like std::function) are not supported because copy/move on resizing is not implemented for now.
+    // NOTE all slots hold a constructed T, free ones a default constructed one. T must be default constructible and movable.
     template <typename T, typename IndexType = TIndex<nsUInt32>, typename TAllocator = core::AnsiAllocator>
     class SArray
     {
-      using RevisionType = typename IndexType;
-      using ElementTypeTypedef = std::remove_pointer_t<T>;
+      using RevisionType = typename IndexType::RevisionType;
 
       enum
       {
@@ -74,9 +79,8 @@ namespace aperture::v8
         int previous;
         RevisionType revision;
         T value;
-
-#if NDEBUG
         bool has_value_;
+
         void reset_value() { has_value_ = false; }
         bool has_value() const { return has_value_; }
         void set_value(T&& p_value)
@@ -89,12 +93,6 @@ namespace aperture::v8
           has_value_ = true;
           value = p_value;
         }
-#else
-        void reset_value() {}
-        bool has_value() const { return true; }
-        void set_value(T&& p_value) { value = std::move(p_value); }
-        void set_value(const T& p_value) { value = p_value; }
-#endif
       };
 
       using AllocatorType = typename TAllocator::template ForType<Slot>;
@@ -264,23 +262,8 @@ namespace aperture::v8
       SArray(SArray&& other) noexcept { *this = std::move(other); }
       SArray(const SArray& other) { *this = other; }
 
-      ~SArray()
-      {
-        if constexpr (!std::is_trivially_destructible_v<T>)
-        {
-          while (_first_index != 0)
-          {
-            Slot& slot = get_data()[_first_index];
-            const int next = slot.next;
-            NS_ISE_JSI_CHECK(slot.has_value());
-            if constexpr (!std::is_trivially_destructible_v<T>)
-            {
-              slot.value.ElementTypeTypedef::~ElementTypeTypedef();
-            }
-            _first_index = next;
-          }
-        }
-      }
+      // the allocator destroys the values of all slots
+      ~SArray() = default;
 
       AddressScope address_scope() { return AddressScope(this); }
 
@@ -302,7 +285,7 @@ namespace aperture::v8
           return;
         }
         Slot* slots_base = get_data();
-        while (_first_index != 0)
+        while (_first_index != INDEX_NONE)
         {
           const int index = _first_index;
           Slot& slot = slots_base[index];
@@ -311,10 +294,10 @@ namespace aperture::v8
           _first_index = slot.next;
           slot.next = _free_index;
           slot.reset_value();
-          // IndexType::increase_revision(slot.revision);
+          IndexType::increase_revision(slot.revision);
           _free_index = index;
         }
-        NS_ISE_JSI_CHECK(_first_index == -1);
+        NS_ISE_JSI_CHECK(_first_index == INDEX_NONE);
         _last_index = -1;
         _used_size = 0;
         ++_version;
@@ -339,14 +322,14 @@ namespace aperture::v8
 
       IndexType get_first_index() const
       {
-        return _first_index != 0
+        return _first_index != INDEX_NONE
                  ? IndexType(_first_index, get_data()[_first_index].revision)
                  : IndexType::none();
       }
 
       IndexType get_last_index() const
       {
-        return _last_index != 0
+        return _last_index != INDEX_NONE
                  ? IndexType(_last_index, get_data()[_last_index].revision)
                  : IndexType::none();
       }
@@ -360,7 +343,7 @@ namespace aperture::v8
         }
 
         const Slot& slot = get_data()[p_index.get_index()];
-        if (slot.next != 0)
+        if (slot.next != INDEX_NONE)
         {
           NS_ISE_JSI_CHECK(get_data()[slot.next].previous == p_index.get_index());
           o_next = IndexType(slot.next, get_data()[slot.next].revision);
@@ -369,7 +352,7 @@ namespace aperture::v8
         {
           o_next = IndexType::none();
         }
-        if (slot.previous != 0)
+        if (slot.previous != INDEX_NONE)
         {
           NS_ISE_JSI_CHECK(get_data()[slot.previous].next == p_index.get_index());
           o_previous = IndexType(slot.previous, get_data()[slot.previous].revision);
@@ -384,7 +367,7 @@ namespace aperture::v8
       {
         NS_ISE_JSI_CHECK(is_valid_index(p_index));
         const Slot& slot = get_data()[p_index.get_index()];
-        if (slot.next != 0)
+        if (slot.next != INDEX_NONE)
         {
           NS_ISE_JSI_CHECK(get_data()[slot.next].previous == p_index.get_index());
           return IndexType(slot.next, get_data()[slot.next].revision);
@@ -396,7 +379,7 @@ namespace aperture::v8
       {
         NS_ISE_JSI_CHECK(is_valid_index(p_index));
         const Slot& slot = get_data()[p_index.get_index()];
-        if (slot.previous != 0)
+        if (slot.previous != INDEX_NONE)
         {
           NS_ISE_JSI_CHECK(get_data()[slot.previous].next == p_index.get_index());
           return IndexType(slot.previous, get_data()[slot.previous].revision);
@@ -427,27 +410,27 @@ namespace aperture::v8
         construct_element(slot);
         slot.set_value(std::forward<TArg>(value));
         _free_index = slot.next;
-        slot.next = 0;
+        slot.next = INDEX_NONE;
         slot.previous = _last_index;
         ++_used_size;
-        if (_last_index != 0)
+        if (_last_index != INDEX_NONE)
         {
           Slot& last_slot = get_data()[_last_index];
           last_slot.next = new_index;
         }
-        if (_first_index == 0)
+        if (_first_index == INDEX_NONE)
         {
           _first_index = new_index;
         }
         _last_index = new_index;
         ++_version;
-        NS_ISE_JSI_CHECK(is_consistent());
+        jsb_check_consistency();
         return IndexType(new_index, slot.revision);
       }
 
       IndexType insert(const IndexType& p_index, T&& p_item)
       {
-        NS_ISE_JSI_CHECK(is_consistent());
+        jsb_check_consistency();
         NS_ISE_JSI_CHECK(is_valid_index(p_index));
         grow_if_needed(1);
 
@@ -465,7 +448,7 @@ namespace aperture::v8
         pivot_slot.previous = new_index;
         NS_ISE_JSI_CHECK(get_data() + p_index.get_index() == &pivot_slot);
         NS_ISE_JSI_CHECK(get_data()[p_index.get_index()].previous == pivot_slot.previous && pivot_slot.previous == new_index);
-        if (new_slot.previous != 0)
+        if (new_slot.previous != INDEX_NONE)
         {
           Slot& previous_slot = get_data()[new_slot.previous];
           previous_slot.next = new_index;
@@ -476,7 +459,7 @@ namespace aperture::v8
           _first_index = new_index;
         }
         ++_version;
-        NS_ISE_JSI_CHECK(is_consistent());
+        jsb_check_consistency();
         return IndexType(new_index, new_slot.revision);
       }
 
@@ -527,7 +510,7 @@ namespace aperture::v8
 
       T pop()
       {
-        NS_ISE_JSI_CHECK(_last_index != 0);
+        NS_ISE_JSI_CHECK(_last_index != INDEX_NONE);
         const Slot& slot = get_data()[_last_index];
         const T item = std::move(slot.value);
         remove_at({_last_index, slot.revision});
@@ -600,7 +583,7 @@ namespace aperture::v8
       IndexType index_of(const T& p_item) const
       {
         int current = _first_index;
-        while (current != 0)
+        while (current != INDEX_NONE)
         {
           const Slot& slot = get_data()[current];
           if (slot.value == p_item)
@@ -616,7 +599,7 @@ namespace aperture::v8
       IndexType last_index_of(const T& p_item) const
       {
         int current = _last_index;
-        while (current != 0)
+        while (current != INDEX_NONE)
         {
           const Slot& slot = get_data()[current];
           if (slot.value == p_item)
@@ -661,11 +644,11 @@ namespace aperture::v8
         _free_index = p_index.get_index();
         --_used_size;
         ++_version;
-        if (next != 0)
+        if (next != INDEX_NONE)
         {
           get_data()[next].previous = previous;
         }
-        if (previous != 0)
+        if (previous != INDEX_NONE)
         {
           get_data()[previous].next = next;
         }
@@ -677,7 +660,7 @@ namespace aperture::v8
         {
           _last_index = previous;
         }
-        NS_ISE_JSI_CHECK(is_consistent());
+        jsb_check_consistency();
         return true;
       }
 
@@ -687,13 +670,15 @@ namespace aperture::v8
         NS_ISE_JSI_CHECK(ret);
       }
 
+      // make room for `p_size` items in total, e.g. before adding many items at once
       void reserve(int p_size)
       {
+        NS_ISE_JSI_CHECK(_address_locked == 0);
         if (p_size <= capacity())
         {
           return;
         }
-        grow_if_needed(p_size - capacity());
+        grow_to(p_size);
       }
 
       // ensure the number of free slot is enough to add `p_extra_count` new elements
@@ -708,19 +693,7 @@ namespace aperture::v8
           return;
         }
 
-        const int new_capacity = std::max(std::max(current_size * 2, 4), expected_size);
-        allocator.resize(current_size, new_capacity);
-        NS_ISE_JSI_CHECK(new_capacity == capacity());
-        Slot* slots_base = get_data();
-        for (int i = current_size; i < new_capacity; ++i)
-        {
-          Slot& slot = slots_base[i];
-          NS_ISE_JSI_CHECK(!slot.has_value());
-          slot.next = _free_index;
-          slot.revision = kInitialRevision;
-          _free_index = i;
-        }
-        NS_ISE_JSI_CHECK(is_consistent());
+        grow_to(std::max(std::max(current_size * 2, 4), expected_size));
       }
 
       template <typename ContainerType, typename ElementType>
@@ -862,7 +835,7 @@ namespace aperture::v8
         }
         clear();
         int index = other._first_index;
-        while (index != 0)
+        while (index != INDEX_NONE)
         {
           add(other.get_data()[index].value);
           index = other.get_data()[index].next;
@@ -882,7 +855,7 @@ namespace aperture::v8
         }
         int lhs_index = lhs._first_index;
         int rhs_index = rhs._first_index;
-        while (lhs_index != 0 && rhs_index != 0)
+        while (lhs_index != INDEX_NONE && rhs_index != INDEX_NONE)
         {
           if (lhs.get_data()[lhs_index].value != rhs.get_data()[rhs_index].value)
           {
@@ -900,6 +873,25 @@ namespace aperture::v8
       }
 
     private:
+      void grow_to(int p_new_capacity)
+      {
+        const int current_size = capacity();
+        allocator.resize(p_new_capacity);
+        NS_ISE_JSI_CHECK(p_new_capacity == capacity());
+
+        // push in reverse order, so that new items are added in the order of the slots
+        Slot* slots_base = get_data();
+        for (int i = p_new_capacity - 1; i >= current_size; --i)
+        {
+          Slot& slot = slots_base[i];
+          NS_ISE_JSI_CHECK(!slot.has_value());
+          slot.next = _free_index;
+          slot.revision = kInitialRevision;
+          _free_index = i;
+        }
+        jsb_check_consistency();
+      }
+
       void lock_address() { ++_address_locked; }
       void unlock_address()
       {
@@ -922,19 +914,19 @@ namespace aperture::v8
         {
           count = 0;
           index = _first_index;
-          while (index != 0)
+          while (index != INDEX_NONE)
           {
             const Slot& slot = get_data()[index];
             // NS_ISE_JSI_CHECK(is_valid_index({index, slot.revision}));
             if (index == _first_index)
             {
-              NS_ISE_JSI_CHECK(slot.previous == 0);
+              NS_ISE_JSI_CHECK(slot.previous == INDEX_NONE);
             }
-            if (slot.next != 0)
+            if (slot.next != INDEX_NONE)
             {
               NS_ISE_JSI_CHECK(get_data()[slot.next].previous == index);
             }
-            if (slot.previous != 0)
+            if (slot.previous != INDEX_NONE)
             {
               NS_ISE_JSI_CHECK(get_data()[slot.previous].next == index);
             }
@@ -948,24 +940,22 @@ namespace aperture::v8
           }
           return _used_size == count;
         }
-        return _first_index == 0 && _last_index == 0;
+        return _first_index == INDEX_NONE && _last_index == INDEX_NONE;
       }
 
+      // free slots already hold a default constructed value
       static void construct_element(Slot& p_slot)
       {
         NS_ISE_JSI_CHECK(!p_slot.has_value());
-        if constexpr (!std::is_trivially_constructible_v<T>)
-        {
-          memnew_placement(&p_slot.value, T);
-        }
       }
 
+      // releases what the value holds, but keeps it constructed
       static void destruct_element(Slot& p_slot)
       {
         NS_ISE_JSI_CHECK(p_slot.has_value());
-        if constexpr (!std::is_trivially_destructible_v<T>)
+        if constexpr (!std::is_trivially_copyable_v<T>)
         {
-          p_slot.value.ElementTypeTypedef::~ElementTypeTypedef();
+          p_slot.value = T();
         }
         else
         {
@@ -35,6 +35,7 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <Foundation/Strings/String.h>
+#include <Foundation/Strings/StringBuilder.h>
 #include <Foundation/Types/SharedPtr.h>
 #include <Foundation/Types/Variant.h>
 #include <Foundation/Threading/Mutex.h>
@@ -61,7 +62,7 @@ namespace aperture::v8::internal
             packed_(((UnderlyingType)index << kRevisionBits) | ((UnderlyingType)revision & kRevisionMask))
         {
             // index overflow check
-            jsb_check(!((UnderlyingType) index >> (sizeof(UnderlyingType) * 8 - kRevisionBits)));
+            NS_ISE_JSI_CHECK(!((UnderlyingType) index >> (sizeof(UnderlyingType) * 8 - kRevisionBits)));
         }
 
         explicit TIndex(UnderlyingType p_value) : packed_(p_value)
@@ -72,7 +73,12 @@ namespace aperture::v8::internal
         operator UnderlyingType() const { return packed_; }
         UnderlyingType value() const { return packed_; }
         UnderlyingType operator *() const { return packed_; }
-        nsString to_string() const { return uitos(packed_); }
+        nsString to_string() const
+        {
+            nsStringBuilder s;
+            s.SetFormat("{}", packed_);
+            return s;
+        }
 
         TIndex(const TIndex& other) = default;
         TIndex(TIndex&& other) = default;
@@ -108,7 +114,7 @@ namespace aperture::v8::internal
 
         static void increase_revision(RevisionType& p_value)
         {
-            p_value = MAX((RevisionType) 1, (p_value + 1) & kRevisionMask);
+            p_value = nsMath::Max((RevisionType) 1, (RevisionType) ((p_value + 1) & kRevisionMask));
         }
 
     private:
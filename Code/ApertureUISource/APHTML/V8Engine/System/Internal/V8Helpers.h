@@ -155,11 +155,7 @@ namespace aperture::v8::helpers
     static core::CoreBuffer<T> to_core_buffer(::v8::Isolate* isolate, const ::v8::Local<::v8::ArrayBuffer>& array_buffer)
     {
       const size_t size = array_buffer->ByteLength();
-      core::CoreBuffer packed;
-      nsResult err = packed.resize((int)size);
-      NS_ISE_JSI_CHECK(err == NS_SUCCESS);
-      const void* data = array_buffer->Data();
-      memcpy(packed.get(), data, size);
+      core::CoreBuffer<T> packed(static_cast<const T*>(array_buffer->Data()), size / sizeof(T));
       return packed;
     }
 
@@ -0,0 +1,104 @@
+#include <APHTML/V8Engine/System/JobSystem/V8EIdleTaskScheduler.h>
+#include <Foundation/Profiling/Profiling.h>
+#include <Foundation/Threading/Lock.h>
+#include <Foundation/Utilities/Stats.h>
+
+aperture::v8::jobsystem::V8EIdleTaskScheduler::V8EIdleTaskScheduler(::v8::Platform* p_pPlatform)
+  : m_pPlatform(p_pPlatform)
+{
+}
+
+aperture::v8::jobsystem::V8EIdleTaskScheduler::~V8EIdleTaskScheduler()
+{
+  Clear();
+}
+
+void aperture::v8::jobsystem::V8EIdleTaskScheduler::PostIdleTask(std::unique_ptr<::v8::IdleTask> p_pTask)
+{
+  NS_LOCK(m_TasksMutex);
+  m_Tasks.PushBack(std::move(p_pTask));
+}
+
+void aperture::v8::jobsystem::V8EIdleTaskScheduler::BeginFrame(nsTime p_frameBudget)
+{
+  m_FrameDeadline = GetTime() + p_frameBudget;
+}
+
+nsUInt32 aperture::v8::jobsystem::V8EIdleTaskScheduler::RunIdleTasks()
+{
+  return RunIdleTasks(m_FrameDeadline);
+}
+
+nsUInt32 aperture::v8::jobsystem::V8EIdleTaskScheduler::RunIdleTasks(nsTime p_deadline)
+{
+  NS_PROFILE_SCOPE("V8EIdleTaskScheduler::RunIdleTasks");
+  const nsTime start = GetTime();
+  if (p_deadline > start)
+  {
+    m_FrameStats.m_IdleTimeAvailable += p_deadline - start;
+  }
+
+  nsUInt32 uiTasksRun = 0;
+  while (p_deadline - GetTime() >= m_MinimumIdleSlice)
+  {
+    // Tasks may post follow-up idle tasks, those still get the rest of this frame.
+    std::unique_ptr<::v8::IdleTask> pTask = PopTask();
+    if (pTask == nullptr)
+      break;
+
+    pTask->Run(p_deadline.GetSeconds());
+    ++uiTasksRun;
+  }
+
+  if (uiTasksRun > 0)
+  {
+    m_FrameStats.m_IdleTimeUsed += GetTime() - start;
+    m_FrameStats.m_uiTasksRun += uiTasksRun;
+  }
+  return uiTasksRun;
+}
+
+void aperture::v8::jobsystem::V8EIdleTaskScheduler::EndFrame()
+{
+  m_FrameStats.m_uiTasksPending = GetPendingTaskCount();
+  m_LastFrameStats = m_FrameStats;
+  m_FrameStats = V8EIdleFrameStats();
+
+  nsStats::SetStat("V8EJobManager/Idle/TimeAvailable", m_LastFrameStats.m_IdleTimeAvailable);
+  nsStats::SetStat("V8EJobManager/Idle/TimeUsed", m_LastFrameStats.m_IdleTimeUsed);
+  nsStats::SetStat("V8EJobManager/Idle/TasksRun", m_LastFrameStats.m_uiTasksRun);
+  nsStats::SetStat("V8EJobManager/Idle/TasksPending", m_LastFrameStats.m_uiTasksPending);
+}
+
+nsTime aperture::v8::jobsystem::V8EIdleTaskScheduler::GetTime() const
+{
+  return m_pPlatform != nullptr ? nsTime::MakeFromSeconds(m_pPlatform->MonotonicallyIncreasingTime()) : nsTime::Now();
+}
+
+nsTime aperture::v8::jobsystem::V8EIdleTaskScheduler::GetRemainingFrameTime() const
+{
+  return nsMath::Max(m_FrameDeadline - GetTime(), nsTime::MakeZero());
+}
+
+nsUInt32 aperture::v8::jobsystem::V8EIdleTaskScheduler::GetPendingTaskCount() const
+{
+  NS_LOCK(m_TasksMutex);
+  return m_Tasks.GetCount();
+}
+
+void aperture::v8::jobsystem::V8EIdleTaskScheduler::Clear()
+{
+  NS_LOCK(m_TasksMutex);
+  m_Tasks.Clear();
+}
+
+std::unique_ptr<::v8::IdleTask> aperture::v8::jobsystem::V8EIdleTaskScheduler::PopTask()
+{
+  NS_LOCK(m_TasksMutex);
+  if (m_Tasks.IsEmpty())
+    return nullptr;
+
+  std::unique_ptr<::v8::IdleTask> pTask = std::move(m_Tasks.PeekFront());
+  m_Tasks.PopFront();
+  return pTask;
+}
@@ -0,0 +1,115 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <APHTML/V8Engine/V8EngineDLL.h>
+#include <Foundation/Containers/Deque.h>
+#include <Foundation/Threading/Mutex.h>
+#include <Foundation/Time/Time.h>
+#include <libplatform/libplatform.h>
+
+namespace aperture::v8::jobsystem
+{
+  /// @brief What the idle task scheduler did in one frame.
+  struct V8EIdleFrameStats
+  {
+    /// Frame time that was left when idle tasks got their turn.
+    nsTime m_IdleTimeAvailable;
+    /// Time spent in idle tasks.
+    nsTime m_IdleTimeUsed;
+    nsUInt32 m_uiTasksRun = 0;
+    /// Tasks still waiting at the end of the frame, because the budget ran out.
+    nsUInt32 m_uiTasksPending = 0;
+  };
+
+  /**
+   * @brief Runs V8 idle tasks (incremental GC finalization, memory reducer) in the time left of a frame.
+   *
+   * BeginFrame() sets the frame budget, RunIdleTasks() is called once the frame's UI work is done and runs idle tasks until the
+   * budget is used up. V8 gets the real end of the frame as deadline and sizes its work to it. A task is only started while at
+   * least the minimum idle slice remains, so an almost spent frame is not pushed over its budget.
+   *
+   * @note PostIdleTask() is thread-safe. RunIdleTasks() has to be called on the thread that owns the isolate.
+   */
+  class NS_V8ENGINE_DLL V8EIdleTaskScheduler
+  {
+  public:
+    /// @brief Deadlines are measured on p_pPlatform's MonotonicallyIncreasingTime(), nsTime::Now() while there is no platform.
+    explicit V8EIdleTaskScheduler(::v8::Platform* p_pPlatform = nullptr);
+    ~V8EIdleTaskScheduler();
+
+    void SetPlatform(::v8::Platform* p_pPlatform) { m_pPlatform = p_pPlatform; }
+
+    void PostIdleTask(std::unique_ptr<::v8::IdleTask> p_pTask);
+
+    /// @brief Starts a frame that may take p_frameBudget in total.
+    void BeginFrame(nsTime p_frameBudget);
+
+    /// @brief Runs idle tasks until the budget set in BeginFrame() is used up. Returns how many ran.
+    nsUInt32 RunIdleTasks();
+    /// @brief Runs idle tasks until p_deadline, a time on GetTime()'s clock. Returns how many ran.
+    nsUInt32 RunIdleTasks(nsTime p_deadline);
+
+    /// @brief Publishes the stats of the frame and starts counting the next one.
+    void EndFrame();
+
+    /// @brief Tasks are not started with less than this left, 1 ms by default.
+    void SetMinimumIdleSlice(nsTime p_slice) { m_MinimumIdleSlice = p_slice; }
+    nsTime GetMinimumIdleSlice() const { return m_MinimumIdleSlice; }
+
+    nsTime GetTime() const;
+    /// @brief Time left until the end of the frame set in BeginFrame(), zero once it passed.
+    nsTime GetRemainingFrameTime() const;
+
+    nsUInt32 GetPendingTaskCount() const;
+    const V8EIdleFrameStats& GetLastFrameStats() const { return m_LastFrameStats; }
+
+    /// @brief Drops all waiting tasks without running them.
+    void Clear();
+
+  private:
+    std::unique_ptr<::v8::IdleTask> PopTask();
+
+    ::v8::Platform* m_pPlatform = nullptr;
+    mutable nsMutex m_TasksMutex;
+    nsDeque<std::unique_ptr<::v8::IdleTask>> m_Tasks;
+
+    nsTime m_MinimumIdleSlice = nsTime::MakeFromMilliseconds(1);
+    nsTime m_FrameDeadline;
+    V8EIdleFrameStats m_FrameStats;
+    V8EIdleFrameStats m_LastFrameStats;
+  };
+} // namespace aperture::v8::jobsystem
@@ -0,0 +1,269 @@
+#include <APHTML/V8Engine/System/JobSystem/V8EJob.h>
+#include <APHTML/V8Engine/System/JobSystem/V8EJobManager.h>
+#include <Foundation/Profiling/Profiling.h>
+
+aperture::v8::jobsystem::V8EJobState::V8EJobState(V8EJobManager* p_pJobManager, std::unique_ptr<::v8::JobTask> p_pJobTask, ::v8::TaskPriority p_priority, nsUInt32 p_uiNumWorkers, const ::v8::SourceLocation& p_location)
+  : m_pJobManager(p_pJobManager)
+  , m_pJobTask(std::move(p_pJobTask))
+  , m_uiNumWorkers(nsMath::Min(p_uiNumWorkers, 32u))
+  , m_Location(p_location)
+  , m_Priority(p_priority)
+{
+  m_uiWorkerLimit = GetWorkerLimit();
+}
+
+aperture::v8::jobsystem::V8EJobState::~V8EJobState()
+{
+  NS_ASSERT_DEV(m_uiActiveWorkers == 0, "V8EJobState: Destroyed while {0} workers are still running.", m_uiActiveWorkers);
+}
+
+void aperture::v8::jobsystem::V8EJobState::NotifyConcurrencyIncrease()
+{
+  if (m_bCanceled.load(std::memory_order_relaxed))
+    return;
+
+  nsUInt32 uiTasksToPost = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    uiTasksToPost = ReserveTasksToPost(CappedMaxConcurrency(m_uiActiveWorkers));
+  }
+  PostWorkerTasks(uiTasksToPost);
+}
+
+void aperture::v8::jobsystem::V8EJobState::Join()
+{
+  NS_PROFILE_SCOPE("V8EJobState::Join");
+  nsUInt32 uiTasksToPost = 0;
+  {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    // Someone waits on the job now. The joining thread counts as an extra worker, GetMaxConcurrency() is still respected
+    // because WaitForParticipationOpportunity() waits for workers to return first if needed.
+    m_Priority = ::v8::TaskPriority::kUserBlocking;
+    m_bJoining = true;
+    m_uiWorkerLimit = GetWorkerLimit();
+    ++m_uiActiveWorkers;
+
+    const nsUInt32 uiMaxConcurrency = WaitForParticipationOpportunity(lock);
+    if (uiMaxConcurrency == 0)
+      return;
+    uiTasksToPost = ReserveTasksToPost(uiMaxConcurrency);
+  }
+  PostWorkerTasks(uiTasksToPost);
+
+  V8EJobDelegate delegate(this, true);
+  while (true)
+  {
+    m_pJobTask->Run(&delegate);
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    if (WaitForParticipationOpportunity(lock) == 0)
+      return;
+  }
+}
+
+void aperture::v8::jobsystem::V8EJobState::CancelAndWait()
+{
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  m_bCanceled.store(true, std::memory_order_relaxed);
+  m_WorkerReleased.wait(lock, [this]()
+    { return m_uiActiveWorkers == 0; });
+}
+
+void aperture::v8::jobsystem::V8EJobState::CancelAndDetach()
+{
+  // Posted workers keep the state alive, they see the flag in CanRunFirstTask() or DidRunTask() and stop.
+  m_bCanceled.store(true, std::memory_order_relaxed);
+}
+
+bool aperture::v8::jobsystem::V8EJobState::IsActive()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_pJobTask->GetMaxConcurrency(m_uiActiveWorkers) != 0 || m_uiActiveWorkers != 0;
+}
+
+void aperture::v8::jobsystem::V8EJobState::UpdatePriority(::v8::TaskPriority p_priority)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    // Once a thread joined, the job stays blocking.
+    if (!m_bJoining)
+    {
+      m_Priority = p_priority;
+      m_uiWorkerLimit = GetWorkerLimit();
+    }
+  }
+  // A higher priority may allow more workers right away.
+  NotifyConcurrencyIncrease();
+}
+
+nsUInt8 aperture::v8::jobsystem::V8EJobState::AcquireTaskId()
+{
+  nsUInt32 uiAssigned = m_uiAssignedTaskIds.load(std::memory_order_relaxed);
+  nsUInt32 uiTaskId = 0;
+  do
+  {
+    NS_ASSERT_DEV(uiAssigned != 0xFFFFFFFFu, "V8EJobState: More than 32 workers on one job.");
+    uiTaskId = nsMath::FirstBitLow(~uiAssigned);
+  } while (!m_uiAssignedTaskIds.compare_exchange_weak(uiAssigned, uiAssigned | (1u << uiTaskId), std::memory_order_acquire, std::memory_order_relaxed));
+  return static_cast<nsUInt8>(uiTaskId);
+}
+
+void aperture::v8::jobsystem::V8EJobState::ReleaseTaskId(nsUInt8 p_uiTaskId)
+{
+  m_uiAssignedTaskIds.fetch_and(~(1u << p_uiTaskId), std::memory_order_release);
+}
+
+bool aperture::v8::jobsystem::V8EJobState::CanRunFirstTask()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  --m_uiPendingTasks;
+  if (m_bCanceled.load(std::memory_order_relaxed))
+    return false;
+  if (m_uiActiveWorkers >= CappedMaxConcurrency(m_uiActiveWorkers))
+    return false;
+
+  ++m_uiActiveWorkers;
+  return true;
+}
+
+bool aperture::v8::jobsystem::V8EJobState::DidRunTask()
+{
+  nsUInt32 uiTasksToPost = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const nsUInt32 uiMaxConcurrency = CappedMaxConcurrency(m_uiActiveWorkers - 1);
+    if (m_bCanceled.load(std::memory_order_relaxed) || m_uiActiveWorkers > uiMaxConcurrency)
+    {
+      --m_uiActiveWorkers;
+      m_WorkerReleased.notify_all();
+      return false;
+    }
+    // Some tasks only call NotifyConcurrencyIncrease() late, posting here gets the extra workers going sooner.
+    uiTasksToPost = ReserveTasksToPost(uiMaxConcurrency);
+  }
+  PostWorkerTasks(uiTasksToPost);
+  return true;
+}
+
+nsUInt32 aperture::v8::jobsystem::V8EJobState::CappedMaxConcurrency(nsUInt32 p_uiWorkerCount) const
+{
+  const size_t uiMaxConcurrency = m_pJobTask->GetMaxConcurrency(p_uiWorkerCount);
+  return static_cast<nsUInt32>(nsMath::Min<size_t>(uiMaxConcurrency, m_uiWorkerLimit));
+}
+
+nsUInt32 aperture::v8::jobsystem::V8EJobState::WaitForParticipationOpportunity(std::unique_lock<std::mutex>& ref_lock)
+{
+  // A canceled job wants no workers, so the joining thread waits for all others to return before it leaves.
+  auto getMaxConcurrency = [this]()
+  {
+    return m_bCanceled.load(std::memory_order_relaxed) ? 0u : CappedMaxConcurrency(m_uiActiveWorkers - 1);
+  };
+
+  nsUInt32 uiMaxConcurrency = getMaxConcurrency();
+  while (m_uiActiveWorkers > uiMaxConcurrency && m_uiActiveWorkers > 1)
+  {
+    m_WorkerReleased.wait(ref_lock);
+    uiMaxConcurrency = getMaxConcurrency();
+  }
+  if (m_uiActiveWorkers <= uiMaxConcurrency)
+    return uiMaxConcurrency;
+
+  // Only the joining thread is left and there is nothing to do anymore, it leaves the job done.
+  m_uiActiveWorkers = 0;
+  m_bCanceled.store(true, std::memory_order_relaxed);
+  return 0;
+}
+
+nsUInt32 aperture::v8::jobsystem::V8EJobState::ReserveTasksToPost(nsUInt32 p_uiMaxConcurrency)
+{
+  // Pending tasks count as workers already, otherwise every notification would post another batch.
+  if (p_uiMaxConcurrency <= m_uiActiveWorkers + m_uiPendingTasks)
+    return 0;
+
+  const nsUInt32 uiTasksToPost = p_uiMaxConcurrency - m_uiActiveWorkers - m_uiPendingTasks;
+  m_uiPendingTasks += uiTasksToPost;
+  return uiTasksToPost;
+}
+
+void aperture::v8::jobsystem::V8EJobState::PostWorkerTasks(nsUInt32 p_uiCount)
+{
+  for (nsUInt32 i = 0; i < p_uiCount; ++i)
+  {
+    m_pJobManager->PostJob(std::make_unique<V8EJobWorker>(shared_from_this()), m_Location);
+  }
+}
+
+nsUInt32 aperture::v8::jobsystem::V8EJobState::GetWorkerLimit() const
+{
+  // The joining thread gets a slot of its own on top of the pool.
+  if (m_bJoining)
+    return m_uiNumWorkers + 1;
+  if (m_Priority == ::v8::TaskPriority::kBestEffort)
+    return nsMath::Min(m_uiNumWorkers, 1u);
+  return m_uiNumWorkers;
+}
+
+aperture::v8::jobsystem::V8EJobDelegate::V8EJobDelegate(V8EJobState* p_pState, bool p_bIsJoiningThread)
+  : m_pState(p_pState)
+  , m_bIsJoiningThread(p_bIsJoiningThread)
+{
+}
+
+aperture::v8::jobsystem::V8EJobDelegate::~V8EJobDelegate()
+{
+  if (m_uiTaskId != InvalidTaskId)
+  {
+    m_pState->ReleaseTaskId(m_uiTaskId);
+  }
+}
+
+uint8_t aperture::v8::jobsystem::V8EJobDelegate::GetTaskId()
+{
+  // Most tasks never ask, so the ID is only taken on first use and kept until the worker stops.
+  if (m_uiTaskId == InvalidTaskId)
+  {
+    m_uiTaskId = m_pState->AcquireTaskId();
+  }
+  return m_uiTaskId;
+}
+
+aperture::v8::jobsystem::V8EJobHandle::V8EJobHandle(std::shared_ptr<V8EJobState> p_pState)
+  : m_pState(std::move(p_pState))
+{
+}
+
+aperture::v8::jobsystem::V8EJobHandle::~V8EJobHandle()
+{
+  NS_ASSERT_DEV(m_pState == nullptr, "V8EJobHandle: Destroyed without Join(), Cancel() or CancelAndDetach().");
+}
+
+void aperture::v8::jobsystem::V8EJobHandle::Join()
+{
+  m_pState->Join();
+  m_pState.reset();
+}
+
+void aperture::v8::jobsystem::V8EJobHandle::Cancel()
+{
+  m_pState->CancelAndWait();
+  m_pState.reset();
+}
+
+void aperture::v8::jobsystem::V8EJobHandle::CancelAndDetach()
+{
+  m_pState->CancelAndDetach();
+  m_pState.reset();
+}
+
+void aperture::v8::jobsystem::V8EJobWorker::Run()
+{
+  NS_PROFILE_SCOPE("V8EJobWorker::Run");
+  if (!m_pState->CanRunFirstTask())
+    return;
+
+  do
+  {
+    V8EJobDelegate delegate(m_pState.get(), false);
+    m_pState->GetJobTask()->Run(&delegate);
+  } while (m_pState->DidRunTask());
+}
@@ -0,0 +1,168 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <APHTML/V8Engine/V8EngineDLL.h>
+#include <libplatform/libplatform.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace aperture::v8::jobsystem
+{
+  class V8EJobManager;
+
+  /**
+   * @brief The state one v8::JobHandle shares with the worker tasks it posted, behaves like V8's own DefaultJobState.
+   *
+   * Worker tasks are posted to the script pool through V8EJobManager::PostJob(). Each one calls JobTask::Run() until the job
+   * needs fewer workers (GetMaxConcurrency()), gets canceled, or runs out of work. A joining thread takes part as a worker.
+   *
+   * The script pool has no priorities between jobs, so the priority limits how many script workers a job may use instead:
+   * kBestEffort jobs get a single worker, so background GC and compilation never take the whole pool from frame work.
+   * kUserVisible and kUserBlocking jobs may use every worker.
+   */
+  class V8EJobState : public std::enable_shared_from_this<V8EJobState>
+  {
+  public:
+    V8EJobState(V8EJobManager* p_pJobManager, std::unique_ptr<::v8::JobTask> p_pJobTask, ::v8::TaskPriority p_priority, nsUInt32 p_uiNumWorkers, const ::v8::SourceLocation& p_location);
+    ~V8EJobState();
+
+    void NotifyConcurrencyIncrease();
+    void Join();
+    void CancelAndWait();
+    void CancelAndDetach();
+    bool IsActive();
+    void UpdatePriority(::v8::TaskPriority p_priority);
+
+    bool ShouldYield() const { return m_bCanceled.load(std::memory_order_relaxed); }
+    nsUInt8 AcquireTaskId();
+    void ReleaseTaskId(nsUInt8 p_uiTaskId);
+
+    /// @brief Called by a worker task before its first Run(). False if the job does not need this worker anymore.
+    bool CanRunFirstTask();
+    /// @brief Called by a worker task after every Run(). False once the worker should stop.
+    bool DidRunTask();
+
+    ::v8::JobTask* GetJobTask() const { return m_pJobTask.get(); }
+
+  private:
+    /// @brief GetMaxConcurrency() capped by the workers the priority allows. Needs m_Mutex.
+    nsUInt32 CappedMaxConcurrency(nsUInt32 p_uiWorkerCount) const;
+    /// @brief Waits until the joining thread may run again. 0 once the job is done, the joining thread is released then. Needs m_Mutex.
+    nsUInt32 WaitForParticipationOpportunity(std::unique_lock<std::mutex>& ref_lock);
+    /// @brief How many tasks to post to reach p_uiMaxConcurrency, counted as pending already. Needs m_Mutex.
+    nsUInt32 ReserveTasksToPost(nsUInt32 p_uiMaxConcurrency);
+    void PostWorkerTasks(nsUInt32 p_uiCount);
+    /// @brief How many workers m_Priority allows. Needs m_Mutex.
+    nsUInt32 GetWorkerLimit() const;
+
+    V8EJobManager* m_pJobManager = nullptr;
+    std::unique_ptr<::v8::JobTask> m_pJobTask;
+    const nsUInt32 m_uiNumWorkers;
+    const ::v8::SourceLocation m_Location;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkerReleased;
+    ::v8::TaskPriority m_Priority;
+    nsUInt32 m_uiWorkerLimit = 0;
+    nsUInt32 m_uiActiveWorkers = 0;
+    nsUInt32 m_uiPendingTasks = 0;
+    bool m_bJoining = false;
+    std::atomic<bool> m_bCanceled = false;
+
+    /// Bit i is set while task ID i is in use. V8 allows at most 32 workers per job.
+    std::atomic<nsUInt32> m_uiAssignedTaskIds = 0;
+  };
+
+  class V8EJobDelegate final : public ::v8::JobDelegate
+  {
+  public:
+    V8EJobDelegate(V8EJobState* p_pState, bool p_bIsJoiningThread);
+    ~V8EJobDelegate();
+
+    virtual bool ShouldYield() override { return m_pState->ShouldYield(); }
+    virtual void NotifyConcurrencyIncrease() override { m_pState->NotifyConcurrencyIncrease(); }
+    virtual uint8_t GetTaskId() override;
+    virtual bool IsJoiningThread() const override { return m_bIsJoiningThread; }
+
+  private:
+    static constexpr nsUInt8 InvalidTaskId = 0xFF;
+
+    V8EJobState* m_pState = nullptr;
+    nsUInt8 m_uiTaskId = InvalidTaskId;
+    bool m_bIsJoiningThread = false;
+  };
+
+  class V8EJobHandle final : public ::v8::JobHandle
+  {
+  public:
+    explicit V8EJobHandle(std::shared_ptr<V8EJobState> p_pState);
+    ~V8EJobHandle();
+
+    V8EJobHandle(const V8EJobHandle&) = delete;
+    V8EJobHandle& operator=(const V8EJobHandle&) = delete;
+
+    virtual void NotifyConcurrencyIncrease() override { m_pState->NotifyConcurrencyIncrease(); }
+    virtual void Join() override;
+    virtual void Cancel() override;
+    virtual void CancelAndDetach() override;
+    virtual bool IsActive() override { return m_pState->IsActive(); }
+    virtual bool IsValid() override { return m_pState != nullptr; }
+    virtual bool UpdatePriorityEnabled() const override { return true; }
+    virtual void UpdatePriority(::v8::TaskPriority p_priority) override { m_pState->UpdatePriority(p_priority); }
+
+  private:
+    std::shared_ptr<V8EJobState> m_pState;
+  };
+
+  /// @brief One worker of a job, runs on a script thread.
+  class V8EJobWorker final : public ::v8::Task
+  {
+  public:
+    explicit V8EJobWorker(std::shared_ptr<V8EJobState> p_pState)
+      : m_pState(std::move(p_pState))
+    {
+    }
+
+    virtual void Run() override;
+
+  private:
+    std::shared_ptr<V8EJobState> m_pState;
+  };
+} // namespace aperture::v8::jobsystem
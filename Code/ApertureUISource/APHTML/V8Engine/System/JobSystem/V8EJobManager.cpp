@@ -3,6 +3,8 @@
 #include <APHTML/CommandExecutor/IAPCCommandList.h>
 #include <APHTML/CommandExecutor/IAPCCommandQueue.h>
 #include <Foundation/Profiling/Profiling.h>
+#include <Foundation/Threading/Lock.h>
+#include <APHTML/V8Engine/System/JobSystem/V8EJob.h>
 #include <APHTML/V8Engine/System/JobSystem/V8EJobManager.h>
 #include <Foundation/Time/Clock.h>
 void aperture::v8::jobsystem::V8EWorkerTaskRunner::SetJobManager(V8EJobManager* jobManager)
@@ -45,18 +47,19 @@ void aperture::v8::jobsystem::V8EWorkerTaskRunner::PostNonNestableTaskImpl(std::
 void aperture::v8::jobsystem::V8EWorkerTaskRunner::PostDelayedTaskImpl(std::unique_ptr<::v8::Task> task, double delay_in_seconds, const ::v8::SourceLocation& location)
 {
   nsLog::Debug("V8EWorkerTaskRunner::PostDelayedTask: Posting Delayed Task from File: {0}", location.FileName());
-  m_pJobManager->PostBatchedJob(std::move(task), location);
+  m_pJobManager->PostDelayedJob(std::move(task), delay_in_seconds, location);
 }
 
 void aperture::v8::jobsystem::V8EWorkerTaskRunner::PostNonNestableDelayedTaskImpl(std::unique_ptr<::v8::Task> task, double delay_in_seconds, const ::v8::SourceLocation& location)
 {
   nsLog::Debug("V8EWorkerTaskRunner::PostNonNestableDelayedTask: Posting Non Nestable Delayed Task from File: {0}", location.FileName());
-  m_pJobManager->PostBatchedJob(std::move(task), location);
+  m_pJobManager->PostDelayedJob(std::move(task), delay_in_seconds, location);
 }
 
 void aperture::v8::jobsystem::V8EWorkerTaskRunner::PostIdleTaskImpl(std::unique_ptr<::v8::IdleTask> task, const ::v8::SourceLocation& location)
 {
-
+  nsLog::Debug("V8EWorkerTaskRunner::PostIdleTask: Posting Idle Task from File: {0}", location.FileName());
+  m_pJobManager->PostIdleJob(std::move(task), location);
 }
 
 
@@ -67,14 +70,31 @@ aperture::v8::jobsystem::V8EPlatform::V8EPlatform(int thread_pool_size, ::v8::pl
     nsLog::Error("V8EJobManager(V8EPlatform): The ThreadPoolSize provided, goes over the listed amount in ApertureSDK::GetScriptThreadCount(). it is being set to the max allowed value.");
     thread_pool_size = ApertureSDK::GetScriptThreadCount();
   }
+  workerthreads = static_cast<nsUInt8>(nsMath::Max(thread_pool_size, 0));
+  m_uiMaxJobWorkers = workerthreads.load();
+
+  // V8 calls into the tracing controller on every trace event, it must never be null. The base class traces nothing.
+  m_pTracingController = tracing_controller != nullptr ? std::move(tracing_controller) : std::make_unique<::v8::TracingController>();
 }
 
 void aperture::v8::jobsystem::V8EPlatform::SetJobManager(V8EJobManager* jobManager)
 {
+  m_pJobManager = jobManager;
+}
+
+void aperture::v8::jobsystem::V8EPlatform::SetMaxJobWorkers(nsUInt32 p_uiMaxWorkers)
+{
+  m_uiMaxJobWorkers = p_uiMaxWorkers;
+}
+
+nsUInt32 aperture::v8::jobsystem::V8EPlatform::GetMaxJobWorkers() const
+{
+  return m_uiMaxJobWorkers.load();
 }
 
 ::v8::PageAllocator* aperture::v8::jobsystem::V8EPlatform::GetPageAllocator()
 {
+  // Null makes V8 use its own page allocator, which already maps pages straight from the OS.
   return nullptr;
 }
 
@@ -95,28 +115,29 @@ double aperture::v8::jobsystem::V8EPlatform::CurrentClockTimeMillis()
 
 ::v8::TracingController* aperture::v8::jobsystem::V8EPlatform::GetTracingController()
 {
-  return nullptr;
+  return m_pTracingController.get();
 }
 
 std::unique_ptr<::v8::JobHandle> aperture::v8::jobsystem::V8EPlatform::CreateJobImpl(::v8::TaskPriority priority, std::unique_ptr<::v8::JobTask> job_task, const ::v8::SourceLocation& location)
 {
-  return std::unique_ptr<::v8::JobHandle>();
+  NS_PROFILE_SCOPE("V8EPlatform::CreateJob");
+  // No workers are posted yet, v8::Platform::PostJob() calls NotifyConcurrencyIncrease() right after this.
+  const nsUInt32 uiNumWorkers = nsMath::Min<nsUInt32>(m_uiMaxJobWorkers.load(), NumberOfWorkerThreads());
+  auto pState = std::make_shared<V8EJobState>(m_pJobManager, std::move(job_task), priority, uiNumWorkers, location);
+  return std::make_unique<V8EJobHandle>(std::move(pState));
 }
 
 void aperture::v8::jobsystem::V8EPlatform::PostTaskOnWorkerThreadImpl(::v8::TaskPriority priority, std::unique_ptr<::v8::Task> task, const ::v8::SourceLocation& location)
 {
-  nsLog::Debug("V8EWorkerTaskRunner::PostTaskOnWorkerThreadImpl: Posting Idle Task from File: {0}", location.FileName());
-  nsHybridArray<::v8::Task*, 1> taskArray;
-  taskArray.PushBack(task.get()); // Pass the raw pointer
-  m_pJobManager->PostBatchedJob(std::move(task), location);
+  nsLog::Debug("V8EWorkerTaskRunner::PostTaskOnWorkerThreadImpl: Posting Task from File: {0}", location.FileName());
+  // Background compilation and GC helpers end up here, they go to the script workers right away.
+  m_pJobManager->PostJob(std::move(task), location);
 }
 
 void aperture::v8::jobsystem::V8EPlatform::PostDelayedTaskOnWorkerThreadImpl(::v8::TaskPriority priority, std::unique_ptr<::v8::Task> task, double delay_in_seconds, const ::v8::SourceLocation& location)
 {
-  nsLog::Debug("V8EWorkerTaskRunner::PostDelayedTaskOnWorkerThreadImpl: Posting Idle Task from File: {0}", location.FileName());
-  nsHybridArray<::v8::Task*, 1> taskArray;
-  taskArray.PushBack(task.get()); // Pass the raw pointer
-  m_pJobManager->PostBatchedJob(std::move(task), location);
+  nsLog::Debug("V8EWorkerTaskRunner::PostDelayedTaskOnWorkerThreadImpl: Posting Delayed Task from File: {0}", location.FileName());
+  m_pJobManager->PostDelayedJob(std::move(task), delay_in_seconds, location);
 }
 
 void aperture::v8::jobsystem::V8EJobManager::PostJob(std::unique_ptr<::v8::Task> task, const ::v8::SourceLocation& location)
@@ -124,7 +145,7 @@ void aperture::v8::jobsystem::V8EJobManager::PostJob(std::unique_ptr<::v8::Task>
   NS_PROFILE_SCOPE("V8EJobManager::PostJob");
   nsLog::Debug("V8EJobManager::PostJob: Posting Task from File: {0}", location.FileName());
   nsHybridArray<::v8::Task*, 1> taskArray;
-  taskArray.PushBack(task.get()); // Pass the raw pointer
+  taskArray.PushBack(task.release()); // The command owns the task from here on.
   m_pJobSystem->AddJob(*CreateQueueFromJobs("V8EJobManager::PostJob", taskArray));
 }
 
@@ -135,11 +156,16 @@ bool aperture::v8::jobsystem::V8EJobManager::Initialize()
   NS_PROFILE_SCOPE("V8EJobManager::Initialize");
   if (m_pJobSystem == nullptr)
   {
-    m_pJobSystem = nsMakeUnique<core::threading::APCJobSystem>();
+    // The job system keeps its hot counters on separate cache lines, so it needs an aligned allocation.
+    m_pJobSystem = nsUniquePtr<core::threading::APCJobSystem>(NS_NEW(nsFoundation::GetAlignedAllocator(), core::threading::APCJobSystem), nsFoundation::GetAlignedAllocator());
   }
   m_pJobSystem->InitializeJobSystem(core::threading::APCJobSystemConfig{
     0, ApertureSDK::GetScriptThreadCount(),
     0, 0, false});
+  {
+    NS_LOCK(m_DelayedJobsMutex);
+    m_DelayedJobs.Clear(GetPlatformTime());
+  }
   if (m_pJobSystem->ActiveScriptThreads() == ApertureSDK::GetScriptThreadCount())
   {
     return true;
@@ -151,6 +177,19 @@ void aperture::v8::jobsystem::V8EJobManager::Shutdown()
 {
   NS_PROFILE_SCOPE("V8EJobManager::Shutdown");
   this->m_pJobSystem->Shutdown();
+  {
+    NS_LOCK(m_DelayedJobsMutex);
+    m_DelayedJobs.Clear();
+  }
+  {
+    NS_LOCK(m_BatchedJobsMutex);
+    for (::v8::Task* pTask : m_BatchedJobs)
+    {
+      delete pTask;
+    }
+    m_BatchedJobs.Clear();
+  }
+  m_IdleTasks.Clear();
   nsLog::Debug("V8EJobManager: Shutting down.");
 }
 
@@ -159,6 +198,51 @@ void aperture::v8::jobsystem::V8EJobManager::PostBatchedJob(std::unique_ptr<::v8
 {
   NS_PROFILE_SCOPE("V8EJobManager::PostBatchedJob");
   nsLog::Debug("V8EJobManager::PostJob: Posting Batched Task File: {0}", location.FileName());
+  NS_LOCK(m_BatchedJobsMutex);
+  m_BatchedJobs.PushBack(task.release()); // The batch owns the task until it becomes a command.
+}
+
+void aperture::v8::jobsystem::V8EJobManager::PostDelayedJob(std::unique_ptr<::v8::Task> task, double delay_in_seconds, const ::v8::SourceLocation& location)
+{
+  NS_PROFILE_SCOPE("V8EJobManager::PostDelayedJob");
+  nsLog::Debug("V8EJobManager::PostDelayedJob: Posting Task delayed by {0}s from File: {1}", delay_in_seconds, location.FileName());
+  const nsTime dueTime = GetPlatformTime() + nsTime::MakeFromSeconds(nsMath::Max(delay_in_seconds, 0.0));
+  NS_LOCK(m_DelayedJobsMutex);
+  m_DelayedJobs.Insert(dueTime, std::move(task));
+}
+
+void aperture::v8::jobsystem::V8EJobManager::PostIdleJob(std::unique_ptr<::v8::IdleTask> task, const ::v8::SourceLocation& location)
+{
+  NS_PROFILE_SCOPE("V8EJobManager::PostIdleJob");
+  nsLog::Debug("V8EJobManager::PostIdleJob: Posting Idle Task from File: {0}", location.FileName());
+  m_IdleTasks.PostIdleTask(std::move(task));
+}
+
+nsTime aperture::v8::jobsystem::V8EJobManager::GetPlatformTime() const
+{
+  if (m_pPlatform == nullptr)
+    return nsTime::Now();
+  return nsTime::MakeFromSeconds(static_cast<::v8::Platform*>(m_pPlatform)->MonotonicallyIncreasingTime());
+}
+
+void aperture::v8::jobsystem::V8EJobManager::SubmitBatchedJobs()
+{
+  NS_PROFILE_SCOPE("V8EJobManager::SubmitBatchedJobs");
+  nsHybridArray<::v8::Task*, 1> batch;
+  {
+    NS_LOCK(m_BatchedJobsMutex);
+    batch.Swap(m_BatchedJobs);
+  }
+  {
+    NS_LOCK(m_DelayedJobsMutex);
+    m_DelayedJobs.Advance(GetPlatformTime(), [&batch](std::unique_ptr<::v8::Task>& ref_pTask)
+      { batch.PushBack(ref_pTask.release()); });
+  }
+
+  if (!batch.IsEmpty())
+  {
+    m_pJobSystem->AddJob(*CreateQueueFromJobs("V8EJobManager::SubmitBatchedJobs", batch));
+  }
 }
 
 nsUInt32 aperture::v8::jobsystem::V8EJobManager::GetFrameCount() const
@@ -166,22 +250,69 @@ nsUInt32 aperture::v8::jobsystem::V8EJobManager::GetFrameCount() const
   return m_iV8EJobManagerFrameCount.load();
 }
 
+void aperture::v8::jobsystem::V8EJobManager::EndFrame(nsTime p_idleTime)
+{
+  NS_PROFILE_SCOPE("V8EJobManager::EndFrame");
+
+  // Before anything else, the frame's time is measured up to here.
+  m_IdleTasks.BeginFrame(p_idleTime);
+  m_IdleTasks.RunIdleTasks();
+
+  const nsUInt32 uiNextArena = m_uiCurrentArena.load(std::memory_order_relaxed) ^ 1;
+
+  // The arena we switch to was filled two frames ago, its jobs normally finished long ago. A worker that still builds a job in it
+  // read the index before the last switch, it notices that and moves to the current arena, see CreateQueueFromJobs().
+  core::APCCommandArena& arena = m_CommandArenas[uiNextArena];
+  while (m_uiArenaWriters[uiNextArena].load(std::memory_order_seq_cst) > 0 || arena.HasPendingJobs())
+  {
+    m_pJobSystem->SafePoll();
+  }
+  arena.Reset();
+
+  // Only published once the arena is reset, nobody builds a job in it before.
+  m_uiCurrentArena.store(uiNextArena, std::memory_order_seq_cst);
+
+  SubmitBatchedJobs();
+  m_pJobSystem->PublishFrameStats();
+  m_IdleTasks.EndFrame();
+  m_iV8EJobManagerFrameCount.fetch_add(1);
+}
+
 void aperture::v8::jobsystem::V8EJobManager::SetPlatform(V8EPlatform* platform)
 {
   m_pPlatform = (platform);
   platform->SetJobManager(this);
+  m_IdleTasks.SetPlatform(platform);
 }
 
 aperture::core::IAPCCommandQueue* aperture::v8::jobsystem::V8EJobManager::CreateQueueFromJobs(const nsString& p_sJobName, const nsHybridArray<::v8::Task*, 1>& p_aJobs)
 {
-  auto pQueue = nsMakeUnique<core::IAPCCommandQueue>();
-  auto pList = nsMakeUnique<core::IAPCCommandList>();
+  // Registering as a writer before checking the index again pairs with EndFrame(), which waits for the writers before it resets
+  // the arena and publishes it as the current one. If the index moved on in between, the arena may be about to be reset.
+  nsUInt32 uiArena = m_uiCurrentArena.load(std::memory_order_seq_cst);
+  while (true)
+  {
+    m_uiArenaWriters[uiArena].fetch_add(1, std::memory_order_seq_cst);
+    const nsUInt32 uiCurrentArena = m_uiCurrentArena.load(std::memory_order_seq_cst);
+    if (uiCurrentArena == uiArena)
+      break;
+
+    m_uiArenaWriters[uiArena].fetch_sub(1, std::memory_order_seq_cst);
+    uiArena = uiCurrentArena;
+  }
+
+  core::APCCommandArena& arena = m_CommandArenas[uiArena];
+  core::IAPCCommandQueue* pQueue = arena.AllocateCommandQueue(core::CommandType::Scripting, core::Runtype::FreeThread_Scripting);
+  core::IAPCCommandList* pList = arena.AllocateCommandList(*pQueue, core::CommandType::Scripting, core::Runtype::FreeThread_Scripting);
   for (auto& job : p_aJobs)
   {
-    core::IAPCCommand command(aperture::core::CommandType::Scripting, aperture::core::Runtype::FreeThread_Scripting);
-    command.SetFunction(CreateFunctionFromTask(job));
-    pList->AddCommand(command);
+    core::IAPCCommand* pCommand = arena.AllocateCommand(core::CommandType::Scripting, core::Runtype::FreeThread_Scripting);
+    pCommand->SetFunction(CreateFunctionFromTask(job));
+    pList->AddCommand(*pCommand);
   }
   pQueue->AddCommandList(*pList);
-  return pQueue.Release();
+
+  // From here on the pending queue keeps the arena from being reset.
+  m_uiArenaWriters[uiArena].fetch_sub(1, std::memory_order_seq_cst);
+  return pQueue;
 }
@@ -35,7 +35,10 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <APHTML/CommandExecutor/APCCommandArena.h>
 #include <APHTML/Multithreading/APCJobSystem.h>
+#include <APHTML/Multithreading/APCTimerWheel.h>
+#include <APHTML/V8Engine/System/JobSystem/V8EIdleTaskScheduler.h>
 #include <APHTML/V8Engine/System/Utils/Multithreading/V8EThreadSafeIsolate.h>
 #include <APHTML/V8Engine/V8EngineDLL.h>
 #include <libplatform/libplatform.h>
@@ -44,10 +47,19 @@ namespace aperture::v8::jobsystem
 {
   class V8EJobManager;
   class V8EPlatform;
-  static NS_ALWAYS_INLINE std::function<void()> CreateFunctionFromTask(::v8::Task* task)
+  /// @brief Wraps a task into a command function that takes ownership of it. The task is deleted once it ran, or together with
+  /// the function if it never runs, e.g. when its queue got canceled and the arena drops the command's function.
+  /// @note Only captures one pointer, so the function never leaves the inline storage of APCCommandFunction.
+  static NS_ALWAYS_INLINE core::APCCommandFunction CreateFunctionFromTask(::v8::Task* task)
   {
-    return [task = std::move(task)]()
-    { task->Run(); };
+    return [ownedTask = std::unique_ptr<::v8::Task>(task)]() mutable
+    {
+      if (ownedTask != nullptr)
+      {
+        ownedTask->Run();
+        ownedTask.reset();
+      }
+    };
   }
   class V8EWorkerTaskRunner : public ::v8::TaskRunner
   {
@@ -88,17 +100,25 @@ namespace aperture::v8::jobsystem
   private:
     V8EJobManager* m_pJobManager;
   };
-  class V8EPlatform : public ::v8::Platform
+  class NS_V8ENGINE_DLL V8EPlatform : public ::v8::Platform
   {
   public:
     explicit V8EPlatform(int thread_pool_size, ::v8::platform::IdleTaskSupport idle_task_support, ::v8::platform::InProcessStackDumping in_process_stack_dumping, std::unique_ptr<::v8::TracingController> tracing_controller, ::v8::platform::PriorityMode priority_mode);
 
     void SetJobManager(V8EJobManager* jobManager);
+
+    /// @brief Limits how many script workers one job (GC marking, concurrent compilation) may use, the joining thread comes on top.
+    /// 0 runs jobs on the joining thread only. Defaults to NumberOfWorkerThreads(), applies to jobs created afterwards.
+    void SetMaxJobWorkers(nsUInt32 p_uiMaxWorkers);
+    nsUInt32 GetMaxJobWorkers() const;
+
   private:
     nsMap<V8EThreadSafeIsolate*, std::shared_ptr<V8EWorkerTaskRunner>> m_workerTaskRunners;
     nsUniquePtr<V8EWorkerTaskRunner> m_workerTaskRunner;
-    std::atomic<nsUInt8> workerthreads;
-    V8EJobManager* m_pJobManager;
+    std::atomic<nsUInt8> workerthreads = 0;
+    std::atomic<nsUInt32> m_uiMaxJobWorkers = 0;
+    V8EJobManager* m_pJobManager = nullptr;
+    std::unique_ptr<::v8::TracingController> m_pTracingController;
 
     // Inherited via Platform
     ::v8::PageAllocator* GetPageAllocator() override;
@@ -122,18 +142,50 @@ namespace aperture::v8::jobsystem
     void Shutdown();
 
     void PostJob(std::unique_ptr<::v8::Task> task, const ::v8::SourceLocation& location);
+    /// @brief Collects the task for the batch that is submitted as one job at the end of the frame.
     void PostBatchedJob(std::unique_ptr<::v8::Task> task, const ::v8::SourceLocation& location);
+    /// @brief Parks the task in the timer wheel until delay_in_seconds passed, it is then batched at the next frame boundary.
+    void PostDelayedJob(std::unique_ptr<::v8::Task> task, double delay_in_seconds, const ::v8::SourceLocation& location);
+    /// @brief Queues the task until the frame has time left, see GetIdleTaskScheduler().
+    void PostIdleJob(std::unique_ptr<::v8::IdleTask> task, const ::v8::SourceLocation& location);
 
     nsUInt32 GetFrameCount() const;
 
+    /// @brief Ends the current frame, called by V8EEngineMain::EndFrame() on the thread that owns the isolates.
+    /// Idle tasks run first, for at most p_idleTime, the time that is left of the frame. The other arena is recycled once its jobs
+    /// are done, and jobs posted from then on are built in it. Delayed tasks that became due and the batched tasks are submitted,
+    /// then the job system's and the idle tasks' frame stats are published.
+    void EndFrame(nsTime p_idleTime = nsTime::MakeZero());
+
+    /// @brief The idle tasks that EndFrame() runs.
+    V8EIdleTaskScheduler& GetIdleTaskScheduler() { return m_IdleTasks; }
+
+    /// @brief The platform's monotonic clock, which delayed tasks are measured against.
+    nsTime GetPlatformTime() const;
+
     void SetPlatform(V8EPlatform* platform);
 
   protected:
     core::IAPCCommandQueue* CreateQueueFromJobs(const nsString& p_sJobName, const nsHybridArray<::v8::Task*, 1>& p_aJobs);
 
   private:
-    V8EPlatform* m_pPlatform;
+    /// @brief Moves the delayed tasks that are due into the batch and submits the batch as one job.
+    void SubmitBatchedJobs();
+
+    V8EPlatform* m_pPlatform = nullptr;
     nsUniquePtr<aperture::core::threading::APCJobSystem> m_pJobSystem;
     std::atomic<nsUInt32> m_iV8EJobManagerFrameCount = 0;
+    /// Double buffered, jobs of the previous frame may still run while the current frame is being built.
+    core::APCCommandArena m_CommandArenas[2];
+    /// V8 worker threads build jobs while EndFrame() switches the arena, see CreateQueueFromJobs().
+    std::atomic<nsUInt32> m_uiCurrentArena = 0;
+    /// Threads that are building a job in the arena right now. An arena is only reset once it has none and no pending queues.
+    std::atomic<nsUInt32> m_uiArenaWriters[2] = {};
+
+    nsMutex m_DelayedJobsMutex;
+    core::threading::APCTimerWheel<std::unique_ptr<::v8::Task>> m_DelayedJobs;
+    nsMutex m_BatchedJobsMutex;
+    nsHybridArray<::v8::Task*, 1> m_BatchedJobs;
+    V8EIdleTaskScheduler m_IdleTasks;
   };
 } // namespace aperture::v8::jobsystem
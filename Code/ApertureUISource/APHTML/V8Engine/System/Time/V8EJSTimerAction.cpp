@@ -0,0 +1,24 @@
+#include <APHTML/V8Engine/System/Time/V8EJSTimerAction.h>
+
+void aperture::v8::JavaScriptTimerAction::operator()(::v8::Isolate* isolate)
+{
+  if (function_.IsEmpty())
+    return;
+
+  ::v8::HandleScope handleScope(isolate);
+  ::v8::Local<::v8::Context> context = isolate->GetCurrentContext();
+
+  nsHybridArray<::v8::Local<::v8::Value>, 4> arguments;
+  for (int index = 0; index < argc_; ++index)
+  {
+    arguments.PushBack(argv_[index].Get(isolate));
+  }
+
+  // A throwing timer must not take the other timers of the frame with it.
+  ::v8::TryCatch tryCatch(isolate);
+  if (function_.Get(isolate)->Call(context, context->Global(), argc_, arguments.GetData()).IsEmpty() && tryCatch.HasCaught())
+  {
+    ::v8::String::Utf8Value message(isolate, tryCatch.Exception());
+    nsLog::Error("JavaScriptTimerAction: Uncaught exception in timer callback: {0}", *message != nullptr ? *message : "<unknown>");
+  }
+}
@@ -59,30 +59,27 @@ namespace aperture::v8
 
         NS_FORCE_INLINE ~JavaScriptTimerAction()
         {
-            if (argc_ > 0)
-            {
-                //NOTE unsafe
-                for (int index = 0 ; index < argc_; ++index)
-                {
-                    argv_[index].Reset();
-                }
-                nsFoundation::GetDefaultAllocator()->Deallocate(argv_);
-            }
-            function_.Reset();
+            Release();
         }
 
         NS_FORCE_INLINE JavaScriptTimerAction(JavaScriptTimerAction&& p_other) noexcept
             : function_(std::move(p_other.function_)), argc_(p_other.argc_), argv_(p_other.argv_)
         {
             p_other.argc_ = 0;
+            p_other.argv_ = nullptr;
         }
 
         NS_FORCE_INLINE JavaScriptTimerAction& operator=(JavaScriptTimerAction&& p_other) noexcept
         {
-            function_ = std::move(p_other.function_);
-            argc_ = p_other.argc_;
-            argv_ = p_other.argv_;
-            p_other.argc_ = 0;
+            if (this != &p_other)
+            {
+                Release();
+                function_ = std::move(p_other.function_);
+                argc_ = p_other.argc_;
+                argv_ = p_other.argv_;
+                p_other.argc_ = 0;
+                p_other.argv_ = nullptr;
+            }
             return *this;
         }
 
@@ -94,11 +91,28 @@ namespace aperture::v8
             argv_[index] = std::move(value);
         }
 
+        /// Calls the function with the stored arguments in the isolate's current context. Exceptions are logged, not rethrown.
         void operator()(::v8::Isolate* isolate);
 
     private:
+        NS_FORCE_INLINE void Release()
+        {
+            if (argc_ > 0)
+            {
+                //NOTE unsafe
+                for (int index = 0 ; index < argc_; ++index)
+                {
+                    argv_[index].Reset();
+                }
+                nsFoundation::GetDefaultAllocator()->Deallocate(argv_);
+            }
+            argc_ = 0;
+            argv_ = nullptr;
+            function_.Reset();
+        }
+
         ::v8::Global<::v8::Function> function_;
-        int argc_;
-        ::v8::Global<::v8::Value>* argv_;
+        int argc_ = 0;
+        ::v8::Global<::v8::Value>* argv_ = nullptr;
     };
 }
@@ -0,0 +1,155 @@
+#include <APHTML/V8Engine/System/Time/V8EJSTimers.h>
+#include <Foundation/Profiling/Profiling.h>
+
+aperture::v8::V8EJSTimers::V8EJSTimers(::v8::Isolate* p_pIsolate, ::v8::Platform* p_pPlatform, nsTime p_resolution)
+  : m_pIsolate(p_pIsolate)
+  , m_pPlatform(p_pPlatform)
+  , m_Wheel(p_resolution)
+{
+  m_Wheel.Clear(GetTime());
+}
+
+aperture::v8::V8EJSTimers::~V8EJSTimers()
+{
+  // The actions hold globals, they have to go while the isolate is still alive.
+  m_Wheel.Clear();
+  m_TimerHandles.Clear();
+  m_Context.Reset();
+}
+
+void aperture::v8::V8EJSTimers::Install(::v8::Local<::v8::Context> p_context)
+{
+  ::v8::HandleScope handleScope(m_pIsolate);
+  m_Context.Reset(m_pIsolate, p_context);
+
+  ::v8::Local<::v8::External> self = ::v8::External::New(m_pIsolate, this);
+  ::v8::Local<::v8::Object> global = p_context->Global();
+  auto install = [&](const char* szName, ::v8::FunctionCallback callback)
+  {
+    ::v8::Local<::v8::Function> function = ::v8::Function::New(p_context, callback, self).ToLocalChecked();
+    global->Set(p_context, ::v8::String::NewFromUtf8(m_pIsolate, szName).ToLocalChecked(), function).Check();
+  };
+  install("setTimeout", &V8EJSTimers::SetTimeoutCallback);
+  install("setInterval", &V8EJSTimers::SetIntervalCallback);
+  install("clearTimeout", &V8EJSTimers::ClearTimerCallback);
+  install("clearInterval", &V8EJSTimers::ClearTimerCallback);
+}
+
+nsUInt32 aperture::v8::V8EJSTimers::SetTimer(JavaScriptTimerAction&& p_action, nsTime p_delay, bool p_bRepeat)
+{
+  // An interval of 0 would fire every frame anyway, one wheel step keeps it from being due again right away.
+  const nsTime delay = nsMath::Max(p_delay, p_bRepeat ? m_Wheel.GetResolution() : nsTime::MakeZero());
+
+  Timer timer;
+  timer.m_Action = std::move(p_action);
+  timer.m_DueTime = GetTime() + delay;
+  timer.m_Interval = delay;
+  timer.m_uiId = m_uiNextTimerId++;
+  timer.m_bRepeat = p_bRepeat;
+  if (m_uiNextTimerId == 0)
+  {
+    m_uiNextTimerId = 1;
+  }
+
+  const nsUInt32 uiTimerId = timer.m_uiId;
+  const nsTime dueTime = timer.m_DueTime;
+  m_TimerHandles.Insert(uiTimerId, m_Wheel.Insert(dueTime, std::move(timer)));
+  return uiTimerId;
+}
+
+bool aperture::v8::V8EJSTimers::ClearTimer(nsUInt32 p_uiTimerId)
+{
+  core::threading::APCTimerHandle handle;
+  if (!m_TimerHandles.Remove(p_uiTimerId, &handle))
+    return false;
+
+  // A timer that is running right now is not in the wheel anymore, removing the ID keeps it from being re-armed.
+  m_Wheel.Cancel(handle);
+  return true;
+}
+
+nsUInt32 aperture::v8::V8EJSTimers::RunDueTimers()
+{
+  NS_PROFILE_SCOPE("V8EJSTimers::RunDueTimers");
+  if (m_Context.IsEmpty())
+    return 0;
+
+  ::v8::HandleScope handleScope(m_pIsolate);
+  ::v8::Local<::v8::Context> context = m_Context.Get(m_pIsolate);
+  ::v8::Context::Scope contextScope(context);
+
+  return m_Wheel.Advance(GetTime(), [this](Timer& ref_timer)
+    {
+      ref_timer.m_Action(m_pIsolate);
+
+      core::threading::APCTimerHandle* pHandle = nullptr;
+      if (!m_TimerHandles.TryGetValue(ref_timer.m_uiId, pHandle))
+        return;
+
+      if (!ref_timer.m_bRepeat)
+      {
+        m_TimerHandles.Remove(ref_timer.m_uiId);
+        return;
+      }
+
+      // Re-armed from the due time, not from now, so a late frame does not push every later run back.
+      ref_timer.m_DueTime = nsMath::Max(ref_timer.m_DueTime + ref_timer.m_Interval, m_Wheel.GetCurrentTime());
+      const nsTime dueTime = ref_timer.m_DueTime;
+      *pHandle = m_Wheel.Insert(dueTime, std::move(ref_timer)); });
+}
+
+nsTime aperture::v8::V8EJSTimers::GetTime() const
+{
+  return m_pPlatform != nullptr ? nsTime::MakeFromSeconds(m_pPlatform->MonotonicallyIncreasingTime()) : nsTime::Now();
+}
+
+void aperture::v8::V8EJSTimers::SetTimeoutCallback(const ::v8::FunctionCallbackInfo<::v8::Value>& p_info)
+{
+  SetTimerFromJS(p_info, false);
+}
+
+void aperture::v8::V8EJSTimers::SetIntervalCallback(const ::v8::FunctionCallbackInfo<::v8::Value>& p_info)
+{
+  SetTimerFromJS(p_info, true);
+}
+
+void aperture::v8::V8EJSTimers::ClearTimerCallback(const ::v8::FunctionCallbackInfo<::v8::Value>& p_info)
+{
+  V8EJSTimers* pTimers = static_cast<V8EJSTimers*>(p_info.Data().As<::v8::External>()->Value());
+  if (p_info.Length() < 1 || !p_info[0]->IsUint32())
+    return;
+
+  pTimers->ClearTimer(p_info[0].As<::v8::Uint32>()->Value());
+}
+
+void aperture::v8::V8EJSTimers::SetTimerFromJS(const ::v8::FunctionCallbackInfo<::v8::Value>& p_info, bool p_bRepeat)
+{
+  ::v8::Isolate* pIsolate = p_info.GetIsolate();
+  V8EJSTimers* pTimers = static_cast<V8EJSTimers*>(p_info.Data().As<::v8::External>()->Value());
+  if (p_info.Length() < 1 || !p_info[0]->IsFunction())
+  {
+    pIsolate->ThrowError(::v8::String::NewFromUtf8Literal(pIsolate, "The timer callback has to be a function."));
+    return;
+  }
+
+  // Like browsers, a missing, negative or NaN delay means 0.
+  double fDelayInMs = 0.0;
+  if (p_info.Length() > 1)
+  {
+    fDelayInMs = p_info[1]->NumberValue(pIsolate->GetCurrentContext()).FromMaybe(0.0);
+    if (!(fDelayInMs > 0.0))
+    {
+      fDelayInMs = 0.0;
+    }
+  }
+
+  const int iArgCount = nsMath::Max(p_info.Length() - 2, 0);
+  JavaScriptTimerAction action(::v8::Global<::v8::Function>(pIsolate, p_info[0].As<::v8::Function>()), iArgCount);
+  for (int index = 0; index < iArgCount; ++index)
+  {
+    action.store(index, ::v8::Global<::v8::Value>(pIsolate, p_info[index + 2]));
+  }
+
+  const nsUInt32 uiTimerId = pTimers->SetTimer(std::move(action), nsTime::MakeFromMilliseconds(fDelayInMs), p_bRepeat);
+  p_info.GetReturnValue().Set(uiTimerId);
+}
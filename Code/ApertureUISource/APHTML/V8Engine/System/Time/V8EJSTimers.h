@@ -0,0 +1,98 @@
+/*
+This code is part of Aperture UI - A HTML/CSS/JS UI Middleware
+
+Copyright (c) 2020-2024 WD Studios L.L.C. and/or its licensors. All
+rights reserved in all media.
+
+The coded instructions, statements, computer programs, and/or related
+material (collectively the "Data") in these files contain confidential
+and unpublished information proprietary WD Studios and/or its
+licensors, which is protected by United States of America federal
+copyright law and by international treaties.
+
+This software or source code is supplied under the terms of a license
+agreement and nondisclosure agreement with WD Studios L.L.C. and may
+not be copied, disclosed, or exploited except in accordance with the
+terms of that agreement. The Data may not be disclosed or distributed to
+third parties, in whole or in part, without the prior written consent of
+WD Studios L.L.C..
+
+WD STUDIOS MAKES NO REPRESENTATION ABOUT THE SUITABILITY OF THIS
+SOURCE CODE FOR ANY PURPOSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER, ITS AFFILIATES,
+PARENT COMPANIES, LICENSORS, SUPPLIERS, OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OR PERFORMANCE OF THIS SOFTWARE OR SOURCE CODE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <APHTML/Multithreading/APCTimerWheel.h>
+#include <APHTML/V8Engine/System/Time/V8EJSTimerAction.h>
+#include <APHTML/V8Engine/V8EngineDLL.h>
+#include <Foundation/Containers/HashTable.h>
+
+namespace aperture::v8
+{
+  /**
+   * @brief setTimeout, setInterval, clearTimeout and clearInterval for one context, backed by an APCTimerWheel.
+   *
+   * Callbacks run on the thread that calls RunDueTimers(), which has to own the isolate. Call it once per frame, so timers fire in a
+   * batch at the frame boundary. Intervals are re-armed from their previous due time, so they do not drift with the frame rate.
+   */
+  class NS_V8ENGINE_DLL V8EJSTimers
+  {
+  public:
+    /// @brief Timers are measured against p_pPlatform's MonotonicallyIncreasingTime(), the same clock delayed V8 tasks use.
+    V8EJSTimers(::v8::Isolate* p_pIsolate, ::v8::Platform* p_pPlatform, nsTime p_resolution = nsTime::MakeFromMilliseconds(1));
+    ~V8EJSTimers();
+
+    V8EJSTimers(const V8EJSTimers&) = delete;
+    V8EJSTimers& operator=(const V8EJSTimers&) = delete;
+
+    /// @brief Adds the timer functions to the global object of p_context. The timers have to outlive the context.
+    void Install(::v8::Local<::v8::Context> p_context);
+
+    /// @brief Starts a timer, returns its ID for ClearTimer(). IDs start at 1, as in browsers.
+    nsUInt32 SetTimer(JavaScriptTimerAction&& p_action, nsTime p_delay, bool p_bRepeat);
+    /// @brief Stops a timer. Also works from inside the timer's own callback.
+    bool ClearTimer(nsUInt32 p_uiTimerId);
+
+    /// @brief Runs the callbacks of all timers that are due, returns how many ran.
+    nsUInt32 RunDueTimers();
+
+    nsUInt32 GetPendingTimerCount() const { return m_TimerHandles.GetCount(); }
+
+  private:
+    struct Timer
+    {
+      JavaScriptTimerAction m_Action;
+      nsTime m_DueTime;
+      nsTime m_Interval;
+      nsUInt32 m_uiId = 0;
+      bool m_bRepeat = false;
+    };
+
+    static void SetTimeoutCallback(const ::v8::FunctionCallbackInfo<::v8::Value>& p_info);
+    static void SetIntervalCallback(const ::v8::FunctionCallbackInfo<::v8::Value>& p_info);
+    static void ClearTimerCallback(const ::v8::FunctionCallbackInfo<::v8::Value>& p_info);
+    static void SetTimerFromJS(const ::v8::FunctionCallbackInfo<::v8::Value>& p_info, bool p_bRepeat);
+
+    nsTime GetTime() const;
+
+    ::v8::Isolate* m_pIsolate = nullptr;
+    ::v8::Platform* m_pPlatform = nullptr;
+    ::v8::Global<::v8::Context> m_Context;
+    core::threading::APCTimerWheel<Timer> m_Wheel;
+    nsHashTable<nsUInt32, core::threading::APCTimerHandle> m_TimerHandles;
+    nsUInt32 m_uiNextTimerId = 1;
+  };
+} // namespace aperture::v8
@@ -3,6 +3,11 @@
 bool aperture::v8::V8EThreadSafeIsolate::CreateIsolate(::v8::Isolate::CreateParams& params)
 {
   NS_LOCK(mangaged_isolate_mutex);
+  m_bOwnsArrayBufferAllocator = params.array_buffer_allocator == nullptr && params.array_buffer_allocator_shared == nullptr;
+  if (m_bOwnsArrayBufferAllocator)
+  {
+    params.array_buffer_allocator = &m_ArrayBufferAllocator;
+  }
   mangaged_isolate = ::v8::Isolate::New(params);
   if (mangaged_isolate != nullptr)
   {
@@ -10,3 +15,39 @@ bool aperture::v8::V8EThreadSafeIsolate::CreateIsolate(::v8::Isolate::CreatePara
   }
   return false;
 }
+
+nsUInt64 aperture::v8::V8EThreadSafeIsolate::GetUsedHeapSize()
+{
+  NS_LOCK(mangaged_isolate_mutex);
+  if (mangaged_isolate == nullptr)
+  {
+    return 0;
+  }
+
+  ::v8::HeapStatistics stats;
+  mangaged_isolate->GetHeapStatistics(&stats);
+  return stats.used_heap_size();
+}
+
+nsUInt64 aperture::v8::V8EThreadSafeIsolate::CollectGarbage()
+{
+  NS_LOCK(mangaged_isolate_mutex);
+  if (mangaged_isolate == nullptr)
+  {
+    return 0;
+  }
+
+  const nsUInt64 uiUsedBefore = GetUsedHeapSize();
+  mangaged_isolate->LowMemoryNotification();
+  const nsUInt64 uiUsedAfter = GetUsedHeapSize();
+  return uiUsedBefore > uiUsedAfter ? uiUsedBefore - uiUsedAfter : 0;
+}
+
+void aperture::v8::V8EThreadSafeIsolate::ReportExternalMemory()
+{
+  NS_LOCK(mangaged_isolate_mutex);
+  if (mangaged_isolate != nullptr && m_bOwnsArrayBufferAllocator)
+  {
+    m_ArrayBufferAllocator.ReportExternalMemory(mangaged_isolate);
+  }
+}
@@ -36,6 +36,7 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <APHTML/Interfaces/APCPlatform.h>
+#include <APHTML/V8Engine/System/V8EArrayBufferAlloc.h>
 #include <Foundation/Threading/LockedObject.h>
 #include <Foundation/Threading/Mutex.h>
 #include <APHTML/V8Engine/V8EngineDLL.h>
@@ -49,10 +50,22 @@ namespace aperture::v8
     virtual ~V8EThreadSafeIsolate() = default;
 
     /// @brief Creates the internal isolate object. This Function REQUIRES you to create this on the Main Thread.
+    ///
+    /// Unless params bring an ArrayBuffer allocator, the ArrayBuffers of the isolate come from a V8EArrayBufferAlloc of this
+    /// object, so the isolate must be disposed before this object is destroyed.
     /// @param params custom options
     /// @return If assigning and creating the isolate was successful.
     bool CreateIsolate(::v8::Isolate::CreateParams& params);
 
+    /// @brief Reports the change of the isolate's ArrayBuffer bytes to its GC. Call once per frame on the isolate's thread.
+    void ReportExternalMemory();
+
+    /// @brief Bytes in use on the isolate's heap, zero without an isolate. Call on the isolate's thread.
+    nsUInt64 GetUsedHeapSize();
+
+    /// @brief Runs a full garbage collection and returns how many bytes of the heap it freed. Call on the isolate's thread.
+    nsUInt64 CollectGarbage();
+
     NS_ALWAYS_INLINE ::v8::Isolate* AccessInternalIsolate()
     {
       if (mangaged_isolate != nullptr)
@@ -68,6 +81,8 @@ namespace aperture::v8
 
   private:
     nsMutex mangaged_isolate_mutex;
-    ::v8::Isolate* mangaged_isolate;
+    ::v8::Isolate* mangaged_isolate = nullptr;
+    V8EArrayBufferAlloc m_ArrayBufferAllocator;
+    bool m_bOwnsArrayBufferAllocator = false;
   };
 } // namespace aperture::v8
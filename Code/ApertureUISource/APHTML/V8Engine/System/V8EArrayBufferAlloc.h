@@ -35,32 +35,68 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <APHTML/Interfaces/APCPlatform.h>
+#include <APHTML/Interfaces/Internal/APCArrayBufferPool.h>
 #include <Foundation/Strings/String.h>
 #include <Foundation/Types/UniquePtr.h>
 #include <Foundation/Types/Variant.h>
 #include <APHTML/V8Engine/V8EngineDLL.h>
 
+#include <atomic>
 
 namespace aperture::v8
 {
+  /// @brief Serves the ArrayBuffers of an isolate from the core::APCArrayBufferPool, whose memory is always zeroed.
+  ///
+  /// Keeps count of the bytes of all ArrayBuffers that are alive, so that they can be reported to V8 as external memory
+  /// with ReportExternalMemory().
   class NS_V8ENGINE_DLL V8EArrayBufferAlloc : public ::v8::ArrayBuffer::Allocator
   {
   public:
     virtual void* Allocate(std::size_t length) override
     {
-      void* p = core::IAPCPlatform::GetAllocatorSystem()->Alloc(length, 0);
-      //core::IAPCPlatform::GetAllocatorSystem()->Memset(p, 0, length);
-      return p;
+      void* pData = core::APCArrayBufferPool::Allocate(length);
+      if (pData != nullptr)
+      {
+        m_iLiveBytes.fetch_add(static_cast<nsInt64>(length), std::memory_order_relaxed);
+      }
+      return pData;
     }
 
     virtual void* AllocateUninitialized(size_t length) override
     {
-      return core::IAPCPlatform::GetAllocatorSystem()->Alloc(length,0);
+      // zeroed memory costs the same here
+      return Allocate(length);
     }
 
     virtual void Free(void* data, size_t length) override
     {
-      core::IAPCPlatform::GetAllocatorSystem()->Free(data);
+      if (data == nullptr)
+        return;
+
+      m_iLiveBytes.fetch_sub(static_cast<nsInt64>(length), std::memory_order_relaxed);
+      core::APCArrayBufferPool::Free(data, length);
     }
+
+    /// @brief Bytes of all ArrayBuffers from this allocator that are alive.
+    nsInt64 GetLiveBytes() const { return m_iLiveBytes.load(std::memory_order_relaxed); }
+
+    /// @brief Tells the isolate how much the ArrayBuffer bytes changed since the last call, so its GC can take them into account.
+    ///
+    /// Must be called on the thread that owns the isolate, e.g. once per frame.
+    void ReportExternalMemory(::v8::Isolate* pIsolate)
+    {
+      const nsInt64 iLiveBytes = GetLiveBytes();
+      const nsInt64 iChange = iLiveBytes - m_iReportedBytes;
+
+      if (iChange != 0)
+      {
+        pIsolate->AdjustAmountOfExternalAllocatedMemory(iChange);
+        m_iReportedBytes = iLiveBytes;
+      }
+    }
+
+  private:
+    std::atomic<nsInt64> m_iLiveBytes = 0;
+    nsInt64 m_iReportedBytes = 0;
   };
-} // namespace aperture::v8
\ No newline at end of file
+} // namespace aperture::v8
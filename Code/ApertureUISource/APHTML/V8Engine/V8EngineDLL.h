@@ -26,7 +26,7 @@
 #include <v8.h>
 
 #define NS_ISE_JSI_CHECK(CHECKER) \
-if(!CHECKER)  \
+if(!(CHECKER))  \
 {                     \
   nsLog::Error("V8Engine: JSB Error: A Function/Value Check Failed! File: {0} Function: {1}", NS_SOURCE_FILE, NS_SOURCE_FUNCTION); \
 }                      
@@ -57,7 +57,8 @@ namespace wdvideo
     memset(&m_vorbisInfo, 0, sizeof(m_vorbisInfo));
     memset(&m_vorbisComment, 0, sizeof(m_vorbisComment));
 
-    m_buffer = new aperture::core::CoreBuffer<float>(bufferSize());
+    // grows to the size of the largest decoded block
+    m_buffer = new aperture::core::CoreBuffer<float>();
   }
 
   AudioDecoderVPX::~AudioDecoderVPX()
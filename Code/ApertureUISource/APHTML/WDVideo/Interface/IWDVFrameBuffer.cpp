@@ -6,40 +6,38 @@ wdvideo::IWDVFrameBuffer::IWDVFrameBuffer(wdvideo::IWDVVideoPlayer* parent, size
   , m_frameCount(frameCount)
   , m_width(width)
   , m_height(height)
+  , m_readQueue(frameCount)
+  , m_writeQueue(frameCount)
   , m_writeFrame(nullptr)
   , m_readTime(0.0)
 {
   m_readFrame = new IWDVFrame(width, height);
 
   for (size_t i = 0; i < frameCount; i++)
-    m_writeQueue.push(new IWDVFrame(width, height));
+    m_writeQueue.try_push(new IWDVFrame(width, height));
 }
 
 wdvideo::IWDVFrameBuffer::~IWDVFrameBuffer()
 {
   aperture::core::SafeDelete<IWDVFrame>(m_readFrame);
 
-  while (m_writeQueue.size() > 0)
-  {
-    IWDVFrame* frame = m_writeQueue.front();
+  IWDVFrame* frame = nullptr;
+  while (m_writeQueue.try_pop(frame))
     aperture::core::SafeDelete<IWDVFrame>(frame);
-    m_writeQueue.pop();
-  }
 
-  while (m_readQueue.size() > 0)
-  {
-    IWDVFrame* frame = m_readQueue.front();
+  while (m_readQueue.try_pop(frame))
     aperture::core::SafeDelete<IWDVFrame>(frame);
-    m_readQueue.pop();
-  }
 }
 
 void wdvideo::IWDVFrameBuffer::reset()
 {
-  while (m_readQueue.size() > 0)
   {
-    m_writeQueue.push(m_readQueue.front());
-    m_readQueue.pop();
+    // Both queues are only ever refilled/drained from one side at a time, m_updateLock keeps update() out.
+    std::lock_guard<std::mutex> lock(m_updateLock);
+
+    IWDVFrame* frame = nullptr;
+    while (m_readQueue.try_pop(frame))
+      m_writeQueue.try_push(frame);
   }
 
   m_writeFrame = nullptr;
@@ -74,8 +72,12 @@ void wdvideo::IWDVFrameBuffer::unlockRead()
 
 wdvideo::IWDVFrame* wdvideo::IWDVFrameBuffer::lockWrite(double time)
 {
-  m_writeFrame = m_writeQueue.front();
-  m_writeQueue.pop();
+  // Callers check isFull() first, but never hand out a frame the reader still owns.
+  if (!m_writeQueue.try_pop(m_writeFrame))
+  {
+    m_writeFrame = nullptr;
+    return nullptr;
+  }
 
   m_writeFrame->setTime(time);
 
@@ -84,30 +86,28 @@ wdvideo::IWDVFrame* wdvideo::IWDVFrameBuffer::lockWrite(double time)
 
 void wdvideo::IWDVFrameBuffer::unlockWrite()
 {
-  m_readQueue.push(m_writeFrame);
+  // Can't fail, both queues hold every frame of the buffer.
+  m_readQueue.try_push(m_writeFrame);
   m_writeFrame = nullptr;
 }
 
 void wdvideo::IWDVFrameBuffer::update(double playTime, double frameTime)
 {
-  if (m_readQueue.size() == 0)
+  if (m_readQueue.empty_approx())
     return;
 
   m_updateLock.lock();
 
-  IWDVFrame* front = m_readQueue.front();
+  IWDVFrame* front = nullptr;
 
-  if ((playTime - front->time()) >= frameTime)
+  if (m_readQueue.try_front(front) && (playTime - front->time()) >= frameTime)
   {
-    while (m_readQueue.size() > 0)
+    while (m_readQueue.try_pop(front))
     {
-      m_readQueue.pop();
-      m_writeQueue.push(front);
+      m_writeQueue.try_push(front);
 
-      if (m_readQueue.size() > 0)
+      if (m_readQueue.try_front(front))
       {
-        front = m_readQueue.front();
-
         if ((playTime - front->time()) < frameTime)
         {
           m_readLock.lock();
@@ -125,5 +125,5 @@ void wdvideo::IWDVFrameBuffer::update(double playTime, double frameTime)
 
 bool wdvideo::IWDVFrameBuffer::isFull()
 {
-  return m_writeQueue.size() == 0;
+  return m_writeQueue.empty_approx();
 }
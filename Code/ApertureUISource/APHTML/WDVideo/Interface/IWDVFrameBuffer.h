@@ -36,7 +36,7 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 #include <mutex>
 
-#include <APHTML/Interfaces/Internal/APCThreadSafeQueue.h>
+#include <APHTML/Interfaces/Internal/APCRingBuffer.h>
 #include <APHTML/APEngineDLL.h>
 #include "IWDVFrame.h"
 #include "IWDVideoPlayer.h"
@@ -57,8 +57,10 @@ namespace wdvideo
     std::mutex m_readLock;
     std::mutex m_updateLock;
 
-    aperture::core::ThreadSafeQueue<IWDVFrame*> m_readQueue;
-    aperture::core::ThreadSafeQueue<IWDVFrame*> m_writeQueue;
+    /// Decoded frames, pushed by the decoder thread, consumed by update() under m_updateLock.
+    aperture::core::SPSCRingBuffer<IWDVFrame*> m_readQueue;
+    /// Free frames, refilled by update()/reset() under m_updateLock, consumed by the decoder thread.
+    aperture::core::SPSCRingBuffer<IWDVFrame*> m_writeQueue;
     IWDVFrame* m_writeFrame;
 
     double m_readTime;
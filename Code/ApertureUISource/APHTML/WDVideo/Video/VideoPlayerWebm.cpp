@@ -50,6 +50,8 @@ void wdvideo::VideoPlayerWebm::updateYUVData(double time)
   const int h2 = h / 2;
 
   IWDVFrame* curYUV = m_frameBuffer->lockWrite(time);
+  if (curYUV == nullptr)
+    return;
 
   unsigned char* y = curYUV->y();
   unsigned char* u = curYUV->u();
@@ -36,6 +36,8 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <APHTML/Interfaces/Internal/APCObjectTree.h>
 #include <APHTML/Interfaces/Internal/APCBuffer.h>
+#include <APHTML/Interfaces/Internal/APCStlAllocator.h>
+#include <APHTML/Interfaces/APCMemoryAllocator.h>
 #include <Foundation/Containers/HybridArray.h>
 #include <Foundation/Containers/List.h>
 #include <Foundation/Containers/Map.h>
@@ -59,13 +61,38 @@ namespace aperture
     NS_ALLOW_PRIVATE_PROPERTIES(aperture::BaseDocument<ElementType>);
 
   public:
+    using DocumentTree = tree<ElementType, aperture::core::APCStlAllocator<tree_node_<ElementType>>>;
+
     BaseDocument();
     BaseDocument(const nsString& in_documentpath)
       : m_documentpath(in_documentpath)
     {
     }
 
-    virtual ~BaseDocument() = default;
+    virtual ~BaseDocument();
+
+    /// @brief Allocates the data of this document from a view heap of p_allocator from now on.
+    ///
+    /// The document buffer and the nodes of the document tree move into the heap. In APCHeapMode::PerView the heap, and
+    /// everything still in it, is released in one call when the document is destroyed.
+    void UseViewHeap(aperture::core::IAPCMemoryAllocator& p_allocator);
+
+    /// @brief The allocator for DOM, style and layout data of this document.
+    nsAllocator* GetHeap() const { return m_pHeap; }
+
+    /// @brief For containers of style and layout data of this document, e.g. std::vector<T, APCStlAllocator<T>>.
+    template <typename T>
+    aperture::core::APCStlAllocator<T> GetStlAllocator() const
+    {
+      return aperture::core::APCStlAllocator<T>(m_pHeap);
+    }
+
+    /// @brief Creates a style or layout node of this document in its heap. It must not outlive the document.
+    template <typename T, typename... Args>
+    std::shared_ptr<T> MakeShared(Args&&... args) const
+    {
+      return std::allocate_shared<T>(GetStlAllocator<T>(), std::forward<Args>(args)...);
+    }
 
     virtual void ComposeDocumentTree() = 0;
 
@@ -79,17 +106,57 @@ namespace aperture
     aperture::core::APCBuffer DocumentBuffer;
 
   public:
-    tree<ElementType> InternalDocumentTree;
+    DocumentTree InternalDocumentTree;
     nsString m_documentpath;
 
   protected:
     nsUInt64 NodeCount;
     nsUInt64 ElementCount;
+
+  private:
+    nsAllocator* m_pHeap = nsFoundation::GetDefaultAllocator();
+    aperture::core::IAPCMemoryAllocator* m_pHeapOwner = nullptr;
   };
   template <typename ElementType>
   inline BaseDocument<ElementType>::BaseDocument()
   {
   }
+
+  template <typename ElementType>
+  inline BaseDocument<ElementType>::~BaseDocument()
+  {
+    if (m_pHeapOwner != nullptr)
+    {
+      DocumentBuffer.Clear();
+      DocumentBuffer.Compact();
+
+      // a view heap frees the nodes at once, only elements that own memory elsewhere have to be destroyed one by one
+      if (m_pHeapOwner->GetHeapMode() == aperture::core::APCHeapMode::PerView)
+        InternalDocumentTree.release();
+      else
+        InternalDocumentTree.clear();
+
+      // the tree may not keep its head and feet in the heap
+      InternalDocumentTree.set_allocator(aperture::core::APCStlAllocator<tree_node_<ElementType>>());
+
+      m_pHeapOwner->DestroyViewHeap(m_pHeap);
+    }
+  }
+
+  template <typename ElementType>
+  inline void BaseDocument<ElementType>::UseViewHeap(aperture::core::IAPCMemoryAllocator& p_allocator)
+  {
+    NS_ASSERT_DEV(m_pHeapOwner == nullptr, "The document '{}' has a view heap already.", m_documentpath);
+
+    m_pHeapOwner = &p_allocator;
+    m_pHeap = p_allocator.CreateViewHeap(m_documentpath);
+
+    aperture::core::APCBuffer buffer(m_pHeap);
+    buffer.PushBackRange(DocumentBuffer);
+    DocumentBuffer.Swap(buffer);
+
+    InternalDocumentTree.set_allocator(GetStlAllocator<tree_node_<ElementType>>());
+  }
 } // namespace aperture
 
 // NS_DECLARE_REFLECTABLE_TYPE(NS_APERTURE_DLL, aperture::BaseDocument<aperture::dom::DOMElement>);
@@ -70,6 +70,37 @@ namespace aperture::harrlow::vector
 		m_data.m_drawOrders.clear();
 	}
 
+	namespace
+	{
+		size_t GetTextCacheEntrySize(const TextCache& cache)
+		{
+			return sizeof(TextCache) + static_cast<size_t>(cache.vtxBuffer.m_capacity) * sizeof(Vertex) + static_cast<size_t>(cache.indxBuffer.m_capacity) * sizeof(Index);
+		}
+	} // namespace
+
+	size_t BufferStore::GetTextCacheSize() const
+	{
+		size_t size = 0;
+
+		for (const auto& [sid, cache] : m_data.m_textCache)
+			size += GetTextCacheEntrySize(cache);
+
+		return size;
+	}
+
+	size_t BufferStore::EvictTextCache(size_t bytes)
+	{
+		size_t freed = 0;
+
+		for (auto it = m_data.m_textCache.begin(); it != m_data.m_textCache.end() && freed < bytes;)
+		{
+			freed += GetTextCacheEntrySize(it->second);
+			it = m_data.m_textCache.erase(it);
+		}
+
+		return freed;
+	}
+
 	void BufferStore::ResetFrame()
 	{
 		m_data.m_gcFrameCounter++;
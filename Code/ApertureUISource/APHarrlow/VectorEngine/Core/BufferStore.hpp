@@ -118,6 +118,17 @@ namespace aperture::harrlow::vector
 		/// </summary>
 		APHARRLOW_API void ClearAllBuffers();
 
+		/// <summary>
+		/// Bytes held by the cached vertex & index data of texts.
+		/// </summary>
+		APHARRLOW_API size_t GetTextCacheSize() const;
+
+		/// <summary>
+		/// Drops cached texts until at least the given amount of bytes is freed, or the cache is empty. Dropped texts are rebuilt the next time they are drawn.
+		/// </summary>
+		/// <returns>The bytes that were freed.</returns>
+		APHARRLOW_API size_t EvictTextCache(size_t bytes);
+
 		APHARRLOW_API inline BufferStoreData& GetData()
 		{
 			return m_data;
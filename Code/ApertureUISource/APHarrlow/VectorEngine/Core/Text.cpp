@@ -192,6 +192,17 @@ namespace aperture::harrlow::vector
 		m_updateFunc(this);
 	}
 
+	bool Atlas::IsEmpty() const
+	{
+		// removed fonts leave their slices unmerged, but they never overlap
+		unsigned int availableHeight = 0;
+
+		for (Slice* slice : m_availableSlices)
+			availableHeight += slice->height;
+
+		return availableHeight == m_size.y;
+	}
+
 	Font* Text::LoadFont(const char* file, bool loadAsSDF, int size, GlyphEncoding* customRanges, int customRangesSize, bool useKerningIfAvailable)
 	{
 		FT_Face face;
@@ -412,11 +423,46 @@ namespace aperture::harrlow::vector
 
 	APHARRLOW_API void Text::RemoveFontFromAtlas(Font* font)
 	{
-		if (font->atlas)
+		if (font->atlas == nullptr)
 			return;
 
 		font->atlas->RemoveFont(font->atlasRectPos, font->atlasRectHeight);
 		font->atlas = nullptr;
 	}
+
+	APHARRLOW_API size_t Text::GetAtlasSize() const
+	{
+		size_t size = 0;
+
+		for (Atlas* atlas : m_atlases)
+			size += static_cast<size_t>(atlas->GetSize().x) * atlas->GetSize().y;
+
+		return size;
+	}
+
+	APHARRLOW_API size_t Text::ReleaseEmptyAtlases()
+	{
+		size_t freed = 0;
+
+		for (auto it = m_atlases.begin(); it != m_atlases.end();)
+		{
+			Atlas* atlas = *it;
+
+			if (!atlas->IsEmpty())
+			{
+				++it;
+				continue;
+			}
+
+			if (m_callbacks.atlasDestroyed)
+				m_callbacks.atlasDestroyed(atlas);
+
+			freed += static_cast<size_t>(atlas->GetSize().x) * atlas->GetSize().y;
+			delete atlas;
+			it = m_atlases.erase(it);
+		}
+
+		return freed;
+	}
 } // namespace aperture::harrlow::vector
 #endif
@@ -113,6 +113,11 @@ namespace aperture::harrlow::vector
 		bool AddFont(Font* font);
 		void RemoveFont(unsigned int pos, unsigned int height);
 
+		/// <summary>
+		/// Whether all fonts were removed from the atlas again.
+		/// </summary>
+		bool IsEmpty() const;
+
 		inline const Vec2ui& GetSize() const
 		{
 			return m_size;
@@ -133,6 +138,8 @@ namespace aperture::harrlow::vector
 	struct Callbacks
 	{
 		std::function<void(Atlas* atlas)> atlasNeedsUpdate;
+		/// Called before ReleaseEmptyAtlases deletes an atlas, so the texture that was made for it can be released.
+		std::function<void(Atlas* atlas)> atlasDestroyed;
 	};
 
 	extern APHARRLOW_API FT_Library g_ftLib;
@@ -204,6 +211,17 @@ namespace aperture::harrlow::vector
 		/// <returns></returns>
 		APHARRLOW_API void RemoveFontFromAtlas(Font* font);
 
+		/// <summary>
+		/// Bytes held by the pixel data of all atlases.
+		/// </summary>
+		APHARRLOW_API size_t GetAtlasSize() const;
+
+		/// <summary>
+		/// Destroys the atlases that no font uses anymore, see RemoveFontFromAtlas.
+		/// </summary>
+		/// <returns>The bytes that were freed.</returns>
+		APHARRLOW_API size_t ReleaseEmptyAtlases();
+
 		/// <summary>
 		/// Returns the kerning vector between two given glphys.
 		/// </summary>
@@ -3,7 +3,10 @@
 #include <Foundation/Memory/LinearAllocator.h>
 
 /// \brief A double buffered stack allocator
-class NS_FOUNDATION_DLL nsDoubleBufferedLinearAllocator
+///
+/// If ThreadSafe is false, the allocator never locks, but must only be used by one thread at a time.
+template <bool ThreadSafe = true>
+class nsDoubleBufferedLinearAllocatorBase
 {
 public:
 #if NS_ENABLED(NS_COMPILE_FOR_DEBUG)
@@ -11,10 +14,10 @@ public:
 #else
   static constexpr bool OverwriteMemoryOnReset = false;
 #endif
-  using StackAllocatorType = nsLinearAllocator<nsAllocatorTrackingMode::Basics, OverwriteMemoryOnReset>;
+  using StackAllocatorType = nsLinearAllocator<nsAllocatorTrackingMode::Basics, OverwriteMemoryOnReset, ThreadSafe>;
 
-  nsDoubleBufferedLinearAllocator(nsStringView sName, nsAllocator* pParent);
-  ~nsDoubleBufferedLinearAllocator();
+  nsDoubleBufferedLinearAllocatorBase(nsStringView sName, nsAllocator* pParent);
+  ~nsDoubleBufferedLinearAllocatorBase();
 
   NS_ALWAYS_INLINE nsAllocator* GetCurrentAllocator() const { return m_pCurrentAllocator; }
 
@@ -26,13 +29,37 @@ private:
   StackAllocatorType* m_pOtherAllocator;
 };
 
+using nsDoubleBufferedLinearAllocator = nsDoubleBufferedLinearAllocatorBase<true>;
+
+/// \brief Provides memory for transient data that only has to live until the end of the next frame.
+///
+/// There is one allocator that all threads share, which has to lock for every allocation, and one allocator per thread,
+/// which never locks. The thread allocators are meant for data that worker threads produce in large amounts during a frame,
+/// e.g. command lists, layout scratch data or tessellation results. Other threads may read that data, but only the thread
+/// that allocated it may deallocate it. Usually nothing is deallocated individually at all, everything is released at once.
+///
+/// Swap() marks the frame fence for all of these allocators. Each thread allocator catches up with the frame on its next use,
+/// Swap() itself only swaps the allocators of threads that do not allocate at that moment, so the memory of threads that
+/// went idle is released as well. Threads may keep allocating while Swap() or Reset() run, the memory they get then already
+/// belongs to the new frame. The allocator of a thread that exited is only handed to another thread once its memory has been released. The thread allocators are registered with the nsMemoryTracker below "FrameAllocator.Threads".
 class NS_FOUNDATION_DLL nsFrameAllocator
 {
 public:
   NS_ALWAYS_INLINE static nsAllocator* GetCurrentAllocator() { return s_pAllocator->GetCurrentAllocator(); }
 
-  static void Swap();
-  static void Reset();
+  /// \brief Returns the frame allocator of the calling thread. Allocating from it never waits for other threads,
+  /// except for the moment in which Swap() or Reset() swaps it.
+  ///
+  /// Memory from this allocator must only be deallocated by the same thread.
+  static nsAllocator* GetCurrentThreadAllocator(); // [tested]
+
+  /// \brief Starts a new frame. Memory from the frame before the previous one is released.
+  ///
+  /// Must be called at a point where the work of the previous frame is finished on all threads.
+  static void Swap(); // [tested]
+
+  /// \brief Releases all memory of the shared frame allocator and of all thread allocators.
+  static void Reset(); // [tested]
 
 private:
   NS_MAKE_SUBSYSTEM_STARTUP_FRIEND(Foundation, FrameAllocator);
@@ -42,3 +69,5 @@ private:
 
   static nsDoubleBufferedLinearAllocator* s_pAllocator;
 };
+
+#include <Foundation/Memory/Implementation/FrameAllocator_inl.h>
@@ -1,42 +1,180 @@
 #include <Foundation/FoundationPCH.h>
 
 #include <Foundation/Configuration/Startup.h>
+#include <Foundation/Memory/CommonAllocators.h>
 #include <Foundation/Memory/FrameAllocator.h>
 #include <Foundation/Profiling/Profiling.h>
 #include <Foundation/Strings/StringBuilder.h>
+#include <Foundation/Threading/Lock.h>
 
-nsDoubleBufferedLinearAllocator::nsDoubleBufferedLinearAllocator(nsStringView sName0, nsAllocator* pParent)
+#include <atomic>
+
+namespace
 {
-  nsStringBuilder sName = sName0;
-  sName.Append("0");
+  using ThreadAllocatorType = nsDoubleBufferedLinearAllocatorBase<false>;
 
-  m_pCurrentAllocator = NS_DEFAULT_NEW(StackAllocatorType, sName, pParent);
+  // all thread arenas allocate from this, so they show up together in the memory tracker
+  nsAllocator* s_pThreadArenaParent = nullptr;
 
-  sName = sName0;
-  sName.Append("1");
+  // incremented by nsFrameAllocator::Swap() and Reset(), only modified while s_ArenaMutex is locked
+  std::atomic<nsUInt32> s_uiFrame;
 
-  m_pOtherAllocator = NS_DEFAULT_NEW(StackAllocatorType, sName, pParent);
-}
+  /// The allocator that GetCurrentThreadAllocator() hands out.
+  ///
+  /// The double buffered allocator inside never locks, so whoever uses it holds m_bBusy: the owning thread for every call,
+  /// nsFrameAllocator::Swap() and Reset() only if the owner does not allocate right now. Whoever holds it first catches the
+  /// arena up with the current frame, so a thread that is busy at the frame fence swaps its own arena with its next call.
+  class FrameAllocatorThreadArena : public nsAllocator
+  {
+  public:
+    FrameAllocatorThreadArena(nsStringView sName)
+      : m_Allocator(sName, s_pThreadArenaParent)
+      , m_uiFrame(s_uiFrame.load(std::memory_order_relaxed))
+    {
+    }
 
-nsDoubleBufferedLinearAllocator::~nsDoubleBufferedLinearAllocator()
-{
-  NS_DEFAULT_DELETE(m_pCurrentAllocator);
-  NS_DEFAULT_DELETE(m_pOtherAllocator);
-}
+    virtual void* Allocate(size_t uiSize, size_t uiAlign, nsMemoryUtils::DestructorFunction destructorFunc = nullptr) override
+    {
+      Lock();
+      void* pPtr = m_Allocator.GetCurrentAllocator()->Allocate(uiSize, uiAlign, destructorFunc);
+      Unlock();
+      return pPtr;
+    }
 
-void nsDoubleBufferedLinearAllocator::Swap()
-{
-  nsMath::Swap(m_pCurrentAllocator, m_pOtherAllocator);
+    virtual void Deallocate(void* pPtr) override
+    {
+      Lock();
+      m_Allocator.GetCurrentAllocator()->Deallocate(pPtr);
+      Unlock();
+    }
 
-  m_pCurrentAllocator->Reset();
-}
+    virtual size_t AllocatedSize(const void* pPtr) override
+    {
+      Lock();
+      const size_t uiSize = m_Allocator.GetCurrentAllocator()->AllocatedSize(pPtr);
+      Unlock();
+      return uiSize;
+    }
 
-void nsDoubleBufferedLinearAllocator::Reset()
-{
-  m_pCurrentAllocator->Reset();
-  m_pOtherAllocator->Reset();
-}
+    virtual nsAllocatorId GetId() const override
+    {
+      Lock();
+      const nsAllocatorId id = m_Allocator.GetCurrentAllocator()->GetId();
+      Unlock();
+      return id;
+    }
+
+    virtual Stats GetStats() const override
+    {
+      Lock();
+      const Stats stats = m_Allocator.GetCurrentAllocator()->GetStats();
+      Unlock();
+      return stats;
+    }
+
+    /// \brief Catches up with the current frame, unless the owning thread allocates right now.
+    void TryCatchUp()
+    {
+      if (m_bBusy.exchange(true, std::memory_order_acquire))
+        return;
+
+      CatchUp();
+      Unlock();
+    }
+
+    bool m_bInUse = true;
+
+    // the frame in which the thread of this arena exited
+    nsUInt32 m_uiReleasedInFrame = 0;
+    FrameAllocatorThreadArena* m_pNextArena = nullptr;
+
+  private:
+    void Lock() const
+    {
+      // only Swap() or Reset() can hold it besides the owner, and only for a moment
+      while (m_bBusy.exchange(true, std::memory_order_acquire))
+      {
+        nsThreadUtils::YieldTimeSlice();
+      }
+
+      CatchUp();
+    }
+
+    void Unlock() const { m_bBusy.store(false, std::memory_order_release); }
+
+    void CatchUp() const
+    {
+      const nsUInt32 uiFrame = s_uiFrame.load(std::memory_order_acquire);
+
+      // the memory of the previous frame stays valid, unless more than one frame has passed
+      if (uiFrame - m_uiFrame == 1)
+        m_Allocator.Swap();
+      else if (uiFrame != m_uiFrame)
+        m_Allocator.Reset();
+
+      m_uiFrame = uiFrame;
+    }
+
+    mutable ThreadAllocatorType m_Allocator;
+    mutable nsUInt32 m_uiFrame;
+    mutable std::atomic<bool> m_bBusy = false;
+  };
+
+  // incremented on startup and shutdown, to detect arena pointers that threads still hold from before
+  std::atomic<nsUInt32> s_uiEpoch;
+
+  // all arenas ever created, arenas of threads that exited are reused once their memory has been released
+  nsMutex s_ArenaMutex;
+  FrameAllocatorThreadArena* s_pFirstArena = nullptr;
+  nsUInt32 s_uiNumArenas = 0;
+
+  struct FrameAllocatorThreadData
+  {
+    ~FrameAllocatorThreadData()
+    {
+      if (m_pArena == nullptr)
+        return;
+
+      // keep the arena alive, its memory may still be read by other threads during the next frame
+      NS_LOCK(s_ArenaMutex);
+      if (m_uiEpoch == s_uiEpoch.load(std::memory_order_relaxed))
+      {
+        m_pArena->m_bInUse = false;
+        m_pArena->m_uiReleasedInFrame = s_uiFrame.load(std::memory_order_relaxed);
+      }
+    }
+
+    FrameAllocatorThreadArena* m_pArena = nullptr;
+    nsUInt32 m_uiEpoch = 0;
+  };
+
+  thread_local FrameAllocatorThreadData tl_FrameAllocatorThreadData;
+
+  FrameAllocatorThreadArena* AcquireThreadArena()
+  {
+    NS_LOCK(s_ArenaMutex);
 
+    for (FrameAllocatorThreadArena* pArena = s_pFirstArena; pArena != nullptr; pArena = pArena->m_pNextArena)
+    {
+      // the memory of the frame in which the previous thread exited is only released by the second Swap() after that
+      if (!pArena->m_bInUse && s_uiFrame.load(std::memory_order_relaxed) - pArena->m_uiReleasedInFrame >= 2)
+      {
+        pArena->m_bInUse = true;
+        return pArena;
+      }
+    }
+
+    nsStringBuilder sName;
+    sName.SetFormat("FrameAllocator.Thread{}", s_uiNumArenas);
+    ++s_uiNumArenas;
+
+    FrameAllocatorThreadArena* pArena = NS_DEFAULT_NEW(FrameAllocatorThreadArena, sName);
+    pArena->m_pNextArena = s_pFirstArena;
+    s_pFirstArena = pArena;
+
+    return pArena;
+  }
+} // namespace
 
 // clang-format off
 NS_BEGIN_SUBSYSTEM_DECLARATION(Foundation, FrameAllocator)
@@ -56,12 +194,35 @@ NS_END_SUBSYSTEM_DECLARATION;
 
 nsDoubleBufferedLinearAllocator* nsFrameAllocator::s_pAllocator;
 
+// static
+nsAllocator* nsFrameAllocator::GetCurrentThreadAllocator()
+{
+  FrameAllocatorThreadData& data = tl_FrameAllocatorThreadData;
+
+  if (data.m_pArena == nullptr || data.m_uiEpoch != s_uiEpoch.load(std::memory_order_relaxed))
+  {
+    data.m_pArena = AcquireThreadArena();
+    data.m_uiEpoch = s_uiEpoch.load(std::memory_order_relaxed);
+  }
+
+  return data.m_pArena;
+}
+
 // static
 void nsFrameAllocator::Swap()
 {
   NS_PROFILE_SCOPE("FrameAllocator.Swap");
 
   s_pAllocator->Swap();
+
+  NS_LOCK(s_ArenaMutex);
+  s_uiFrame.fetch_add(1, std::memory_order_release);
+
+  // releases the memory of idle and exited threads, busy threads swap their arena themselves with their next allocation
+  for (FrameAllocatorThreadArena* pArena = s_pFirstArena; pArena != nullptr; pArena = pArena->m_pNextArena)
+  {
+    pArena->TryCatchUp();
+  }
 }
 
 // static
@@ -71,18 +232,48 @@ void nsFrameAllocator::Reset()
   {
     s_pAllocator->Reset();
   }
+
+  NS_LOCK(s_ArenaMutex);
+
+  // all memory is gone, the arenas of exited threads can be reused right away
+  s_uiFrame.fetch_add(2, std::memory_order_release);
+
+  // busy threads reset their arena themselves with their next allocation
+  for (FrameAllocatorThreadArena* pArena = s_pFirstArena; pArena != nullptr; pArena = pArena->m_pNextArena)
+  {
+    pArena->TryCatchUp();
+  }
 }
 
 // static
 void nsFrameAllocator::Startup()
 {
   s_pAllocator = NS_DEFAULT_NEW(nsDoubleBufferedLinearAllocator, "FrameAllocator", nsFoundation::GetAlignedAllocator());
+
+  NS_LOCK(s_ArenaMutex);
+  s_pThreadArenaParent = NS_DEFAULT_NEW(nsAlignedHeapAllocator, "FrameAllocator.Threads", nsFoundation::GetAlignedAllocator());
+  s_uiEpoch.fetch_add(1, std::memory_order_relaxed);
 }
 
 // static
 void nsFrameAllocator::Shutdown()
 {
   NS_DEFAULT_DELETE(s_pAllocator);
+
+  NS_LOCK(s_ArenaMutex);
+  s_uiEpoch.fetch_add(1, std::memory_order_relaxed);
+
+  while (s_pFirstArena != nullptr)
+  {
+    FrameAllocatorThreadArena* pArena = s_pFirstArena;
+    s_pFirstArena = pArena->m_pNextArena;
+
+    NS_DEFAULT_DELETE(pArena);
+  }
+
+  s_uiNumArenas = 0;
+
+  NS_DEFAULT_DELETE(s_pThreadArenaParent);
 }
 
 NS_STATICLINK_FILE(Foundation, Foundation_Memory_Implementation_FrameAllocator);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Foundation/Strings/StringBuilder.h>
+
+template <bool ThreadSafe>
+nsDoubleBufferedLinearAllocatorBase<ThreadSafe>::nsDoubleBufferedLinearAllocatorBase(nsStringView sName0, nsAllocator* pParent)
+{
+  nsStringBuilder sName = sName0;
+  sName.Append("0");
+
+  m_pCurrentAllocator = NS_DEFAULT_NEW(StackAllocatorType, sName, pParent);
+
+  sName = sName0;
+  sName.Append("1");
+
+  m_pOtherAllocator = NS_DEFAULT_NEW(StackAllocatorType, sName, pParent);
+}
+
+template <bool ThreadSafe>
+nsDoubleBufferedLinearAllocatorBase<ThreadSafe>::~nsDoubleBufferedLinearAllocatorBase()
+{
+  NS_DEFAULT_DELETE(m_pCurrentAllocator);
+  NS_DEFAULT_DELETE(m_pOtherAllocator);
+}
+
+template <bool ThreadSafe>
+void nsDoubleBufferedLinearAllocatorBase<ThreadSafe>::Swap()
+{
+  nsMath::Swap(m_pCurrentAllocator, m_pOtherAllocator);
+
+  m_pCurrentAllocator->Reset();
+}
+
+template <bool ThreadSafe>
+void nsDoubleBufferedLinearAllocatorBase<ThreadSafe>::Reset()
+{
+  m_pCurrentAllocator->Reset();
+  m_pOtherAllocator->Reset();
+}
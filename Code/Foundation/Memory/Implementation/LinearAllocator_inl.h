@@ -1,23 +1,23 @@
-template <nsAllocatorTrackingMode TrackingMode, bool OverwriteMemoryOnReset>
-nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset>::nsLinearAllocator(nsStringView sName, nsAllocator* pParent)
-  : nsAllocatorWithPolicy<typename nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset>::PolicyStack, TrackingMode>(sName, pParent)
+template <nsAllocatorTrackingMode TrackingMode, bool OverwriteMemoryOnReset, bool ThreadSafe>
+nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset, ThreadSafe>::nsLinearAllocator(nsStringView sName, nsAllocator* pParent)
+  : nsAllocatorWithPolicy<typename nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset, ThreadSafe>::PolicyStack, TrackingMode>(sName, pParent)
   , m_DestructData(pParent)
   , m_PtrToDestructDataIndexTable(pParent)
 {
 }
 
-template <nsAllocatorTrackingMode TrackingMode, bool OverwriteMemoryOnReset>
-nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset>::~nsLinearAllocator()
+template <nsAllocatorTrackingMode TrackingMode, bool OverwriteMemoryOnReset, bool ThreadSafe>
+nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset, ThreadSafe>::~nsLinearAllocator()
 {
   Reset();
 }
 
-template <nsAllocatorTrackingMode TrackingMode, bool OverwriteMemoryOnReset>
-void* nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset>::Allocate(size_t uiSize, size_t uiAlign, nsMemoryUtils::DestructorFunction destructorFunc)
+template <nsAllocatorTrackingMode TrackingMode, bool OverwriteMemoryOnReset, bool ThreadSafe>
+void* nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset, ThreadSafe>::Allocate(size_t uiSize, size_t uiAlign, nsMemoryUtils::DestructorFunction destructorFunc)
 {
-  NS_LOCK(m_Mutex);
+  nsConditionalLock<nsMutex> lock(m_Mutex, ThreadSafe);
 
-  void* ptr = nsAllocatorWithPolicy<typename nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset>::PolicyStack, TrackingMode>::Allocate(uiSize, uiAlign, destructorFunc);
+  void* ptr = nsAllocatorWithPolicy<typename nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset, ThreadSafe>::PolicyStack, TrackingMode>::Allocate(uiSize, uiAlign, destructorFunc);
 
   if (destructorFunc != nullptr)
   {
@@ -32,10 +32,10 @@ void* nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset>::Allocate(size_t u
   return ptr;
 }
 
-template <nsAllocatorTrackingMode TrackingMode, bool OverwriteMemoryOnReset>
-void nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset>::Deallocate(void* pPtr)
+template <nsAllocatorTrackingMode TrackingMode, bool OverwriteMemoryOnReset, bool ThreadSafe>
+void nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset, ThreadSafe>::Deallocate(void* pPtr)
 {
-  NS_LOCK(m_Mutex);
+  nsConditionalLock<nsMutex> lock(m_Mutex, ThreadSafe);
 
   nsUInt32 uiIndex;
   if (m_PtrToDestructDataIndexTable.Remove(pPtr, &uiIndex))
@@ -45,7 +45,7 @@ void nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset>::Deallocate(void* p
     data.m_Ptr = nullptr;
   }
 
-  nsAllocatorWithPolicy<typename nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset>::PolicyStack, TrackingMode>::Deallocate(pPtr);
+  nsAllocatorWithPolicy<typename nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset, ThreadSafe>::PolicyStack, TrackingMode>::Deallocate(pPtr);
 }
 
 NS_MSVC_ANALYSIS_WARNING_PUSH
@@ -54,10 +54,10 @@ NS_MSVC_ANALYSIS_WARNING_PUSH
 // even with the added guard of a check that it can't be 0.
 NS_MSVC_ANALYSIS_WARNING_DISABLE(6313)
 
-template <nsAllocatorTrackingMode TrackingMode, bool OverwriteMemoryOnReset>
-void nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset>::Reset()
+template <nsAllocatorTrackingMode TrackingMode, bool OverwriteMemoryOnReset, bool ThreadSafe>
+void nsLinearAllocator<TrackingMode, OverwriteMemoryOnReset, ThreadSafe>::Reset()
 {
-  NS_LOCK(m_Mutex);
+  nsConditionalLock<nsMutex> lock(m_Mutex, ThreadSafe);
 
   for (nsUInt32 i = m_DestructData.GetCount(); i-- > 0;)
   {
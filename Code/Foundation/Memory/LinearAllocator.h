@@ -4,10 +4,15 @@
 #include <Foundation/Containers/HashTable.h>
 #include <Foundation/Memory/AllocatorWithPolicy.h>
 #include <Foundation/Memory/Policies/AllocPolicyLinear.h>
+#include <Foundation/Threading/ConditionalLock.h>
 #include <Foundation/Threading/Lock.h>
 #include <Foundation/Threading/Mutex.h>
 
-template <nsAllocatorTrackingMode TrackingMode = nsAllocatorTrackingMode::Default, bool OverwriteMemoryOnReset = false>
+/// \brief An allocator that only grows and frees all of its memory at once, in Reset().
+///
+/// If ThreadSafe is false, the allocator never locks, but then it must only be used by one thread at a time. That includes
+/// deallocations.
+template <nsAllocatorTrackingMode TrackingMode = nsAllocatorTrackingMode::Default, bool OverwriteMemoryOnReset = false, bool ThreadSafe = true>
 class nsLinearAllocator : public nsAllocatorWithPolicy<nsAllocPolicyLinear<OverwriteMemoryOnReset>, TrackingMode>
 {
   using PolicyStack = nsAllocPolicyLinear<OverwriteMemoryOnReset>;
@@ -149,13 +149,15 @@ private:
   /// \brief Removes profiling data of dead threads.
   static void Reset();
 
+public:
   /// \brief Sets the name of the current thread.
+  ///
+  /// nsThread does this by itself, threads that are not nsThreads (e.g. std::thread) have to call this and RemoveThread() themselves.
   static void SetThreadName(nsStringView sThreadName);
   /// \brief Removes the current thread from the profiling system.
   ///  Needs to be called before the thread exits to be able to release profiling memory of dead threads on Reset.
   static void RemoveThread();
 
-public:
   /// \brief Initialized internal data structures for GPU profiling data. Needs to be called before adding any data.
   static void InitializeGPUData(nsUInt32 uiGpuCount = 1);
 
@@ -39,6 +39,107 @@ private:
   Callback m_TaskCallback;
 };
 
+/// \brief State that all tasks of one adaptive ParallelForIndexed() invocation share. Lives on the stack of the calling thread.
+template <typename IndexType, typename Callback>
+struct AdaptiveIndexedState
+{
+  const Callback* m_pTaskCallback = nullptr;
+  nsParallelForAdaptiveGrainSize* m_pGrainSize = nullptr;
+  nsInt64 m_iTargetChunkPicoseconds = 0;
+  IndexType m_uiInitialGrainSize = 1;
+  const char* m_szTaskName = nullptr;
+  nsTaskNesting m_TaskNesting = nsTaskNesting::Never;
+  nsAllocator* m_pAllocator = nullptr;
+
+  /// The number of ranges that are not yet finished. The calling thread waits for this to drop to zero.
+  nsAtomicInteger32 m_iOpenRanges;
+};
+
+/// \brief Works through an index range in chunks whose size is derived from the measured cost per item.
+///
+/// Uses lazy binary splitting: the upper half of the remaining range is only handed out as a new task, once all tasks that the
+/// executing thread handed out before were picked up by other threads. Thus idle threads always find something to steal,
+/// while busy threads do not pay for tasks that no one needs.
+template <typename IndexType, typename Callback>
+class AdaptiveIndexedTask final : public nsTask
+{
+public:
+  using State = AdaptiveIndexedState<IndexType, Callback>;
+
+  AdaptiveIndexedTask(State* pState, IndexType uiStartIndex, IndexType uiEndIndex)
+    : m_pState(pState)
+    , m_uiStartIndex(uiStartIndex)
+    , m_uiEndIndex(uiEndIndex)
+  {
+  }
+
+  void Execute() override
+  {
+    ProcessRange(*m_pState, m_uiStartIndex, m_uiEndIndex);
+
+    // the calling thread may return as soon as this drops to zero, the state must not be accessed afterwards
+    m_pState->m_iOpenRanges.Decrement();
+  }
+
+  static void ProcessRange(State& ref_state, IndexType uiStartIndex, IndexType uiEndIndex)
+  {
+    while (uiStartIndex < uiEndIndex)
+    {
+      const IndexType uiGrainSize = GetGrainSize(ref_state);
+
+      if (uiEndIndex - uiStartIndex >= 2 * uiGrainSize && nsTaskSystem::AreThreadQueuesEmpty(nsTaskPriority::EarlyThisFrame))
+      {
+        const IndexType uiMiddleIndex = uiStartIndex + (uiEndIndex - uiStartIndex) / 2;
+        SplitOff(ref_state, uiMiddleIndex, uiEndIndex);
+        uiEndIndex = uiMiddleIndex;
+      }
+
+      const IndexType uiChunkEndIndex = uiStartIndex + nsMath::Min<IndexType>(uiGrainSize, uiEndIndex - uiStartIndex);
+
+      const nsTime startTime = nsTime::Now();
+      (*ref_state.m_pTaskCallback)(uiStartIndex, uiChunkEndIndex);
+      RecordChunk(ref_state, uiChunkEndIndex - uiStartIndex, nsTime::Now() - startTime);
+
+      uiStartIndex = uiChunkEndIndex;
+    }
+  }
+
+private:
+  static IndexType GetGrainSize(const State& state)
+  {
+    const nsInt64 iPicosecondsPerItem = state.m_pGrainSize->m_iPicosecondsPerItem;
+
+    if (iPicosecondsPerItem <= 0)
+      return state.m_uiInitialGrainSize;
+
+    // the upper limit keeps '2 * grain size' from overflowing
+    return static_cast<IndexType>(nsMath::Clamp<nsInt64>(state.m_iTargetChunkPicoseconds / iPicosecondsPerItem, 1, 0x40000000));
+  }
+
+  static void RecordChunk(State& ref_state, IndexType uiNumItems, nsTime duration)
+  {
+    const nsInt64 iSample = nsMath::Max<nsInt64>(1, static_cast<nsInt64>(duration.GetNanoseconds() * 1000.0) / static_cast<nsInt64>(uiNumItems));
+    const nsInt64 iPrevious = ref_state.m_pGrainSize->m_iPicosecondsPerItem;
+
+    // concurrent updates may lose a sample, which does not matter for an average
+    ref_state.m_pGrainSize->m_iPicosecondsPerItem.Set(iPrevious <= 0 ? iSample : iPrevious + (iSample - iPrevious) / 4);
+  }
+
+  static void SplitOff(State& ref_state, IndexType uiStartIndex, IndexType uiEndIndex)
+  {
+    ref_state.m_iOpenRanges.Increment();
+
+    nsSharedPtr<AdaptiveIndexedTask> pTask = NS_NEW(ref_state.m_pAllocator, AdaptiveIndexedTask, &ref_state, uiStartIndex, uiEndIndex);
+    pTask->ConfigureTask(ref_state.m_szTaskName, ref_state.m_TaskNesting);
+
+    nsTaskSystem::StartSingleTask(pTask, nsTaskPriority::EarlyThisFrame);
+  }
+
+  State* m_pState;
+  IndexType m_uiStartIndex;
+  IndexType m_uiEndIndex;
+};
+
 template <typename IndexType, typename Callback>
 void ParallelForIndexedInternal(IndexType uiStartIndex, IndexType uiNumItems, const Callback&& taskCallback, const char* szTaskName, const nsParallelForParams& params, nsTaskNesting taskNesting)
 {
@@ -59,6 +160,29 @@ void ParallelForIndexedInternal(IndexType uiStartIndex, IndexType uiNumItems, co
     NS_PROFILE_SCOPE(szTaskName);
     indexedTask.Execute();
   }
+  else if (params.m_pAdaptiveGrainSize != nullptr)
+  {
+    AdaptiveIndexedState<IndexType, Callback> state;
+    state.m_pTaskCallback = &taskCallback;
+    state.m_pGrainSize = params.m_pAdaptiveGrainSize;
+    state.m_iTargetChunkPicoseconds = nsMath::Max<nsInt64>(1, static_cast<nsInt64>(params.m_AdaptiveChunkDuration.GetNanoseconds() * 1000.0));
+    state.m_uiInitialGrainSize = static_cast<IndexType>(nsMath::Max(1u, params.m_uiBinSize));
+    state.m_szTaskName = szTaskName;
+    state.m_TaskNesting = taskNesting;
+    state.m_pAllocator = (params.m_pTaskAllocator != nullptr) ? params.m_pTaskAllocator : nsFoundation::GetDefaultAllocator();
+    state.m_iOpenRanges = 1;
+
+    {
+      // the calling thread works on the whole range, until other threads take parts of it
+      NS_PROFILE_SCOPE(szTaskName);
+      AdaptiveIndexedTask<IndexType, Callback>::ProcessRange(state, uiStartIndex, uiStartIndex + uiNumItems);
+    }
+
+    state.m_iOpenRanges.Decrement();
+
+    nsTaskSystem::WaitForCondition([&state]()
+      { return state.m_iOpenRanges == 0; });
+  }
   else
   {
     nsUInt32 uiMultiplicity;
@@ -31,12 +31,9 @@ void nsTask::SetMultiplicity(nsUInt32 uiMultiplicity)
 
 void nsTask::Run(nsUInt32 uiInvocation)
 {
-  // actually this should not be possible to happen
-  if (m_iRemainingRuns == 0 || m_bCancelExecution)
-  {
-    m_iRemainingRuns = 0;
+  // canceled after the run was picked up, it still counts as finished, see nsTaskSystem::TaskHasFinished()
+  if (m_bCancelExecution)
     return;
-  }
 
   {
     nsStringBuilder scopeName = m_sTaskName;
@@ -55,6 +52,4 @@ void nsTask::Run(nsUInt32 uiInvocation)
       Execute();
     }
   }
-
-  m_iRemainingRuns.Decrement();
 }
@@ -85,9 +85,19 @@ private:
   /// \brief Called by nsTaskSystem to execute the task. Calls 'Execute' internally.
   void Run(nsUInt32 uiInvocation);
 
-  /// \brief Decremented when a task is finished, set to zero when canceled.
+  /// \brief Decremented when a run is finished or canceled.
   nsAtomicInteger32 m_iRemainingRuns;
 
+  /// \brief The counter of the current scheduling (upper 32 bits) and how many of its runs have not been picked up yet (lower 32 bits).
+  nsAtomicInteger64 m_iRunState;
+
+  /// \brief How many queue entries of canceled runs the task system still has to skip. See nsTaskSystem::CancelTask().
+  nsAtomicInteger32 m_iCanceledQueueEntries;
+
+  /// \brief The number of runs of the current scheduling and the index of this task in its group.
+  nsUInt32 m_uiScheduledRuns = 0;
+  nsUInt32 m_uiIndexInGroup = 0;
+
   /// \brief Set to true when the task is SUPPOSED to cancel. Whether the task is able to do that, depends on its implementation.
   bool m_bCancelExecution = false;
 
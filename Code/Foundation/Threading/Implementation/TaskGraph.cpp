@@ -0,0 +1,381 @@
+#include <Foundation/FoundationPCH.h>
+
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Profiling/Profiling.h>
+#include <Foundation/Threading/Lock.h>
+#include <Foundation/Threading/TaskGraph.h>
+#include <Foundation/Utilities/DGMLWriter.h>
+
+nsTaskGraph* nsTaskGraph::s_pFirstGraph = nullptr;
+
+nsTaskGraph::nsTaskGraph(nsStringView sName)
+  : m_sName(sName)
+{
+}
+
+nsTaskGraph::~nsTaskGraph()
+{
+  // the nodes reference the graph
+  WaitForFinish();
+
+  if (!m_bRegistered)
+    return;
+
+  NS_LOCK(nsTaskSystem::s_TaskSystemMutex);
+
+  if (m_pPrevGraph != nullptr)
+  {
+    m_pPrevGraph->m_pNextGraph = m_pNextGraph;
+  }
+  else
+  {
+    s_pFirstGraph = m_pNextGraph;
+  }
+
+  if (m_pNextGraph != nullptr)
+  {
+    m_pNextGraph->m_pPrevGraph = m_pPrevGraph;
+  }
+}
+
+nsUInt32 nsTaskGraph::AddNode(nsStringView sName, nsLightTaskFunction function)
+{
+  NS_ASSERT_DEV(IsFinished(), "Task graph '{}' cannot be modified while it is running.", m_sName);
+  NS_ASSERT_DEV(function.IsValid(), "Task graph nodes need a function to execute.");
+
+  Register();
+
+  NS_LOCK(m_Mutex);
+
+  m_bFinalized = false;
+
+  Node& node = m_Nodes.ExpandAndGetRef();
+  node.m_sName = sName;
+  node.m_Function = std::move(function);
+
+  return m_Nodes.GetCount() - 1;
+}
+
+void nsTaskGraph::AddDependency(nsUInt32 uiNode, nsUInt32 uiDependsOnNode)
+{
+  NS_ASSERT_DEV(IsFinished(), "Task graph '{}' cannot be modified while it is running.", m_sName);
+  NS_ASSERT_DEV(uiNode < m_Nodes.GetCount() && uiDependsOnNode < m_Nodes.GetCount(), "Invalid task graph node index.");
+
+  NS_LOCK(m_Mutex);
+
+  for (const Dependency& dep : m_Dependencies)
+  {
+    if (dep.m_uiNode == uiNode && dep.m_uiDependsOnNode == uiDependsOnNode)
+      return;
+  }
+
+  m_bFinalized = false;
+
+  Dependency& dep = m_Dependencies.ExpandAndGetRef();
+  dep.m_uiNode = uiNode;
+  dep.m_uiDependsOnNode = uiDependsOnNode;
+}
+
+nsResult nsTaskGraph::Finalize()
+{
+  NS_ASSERT_DEV(IsFinished(), "Task graph '{}' cannot be modified while it is running.", m_sName);
+
+  NS_LOCK(m_Mutex);
+
+  m_bFinalized = false;
+
+  // store the successors of every node as one contiguous range
+  for (Node& node : m_Nodes)
+  {
+    node.m_uiNumSuccessors = 0;
+    node.m_uiNumDependencies = 0;
+  }
+
+  for (const Dependency& dep : m_Dependencies)
+  {
+    ++m_Nodes[dep.m_uiDependsOnNode].m_uiNumSuccessors;
+    ++m_Nodes[dep.m_uiNode].m_uiNumDependencies;
+  }
+
+  nsUInt32 uiNextSuccessor = 0;
+  for (Node& node : m_Nodes)
+  {
+    node.m_uiFirstSuccessor = uiNextSuccessor;
+    uiNextSuccessor += node.m_uiNumSuccessors;
+    node.m_uiNumSuccessors = 0;
+  }
+
+  m_Successors.SetCountUninitialized(m_Dependencies.GetCount());
+  for (const Dependency& dep : m_Dependencies)
+  {
+    Node& node = m_Nodes[dep.m_uiDependsOnNode];
+    m_Successors[node.m_uiFirstSuccessor + node.m_uiNumSuccessors] = dep.m_uiNode;
+    ++node.m_uiNumSuccessors;
+  }
+
+  // sort the nodes topologically, nodes that are left over are part of a cycle
+  nsDynamicArray<nsUInt32> pendingDependencies;
+  pendingDependencies.SetCountUninitialized(m_Nodes.GetCount());
+
+  m_TopologicalOrder.Clear();
+  m_TopologicalOrder.Reserve(m_Nodes.GetCount());
+
+  for (nsUInt32 i = 0; i < m_Nodes.GetCount(); ++i)
+  {
+    pendingDependencies[i] = m_Nodes[i].m_uiNumDependencies;
+
+    if (pendingDependencies[i] == 0)
+    {
+      m_TopologicalOrder.PushBack(i);
+    }
+  }
+
+  for (nsUInt32 i = 0; i < m_TopologicalOrder.GetCount(); ++i)
+  {
+    const Node& node = m_Nodes[m_TopologicalOrder[i]];
+
+    for (nsUInt32 s = 0; s < node.m_uiNumSuccessors; ++s)
+    {
+      const nsUInt32 uiSuccessor = m_Successors[node.m_uiFirstSuccessor + s];
+
+      if (--pendingDependencies[uiSuccessor] == 0)
+      {
+        m_TopologicalOrder.PushBack(uiSuccessor);
+      }
+    }
+  }
+
+  if (m_TopologicalOrder.GetCount() != m_Nodes.GetCount())
+  {
+    for (nsUInt32 i = 0; i < m_Nodes.GetCount(); ++i)
+    {
+      if (pendingDependencies[i] != 0)
+      {
+        nsLog::Error("Task graph '{}': node '{}' is part of a dependency cycle.", m_sName, m_Nodes[i].m_sName);
+        break;
+      }
+    }
+
+    return NS_FAILURE;
+  }
+
+  m_bFinalized = true;
+  return NS_SUCCESS;
+}
+
+void nsTaskGraph::Clear()
+{
+  NS_ASSERT_DEV(IsFinished(), "Task graph '{}' cannot be modified while it is running.", m_sName);
+
+  NS_LOCK(m_Mutex);
+
+  m_Nodes.Clear();
+  m_Dependencies.Clear();
+  m_Successors.Clear();
+  m_TopologicalOrder.Clear();
+  m_bFinalized = false;
+}
+
+void nsTaskGraph::Launch(nsTaskPriority::Enum priority)
+{
+  NS_ASSERT_DEV(m_bFinalized, "Task graph '{}' has to be finalized successfully before it can be launched.", m_sName);
+
+  WaitForFinish();
+
+  if (m_Nodes.IsEmpty())
+    return;
+
+  m_Priority = priority;
+
+  // everything has to be reset, before the first node may finish
+  for (Node& node : m_Nodes)
+  {
+    node.m_iPendingDependencies = node.m_uiNumDependencies;
+  }
+
+  m_iRemainingNodes = m_Nodes.GetCount();
+
+  for (nsUInt32 i = 0; i < m_Nodes.GetCount(); ++i)
+  {
+    if (m_Nodes[i].m_uiNumDependencies == 0)
+    {
+      StartNode(i);
+    }
+  }
+}
+
+void nsTaskGraph::WaitForFinish() const
+{
+  if (IsFinished())
+    return;
+
+  nsTaskSystem::WaitForCondition([this]()
+    { return IsFinished(); });
+}
+
+nsTime nsTaskGraph::GetCriticalPath(nsDynamicArray<nsUInt32>& out_nodes) const
+{
+  NS_ASSERT_DEV(IsFinished(), "Task graph '{}' is still running.", m_sName);
+
+  out_nodes.Clear();
+
+  if (!m_bFinalized || m_Nodes.IsEmpty())
+    return nsTime::MakeZero();
+
+  // the earliest time at which each node could have started, given the durations of its dependencies
+  nsDynamicArray<nsTime> startTimes;
+  startTimes.SetCount(m_Nodes.GetCount(), nsTime::MakeZero());
+
+  nsDynamicArray<nsUInt32> previousNodes;
+  previousNodes.SetCount(m_Nodes.GetCount(), nsInvalidIndex);
+
+  nsUInt32 uiLastNode = m_TopologicalOrder[0];
+  nsTime endTime = nsTime::MakeZero();
+
+  for (nsUInt32 uiNode : m_TopologicalOrder)
+  {
+    const Node& node = m_Nodes[uiNode];
+    const nsTime nodeEndTime = startTimes[uiNode] + node.m_Duration;
+
+    if (nodeEndTime > endTime)
+    {
+      endTime = nodeEndTime;
+      uiLastNode = uiNode;
+    }
+
+    for (nsUInt32 s = 0; s < node.m_uiNumSuccessors; ++s)
+    {
+      const nsUInt32 uiSuccessor = m_Successors[node.m_uiFirstSuccessor + s];
+
+      if (nodeEndTime > startTimes[uiSuccessor] || previousNodes[uiSuccessor] == nsInvalidIndex)
+      {
+        startTimes[uiSuccessor] = nodeEndTime;
+        previousNodes[uiSuccessor] = uiNode;
+      }
+    }
+  }
+
+  for (nsUInt32 uiNode = uiLastNode; uiNode != nsInvalidIndex; uiNode = previousNodes[uiNode])
+  {
+    out_nodes.PushBack(uiNode);
+  }
+
+  // collected from the end
+  for (nsUInt32 i = 0; i < out_nodes.GetCount() / 2; ++i)
+  {
+    nsMath::Swap(out_nodes[i], out_nodes[out_nodes.GetCount() - 1 - i]);
+  }
+
+  return endTime;
+}
+
+void nsTaskGraph::WriteToDGML(nsDGMLGraph& ref_graph) const
+{
+  const nsDGMLGraph::PropertyId durationId = ref_graph.AddPropertyType("Duration");
+  const nsDGMLGraph::PropertyId criticalPathId = ref_graph.AddPropertyType("CriticalPath");
+
+  WriteToDGML(ref_graph, durationId, criticalPathId);
+}
+
+void nsTaskGraph::WriteToDGML(nsDGMLGraph& ref_graph, nsUInt32 uiDurationPropertyId, nsUInt32 uiCriticalPathPropertyId) const
+{
+  // the owner may be recording the graph on another thread
+  NS_LOCK(m_Mutex);
+
+  // a running graph has no consistent durations
+  nsDynamicArray<nsUInt32> criticalPath;
+  nsTime criticalPathDuration;
+  if (IsFinished())
+  {
+    criticalPathDuration = GetCriticalPath(criticalPath);
+  }
+
+  nsDGMLGraph::NodeDesc graphND;
+  graphND.m_Color = nsColor::MediumSeaGreen;
+  graphND.m_Shape = nsDGMLGraph::NodeShape::Rectangle;
+
+  nsDGMLGraph::NodeDesc nodeND;
+  nodeND.m_Color = nsColor::LightSteelBlue;
+  nodeND.m_Shape = nsDGMLGraph::NodeShape::RoundedRectangle;
+
+  nsDGMLGraph::NodeDesc criticalNodeND = nodeND;
+  criticalNodeND.m_Color = nsColor::OrangeRed;
+
+  nsStringBuilder title;
+  title.SetFormat("{} (critical path {})", m_sName, criticalPathDuration);
+
+  const nsDGMLGraph::NodeId graphId = ref_graph.AddGroup(title, nsDGMLGraph::GroupType::Expanded, &graphND);
+
+  nsDynamicArray<bool> onCriticalPath;
+  onCriticalPath.SetCount(m_Nodes.GetCount(), false);
+  for (nsUInt32 uiNode : criticalPath)
+  {
+    onCriticalPath[uiNode] = true;
+  }
+
+  nsDynamicArray<nsDGMLGraph::NodeId> nodeIds;
+  nodeIds.SetCountUninitialized(m_Nodes.GetCount());
+
+  for (nsUInt32 i = 0; i < m_Nodes.GetCount(); ++i)
+  {
+    nodeIds[i] = ref_graph.AddNode(m_Nodes[i].m_sName, onCriticalPath[i] ? &criticalNodeND : &nodeND);
+    ref_graph.AddNodeToGroup(nodeIds[i], graphId);
+
+    ref_graph.AddNodeProperty(nodeIds[i], uiDurationPropertyId, nsFmt("{}", m_Nodes[i].m_Duration));
+    ref_graph.AddNodeProperty(nodeIds[i], uiCriticalPathPropertyId, onCriticalPath[i] ? "true" : "false");
+  }
+
+  for (const Dependency& dep : m_Dependencies)
+  {
+    ref_graph.AddConnection(nodeIds[dep.m_uiDependsOnNode], nodeIds[dep.m_uiNode]);
+  }
+}
+
+void nsTaskGraph::Register()
+{
+  if (m_bRegistered)
+    return;
+
+  NS_LOCK(nsTaskSystem::s_TaskSystemMutex);
+
+  m_pNextGraph = s_pFirstGraph;
+  if (s_pFirstGraph != nullptr)
+  {
+    s_pFirstGraph->m_pPrevGraph = this;
+  }
+  s_pFirstGraph = this;
+
+  m_bRegistered = true;
+}
+
+void nsTaskGraph::StartNode(nsUInt32 uiNode)
+{
+  nsTaskSystem::StartLightTask([this, uiNode]()
+    { RunNode(uiNode); },
+    m_Priority);
+}
+
+void nsTaskGraph::RunNode(nsUInt32 uiNode)
+{
+  Node& node = m_Nodes[uiNode];
+
+  const nsTime startTime = nsTime::Now();
+  {
+    NS_PROFILE_SCOPE(node.m_sName);
+    node.m_Function();
+  }
+  node.m_Duration = nsTime::Now() - startTime;
+
+  for (nsUInt32 s = 0; s < node.m_uiNumSuccessors; ++s)
+  {
+    const nsUInt32 uiSuccessor = m_Successors[node.m_uiFirstSuccessor + s];
+
+    if (m_Nodes[uiSuccessor].m_iPendingDependencies.Decrement() == 0)
+    {
+      StartNode(uiSuccessor);
+    }
+  }
+
+  // the graph may be launched again or destroyed as soon as this reaches zero
+  m_iRemainingNodes.Decrement();
+}
@@ -33,10 +33,8 @@ void nsTaskGroup::Reuse(nsTaskPriority::Enum priority, nsOnTaskGroupFinishedCall
 }
 
 #if NS_ENABLED(NS_COMPILE_FOR_DEBUG)
-void nsTaskGroup::DebugCheckTaskGroup(nsTaskGroupID groupID, nsMutex& mutex)
+void nsTaskGroup::DebugCheckTaskGroup(nsTaskGroupID groupID)
 {
-  NS_LOCK(mutex);
-
   const nsTaskGroup* pGroup = groupID.m_pTaskGroup;
   NS_IGNORE_UNUSED(pGroup);
 
@@ -19,12 +19,11 @@ private:
   friend class nsTaskSystem;
 
 #if NS_ENABLED(NS_COMPILE_FOR_DEBUG)
-  static void DebugCheckTaskGroup(nsTaskGroupID groupID, nsMutex& mutex);
+  static void DebugCheckTaskGroup(nsTaskGroupID groupID);
 #else
-  NS_ALWAYS_INLINE static void DebugCheckTaskGroup(nsTaskGroupID groupID, nsMutex& mutex)
+  NS_ALWAYS_INLINE static void DebugCheckTaskGroup(nsTaskGroupID groupID)
   {
     NS_IGNORE_UNUSED(groupID);
-    NS_IGNORE_UNUSED(mutex);
   }
 #endif
 
@@ -34,7 +33,8 @@ private:
 
   bool m_bInUse = true;
   bool m_bStartedByUser = false;
-  nsUInt16 m_uiTaskGroupIndex = 0xFFFF; // only there as a debugging aid
+  nsUInt16 m_uiTaskGroupIndex = 0xFFFF;
+  nsAtomicInteger32 m_iNextFreeGroup; // index + 1 of the next unused group, see nsTaskSystemState::m_iFreeTaskGroups
   nsUInt32 m_uiGroupCounter = 1;
   nsHybridArray<nsSharedPtr<nsTask>, 16> m_Tasks;
   nsHybridArray<nsTaskGroupID, 4> m_DependsOnGroups;
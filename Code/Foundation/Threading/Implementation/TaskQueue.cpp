@@ -0,0 +1,137 @@
+#include <Foundation/FoundationPCH.h>
+
+#include <Foundation/Threading/Implementation/TaskQueue.h>
+
+nsTaskDeque::nsTaskDeque()
+{
+  m_iTop.store(0, std::memory_order_relaxed);
+  m_iBottom.store(0, std::memory_order_relaxed);
+  m_pRing.store(CreateRing(32), std::memory_order_relaxed);
+}
+
+nsTaskDeque::~nsTaskDeque()
+{
+  DestroyRing(m_pRing.load(std::memory_order_relaxed));
+
+  for (Ring* pRing : m_RetiredRings)
+  {
+    DestroyRing(pRing);
+  }
+}
+
+void nsTaskDeque::Push(const nsTaskQueueEntry& entry)
+{
+  const nsInt64 iBottom = m_iBottom.load(std::memory_order_relaxed);
+  const nsInt64 iTop = m_iTop.load(std::memory_order_acquire);
+  Ring* pRing = m_pRing.load(std::memory_order_relaxed);
+
+  if (iBottom - iTop > pRing->m_iMask)
+  {
+    pRing = Grow(pRing, iTop, iBottom);
+  }
+
+  pRing->Store(iBottom, entry);
+  std::atomic_thread_fence(std::memory_order_release);
+  m_iBottom.store(iBottom + 1, std::memory_order_relaxed);
+}
+
+bool nsTaskDeque::Pop(nsTaskQueueEntry& out_entry)
+{
+  const nsInt64 iBottom = m_iBottom.load(std::memory_order_relaxed) - 1;
+  Ring* pRing = m_pRing.load(std::memory_order_relaxed);
+  m_iBottom.store(iBottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  nsInt64 iTop = m_iTop.load(std::memory_order_relaxed);
+
+  if (iTop > iBottom)
+  {
+    // empty, restore the bottom
+    m_iBottom.store(iBottom + 1, std::memory_order_relaxed);
+    return false;
+  }
+
+  out_entry = pRing->Load(iBottom);
+
+  if (iTop != iBottom)
+  {
+    // more than one entry left, thieves cannot get to this one
+    return true;
+  }
+
+  // the last entry, race against the thieves for it
+  const bool bWon = m_iTop.compare_exchange_strong(iTop, iTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  m_iBottom.store(iBottom + 1, std::memory_order_relaxed);
+  return bWon;
+}
+
+bool nsTaskDeque::Steal(nsTaskQueueEntry& out_entry)
+{
+  nsInt64 iTop = m_iTop.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const nsInt64 iBottom = m_iBottom.load(std::memory_order_acquire);
+
+  if (iTop >= iBottom)
+    return false;
+
+  const Ring* pRing = m_pRing.load(std::memory_order_acquire);
+  const nsTaskQueueEntry entry = pRing->Load(iTop);
+
+  if (!m_iTop.compare_exchange_strong(iTop, iTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    return false;
+
+  out_entry = entry;
+  return true;
+}
+
+void nsTaskDeque::Ring::Store(nsInt64 iIndex, const nsTaskQueueEntry& entry)
+{
+  Slot& slot = m_pSlots[iIndex & m_iMask];
+  slot.m_pTask.store(entry.m_pTask, std::memory_order_relaxed);
+  slot.m_uiScheduleCounter.store(entry.m_uiScheduleCounter, std::memory_order_relaxed);
+  slot.m_uiLightTask.store(entry.m_uiLightTask, std::memory_order_relaxed);
+}
+
+nsTaskQueueEntry nsTaskDeque::Ring::Load(nsInt64 iIndex) const
+{
+  const Slot& slot = m_pSlots[iIndex & m_iMask];
+
+  nsTaskQueueEntry entry;
+  entry.m_pTask = slot.m_pTask.load(std::memory_order_relaxed);
+  entry.m_uiScheduleCounter = slot.m_uiScheduleCounter.load(std::memory_order_relaxed);
+  entry.m_uiLightTask = slot.m_uiLightTask.load(std::memory_order_relaxed);
+  return entry;
+}
+
+nsTaskDeque::Ring* nsTaskDeque::CreateRing(nsUInt32 uiCapacity)
+{
+  Ring* pRing = NS_DEFAULT_NEW(Ring);
+  pRing->m_iMask = static_cast<nsInt64>(uiCapacity) - 1;
+  pRing->m_pSlots = NS_DEFAULT_NEW_RAW_BUFFER(Slot, uiCapacity);
+
+  for (nsUInt32 i = 0; i < uiCapacity; ++i)
+  {
+    new (&pRing->m_pSlots[i]) Slot();
+  }
+
+  return pRing;
+}
+
+void nsTaskDeque::DestroyRing(Ring* pRing)
+{
+  NS_DEFAULT_DELETE_RAW_BUFFER(pRing->m_pSlots);
+  NS_DEFAULT_DELETE(pRing);
+}
+
+nsTaskDeque::Ring* nsTaskDeque::Grow(Ring* pOldRing, nsInt64 iTop, nsInt64 iBottom)
+{
+  Ring* pNewRing = CreateRing(static_cast<nsUInt32>((pOldRing->m_iMask + 1) * 2));
+
+  for (nsInt64 i = iTop; i < iBottom; ++i)
+  {
+    pNewRing->Store(i, pOldRing->Load(i));
+  }
+
+  m_RetiredRings.PushBack(pOldRing);
+  m_pRing.store(pNewRing, std::memory_order_release);
+  return pNewRing;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Foundation/Containers/DynamicArray.h>
+#include <Foundation/Threading/Implementation/TaskSystemDeclarations.h>
+
+#include <atomic>
+
+/// \internal One queued run of a task, or one queued light task.
+///
+/// The entry does not keep the task alive, the task's group does that until all of its runs are finished. Entries of runs that got
+/// canceled while still queued are skipped when they are dequeued, see nsTaskSystem::CancelTask().
+struct nsTaskQueueEntry
+{
+  nsTask* m_pTask = nullptr;
+  nsUInt32 m_uiScheduleCounter = 0;
+
+  /// Index + 1 of a light task, m_pTask is null in that case. Zero for regular tasks.
+  nsUInt32 m_uiLightTask = 0;
+};
+
+/// \internal A Chase-Lev work-stealing deque of task runs.
+///
+/// The owning thread pushes and pops at the bottom (LIFO), every other thread may steal from the top (FIFO).
+/// Rings that were replaced while growing are kept alive until the deque is destroyed, since a thief may still read from them.
+class nsTaskDeque
+{
+  NS_DISALLOW_COPY_AND_ASSIGN(nsTaskDeque);
+
+public:
+  nsTaskDeque();
+  ~nsTaskDeque();
+
+  /// \brief Pushes an entry to the bottom of the deque. Owner only.
+  void Push(const nsTaskQueueEntry& entry);
+
+  /// \brief Pops the most recently pushed entry. Owner only. Returns false if the deque is empty or the last entry was stolen concurrently.
+  bool Pop(nsTaskQueueEntry& out_entry);
+
+  /// \brief Steals the oldest entry. Safe from any thread. Returns false if the deque is empty or another thread won the race for the entry.
+  bool Steal(nsTaskQueueEntry& out_entry);
+
+  /// \brief Approximate number of entries. Safe from any thread.
+  nsUInt32 GetCount() const
+  {
+    const nsInt64 iBottom = m_iBottom.load(std::memory_order_relaxed);
+    const nsInt64 iTop = m_iTop.load(std::memory_order_relaxed);
+    return iBottom > iTop ? static_cast<nsUInt32>(iBottom - iTop) : 0u;
+  }
+
+private:
+  struct Slot
+  {
+    std::atomic<nsTask*> m_pTask;
+    std::atomic<nsUInt32> m_uiScheduleCounter;
+    std::atomic<nsUInt32> m_uiLightTask;
+  };
+
+  struct Ring
+  {
+    nsInt64 m_iMask = 0;
+    Slot* m_pSlots = nullptr;
+
+    void Store(nsInt64 iIndex, const nsTaskQueueEntry& entry);
+    nsTaskQueueEntry Load(nsInt64 iIndex) const;
+  };
+
+  static Ring* CreateRing(nsUInt32 uiCapacity);
+  static void DestroyRing(Ring* pRing);
+  Ring* Grow(Ring* pOldRing, nsInt64 iTop, nsInt64 iBottom);
+
+  // top and bottom are kept on separate cache lines, thieves only write the top
+  alignas(64) std::atomic<nsInt64> m_iTop;
+  alignas(64) std::atomic<nsInt64> m_iBottom;
+  std::atomic<Ring*> m_pRing;
+  nsHybridArray<Ring*, 4> m_RetiredRings;
+};
+
+/// \internal The deques of one thread that schedules tasks, one per priority and nesting mode, and its pool of light tasks.
+///
+/// Tasks that may wait for other tasks go into a separate lane, so that a thread that is itself waiting inside a task
+/// can pick up tasks that never wait without searching through the queue.
+struct nsTaskWorkerQueues
+{
+  enum Lane
+  {
+    NeverNests,
+    MayNest,
+    LaneCount
+  };
+
+  /// Index in nsTaskSystemState::m_QueueOwners, thieves start searching behind it.
+  nsUInt32 m_uiOwnerIndex = 0;
+
+  /// Light tasks that this thread may reuse without synchronization. Excess ones go back to nsTaskSystemState::m_FreeLightTasks.
+  nsDynamicArray<nsUInt32> m_FreeLightTasks;
+
+  nsTaskDeque m_Queues[nsTaskPriority::ENUM_COUNT][LaneCount];
+};
@@ -4,6 +4,7 @@
 #include <Foundation/Threading/Implementation/TaskGroup.h>
 #include <Foundation/Threading/Implementation/TaskSystemState.h>
 #include <Foundation/Threading/Implementation/TaskWorkerThread.h>
+#include <Foundation/Threading/Lock.h>
 #include <Foundation/Threading/TaskSystem.h>
 
 nsMutex nsTaskSystem::s_TaskSystemMutex;
@@ -42,6 +43,11 @@ void nsTaskSystem::Startup()
   tl_TaskWorkerInfo.m_WorkerType = nsWorkerThreadType::MainThread;
   tl_TaskWorkerInfo.m_iWorkerIndex = 0;
 
+  {
+    NS_LOCK(s_TaskSystemMutex);
+    tl_TaskWorkerInfo.m_pQueues = AllocateQueues();
+  }
+
   // initialize with the default number of worker threads
   SetWorkerThreadCount();
 }
@@ -53,10 +59,43 @@ void nsTaskSystem::Shutdown()
 
   StopWorkerThreads();
 
+  tl_TaskWorkerInfo.m_pQueues = nullptr;
   s_pState.Clear();
   s_pThreadState.Clear();
 }
 
+nsTaskSystemState::nsTaskSystemState()
+  : m_QueueAllocator("TaskSystemQueues", nsFoundation::GetAlignedAllocator())
+{
+}
+
+nsTaskSystemState::~nsTaskSystemState()
+{
+  // the queues do not own the tasks, the groups and the canceled list do
+  for (nsUInt32 i = 0; i < m_uiNumQueueOwners; ++i)
+  {
+    NS_DELETE(&m_QueueAllocator, m_QueueOwners[i]);
+  }
+
+  for (nsTaskGroup* pBlock : m_TaskGroupBlocks)
+  {
+    if (pBlock != nullptr)
+    {
+      nsArrayPtr<nsTaskGroup> groups = nsMakeArrayPtr(pBlock, TaskGroupsPerBlock);
+      NS_DEFAULT_DELETE_ARRAY(groups);
+    }
+  }
+
+  for (nsLightTask* pBlock : m_LightTaskBlocks)
+  {
+    if (pBlock != nullptr)
+    {
+      nsArrayPtr<nsLightTask> lightTasks = nsMakeArrayPtr(pBlock, LightTasksPerBlock);
+      NS_DEFAULT_DELETE_ARRAY(lightTasks);
+    }
+  }
+}
+
 void nsTaskSystem::SetTargetFrameTime(nsTime targetFrameTime)
 {
   s_pState->m_TargetFrameTime = targetFrameTime;
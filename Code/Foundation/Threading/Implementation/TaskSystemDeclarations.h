@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Foundation/Containers/HybridArray.h>
+#include <Foundation/Threading/AtomicInteger.h>
 #include <Foundation/Threading/ConditionVariable.h>
 #include <Foundation/Time/Time.h>
 #include <Foundation/Types/Delegate.h>
@@ -12,6 +13,9 @@ class nsTaskGroup;
 class nsTaskWorkerThread;
 class nsTaskSystemState;
 class nsTaskSystemThreadState;
+struct nsTaskQueueEntry;
+struct nsLightTask;
+struct nsTaskWorkerQueues;
 class nsDGMLGraph;
 class nsAllocator;
 
@@ -136,6 +140,41 @@ private:
   nsTaskGroup* m_pTaskGroup = nullptr;
 };
 
+/// \brief The function that a light task executes, see nsTaskSystem::StartLightTask().
+///
+/// Lambdas whose captures do not fit into the delegate are allocated on the heap, which defeats the purpose of light tasks.
+using nsLightTaskFunction = nsDelegate<void(), 48>;
+
+/// \brief References a light task that was started through nsTaskSystem::StartLightTask().
+///
+/// Light tasks are recycled as soon as they are finished. The handle stores the generation of the task it refers to,
+/// so once the task is finished, the handle simply reports that, even if the task has been reused for other work since.
+class NS_FOUNDATION_DLL nsLightTaskHandle
+{
+public:
+  NS_DECLARE_POD_TYPE();
+
+  /// \brief Returns false, if the handle does not reference any light task.
+  NS_ALWAYS_INLINE bool IsValid() const { return m_uiGeneration != 0; }
+
+  /// \brief Resets the handle into an invalid state.
+  NS_ALWAYS_INLINE void Invalidate() { m_uiGeneration = 0; }
+
+  NS_ALWAYS_INLINE bool operator==(const nsLightTaskHandle& other) const { return m_uiIndex == other.m_uiIndex && m_uiGeneration == other.m_uiGeneration; }
+  NS_ALWAYS_INLINE bool operator!=(const nsLightTaskHandle& other) const { return !(*this == other); }
+
+  /// \brief Starts \a continuation once the referenced task is finished, see nsTaskSystem::StartLightTaskAfter().
+  nsLightTaskHandle Then(nsLightTaskFunction continuation, nsTaskPriority::Enum priority = nsTaskPriority::ThisFrame) const;
+
+private:
+  friend class nsTaskSystem;
+
+  nsUInt32 m_uiIndex = 0;
+
+  // zero is never used as a generation, so it marks invalid handles
+  nsUInt32 m_uiGeneration = 0;
+};
+
 /// \brief Callback type when a task group has been finished (or canceled).
 using nsOnTaskGroupFinishedCallback = nsDelegate<void(nsTaskGroupID)>;
 
@@ -162,6 +201,15 @@ enum class nsTaskNesting
   Never,
 };
 
+/// \brief Stores the measured cost per item of one adaptive nsTaskSystem::ParallelForIndexed() call site.
+///
+/// \see nsParallelForParams::m_pAdaptiveGrainSize
+struct nsParallelForAdaptiveGrainSize
+{
+  /// Moving average of the time that one item takes, in picoseconds. Zero until the first chunk was measured.
+  nsAtomicInteger64 m_iPicosecondsPerItem;
+};
+
 /// \brief Settings for nsTaskSystem::ParallelFor invocations.
 struct NS_FOUNDATION_DLL nsParallelForParams
 {
@@ -185,6 +233,16 @@ struct NS_FOUNDATION_DLL nsParallelForParams
   /// The allocator used to for the tasks that the parallel-for uses internally. If null, will use the default allocator.
   nsAllocator* m_pTaskAllocator = nullptr;
 
+  /// If set, nsTaskSystem::ParallelForIndexed() chooses its chunk sizes itself, instead of using m_uiMaxTasksPerThread.
+  /// It measures how long the items take, sizes the remaining chunks such that each takes about m_AdaptiveChunkDuration,
+  /// and splits its range in halves only when another thread is free to take one. The measured cost is stored in the given object,
+  /// which should belong to a single call site (typically a function-local static), so that the next invocation starts out with it.
+  /// m_uiBinSize is still used as the threshold for serial execution and as the chunk size until a first measurement exists.
+  nsParallelForAdaptiveGrainSize* m_pAdaptiveGrainSize = nullptr;
+
+  /// The time that one chunk of items should take, when m_pAdaptiveGrainSize is set.
+  nsTime m_AdaptiveChunkDuration = nsTime::MakeFromMicroseconds(100);
+
   void DetermineThreading(nsUInt64 uiNumItemsToExecute, nsUInt32& out_uiNumTasksToRun, nsUInt64& out_uiNumItemsPerTask) const;
 };
 
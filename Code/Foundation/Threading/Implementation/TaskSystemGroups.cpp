@@ -8,43 +8,85 @@
 #include <Foundation/Threading/Lock.h>
 #include <Foundation/Threading/TaskSystem.h>
 
+#include <atomic>
+
 
 nsTaskGroupID nsTaskSystem::CreateTaskGroup(nsTaskPriority::Enum priority, nsOnTaskGroupFinishedCallback callback)
 {
-  NS_LOCK(s_TaskSystemMutex);
-
-  nsUInt32 i = 0;
+  nsTaskGroup* pGroup = nullptr;
 
-  // this search could be speed up with a stack of free groups
-  for (; i < s_pState->m_TaskGroups.GetCount(); ++i)
+  // pop an unused group from the free list
+  nsInt64 iHead = s_pState->m_iFreeTaskGroups;
+  while ((iHead & 0xFFFFFFFF) != 0)
   {
-    if (!s_pState->m_TaskGroups[i].m_bInUse)
+    const nsUInt32 uiIndex = static_cast<nsUInt32>(iHead & 0xFFFFFFFF) - 1;
+    nsTaskGroup* pCandidate = &s_pState->m_TaskGroupBlocks[uiIndex / nsTaskSystemState::TaskGroupsPerBlock][uiIndex % nsTaskSystemState::TaskGroupsPerBlock];
+
+    // the tag changes with every push and pop, so a group that got popped and pushed again in between cannot be taken twice
+    const nsInt64 iNewHead = (((iHead >> 32) + 1) << 32) | static_cast<nsUInt32>(pCandidate->m_iNextFreeGroup);
+
+    const nsInt64 iPrevHead = s_pState->m_iFreeTaskGroups.CompareAndSwap(iHead, iNewHead);
+    if (iPrevHead == iHead)
     {
-      goto foundtaskgroup;
+      pGroup = pCandidate;
+      break;
     }
+
+    iHead = iPrevHead;
   }
 
-  // no free group found, create a new one
-  s_pState->m_TaskGroups.ExpandAndGetRef();
-  s_pState->m_TaskGroups[i].m_uiTaskGroupIndex = static_cast<nsUInt16>(i);
+  if (pGroup == nullptr)
+  {
+    // no free group found, create a new one
+    NS_LOCK(s_TaskSystemMutex);
+
+    const nsUInt32 uiIndex = s_pState->m_uiNumTaskGroups;
+    NS_ASSERT_ALWAYS(uiIndex < NS_ARRAY_SIZE(s_pState->m_TaskGroupBlocks) * nsTaskSystemState::TaskGroupsPerBlock, "Max number of task groups exceeded.");
 
-foundtaskgroup:
+    nsTaskGroup*& pBlock = s_pState->m_TaskGroupBlocks[uiIndex / nsTaskSystemState::TaskGroupsPerBlock];
+    if (pBlock == nullptr)
+    {
+      pBlock = NS_DEFAULT_NEW_ARRAY(nsTaskGroup, nsTaskSystemState::TaskGroupsPerBlock).GetPtr();
+    }
+
+    pGroup = &pBlock[uiIndex % nsTaskSystemState::TaskGroupsPerBlock];
+    pGroup->m_uiTaskGroupIndex = static_cast<nsUInt16>(uiIndex);
+
+    s_pState->m_uiNumTaskGroups = uiIndex + 1;
+  }
 
-  s_pState->m_TaskGroups[i].Reuse(priority, callback);
+  pGroup->Reuse(priority, callback);
 
   nsTaskGroupID id;
-  id.m_pTaskGroup = &s_pState->m_TaskGroups[i];
-  id.m_uiGroupCounter = s_pState->m_TaskGroups[i].m_uiGroupCounter;
+  id.m_pTaskGroup = pGroup;
+  id.m_uiGroupCounter = pGroup->m_uiGroupCounter;
   return id;
 }
 
+void nsTaskSystem::FreeTaskGroup(nsTaskGroup* pGroup)
+{
+  const nsInt64 iIndex = static_cast<nsInt64>(pGroup->m_uiTaskGroupIndex) + 1;
+
+  nsInt64 iHead = s_pState->m_iFreeTaskGroups;
+  while (true)
+  {
+    pGroup->m_iNextFreeGroup = static_cast<nsInt32>(iHead & 0xFFFFFFFF);
+
+    const nsInt64 iPrevHead = s_pState->m_iFreeTaskGroups.CompareAndSwap(iHead, (((iHead >> 32) + 1) << 32) | iIndex);
+    if (iPrevHead == iHead)
+      return;
+
+    iHead = iPrevHead;
+  }
+}
+
 void nsTaskSystem::AddTaskToGroup(nsTaskGroupID groupID, const nsSharedPtr<nsTask>& pTask)
 {
   NS_ASSERT_DEBUG(pTask != nullptr, "Cannot add nullptr tasks.");
   NS_ASSERT_DEV(pTask->IsTaskFinished(), "The given task is not finished! Cannot reuse a task before it is done.");
   NS_ASSERT_DEBUG(!pTask->m_sTaskName.IsEmpty(), "Every task should have a name");
 
-  nsTaskGroup::DebugCheckTaskGroup(groupID, s_TaskSystemMutex);
+  nsTaskGroup::DebugCheckTaskGroup(groupID);
 
   pTask->Reset();
   pTask->m_BelongsToGroup = groupID;
@@ -56,18 +98,13 @@ void nsTaskSystem::AddTaskGroupDependency(nsTaskGroupID groupID, nsTaskGroupID d
   NS_ASSERT_DEBUG(dependsOn.IsValid(), "Invalid dependency");
   NS_ASSERT_DEBUG(groupID.m_pTaskGroup != dependsOn.m_pTaskGroup || groupID.m_uiGroupCounter != dependsOn.m_uiGroupCounter, "Group cannot depend on itselfs");
 
-  nsTaskGroup::DebugCheckTaskGroup(groupID, s_TaskSystemMutex);
+  nsTaskGroup::DebugCheckTaskGroup(groupID);
 
   groupID.m_pTaskGroup->m_DependsOnGroups.PushBack(dependsOn);
 }
 
 void nsTaskSystem::AddTaskGroupDependencyBatch(nsArrayPtr<const nsTaskGroupDependency> batch)
 {
-#if NS_ENABLED(NS_COMPILE_FOR_DEBUG)
-  // lock here once to reduce the overhead of nsTaskGroup::DebugCheckTaskGroup inside AddTaskGroupDependency
-  NS_LOCK(s_TaskSystemMutex);
-#endif
-
   for (const nsTaskGroupDependency& dep : batch)
   {
     AddTaskGroupDependency(dep.m_TaskGroup, dep.m_DependsOn);
@@ -78,48 +115,37 @@ void nsTaskSystem::StartTaskGroup(nsTaskGroupID groupID)
 {
   NS_ASSERT_DEV(s_pThreadState->m_Workers[nsWorkerThreadType::ShortTasks].GetCount() > 0, "No worker threads started.");
 
-  nsTaskGroup::DebugCheckTaskGroup(groupID, s_TaskSystemMutex);
+  nsTaskGroup::DebugCheckTaskGroup(groupID);
 
-  nsInt32 iActiveDependencies = 0;
+  nsTaskGroup& tg = *groupID.m_pTaskGroup;
 
-  {
-    NS_LOCK(s_TaskSystemMutex);
+  tg.m_bStartedByUser = true;
 
-    nsTaskGroup& tg = *groupID.m_pTaskGroup;
+  // hold one dependency ourselves, so that dependencies which finish while we are still registering cannot schedule the group early
+  tg.m_iNumActiveDependencies = 1;
 
-    tg.m_bStartedByUser = true;
-
-    for (nsUInt32 i = 0; i < tg.m_DependsOnGroups.GetCount(); ++i)
-    {
-      if (!IsTaskGroupFinished(tg.m_DependsOnGroups[i]))
-      {
-        nsTaskGroup& Dependency = *tg.m_DependsOnGroups[i].m_pTaskGroup;
-
-        // add this task group to the list of dependencies, such that when that group finishes, this task group can get woken up
-        Dependency.m_OthersDependingOnMe.PushBack(groupID);
+  for (nsUInt32 i = 0; i < tg.m_DependsOnGroups.GetCount(); ++i)
+  {
+    nsTaskGroup& Dependency = *tg.m_DependsOnGroups[i].m_pTaskGroup;
 
-        // count how many other groups need to finish before this task group can be executed
-        ++iActiveDependencies;
-      }
-    }
+    // TaskHasFinished() marks the dependency as finished under the same lock, after that it does not look at its dependents anymore
+    NS_LOCK(Dependency.m_CondVarGroupFinished);
 
-    if (iActiveDependencies != 0)
+    if (!IsTaskGroupFinished(tg.m_DependsOnGroups[i]))
     {
-      // atomic integers are quite slow, so do not use them in the loop, where they are not yet needed
-      tg.m_iNumActiveDependencies = iActiveDependencies;
+      // count how many other groups need to finish before this task group can be executed
+      tg.m_iNumActiveDependencies.Increment();
+
+      // add this task group to the list of dependencies, such that when that group finishes, this task group can get woken up
+      Dependency.m_OthersDependingOnMe.PushBack(groupID);
     }
   }
 
-  if (iActiveDependencies == 0)
-  {
-    ScheduleGroupTasks(groupID.m_pTaskGroup, false);
-  }
+  DependencyHasFinished(&tg, false);
 }
 
 void nsTaskSystem::StartTaskGroupBatch(nsArrayPtr<const nsTaskGroupID> batch)
 {
-  NS_LOCK(s_TaskSystemMutex);
-
   for (const nsTaskGroupID& group : batch)
   {
     StartTaskGroup(group);
@@ -145,10 +171,13 @@ void nsTaskSystem::ScheduleGroupTasks(nsTaskGroup* pGroup, bool bHighPriority)
 
   nsInt32 iRemainingTasks = 0;
 
-  // add all the tasks to the task list, so that they will be processed
-  {
-    NS_LOCK(s_TaskSystemMutex);
+  // once the tasks are queued the group may finish and get reused at any time
+  const nsTaskPriority::Enum priority = pGroup->m_Priority;
 
+  // add all the tasks to the task queues, so that they will be processed
+  {
+    // CancelTask() removes tasks that are not scheduled yet from the group under this lock
+    NS_LOCK(pGroup->m_CondVarGroupFinished);
 
     // store how many tasks from this groups still need to be processed
 
@@ -160,78 +189,44 @@ void nsTaskSystem::ScheduleGroupTasks(nsTaskGroup* pGroup, bool bHighPriority)
 
     pGroup->m_iNumRemainingTasks = iRemainingTasks;
 
-
     for (nsUInt32 task = 0; task < pGroup->m_Tasks.GetCount(); ++task)
     {
-      auto& pTask = pGroup->m_Tasks[task];
+      nsTask* pTask = pGroup->m_Tasks[task].Borrow();
 
-      for (nsUInt32 mult = 0; mult < nsMath::Max(1u, pTask->m_uiMultiplicity); ++mult)
-      {
-        TaskData td;
-        td.m_pBelongsToGroup = pGroup;
-        td.m_pTask = pTask;
-        td.m_pTask->m_bTaskIsScheduled = true;
-        td.m_uiInvocation = mult;
-
-        if (bHighPriority)
-          s_pState->m_Tasks[pGroup->m_Priority].PushFront(td);
-        else
-          s_pState->m_Tasks[pGroup->m_Priority].PushBack(td);
-      }
-    }
+      const nsUInt32 uiRuns = nsMath::Max(1u, pTask->m_uiMultiplicity);
 
-    // send the proper thread signal, to make sure one of the correct worker threads is awake
-    switch (pGroup->m_Priority)
-    {
-      case nsTaskPriority::EarlyThisFrame:
-      case nsTaskPriority::ThisFrame:
-      case nsTaskPriority::LateThisFrame:
-      case nsTaskPriority::EarlyNextFrame:
-      case nsTaskPriority::NextFrame:
-      case nsTaskPriority::LateNextFrame:
-      case nsTaskPriority::In2Frames:
-      case nsTaskPriority::In3Frames:
-      case nsTaskPriority::In4Frames:
-      case nsTaskPriority::In5Frames:
-      case nsTaskPriority::In6Frames:
-      case nsTaskPriority::In7Frames:
-      case nsTaskPriority::In8Frames:
-      case nsTaskPriority::In9Frames:
-      {
-        WakeUpThreads(nsWorkerThreadType::ShortTasks, iRemainingTasks);
-        break;
-      }
+      // a new schedule counter invalidates queue entries that are still around from canceled runs of a previous scheduling
+      nsTaskQueueEntry entry;
+      entry.m_pTask = pTask;
+      entry.m_uiScheduleCounter = static_cast<nsUInt32>(static_cast<nsUInt64>(static_cast<nsInt64>(pTask->m_iRunState)) >> 32) + 1;
 
-      case nsTaskPriority::LongRunning:
-      case nsTaskPriority::LongRunningHighPriority:
-      {
-        WakeUpThreads(nsWorkerThreadType::LongTasks, iRemainingTasks);
-        break;
-      }
+      pTask->m_bTaskIsScheduled = true;
+      pTask->m_uiScheduledRuns = uiRuns;
+      pTask->m_uiIndexInGroup = task;
+      pTask->m_iRunState = static_cast<nsInt64>((static_cast<nsUInt64>(entry.m_uiScheduleCounter) << 32) | uiRuns);
+
+      const bool bMayNest = pTask->m_NestingMode != nsTaskNesting::Never;
 
-      case nsTaskPriority::FileAccess:
-      case nsTaskPriority::FileAccessHighPriority:
+      for (nsUInt32 mult = 0; mult < uiRuns; ++mult)
       {
-        WakeUpThreads(nsWorkerThreadType::FileAccess, iRemainingTasks);
-        break;
+        QueueTask(priority, entry, bMayNest, bHighPriority);
       }
-
-      case nsTaskPriority::SomeFrameMainThread:
-      case nsTaskPriority::ThisFrameMainThread:
-      case nsTaskPriority::ENUM_COUNT:
-        // nothing to do for these enum values
-        break;
     }
   }
+
+  // a worker that is about to go idle re-checks the queues after publishing that, this fence pairs with the one in GetNextTask()
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  WakeUpThreadsForPriority(priority, iRemainingTasks);
 }
 
-void nsTaskSystem::DependencyHasFinished(nsTaskGroup* pGroup)
+void nsTaskSystem::DependencyHasFinished(nsTaskGroup* pGroup, bool bHighPriority)
 {
   // remove one dependency from the group
   if (pGroup->m_iNumActiveDependencies.Decrement() == 0)
   {
     // if there are no remaining dependencies, kick off all tasks in this group
-    ScheduleGroupTasks(pGroup, true);
+    ScheduleGroupTasks(pGroup, bHighPriority);
   }
 }
 
@@ -242,11 +237,19 @@ nsResult nsTaskSystem::CancelGroup(nsTaskGroupID group, nsOnTaskRunning::Enum on
 
   NS_PROFILE_SCOPE("CancelGroup");
 
-  NS_LOCK(s_TaskSystemMutex);
+  nsHybridArray<nsSharedPtr<nsTask>, 16> TasksCopy;
 
-  nsResult res = NS_SUCCESS;
+  {
+    // the group clears its tasks under this lock when it finishes
+    NS_LOCK(group.m_pTaskGroup->m_CondVarGroupFinished);
+
+    if (nsTaskSystem::IsTaskGroupFinished(group))
+      return NS_SUCCESS;
 
-  auto TasksCopy = group.m_pTaskGroup->m_Tasks;
+    TasksCopy = group.m_pTaskGroup->m_Tasks;
+  }
+
+  nsResult res = NS_SUCCESS;
 
   // first cancel ALL the tasks in the group, without waiting for anything
   for (nsUInt32 task = 0; task < TasksCopy.GetCount(); ++task)
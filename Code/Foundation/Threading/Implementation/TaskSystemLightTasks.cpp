@@ -0,0 +1,247 @@
+#include <Foundation/FoundationPCH.h>
+
+#include <Foundation/Threading/Implementation/TaskSystemState.h>
+#include <Foundation/Threading/Implementation/TaskWorkerThread.h>
+#include <Foundation/Threading/Lock.h>
+#include <Foundation/Threading/TaskSystem.h>
+
+#include <atomic>
+
+namespace
+{
+  // how many light tasks are moved between a thread's own pool and the shared pool at once
+  constexpr nsUInt32 LightTaskBatchSize = 128;
+
+  NS_ALWAYS_INLINE nsUInt32 GetGeneration(nsInt64 iState)
+  {
+    return static_cast<nsUInt32>(static_cast<nsUInt64>(iState) >> 32);
+  }
+
+  NS_ALWAYS_INLINE nsUInt32 GetContinuations(nsInt64 iState)
+  {
+    return static_cast<nsUInt32>(iState & 0xFFFFFFFF);
+  }
+
+  NS_ALWAYS_INLINE nsInt64 MakeState(nsUInt32 uiGeneration, nsUInt32 uiContinuations)
+  {
+    return static_cast<nsInt64>((static_cast<nsUInt64>(uiGeneration) << 32) | uiContinuations);
+  }
+} // namespace
+
+nsLightTaskHandle nsLightTaskHandle::Then(nsLightTaskFunction continuation, nsTaskPriority::Enum priority) const
+{
+  return nsTaskSystem::StartLightTaskAfter(*this, std::move(continuation), priority);
+}
+
+nsLightTaskHandle nsTaskSystem::StartLightTask(nsLightTaskFunction function, nsTaskPriority::Enum priority)
+{
+  NS_ASSERT_DEV(function.IsValid(), "Light tasks need a function to execute.");
+
+  const nsUInt32 uiIndex = AllocateLightTask();
+  nsLightTask& task = GetLightTask(uiIndex);
+
+  task.m_Function = std::move(function);
+  task.m_Priority = priority;
+
+  nsLightTaskHandle hTask;
+  hTask.m_uiIndex = uiIndex;
+  hTask.m_uiGeneration = GetGeneration(task.m_iState);
+
+  QueueLightTask(uiIndex);
+  return hTask;
+}
+
+nsLightTaskHandle nsTaskSystem::StartLightTaskAfter(nsLightTaskHandle hAntecedent, nsLightTaskFunction continuation, nsTaskPriority::Enum priority)
+{
+  NS_ASSERT_DEV(continuation.IsValid(), "Light tasks need a function to execute.");
+
+  const nsUInt32 uiIndex = AllocateLightTask();
+  nsLightTask& task = GetLightTask(uiIndex);
+
+  task.m_Function = std::move(continuation);
+  task.m_Priority = priority;
+
+  nsLightTaskHandle hTask;
+  hTask.m_uiIndex = uiIndex;
+  hTask.m_uiGeneration = GetGeneration(task.m_iState);
+
+  if (hAntecedent.IsValid())
+  {
+    nsLightTask& antecedent = GetLightTask(hAntecedent.m_uiIndex);
+
+    nsInt64 iState = antecedent.m_iState;
+    while (GetGeneration(iState) == hAntecedent.m_uiGeneration && GetContinuations(iState) != nsLightTask::Finished)
+    {
+      // push the continuation onto the antecedent's list, the thread that finishes the antecedent will queue it
+      task.m_uiNextContinuation = GetContinuations(iState);
+
+      const nsInt64 iPrevState = antecedent.m_iState.CompareAndSwap(iState, MakeState(hAntecedent.m_uiGeneration, uiIndex + 1));
+      if (iPrevState == iState)
+        return hTask;
+
+      iState = iPrevState;
+    }
+  }
+
+  // the antecedent is already finished
+  task.m_uiNextContinuation = 0;
+  QueueLightTask(uiIndex);
+  return hTask;
+}
+
+bool nsTaskSystem::IsLightTaskFinished(nsLightTaskHandle hTask)
+{
+  if (!hTask.IsValid())
+    return true;
+
+  const nsInt64 iState = GetLightTask(hTask.m_uiIndex).m_iState;
+  return GetGeneration(iState) != hTask.m_uiGeneration || GetContinuations(iState) == nsLightTask::Finished;
+}
+
+void nsTaskSystem::WaitForLightTask(nsLightTaskHandle hTask)
+{
+  if (IsLightTaskFinished(hTask))
+    return;
+
+  WaitForCondition([hTask]()
+    { return IsLightTaskFinished(hTask); });
+}
+
+nsLightTask& nsTaskSystem::GetLightTask(nsUInt32 uiIndex)
+{
+  return s_pState->m_LightTaskBlocks[uiIndex / nsTaskSystemState::LightTasksPerBlock][uiIndex % nsTaskSystemState::LightTasksPerBlock];
+}
+
+nsUInt32 nsTaskSystem::AllocateLightTask()
+{
+  nsTaskWorkerQueues* pQueues = tl_TaskWorkerInfo.m_pQueues;
+  nsUInt32 uiIndex = nsInvalidIndex;
+
+  if (pQueues != nullptr && !pQueues->m_FreeLightTasks.IsEmpty())
+  {
+    uiIndex = pQueues->m_FreeLightTasks.PeekBack();
+    pQueues->m_FreeLightTasks.PopBack();
+  }
+  else
+  {
+    NS_LOCK(s_pState->m_FreeLightTasksMutex);
+
+    nsDynamicArray<nsUInt32>& shared = s_pState->m_FreeLightTasks;
+    if (!shared.IsEmpty())
+    {
+      uiIndex = shared.PeekBack();
+      shared.PopBack();
+
+      // take a whole batch, so that the next allocations do not need the lock
+      if (pQueues != nullptr)
+      {
+        const nsUInt32 uiTake = nsMath::Min(shared.GetCount(), LightTaskBatchSize - 1);
+        pQueues->m_FreeLightTasks.PushBackRange(shared.GetArrayPtr().GetSubArray(shared.GetCount() - uiTake));
+        shared.SetCountUninitialized(shared.GetCount() - uiTake);
+      }
+    }
+  }
+
+  if (uiIndex == nsInvalidIndex)
+  {
+    // no free light task anywhere, allocate a new block
+    NS_LOCK(s_TaskSystemMutex);
+
+    const nsUInt32 uiFirstIndex = s_pState->m_uiNumLightTasks;
+    NS_ASSERT_ALWAYS(uiFirstIndex < NS_ARRAY_SIZE(s_pState->m_LightTaskBlocks) * nsTaskSystemState::LightTasksPerBlock, "Max number of light tasks exceeded.");
+
+    s_pState->m_LightTaskBlocks[uiFirstIndex / nsTaskSystemState::LightTasksPerBlock] = NS_DEFAULT_NEW_ARRAY(nsLightTask, nsTaskSystemState::LightTasksPerBlock).GetPtr();
+    s_pState->m_uiNumLightTasks = uiFirstIndex + nsTaskSystemState::LightTasksPerBlock;
+
+    uiIndex = uiFirstIndex;
+
+    for (nsUInt32 i = nsTaskSystemState::LightTasksPerBlock - 1; i > 0; --i)
+    {
+      FreeLightTask(uiFirstIndex + i);
+    }
+  }
+
+  // a new generation invalidates all handles to the previous use, zero is skipped as it marks invalid handles
+  nsLightTask& task = GetLightTask(uiIndex);
+  nsUInt32 uiGeneration = GetGeneration(task.m_iState) + 1;
+  uiGeneration = (uiGeneration == 0) ? 1 : uiGeneration;
+
+  task.m_uiNextContinuation = 0;
+  task.m_iState = MakeState(uiGeneration, 0);
+
+  return uiIndex;
+}
+
+void nsTaskSystem::FreeLightTask(nsUInt32 uiIndex)
+{
+  nsTaskWorkerQueues* pQueues = tl_TaskWorkerInfo.m_pQueues;
+
+  if (pQueues != nullptr)
+  {
+    pQueues->m_FreeLightTasks.PushBack(uiIndex);
+
+    // threads that mostly finish tasks that others started, hand their surplus back
+    if (pQueues->m_FreeLightTasks.GetCount() >= 2 * LightTaskBatchSize)
+    {
+      const nsUInt32 uiKeep = pQueues->m_FreeLightTasks.GetCount() - LightTaskBatchSize;
+
+      NS_LOCK(s_pState->m_FreeLightTasksMutex);
+      s_pState->m_FreeLightTasks.PushBackRange(pQueues->m_FreeLightTasks.GetArrayPtr().GetSubArray(uiKeep));
+      pQueues->m_FreeLightTasks.SetCountUninitialized(uiKeep);
+    }
+  }
+  else
+  {
+    NS_LOCK(s_pState->m_FreeLightTasksMutex);
+    s_pState->m_FreeLightTasks.PushBack(uiIndex);
+  }
+}
+
+void nsTaskSystem::QueueLightTask(nsUInt32 uiIndex)
+{
+  const nsTaskPriority::Enum priority = GetLightTask(uiIndex).m_Priority;
+
+  nsTaskQueueEntry entry;
+  entry.m_uiLightTask = uiIndex + 1;
+
+  // light tasks never wait, so they can always be picked up by threads that wait themselves
+  QueueTask(priority, entry, false, false);
+
+  // a worker that is about to go idle re-checks the queues after publishing that, this fence pairs with the one in GetNextTask()
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  WakeUpThreadsForPriority(priority, 1);
+}
+
+void nsTaskSystem::ExecuteLightTask(nsUInt32 uiIndex)
+{
+  nsLightTask& task = GetLightTask(uiIndex);
+
+  {
+    tl_TaskWorkerInfo.m_bAllowNestedTasks = false;
+    tl_TaskWorkerInfo.m_szTaskName = "Light Task";
+
+    task.m_Function();
+
+    tl_TaskWorkerInfo.m_bAllowNestedTasks = true;
+    tl_TaskWorkerInfo.m_szTaskName = nullptr;
+  }
+
+  // release what the function captured, before anyone can observe the task as finished
+  task.m_Function.Invalidate();
+
+  // from here on no more continuations can be attached
+  const nsInt64 iState = task.m_iState.Set(MakeState(GetGeneration(task.m_iState), nsLightTask::Finished));
+
+  // queue the continuations on this thread, the data they work on is most likely still in its cache
+  nsUInt32 uiContinuation = GetContinuations(iState);
+  while (uiContinuation != 0)
+  {
+    // read the link before queuing, afterwards the continuation may run and get reused at any time
+    const nsUInt32 uiNext = GetLightTask(uiContinuation - 1).m_uiNextContinuation;
+    QueueLightTask(uiContinuation - 1);
+    uiContinuation = uiNext;
+  }
+
+  FreeLightTask(uiIndex);
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <Foundation/Containers/Deque.h>
+#include <Foundation/Memory/CommonAllocators.h>
+#include <Foundation/Threading/Implementation/TaskQueue.h>
 #include <Foundation/Threading/TaskSystem.h>
 
 class nsTaskSystemThreadState
@@ -18,17 +21,84 @@ private:
   nsUInt32 m_uiMaxWorkersToUse[nsWorkerThreadType::ENUM_COUNT] = {};
 };
 
+/// \internal Storage of one light task, see nsTaskSystem::StartLightTask().
+struct nsLightTask
+{
+  /// Marks m_iState as finished, instead of pointing to the first continuation.
+  static constexpr nsUInt32 Finished = 0xFFFFFFFF;
+
+  nsLightTaskFunction m_Function;
+  nsTaskPriority::Enum m_Priority = nsTaskPriority::ThisFrame;
+
+  /// The generation in the upper 32 bits, changes every time the task is started. The lower 32 bits hold
+  /// the index + 1 of the first continuation, or 'Finished'. Both are changed together, so that a continuation can never
+  /// be attached to the wrong generation.
+  nsAtomicInteger64 m_iState;
+
+  /// Index + 1 of the next continuation of the same task, zero at the end of the list.
+  nsUInt32 m_uiNextContinuation = 0;
+};
+
 class nsTaskSystemState
 {
+public:
+  nsTaskSystemState();
+  ~nsTaskSystemState();
+
 private:
   friend class nsTaskSystem;
 
   // The target frame time used by FinishFrameTasks()
   nsTime m_TargetFrameTime = nsTime::MakeFromSeconds(1.0 / 40.0); // => 25 ms
 
-  // The deque can grow without relocating existing data, therefore the nsTaskGroupID's can store pointers directly to the data
-  nsDeque<nsTaskGroup> m_TaskGroups;
+  // Task groups are allocated in blocks that never move, therefore the nsTaskGroupID's can store pointers directly to the data
+  // and the free list can be walked without a lock. nsTaskGroup::m_uiTaskGroupIndex limits the number of groups to 64K.
+  static constexpr nsUInt32 TaskGroupsPerBlock = 256;
+  nsTaskGroup* m_TaskGroupBlocks[256] = {};
+
+  // The number of task groups that have been allocated so far, only modified while s_TaskSystemMutex is locked.
+  nsUInt32 m_uiNumTaskGroups = 0;
+
+  // Head of the stack of unused task groups: a tag against ABA in the upper 32 bits, the group index + 1 in the lower 32 bits.
+  nsAtomicInteger64 m_iFreeTaskGroups;
+
+  // The main thread plus the maximum number of worker threads, see nsTaskSystem::SetWorkerThreadCount()
+  static constexpr nsUInt32 MaxQueueOwners = 1 + 1024 + 1024 + 128;
+
+  // The task queues of the main thread and of every worker thread that has ever been allocated.
+  // Entries are only ever appended, so other threads can steal from them without a lock.
+  nsTaskWorkerQueues* m_QueueOwners[MaxQueueOwners] = {};
+  std::atomic<nsUInt32> m_uiNumQueueOwners = 0;
+
+  // The queues are cache line aligned and live as long as the task system, so they get an allocator of their own.
+  nsAlignedHeapAllocator m_QueueAllocator;
+
+  // Which entry of m_QueueOwners belongs to which worker thread, so that restarted workers take over the tasks of their predecessor.
+  nsDynamicArray<nsUInt32> m_WorkerQueueOwners[nsWorkerThreadType::ENUM_COUNT];
+
+  // Tasks scheduled by threads that are not known to the task system (and thus have no queues of their own).
+  nsMutex m_InjectedTasksMutex;
+  nsDeque<nsTaskQueueEntry> m_InjectedTasks[nsTaskPriority::ENUM_COUNT][nsTaskWorkerQueues::LaneCount];
+  std::atomic<nsUInt32> m_uiNumInjectedTasks = 0;
+
+  // Tasks of groups whose last dependency just finished. Every thread takes them before all other tasks of the same priority,
+  // so that work which waited on other work does not additionally wait behind everything that was queued in the meantime.
+  nsMutex m_UrgentTasksMutex;
+  nsDeque<nsTaskQueueEntry> m_UrgentTasks[nsTaskPriority::ENUM_COUNT][nsTaskWorkerQueues::LaneCount];
+  std::atomic<nsUInt32> m_uiNumUrgentTasks = 0;
+
+  // Light tasks are allocated in blocks that never move, so their handles can be resolved without a lock.
+  static constexpr nsUInt32 LightTasksPerBlock = 1024;
+  nsLightTask* m_LightTaskBlocks[1024] = {};
+
+  // The number of light tasks that have been allocated so far, only modified while s_TaskSystemMutex is locked.
+  nsUInt32 m_uiNumLightTasks = 0;
+
+  // Light tasks that were returned by threads with too many, or by threads that are unknown to the task system.
+  nsMutex m_FreeLightTasksMutex;
+  nsDynamicArray<nsUInt32> m_FreeLightTasks;
 
-  // The lists of all scheduled tasks, for each priority.
-  nsList<nsTaskSystem::TaskData> m_Tasks[nsTaskPriority::ENUM_COUNT];
+  // Tasks that were canceled while some of their runs were still queued. Keeps them alive until those queue entries are skipped.
+  nsMutex m_CanceledTasksMutex;
+  nsDynamicArray<nsSharedPtr<nsTask>> m_CanceledTasks;
 };
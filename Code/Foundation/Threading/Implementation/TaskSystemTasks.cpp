@@ -7,6 +7,8 @@
 #include <Foundation/Threading/Lock.h>
 #include <Foundation/Threading/TaskSystem.h>
 
+#include <atomic>
+
 nsTaskGroupID nsTaskSystem::StartSingleTask(const nsSharedPtr<nsTask>& pTask, nsTaskPriority::Enum priority, nsTaskGroupID dependency,
   nsOnTaskGroupFinishedCallback callback /*= nsOnTaskGroupFinishedCallback()*/)
 {
@@ -29,7 +31,7 @@ nsTaskGroupID nsTaskSystem::StartSingleTask(
 void nsTaskSystem::TaskHasFinished(nsSharedPtr<nsTask>&& pTask, nsTaskGroup* pGroup)
 {
   // call task finished callback and deallocate the task (if last reference)
-  if (pTask && pTask->m_iRemainingRuns == 0)
+  if (pTask && pTask->m_iRemainingRuns.Decrement() == 0)
   {
     if (pTask->m_OnTaskFinished.IsValid())
     {
@@ -50,24 +52,22 @@ void nsTaskSystem::TaskHasFinished(nsSharedPtr<nsTask>&& pTask, nsTaskGroup* pGr
       // see nsTaskGroup::WaitForFinish() for why we need this lock here
       // without it, there would be a race condition between these two places, reading and writing m_uiGroupCounter and waiting/signaling
       // m_CondVarGroupFinished
+      // StartTaskGroup() and CancelGroup() also rely on this lock, to not add dependents or look at the tasks of a finished group
       NS_LOCK(pGroup->m_CondVarGroupFinished);
 
       groupCounter = pGroup->m_uiGroupCounter;
 
       // set this task group to be finished such that no one tries to append further dependencies
       pGroup->m_uiGroupCounter += 2;
-    }
-
-    {
-      NS_LOCK(s_TaskSystemMutex);
 
       // unless an outside reference is held onto a task, this will deallocate the tasks
       pGroup->m_Tasks.Clear();
+    }
 
-      for (nsUInt32 dep = 0; dep < pGroup->m_OthersDependingOnMe.GetCount(); ++dep)
-      {
-        DependencyHasFinished(pGroup->m_OthersDependingOnMe[dep].m_pTaskGroup);
-      }
+    // no one appends to this list anymore, once the group is marked as finished
+    for (nsUInt32 dep = 0; dep < pGroup->m_OthersDependingOnMe.GetCount(); ++dep)
+    {
+      DependencyHasFinished(pGroup->m_OthersDependingOnMe[dep].m_pTaskGroup, true);
     }
 
     // wake up all threads that are waiting for this group
@@ -83,6 +83,308 @@ void nsTaskSystem::TaskHasFinished(nsSharedPtr<nsTask>&& pTask, nsTaskGroup* pGr
 
     // set this task available for reuse
     pGroup->m_bInUse = false;
+    FreeTaskGroup(pGroup);
+  }
+}
+
+void nsTaskSystem::QueueTask(nsTaskPriority::Enum priority, const nsTaskQueueEntry& entry, bool bMayNest, bool bHighPriority)
+{
+  const nsUInt32 uiLane = bMayNest ? nsTaskWorkerQueues::MayNest : nsTaskWorkerQueues::NeverNests;
+
+  if (bHighPriority)
+  {
+    // the own deque would only put the task in front for the calling thread, every other thread steals the oldest tasks first
+    NS_LOCK(s_pState->m_UrgentTasksMutex);
+    s_pState->m_UrgentTasks[priority][uiLane].PushBack(entry);
+    s_pState->m_uiNumUrgentTasks.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  if (nsTaskWorkerQueues* pQueues = tl_TaskWorkerInfo.m_pQueues)
+  {
+    pQueues->m_Queues[priority][uiLane].Push(entry);
+    return;
+  }
+
+  // threads that were not started by the task system have no deques of their own
+  NS_LOCK(s_pState->m_InjectedTasksMutex);
+  s_pState->m_InjectedTasks[priority][uiLane].PushBack(entry);
+  s_pState->m_uiNumInjectedTasks.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool nsTaskSystem::ClaimQueuedTask(const nsTaskQueueEntry& entry, TaskData& out_task)
+{
+  if (entry.m_uiLightTask != 0)
+  {
+    // light tasks are queued exactly once and cannot be canceled
+    out_task.m_uiLightTask = entry.m_uiLightTask;
+    return true;
+  }
+
+  nsTask* pTask = entry.m_pTask;
+
+  // take one of the runs that were not picked up yet, unless the entry belongs to an older scheduling or the runs got canceled
+  nsInt64 iState = pTask->m_iRunState;
+  while (true)
+  {
+    const nsUInt32 uiScheduleCounter = static_cast<nsUInt32>(static_cast<nsUInt64>(iState) >> 32);
+    const nsUInt32 uiRunsLeft = static_cast<nsUInt32>(iState & 0xFFFFFFFF);
+
+    if (uiScheduleCounter != entry.m_uiScheduleCounter || uiRunsLeft == 0)
+    {
+      // CancelTask() counted this entry, after this the task may get deallocated at any time
+      pTask->m_iCanceledQueueEntries.Decrement();
+      return false;
+    }
+
+    const nsInt64 iPrevState = pTask->m_iRunState.CompareAndSwap(iState, iState - 1);
+    if (iPrevState == iState)
+    {
+      // the group cannot finish before this run is finished, so its task list stays valid
+      nsTaskGroup* pGroup = pTask->m_BelongsToGroup.m_pTaskGroup;
+
+      out_task.m_pTask = pGroup->m_Tasks[pTask->m_uiIndexInGroup];
+      out_task.m_pBelongsToGroup = pGroup;
+      out_task.m_uiInvocation = pTask->m_uiScheduledRuns - uiRunsLeft;
+      return true;
+    }
+
+    iState = iPrevState;
+  }
+}
+
+bool nsTaskSystem::DequeueTask(nsTaskPriority::Enum priority, bool bOnlyTasksThatNeverWait, const nsTaskGroup* pWaitingForGroup, TaskData& out_task)
+{
+  nsTaskWorkerQueues* pOwnQueues = tl_TaskWorkerInfo.m_pQueues;
+  nsTaskQueueEntry entry;
+
+  for (nsUInt32 uiLane = 0; uiLane < nsTaskWorkerQueues::LaneCount; ++uiLane)
+  {
+    // a thread that waits inside a task may only pick up tasks that may nest, if they belong to the group it is waiting for
+    const bool bOnlyWaitedForGroup = bOnlyTasksThatNeverWait && uiLane == nsTaskWorkerQueues::MayNest;
+
+    if (bOnlyWaitedForGroup && pWaitingForGroup == nullptr)
+      continue;
+
+    // tasks of groups that were just unblocked by a dependency go before everything else
+    if (s_pState->m_uiNumUrgentTasks.load(std::memory_order_relaxed) > 0)
+    {
+      NS_LOCK(s_pState->m_UrgentTasksMutex);
+
+      nsDeque<nsTaskQueueEntry>& urgent = s_pState->m_UrgentTasks[priority][uiLane];
+      for (nsUInt32 i = 0; i < urgent.GetCount();)
+      {
+        if (bOnlyWaitedForGroup && urgent[i].m_pTask->m_BelongsToGroup.m_pTaskGroup != pWaitingForGroup)
+        {
+          ++i;
+          continue;
+        }
+
+        entry = urgent[i];
+        if (i == 0)
+          urgent.PopFront();
+        else
+          urgent.RemoveAtAndCopy(i);
+        s_pState->m_uiNumUrgentTasks.fetch_sub(1, std::memory_order_relaxed);
+
+        if (ClaimQueuedTask(entry, out_task))
+          return true;
+      }
+    }
+
+    // the own deque first
+    if (pOwnQueues != nullptr)
+    {
+      nsTaskDeque& ownQueue = pOwnQueues->m_Queues[priority][uiLane];
+
+      // frame and main thread tasks run in the order they were queued, otherwise a steady stream of new tasks could hold back
+      // older ones beyond their frame, see FinishFrameTasks() and ReprioritizeFrameTasks()
+      const bool bKeepOrder = priority < nsTaskPriority::LongRunningHighPriority || priority >= nsTaskPriority::ThisFrameMainThread;
+
+      if (bKeepOrder && !bOnlyWaitedForGroup)
+      {
+        // stealing from the own deque takes the oldest entry, it only fails when a thief was faster
+        while (ownQueue.GetCount() > 0)
+        {
+          if (ownQueue.Steal(entry) && ClaimQueuedTask(entry, out_task))
+            return true;
+        }
+      }
+
+      // otherwise the most recently queued tasks are the most likely to still be in the cache
+      while (ownQueue.Pop(entry))
+      {
+        if (bOnlyWaitedForGroup && entry.m_pTask->m_BelongsToGroup.m_pTaskGroup != pWaitingForGroup)
+        {
+          // only the bottom is looked at, tasks of the waited for group are usually queued last by this very thread
+          ownQueue.Push(entry);
+          break;
+        }
+
+        if (ClaimQueuedTask(entry, out_task))
+          return true;
+      }
+    }
+
+    if (bOnlyWaitedForGroup)
+      continue;
+
+    if (s_pState->m_uiNumInjectedTasks.load(std::memory_order_relaxed) > 0)
+    {
+      NS_LOCK(s_pState->m_InjectedTasksMutex);
+
+      nsDeque<nsTaskQueueEntry>& injected = s_pState->m_InjectedTasks[priority][uiLane];
+      while (!injected.IsEmpty())
+      {
+        entry = injected.PeekFront();
+        injected.PopFront();
+        s_pState->m_uiNumInjectedTasks.fetch_sub(1, std::memory_order_relaxed);
+
+        if (ClaimQueuedTask(entry, out_task))
+          return true;
+      }
+    }
+
+    // steal from everyone else, starting behind the own queues so that the thieves spread out
+    const nsUInt32 uiNumOwners = s_pState->m_uiNumQueueOwners.load(std::memory_order_acquire);
+    const nsUInt32 uiFirstOwner = pOwnQueues != nullptr ? pOwnQueues->m_uiOwnerIndex + 1 : 0;
+
+    for (nsUInt32 i = 0; i < uiNumOwners; ++i)
+    {
+      nsTaskWorkerQueues* pVictim = s_pState->m_QueueOwners[(uiFirstOwner + i) % uiNumOwners];
+
+      if (pVictim == pOwnQueues)
+        continue;
+
+      nsTaskDeque& victimQueue = pVictim->m_Queues[priority][uiLane];
+
+      // Steal() also fails when another thief was faster, so keep trying as long as there is something left
+      while (victimQueue.GetCount() > 0)
+      {
+        if (victimQueue.Steal(entry) && ClaimQueuedTask(entry, out_task))
+          return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+nsUInt32 nsTaskSystem::GetNumQueuedTasks(nsTaskPriority::Enum priority)
+{
+  nsUInt32 uiNumTasks = 0;
+
+  const nsUInt32 uiNumOwners = s_pState->m_uiNumQueueOwners.load(std::memory_order_acquire);
+  for (nsUInt32 i = 0; i < uiNumOwners; ++i)
+  {
+    for (nsUInt32 uiLane = 0; uiLane < nsTaskWorkerQueues::LaneCount; ++uiLane)
+    {
+      uiNumTasks += s_pState->m_QueueOwners[i]->m_Queues[priority][uiLane].GetCount();
+    }
+  }
+
+  if (s_pState->m_uiNumInjectedTasks.load(std::memory_order_relaxed) > 0)
+  {
+    NS_LOCK(s_pState->m_InjectedTasksMutex);
+
+    for (nsUInt32 uiLane = 0; uiLane < nsTaskWorkerQueues::LaneCount; ++uiLane)
+    {
+      uiNumTasks += s_pState->m_InjectedTasks[priority][uiLane].GetCount();
+    }
+  }
+
+  if (s_pState->m_uiNumUrgentTasks.load(std::memory_order_relaxed) > 0)
+  {
+    NS_LOCK(s_pState->m_UrgentTasksMutex);
+
+    for (nsUInt32 uiLane = 0; uiLane < nsTaskWorkerQueues::LaneCount; ++uiLane)
+    {
+      uiNumTasks += s_pState->m_UrgentTasks[priority][uiLane].GetCount();
+    }
+  }
+
+  return uiNumTasks;
+}
+
+bool nsTaskSystem::AreThreadQueuesEmpty(nsTaskPriority::Enum priority)
+{
+  nsTaskWorkerQueues* pQueues = tl_TaskWorkerInfo.m_pQueues;
+
+  if (pQueues == nullptr)
+  {
+    // tasks of unknown threads all end up in the same injection queues
+    return GetNumQueuedTasks(priority) == 0;
+  }
+
+  return pQueues->m_Queues[priority][nsTaskWorkerQueues::NeverNests].GetCount() == 0 &&
+         pQueues->m_Queues[priority][nsTaskWorkerQueues::MayNest].GetCount() == 0;
+}
+
+void nsTaskSystem::MoveQueuedTasks(nsTaskPriority::Enum from, nsTaskPriority::Enum to)
+{
+  nsTaskWorkerQueues* pOwnQueues = tl_TaskWorkerInfo.m_pQueues;
+  NS_ASSERT_DEV(pOwnQueues != nullptr, "Only the main thread can move tasks between priorities.");
+
+  nsTaskQueueEntry entry;
+
+  for (nsUInt32 uiLane = 0; uiLane < nsTaskWorkerQueues::LaneCount; ++uiLane)
+  {
+    nsTaskDeque& target = pOwnQueues->m_Queues[to][uiLane];
+
+    // other threads only allow stealing, so all the moved tasks end up in the deques of the calling thread, where the workers steal them from
+    const nsUInt32 uiNumOwners = s_pState->m_uiNumQueueOwners.load(std::memory_order_acquire);
+    for (nsUInt32 i = 0; i < uiNumOwners; ++i)
+    {
+      nsTaskDeque& source = s_pState->m_QueueOwners[i]->m_Queues[from][uiLane];
+
+      while (source.GetCount() > 0)
+      {
+        if (source.Steal(entry))
+        {
+          target.Push(entry);
+        }
+      }
+    }
+
+    if (s_pState->m_uiNumInjectedTasks.load(std::memory_order_relaxed) > 0)
+    {
+      NS_LOCK(s_pState->m_InjectedTasksMutex);
+
+      nsDeque<nsTaskQueueEntry>& injected = s_pState->m_InjectedTasks[from][uiLane];
+      while (!injected.IsEmpty())
+      {
+        target.Push(injected.PeekFront());
+        injected.PopFront();
+        s_pState->m_uiNumInjectedTasks.fetch_sub(1, std::memory_order_relaxed);
+      }
+    }
+
+    if (s_pState->m_uiNumUrgentTasks.load(std::memory_order_relaxed) > 0)
+    {
+      // urgent tasks stay urgent in their new priority
+      NS_LOCK(s_pState->m_UrgentTasksMutex);
+
+      nsDeque<nsTaskQueueEntry>& source = s_pState->m_UrgentTasks[from][uiLane];
+      nsDeque<nsTaskQueueEntry>& urgentTarget = s_pState->m_UrgentTasks[to][uiLane];
+      while (!source.IsEmpty())
+      {
+        urgentTarget.PushBack(source.PeekFront());
+        source.PopFront();
+      }
+    }
+  }
+}
+
+void nsTaskSystem::ReleaseCanceledTasks()
+{
+  NS_LOCK(s_pState->m_CanceledTasksMutex);
+
+  for (nsUInt32 i = s_pState->m_CanceledTasks.GetCount(); i > 0; --i)
+  {
+    if (s_pState->m_CanceledTasks[i - 1]->m_iCanceledQueueEntries == 0)
+    {
+      s_pState->m_CanceledTasks.RemoveAtAndSwap(i - 1);
+    }
   }
 }
 
@@ -94,29 +396,36 @@ nsTaskSystem::TaskData nsTaskSystem::GetNextTask(nsTaskPriority::Enum FirstPrior
   NS_ASSERT_DEV(FirstPriority >= nsTaskPriority::EarlyThisFrame && LastPriority < nsTaskPriority::ENUM_COUNT, "Priority Range is invalid: {0} to {1}",
     FirstPriority, LastPriority);
 
-  NS_LOCK(s_TaskSystemMutex);
+  TaskData td;
 
-  // go through all the task lists that this thread is willing to work on
-  for (nsUInt32 prio = FirstPriority; prio <= (nsUInt32)LastPriority; ++prio)
+  while (true)
   {
-    for (auto it = s_pState->m_Tasks[prio].GetIterator(); it.IsValid(); ++it)
+    // go through all the task queues that this thread is willing to work on
+    for (nsUInt32 prio = FirstPriority; prio <= (nsUInt32)LastPriority; ++prio)
     {
-      if (!bOnlyTasksThatNeverWait || (it->m_pTask->m_NestingMode == nsTaskNesting::Never) || it->m_pBelongsToGroup == WaitingForGroup.m_pTaskGroup)
-      {
-        TaskData td = *it;
-
-        s_pState->m_Tasks[prio].Remove(it);
+      if (DequeueTask((nsTaskPriority::Enum)prio, bOnlyTasksThatNeverWait, WaitingForGroup.m_pTaskGroup, td))
         return td;
-      }
     }
-  }
 
-  if (pWorkerState)
-  {
+    if (pWorkerState == nullptr)
+      return TaskData();
+
     NS_VERIFY(pWorkerState->Set((int)nsTaskWorkerState::Idle) == (int)nsTaskWorkerState::Active, "Corrupt Worker State");
-  }
 
-  return TaskData();
+    // a task may have been queued after we looked, but before we went idle, in that case no one would wake us up for it
+    // this fence pairs with the one in ScheduleGroupTasks()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool bAnyTasksQueued = false;
+    for (nsUInt32 prio = FirstPriority; prio <= (nsUInt32)LastPriority && !bAnyTasksQueued; ++prio)
+    {
+      bAnyTasksQueued = GetNumQueuedTasks((nsTaskPriority::Enum)prio) > 0;
+    }
+
+    // if someone else already woke us up, the worker runs straight through its wake up signal and comes back here
+    if (!bAnyTasksQueued || pWorkerState->CompareAndSwap((int)nsTaskWorkerState::Idle, (int)nsTaskWorkerState::Active) != (int)nsTaskWorkerState::Idle)
+      return TaskData();
+  }
 }
 
 bool nsTaskSystem::ExecuteTask(nsTaskPriority::Enum FirstPriority, nsTaskPriority::Enum LastPriority, bool bOnlyTasksThatNeverWait,
@@ -127,6 +436,12 @@ bool nsTaskSystem::ExecuteTask(nsTaskPriority::Enum FirstPriority, nsTaskPriorit
 
   nsTaskSystem::TaskData td = GetNextTask(FirstPriority, LastPriority, bOnlyTasksThatNeverWait, WaitingForGroup, pWorkerState);
 
+  if (td.m_uiLightTask != 0)
+  {
+    ExecuteLightTask(td.m_uiLightTask - 1);
+    return true;
+  }
+
   if (td.m_pTask == nullptr)
     return false;
 
@@ -162,42 +477,59 @@ nsResult nsTaskSystem::CancelTask(const nsSharedPtr<nsTask>& pTask, nsOnTaskRunn
   // we set the cancel flag, to make sure that tasks that support canceling will terminate asap
   pTask->m_bCancelExecution = true;
 
+  nsTaskGroup* pGroup = pTask->m_BelongsToGroup.m_pTaskGroup;
+
   {
-    NS_LOCK(s_TaskSystemMutex);
+    // ScheduleGroupTasks() queues the tasks of a group under this lock
+    NS_LOCK(pGroup->m_CondVarGroupFinished);
 
     // if the task is still in the queue of its group, it had not yet been scheduled
-    if (!pTask->m_bTaskIsScheduled && pTask->m_BelongsToGroup.m_pTaskGroup->m_Tasks.RemoveAndSwap(pTask))
+    if (!pTask->m_bTaskIsScheduled && pGroup->m_Tasks.RemoveAndSwap(pTask))
     {
       // we set the task to finished, even though it was not executed
       pTask->m_iRemainingRuns = 0;
       return NS_SUCCESS;
     }
+  }
 
-    // check if the task has already been scheduled for execution
-    // if so, remove it from the work queue
+  // the task has been scheduled for execution already
+  // take all of its runs that have not been picked up by any thread yet, their queue entries are skipped when they get dequeued
+  nsUInt32 uiCanceledRuns = 0;
+  {
+    nsInt64 iState = pTask->m_iRunState;
+    while ((iState & 0xFFFFFFFF) != 0)
     {
-      for (nsUInt32 i = 0; i < nsTaskPriority::ENUM_COUNT; ++i)
+      const nsInt64 iPrevState = pTask->m_iRunState.CompareAndSwap(iState, iState & ~static_cast<nsInt64>(0xFFFFFFFF));
+      if (iPrevState == iState)
       {
-        auto it = s_pState->m_Tasks[i].GetIterator();
+        uiCanceledRuns = static_cast<nsUInt32>(iState & 0xFFFFFFFF);
+        break;
+      }
 
-        while (it.IsValid())
-        {
-          if (it->m_pTask == pTask)
-          {
-            // we set the task to finished, even though it was not executed
-            pTask->m_iRemainingRuns = 0;
+      iState = iPrevState;
+    }
+  }
 
-            // tell the system that one task of that group is 'finished', to ensure its dependencies will get scheduled
-            TaskHasFinished(std::move(it->m_pTask), it->m_pBelongsToGroup);
+  if (uiCanceledRuns > 0)
+  {
+    // the group releases the task once it is finished, but the queue entries still point to it
+    pTask->m_iCanceledQueueEntries.Add(uiCanceledRuns);
 
-            s_pState->m_Tasks[i].Remove(it);
-            return NS_SUCCESS;
-          }
+    {
+      NS_LOCK(s_pState->m_CanceledTasksMutex);
+      s_pState->m_CanceledTasks.PushBack(pTask);
+    }
 
-          ++it;
-        }
-      }
+    // tell the system that these runs of the task are 'finished', to ensure its dependencies will get scheduled
+    const bool bNoneStarted = uiCanceledRuns == pTask->m_uiScheduledRuns;
+
+    for (nsUInt32 i = 0; i < uiCanceledRuns; ++i)
+    {
+      TaskHasFinished(nsSharedPtr<nsTask>(pTask), pGroup);
     }
+
+    if (bNoneStarted)
+      return NS_SUCCESS;
   }
 
   // if we made it here, the task was already running
@@ -227,55 +559,26 @@ bool nsTaskSystem::HelpExecutingTasks(const nsTaskGroupID& WaitingForGroup)
 void nsTaskSystem::ReprioritizeFrameTasks()
 {
   // There should usually be no 'this frame tasks' left at this time
-  // however, while we waited to enter the lock, such tasks might have appeared
+  // however, while we were finishing the frame, such tasks might have appeared
   // In this case we move them into the highest-priority 'this frame' queue, to ensure they will be executed asap
+  // Tasks that are queued while this is going on, are treated as if they were queued right after the frame change
   for (nsUInt32 i = (nsUInt32)nsTaskPriority::ThisFrame; i <= (nsUInt32)nsTaskPriority::LateThisFrame; ++i)
   {
-    auto it = s_pState->m_Tasks[i].GetIterator();
-
     // move all 'this frame' tasks into the 'early this frame' queue
-    while (it.IsValid())
-    {
-      s_pState->m_Tasks[nsTaskPriority::EarlyThisFrame].PushBack(*it);
-
-      ++it;
-    }
-
-    // remove the tasks from their current queue
-    s_pState->m_Tasks[i].Clear();
+    MoveQueuedTasks((nsTaskPriority::Enum)i, nsTaskPriority::EarlyThisFrame);
   }
 
   for (nsUInt32 i = (nsUInt32)nsTaskPriority::EarlyNextFrame; i <= (nsUInt32)nsTaskPriority::LateNextFrame; ++i)
   {
-    auto it = s_pState->m_Tasks[i].GetIterator();
-
     // move all 'next frame' tasks into the 'this frame' queues
-    while (it.IsValid())
-    {
-      s_pState->m_Tasks[i - 3].PushBack(*it);
-
-      ++it;
-    }
-
-    // remove the tasks from their current queue
-    s_pState->m_Tasks[i].Clear();
+    MoveQueuedTasks((nsTaskPriority::Enum)i, (nsTaskPriority::Enum)(i - 3));
   }
 
   for (nsUInt32 i = (nsUInt32)nsTaskPriority::In2Frames; i <= (nsUInt32)nsTaskPriority::In9Frames; ++i)
   {
-    auto it = s_pState->m_Tasks[i].GetIterator();
-
     // move all 'in N frames' tasks into the 'in N-1 frames' queues
     // moves 'In2Frames' into 'LateNextFrame'
-    while (it.IsValid())
-    {
-      s_pState->m_Tasks[i - 1].PushBack(*it);
-
-      ++it;
-    }
-
-    // remove the tasks from their current queue
-    s_pState->m_Tasks[i].Clear();
+    MoveQueuedTasks((nsTaskPriority::Enum)i, (nsTaskPriority::Enum)(i - 1));
   }
 }
 
@@ -313,12 +616,7 @@ void nsTaskSystem::ExecuteSomeFrameTasks(nsTime smoothFrameTime)
     CurTime = nsTime::Now();
   }
 
-  nsUInt32 uiNumTasksTodo = 0;
-
-  {
-    NS_LOCK(s_TaskSystemMutex);
-    uiNumTasksTodo = s_pState->m_Tasks[nsTaskPriority::SomeFrameMainThread].GetCount();
-  }
+  const nsUInt32 uiNumTasksTodo = GetNumQueuedTasks(nsTaskPriority::SomeFrameMainThread);
 
   if (uiNumTasksTodo == 0)
     return;
@@ -381,11 +679,9 @@ void nsTaskSystem::FinishFrameTasks()
 
   // all the important tasks for this frame should be finished or worked on by now
   // so we can now re-prioritize the tasks for the next frame
-  {
-    NS_LOCK(s_TaskSystemMutex);
+  ReprioritizeFrameTasks();
 
-    ReprioritizeFrameTasks();
-  }
+  ReleaseCanceledTasks();
 
   ExecuteSomeFrameTasks(s_pState->m_TargetFrameTime);
 
@@ -118,9 +118,19 @@ void nsTaskSystem::AllocateThreads(nsWorkerThreadType::Enum type, nsUInt32 uiAdd
     NS_ASSERT_ALWAYS(uiNextThreadIdx + uiAddThreads <= s_pThreadState->m_Workers[type].GetCount(), "Max number of worker threads ({}) exceeded.",
       s_pThreadState->m_Workers[type].GetCount());
 
+    nsDynamicArray<nsUInt32>& queueOwners = s_pState->m_WorkerQueueOwners[type];
+
     for (nsUInt32 i = 0; i < uiAddThreads; ++i)
     {
-      s_pThreadState->m_Workers[type][uiNextThreadIdx] = NS_DEFAULT_NEW(nsTaskWorkerThread, (nsWorkerThreadType::Enum)type, uiNextThreadIdx);
+      // a worker that replaces a stopped one takes over its queues, including the tasks that were left in them
+      if (uiNextThreadIdx >= queueOwners.GetCount())
+      {
+        queueOwners.PushBack(AllocateQueues()->m_uiOwnerIndex);
+      }
+
+      nsTaskWorkerQueues* pQueues = s_pState->m_QueueOwners[queueOwners[uiNextThreadIdx]];
+
+      s_pThreadState->m_Workers[type][uiNextThreadIdx] = NS_DEFAULT_NEW(nsTaskWorkerThread, (nsWorkerThreadType::Enum)type, uiNextThreadIdx, pQueues);
       s_pThreadState->m_Workers[type][uiNextThreadIdx]->Start();
 
       ++uiNextThreadIdx;
@@ -134,6 +144,21 @@ void nsTaskSystem::AllocateThreads(nsWorkerThreadType::Enum type, nsUInt32 uiAdd
     s_pThreadState->m_iAllocatedWorkers[type]);
 }
 
+nsTaskWorkerQueues* nsTaskSystem::AllocateQueues()
+{
+  const nsUInt32 uiOwnerIndex = s_pState->m_uiNumQueueOwners.load(std::memory_order_relaxed);
+  NS_ASSERT_ALWAYS(uiOwnerIndex < nsTaskSystemState::MaxQueueOwners, "Max number of task queues ({}) exceeded.", nsTaskSystemState::MaxQueueOwners);
+
+  nsTaskWorkerQueues* pQueues = NS_NEW(&s_pState->m_QueueAllocator, nsTaskWorkerQueues);
+  pQueues->m_uiOwnerIndex = uiOwnerIndex;
+
+  // publish the queues only once they are fully constructed, thieves iterate up to m_uiNumQueueOwners without a lock
+  s_pState->m_QueueOwners[uiOwnerIndex] = pQueues;
+  s_pState->m_uiNumQueueOwners.store(uiOwnerIndex + 1, std::memory_order_release);
+
+  return pQueues;
+}
+
 void nsTaskSystem::WakeUpThreads(nsWorkerThreadType::Enum type, nsUInt32 uiNumThreadsToWakeUp)
 {
   // together with nsTaskWorkerThread::Run() this function will make sure to keep the number
@@ -183,6 +208,52 @@ void nsTaskSystem::WakeUpThreads(nsWorkerThreadType::Enum type, nsUInt32 uiNumTh
   }
 }
 
+void nsTaskSystem::WakeUpThreadsForPriority(nsTaskPriority::Enum priority, nsUInt32 uiNumTasks)
+{
+  // send the proper thread signal, to make sure one of the correct worker threads is awake
+  switch (priority)
+  {
+    case nsTaskPriority::EarlyThisFrame:
+    case nsTaskPriority::ThisFrame:
+    case nsTaskPriority::LateThisFrame:
+    case nsTaskPriority::EarlyNextFrame:
+    case nsTaskPriority::NextFrame:
+    case nsTaskPriority::LateNextFrame:
+    case nsTaskPriority::In2Frames:
+    case nsTaskPriority::In3Frames:
+    case nsTaskPriority::In4Frames:
+    case nsTaskPriority::In5Frames:
+    case nsTaskPriority::In6Frames:
+    case nsTaskPriority::In7Frames:
+    case nsTaskPriority::In8Frames:
+    case nsTaskPriority::In9Frames:
+    {
+      WakeUpThreads(nsWorkerThreadType::ShortTasks, uiNumTasks);
+      break;
+    }
+
+    case nsTaskPriority::LongRunning:
+    case nsTaskPriority::LongRunningHighPriority:
+    {
+      WakeUpThreads(nsWorkerThreadType::LongTasks, uiNumTasks);
+      break;
+    }
+
+    case nsTaskPriority::FileAccess:
+    case nsTaskPriority::FileAccessHighPriority:
+    {
+      WakeUpThreads(nsWorkerThreadType::FileAccess, uiNumTasks);
+      break;
+    }
+
+    case nsTaskPriority::SomeFrameMainThread:
+    case nsTaskPriority::ThisFrameMainThread:
+    case nsTaskPriority::ENUM_COUNT:
+      // nothing to do for these enum values
+      break;
+  }
+}
+
 nsWorkerThreadType::Enum nsTaskSystem::GetCurrentThreadWorkerType()
 {
   return tl_TaskWorkerInfo.m_WorkerType;
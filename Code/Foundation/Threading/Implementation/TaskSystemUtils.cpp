@@ -4,6 +4,7 @@
 #include <Foundation/Logging/Log.h>
 #include <Foundation/Threading/Implementation/TaskGroup.h>
 #include <Foundation/Threading/Implementation/TaskSystemState.h>
+#include <Foundation/Threading/TaskGraph.h>
 #include <Foundation/Threading/TaskSystem.h>
 #include <Foundation/Time/Timestamp.h>
 #include <Foundation/Utilities/DGMLWriter.h>
@@ -73,9 +74,9 @@ void nsTaskSystem::WriteStateSnapshotToDGML(nsDGMLGraph& ref_graph)
   szTaskPriorityNames[nsTaskPriority::ThisFrameMainThread] = "ThisFrameMainThread";
   szTaskPriorityNames[nsTaskPriority::SomeFrameMainThread] = "SomeFrameMainThread";
 
-  for (nsUInt32 g = 0; g < s_pState->m_TaskGroups.GetCount(); ++g)
+  for (nsUInt32 g = 0; g < s_pState->m_uiNumTaskGroups; ++g)
   {
-    const nsTaskGroup& tg = s_pState->m_TaskGroups[g];
+    const nsTaskGroup& tg = s_pState->m_TaskGroupBlocks[g / nsTaskSystemState::TaskGroupsPerBlock][g % nsTaskSystemState::TaskGroupsPerBlock];
 
     if (!tg.m_bInUse)
       continue;
@@ -107,9 +108,9 @@ void nsTaskSystem::WriteStateSnapshotToDGML(nsDGMLGraph& ref_graph)
     }
   }
 
-  for (nsUInt32 g = 0; g < s_pState->m_TaskGroups.GetCount(); ++g)
+  for (nsUInt32 g = 0; g < s_pState->m_uiNumTaskGroups; ++g)
   {
-    const nsTaskGroup& tg = s_pState->m_TaskGroups[g];
+    const nsTaskGroup& tg = s_pState->m_TaskGroupBlocks[g / nsTaskSystemState::TaskGroupsPerBlock][g % nsTaskSystemState::TaskGroupsPerBlock];
 
     if (!tg.m_bInUse)
       continue;
@@ -133,6 +134,17 @@ void nsTaskSystem::WriteStateSnapshotToDGML(nsDGMLGraph& ref_graph)
       ref_graph.AddConnection(otherNodeId, ownNodeId);
     }
   }
+
+  if (nsTaskGraph::s_pFirstGraph != nullptr)
+  {
+    const nsDGMLGraph::PropertyId durationId = ref_graph.AddPropertyType("Duration");
+    const nsDGMLGraph::PropertyId criticalPathId = ref_graph.AddPropertyType("CriticalPath");
+
+    for (const nsTaskGraph* pGraph = nsTaskGraph::s_pFirstGraph; pGraph != nullptr; pGraph = pGraph->m_pNextGraph)
+    {
+      pGraph->WriteToDGML(ref_graph, durationId, criticalPathId);
+    }
+  }
 }
 
 void nsTaskSystem::WriteStateSnapshotToFile(const char* szPath /*= nullptr*/)
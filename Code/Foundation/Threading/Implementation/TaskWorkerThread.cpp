@@ -13,12 +13,13 @@ static nsString GenerateThreadName(nsWorkerThreadType::Enum threadType, nsUInt32
   return sTemp;
 }
 
-nsTaskWorkerThread::nsTaskWorkerThread(nsWorkerThreadType::Enum threadType, nsUInt32 uiThreadNumber)
+nsTaskWorkerThread::nsTaskWorkerThread(nsWorkerThreadType::Enum threadType, nsUInt32 uiThreadNumber, nsTaskWorkerQueues* pQueues)
   // We need at least 256 kb of stack size, otherwise the shader compilation tasks will run out of stack space.
   : nsThread(GenerateThreadName(threadType, uiThreadNumber), 256 * 1024)
 {
   m_WorkerType = threadType;
   m_uiWorkerThreadNumber = uiThreadNumber & 0xFFFF;
+  m_pQueues = pQueues;
 }
 
 nsTaskWorkerThread::~nsTaskWorkerThread() = default;
@@ -49,6 +50,7 @@ nsUInt32 nsTaskWorkerThread::Run()
   tl_TaskWorkerInfo.m_WorkerType = m_WorkerType;
   tl_TaskWorkerInfo.m_iWorkerIndex = m_uiWorkerThreadNumber;
   tl_TaskWorkerInfo.m_pWorkerState = &m_iWorkerState;
+  tl_TaskWorkerInfo.m_pQueues = m_pQueues;
 
   const bool bIsReserve = m_uiWorkerThreadNumber >= nsTaskSystem::s_pThreadState->m_uiMaxWorkersToUse[m_WorkerType];
 
@@ -15,7 +15,7 @@ class nsTaskWorkerThread final : public nsThread
 
 public:
   /// \brief Tells the worker thread what tasks to execute and which thread index it has.
-  nsTaskWorkerThread(nsWorkerThreadType::Enum threadType, nsUInt32 uiThreadNumber);
+  nsTaskWorkerThread(nsWorkerThreadType::Enum threadType, nsUInt32 uiThreadNumber, nsTaskWorkerQueues* pQueues);
   ~nsTaskWorkerThread();
 
   /// \brief Deactivates the thread. Returns failure, if the thread is currently still running.
@@ -31,6 +31,9 @@ private:
   // For display purposes.
   nsUInt16 m_uiWorkerThreadNumber = 0xFFFF;
 
+  // The deques into which this thread schedules tasks and from which it takes them first.
+  nsTaskWorkerQueues* m_pQueues = nullptr;
+
   ///@}
 
   /// \name Thread Utilization
@@ -85,6 +88,7 @@ struct nsTaskWorkerInfo
   nsInt32 m_iWorkerIndex = -1;
   const char* m_szTaskName = nullptr;
   nsAtomicInteger32* m_pWorkerState = nullptr;
+  nsTaskWorkerQueues* m_pQueues = nullptr;
 };
 
 extern thread_local nsTaskWorkerInfo tl_TaskWorkerInfo;
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <Foundation/Strings/String.h>
+#include <Foundation/Threading/TaskSystem.h>
+
+class nsDGMLGraph;
+
+/// \brief A graph of functions and their dependencies, that is recorded once and then launched any number of times.
+///
+/// Per-frame workloads often rebuild the same task groups with the same dependencies every frame. A task graph records that
+/// structure once: add nodes with AddNode(), connect them with AddDependency() and validate the result with Finalize().
+/// Afterwards Launch() only resets one counter per node and starts the nodes without dependencies. Every node that finishes
+/// starts the nodes that were only waiting for it. The nodes run as light tasks (see nsTaskSystem::StartLightTask()),
+/// so launching does not allocate memory.
+///
+/// The node functions are bound once. To give them new parameters for every launch, let them read from data that they
+/// reference and update that data before calling Launch().
+///
+/// The duration of every node is measured during each launch. GetCriticalPath() uses these to determine the chain of nodes
+/// that limits how fast the whole graph can finish. All task graphs that have nodes are included in
+/// nsTaskSystem::WriteStateSnapshotToDGML(), with their critical path highlighted.
+class NS_FOUNDATION_DLL nsTaskGraph
+{
+  NS_DISALLOW_COPY_AND_ASSIGN(nsTaskGraph);
+
+public:
+  nsTaskGraph(nsStringView sName = "Task Graph");
+  ~nsTaskGraph();
+
+  /// \name Recording
+  ///@{
+
+  /// \brief Adds a node that executes \a function. Returns the index of the node.
+  ///
+  /// Node functions run as light tasks and thus must not wait for other tasks.
+  nsUInt32 AddNode(nsStringView sName, nsLightTaskFunction function); // [tested]
+
+  /// \brief Makes \a uiNode wait for \a uiDependsOnNode to finish, every time the graph is launched.
+  void AddDependency(nsUInt32 uiNode, nsUInt32 uiDependsOnNode); // [tested]
+
+  /// \brief Validates the graph and prepares it for being launched. Fails, if the dependencies contain a cycle.
+  ///
+  /// Adding further nodes or dependencies requires calling Finalize() again.
+  nsResult Finalize(); // [tested]
+
+  /// \brief Removes all nodes and dependencies. Must not be called while the graph is running.
+  void Clear();
+
+  /// \brief Returns the number of nodes in the graph.
+  nsUInt32 GetNodeCount() const { return m_Nodes.GetCount(); }
+
+  ///@}
+
+  /// \name Running
+  ///@{
+
+  /// \brief Starts all nodes without dependencies, with the given priority. Requires a successful Finalize().
+  ///
+  /// If the previous launch is not finished yet, this waits for it first.
+  void Launch(nsTaskPriority::Enum priority = nsTaskPriority::ThisFrame); // [tested]
+
+  /// \brief Returns whether all nodes of the last launch are finished.
+  bool IsFinished() const { return m_iRemainingNodes == 0; } // [tested]
+
+  /// \brief Helps executing tasks until all nodes of the last launch are finished.
+  void WaitForFinish() const; // [tested]
+
+  ///@}
+
+  /// \name Analysis
+  ///@{
+
+  /// \brief Returns how long the node took during the last launch.
+  nsTime GetNodeDuration(nsUInt32 uiNode) const { return m_Nodes[uiNode].m_Duration; } // [tested]
+
+  /// \brief Determines the chain of dependent nodes with the largest total duration in the last launch, from first to last.
+  ///
+  /// Returns the total duration of that chain. Must not be called while the graph is running.
+  nsTime GetCriticalPath(nsDynamicArray<nsUInt32>& out_nodes) const; // [tested]
+
+  /// \brief Adds the graph's nodes and dependencies to \a ref_graph, with the critical path of the last launch highlighted.
+  void WriteToDGML(nsDGMLGraph& ref_graph) const;
+
+  ///@}
+
+private:
+  friend class nsTaskSystem;
+
+  struct Node
+  {
+    nsString m_sName;
+    nsLightTaskFunction m_Function;
+
+    // the nodes that wait for this one, as a range in m_Successors
+    nsUInt32 m_uiFirstSuccessor = 0;
+    nsUInt32 m_uiNumSuccessors = 0;
+
+    nsUInt32 m_uiNumDependencies = 0;
+    nsAtomicInteger32 m_iPendingDependencies;
+
+    nsTime m_Duration;
+  };
+
+  struct Dependency
+  {
+    NS_DECLARE_POD_TYPE();
+
+    nsUInt32 m_uiNode;
+    nsUInt32 m_uiDependsOnNode;
+  };
+
+  void StartNode(nsUInt32 uiNode);
+  void RunNode(nsUInt32 uiNode);
+
+  // adds the graph to the list of all graphs, the first time it gets a node
+  void Register();
+
+  // used by the task system snapshot, which registers the property types only once for all graphs
+  void WriteToDGML(nsDGMLGraph& ref_graph, nsUInt32 uiDurationPropertyId, nsUInt32 uiCriticalPathPropertyId) const;
+
+  nsString m_sName;
+
+  // guards the nodes and dependencies, which nsTaskSystem::WriteStateSnapshotToDGML() reads from other threads
+  mutable nsMutex m_Mutex;
+
+  nsDynamicArray<Node> m_Nodes;
+  nsDynamicArray<Dependency> m_Dependencies;
+  bool m_bFinalized = false;
+
+  // filled by Finalize()
+  nsDynamicArray<nsUInt32> m_Successors;
+  nsDynamicArray<nsUInt32> m_TopologicalOrder;
+
+  nsTaskPriority::Enum m_Priority = nsTaskPriority::ThisFrame;
+  nsAtomicInteger32 m_iRemainingNodes;
+
+  // all task graphs with nodes, for nsTaskSystem::WriteStateSnapshotToDGML(), guarded by nsTaskSystem::s_TaskSystemMutex
+  // graphs only register on first use, so that they can be static objects that are constructed before the task system's mutex
+  static nsTaskGraph* s_pFirstGraph;
+  bool m_bRegistered = false;
+  nsTaskGraph* m_pPrevGraph = nullptr;
+  nsTaskGraph* m_pNextGraph = nullptr;
+};
@@ -79,6 +79,9 @@ public:
     nsSharedPtr<nsTask> m_pTask;
     nsTaskGroup* m_pBelongsToGroup = nullptr;
     nsUInt32 m_uiInvocation = 0;
+
+    /// Index + 1 of a light task, in which case all other members are unused.
+    nsUInt32 m_uiLightTask = 0;
   };
 
 private:
@@ -103,6 +106,26 @@ private:
   /// \brief Helps executing tasks that are suitable for the calling thread. Returns true if a task was found and executed.
   static bool HelpExecutingTasks(const nsTaskGroupID& WaitingForGroup);
 
+  /// \brief Queues one run of a task. Goes into the calling thread's own deques, or the shared injection queues for unknown threads.
+  ///
+  /// With \a bHighPriority the run goes into the shared urgent queues instead, which all threads look at before any other queue.
+  static void QueueTask(nsTaskPriority::Enum priority, const nsTaskQueueEntry& entry, bool bMayNest, bool bHighPriority);
+
+  /// \brief Takes a task of exactly \a priority from the own deques, the injection queues or the deques of other threads.
+  static bool DequeueTask(nsTaskPriority::Enum priority, bool bOnlyTasksThatNeverWait, const nsTaskGroup* pWaitingForGroup, TaskData& out_task);
+
+  /// \brief Picks up the run that a dequeued entry stands for. Returns false for entries of canceled runs, which are just dropped.
+  static bool ClaimQueuedTask(const nsTaskQueueEntry& entry, TaskData& out_task);
+
+  /// \brief Returns the (approximate) number of queued runs with the given priority.
+  static nsUInt32 GetNumQueuedTasks(nsTaskPriority::Enum priority);
+
+  /// \brief Moves all queued runs of priority \a from to priority \a to. Only the main thread may do this.
+  static void MoveQueuedTasks(nsTaskPriority::Enum from, nsTaskPriority::Enum to);
+
+  /// \brief Releases canceled tasks once the task system does not reference them anymore.
+  static void ReleaseCanceledTasks();
+
   ///@}
 
   /// \name Managing Task Groups
@@ -171,13 +194,53 @@ public:
 
 private:
   /// \brief Takes all the tasks in the given group and schedules them for execution, by inserting them into the proper task lists.
+  ///
+  /// With \a bHighPriority the tasks are executed before all other queued tasks of the same priority.
   static void ScheduleGroupTasks(nsTaskGroup* pGroup, bool bHighPriority);
 
   /// \brief Is called whenever a dependency of pGroup has finished. Once all dependencies are finished, the group's tasks will get scheduled.
-  static void DependencyHasFinished(nsTaskGroup* pGroup);
+  ///
+  /// \a bHighPriority is passed on to ScheduleGroupTasks(), it is set when another group finished, but not when the group is started.
+  static void DependencyHasFinished(nsTaskGroup* pGroup, bool bHighPriority);
+
+  /// \brief Puts a finished group back onto the stack of unused groups.
+  static void FreeTaskGroup(nsTaskGroup* pGroup);
+
+  ///@}
+
+  /// \name Light Tasks
+  ///@{
+
+public:
+  /// \brief Starts a function as a light task and returns a handle to it.
+  ///
+  /// Light tasks are meant for very fine-grained work, where the cost of an nsTask would dominate. They are not reference counted
+  /// and do not belong to a task group. Instead they are taken from a per-thread pool and recycled as soon as they are finished.
+  /// Light tasks can neither be canceled nor wait for other tasks; use StartLightTaskAfter() to express dependencies.
+  static nsLightTaskHandle StartLightTask(nsLightTaskFunction function, nsTaskPriority::Enum priority = nsTaskPriority::ThisFrame); // [tested]
+
+  /// \brief Starts \a continuation as a light task, once the task referenced by \a hAntecedent has finished.
+  ///
+  /// The continuation is queued by the thread that finishes the antecedent, on its own queues, so it typically runs next on the same thread.
+  /// If the antecedent is already finished, the continuation is started right away.
+  static nsLightTaskHandle StartLightTaskAfter(nsLightTaskHandle hAntecedent, nsLightTaskFunction continuation, nsTaskPriority::Enum priority = nsTaskPriority::ThisFrame); // [tested]
+
+  /// \brief Returns whether the given light task is finished. Invalid handles count as finished.
+  static bool IsLightTaskFinished(nsLightTaskHandle hTask); // [tested]
+
+  /// \brief Helps executing tasks until the given light task is finished.
+  static void WaitForLightTask(nsLightTaskHandle hTask); // [tested]
+
+private:
+  static nsLightTask& GetLightTask(nsUInt32 uiIndex);
+  static nsUInt32 AllocateLightTask();
+  static void FreeLightTask(nsUInt32 uiIndex);
+  static void QueueLightTask(nsUInt32 uiIndex);
+  static void ExecuteLightTask(nsUInt32 uiIndex);
 
   ///@}
 
+
   /// \name Thread Management
   ///@{
 
@@ -217,6 +280,9 @@ public:
   /// \brief [internal] Wakes up or allocates up to \a uiNumThreads, unless enough threads are currently active and not blocked
   static void WakeUpThreads(nsWorkerThreadType::Enum type, nsUInt32 uiNumThreads);
 
+  /// \brief [internal] Wakes up the type of worker threads that executes tasks of the given priority, see WakeUpThreads().
+  static void WakeUpThreadsForPriority(nsTaskPriority::Enum priority, nsUInt32 uiNumTasks);
+
 private:
   friend class nsTaskWorkerThread;
 
@@ -226,6 +292,9 @@ private:
   /// \brief Shuts down all worker threads. Does NOT finish the remaining tasks that were not started yet. Does not clear them either, though.
   static void StopWorkerThreads();
 
+  /// \brief Creates a new set of task queues that thieves will look at. Must be called while s_TaskSystemMutex is locked.
+  static nsTaskWorkerQueues* AllocateQueues();
+
   /// \brief Uses a thread local variable to know the current thread type and to decide the range of task priorities that it may execute
   static void DetermineTasksToExecuteOnThread(nsTaskPriority::Enum& out_FirstPriority, nsTaskPriority::Enum& out_LastPriority);
 
@@ -275,6 +344,15 @@ private:
   static void ParallelForInternal(
     nsArrayPtr<ElemType> taskItems, nsParallelForFunction<ElemType> taskCallback, const char* taskName, const nsParallelForParams& params);
 
+  template <typename IndexType, typename Callback>
+  friend class AdaptiveIndexedTask;
+  friend class nsTaskGraph;
+
+  /// \brief Whether every task that the calling thread queued with the given priority has been picked up by some thread already.
+  ///
+  /// Adaptive parallel-for only splits off more work once the previous split was taken.
+  static bool AreThreadQueuesEmpty(nsTaskPriority::Enum priority);
+
   ///@}
 
   /// \name Utilities
@@ -307,7 +385,8 @@ private:
   static void Shutdown();
 
 private:
-  /// One mutex to rule them all.
+  /// Only guards the rare operations: allocating task groups and worker threads, and the state snapshot.
+  /// Scheduling and executing tasks goes through lock-free per-thread deques instead.
   static nsMutex s_TaskSystemMutex;
 
   static nsUniquePtr<nsTaskSystemState> s_pState;
@@ -37,6 +37,11 @@ public:
       const nsUInt32 srcStride = numBlocksX * 4 * 4;
       const nsUInt32 targetStride = numBlocksX * 16;
 
+      // each format keeps its own measured cost per row of blocks, the first chunks of every call adapt it to the image width
+      static nsParallelForAdaptiveGrainSize s_GrainSize;
+      nsParallelForParams params;
+      params.m_pAdaptiveGrainSize = &s_GrainSize;
+
       nsTaskSystem::ParallelForIndexed(0, numBlocksY, [srcStride, targetStride, source, target, numBlocksX](nsUInt32 startIndex, nsUInt32 endIndex)
         {
         const nsUInt8* srcIt = source.GetPtr() + srcStride * startIndex * 4;
@@ -60,7 +65,7 @@ public:
             targetIt += 16;
           }
           srcIt += 3 * srcStride;
-        } });
+        } }, "Compress BC7", nsTaskNesting::Never, params);
 
       return NS_SUCCESS;
     }
@@ -69,6 +74,10 @@ public:
       const nsUInt32 srcStride = numBlocksX * 4 * 4;
       const nsUInt32 targetStride = numBlocksX * 8;
 
+      static nsParallelForAdaptiveGrainSize s_GrainSize;
+      nsParallelForParams params;
+      params.m_pAdaptiveGrainSize = &s_GrainSize;
+
       nsTaskSystem::ParallelForIndexed(0, numBlocksY, [srcStride, targetStride, source, target, numBlocksX](nsUInt32 startIndex, nsUInt32 endIndex)
         {
         const nsUInt8* srcIt = source.GetPtr() + srcStride * startIndex * 4;
@@ -92,7 +101,7 @@ public:
             targetIt += 8;
           }
           srcIt += 3 * srcStride;
-        } });
+        } }, "Compress BC1", nsTaskNesting::Never, params);
 
       return NS_SUCCESS;
     }
@@ -101,6 +110,10 @@ public:
       const nsUInt32 srcStride = numBlocksX * 4 * 4 * sizeof(float);
       const nsUInt32 targetStride = numBlocksX * 16;
 
+      static nsParallelForAdaptiveGrainSize s_GrainSize;
+      nsParallelForParams params;
+      params.m_pAdaptiveGrainSize = &s_GrainSize;
+
       nsTaskSystem::ParallelForIndexed(0, numBlocksY, [srcStride, targetStride, source, target, numBlocksX](nsUInt32 startIndex, nsUInt32 endIndex)
         {
         const nsUInt8* srcIt = source.GetPtr() + srcStride * startIndex * 4;
@@ -124,7 +137,7 @@ public:
             targetIt += 16;
           }
           srcIt += 3 * srcStride;
-        } });
+        } }, "Compress BC6H", nsTaskNesting::Never, params);
 
       return NS_SUCCESS;
     }
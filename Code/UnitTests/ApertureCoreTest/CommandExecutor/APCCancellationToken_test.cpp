@@ -0,0 +1,150 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <APHTML/CommandExecutor/APCCancellationToken.h>
+#include <APHTML/CommandExecutor/IAPCCommand.h>
+#include <APHTML/CommandExecutor/IAPCCommandList.h>
+#include <APHTML/CommandExecutor/IAPCCommandQueue.h>
+#include <APHTML/Multithreading/APCJobSystem.h>
+
+namespace
+{
+  using namespace aperture::core;
+
+  /// A queue of four commands, the second one cancels the queue's token.
+  struct CancelingQueue
+  {
+    IAPCCommandQueue m_Queue;
+    IAPCCommandList m_List;
+    IAPCCommand m_Commands[4];
+    nsUInt32 m_uiExecuted = 0;
+    bool m_bSawCancellation = false;
+
+    explicit CancelingQueue(APCCancellationToken& ref_token)
+    {
+      m_Queue.Reset(CommandType::Layout, Runtype::FreeThread_Layout);
+      m_List.Reset(&m_Queue, CommandType::Layout, Runtype::FreeThread_Layout);
+      for (nsUInt32 i = 0; i < 4; ++i)
+      {
+        m_Commands[i].Reset(CommandType::Layout, Runtype::FreeThread_Layout);
+        m_List.AddCommand(m_Commands[i]);
+      }
+      m_Commands[0].SetFunction([this]()
+        { m_uiExecuted++; });
+      m_Commands[1].SetFunction([this, &ref_token]()
+        {
+        m_uiExecuted++;
+        ref_token.Cancel();
+        m_bSawCancellation = m_Commands[1].IsCancellationRequested(); });
+      m_Commands[2].SetFunction([this]()
+        { m_uiExecuted++; });
+      m_Commands[3].SetFunction([this]()
+        { m_uiExecuted++; });
+      m_Queue.AddCommandList(m_List);
+      m_Queue.SetCancellationToken(&ref_token);
+    }
+  };
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(CommandExecutor, APCCancellationToken)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Propagation")
+  {
+    APCCancellationToken parse, compile, run;
+    parse.AddDependent(compile);
+    compile.AddDependent(run);
+    run.AddDependent(parse);
+
+    compile.Cancel();
+    NS_TEST_BOOL(parse.IsCanceled());
+    NS_TEST_BOOL(compile.IsCanceled());
+    NS_TEST_BOOL(run.IsCanceled());
+
+    APCCancellationToken late;
+    parse.AddDependent(late);
+    NS_TEST_BOOL(late.IsCanceled());
+
+    parse.Reset();
+    compile.Reset();
+    run.Reset();
+    run.RemoveDependent(parse);
+    run.Cancel();
+    NS_TEST_BOOL(!parse.IsCanceled());
+    NS_TEST_BOOL(!compile.IsCanceled());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Interrupt a running queue")
+  {
+    APCCancellationToken token;
+    CancelingQueue rec(token);
+
+    NS_TEST_BOOL(rec.m_Queue.Execute(false).Succeeded());
+    NS_TEST_INT(rec.m_uiExecuted, 2);
+    NS_TEST_BOOL(rec.m_bSawCancellation);
+    NS_TEST_INT(rec.m_Queue.GetLastCanceledCommandCount(), 2);
+
+    const APCCancellationStats stats = token.GetStats();
+    NS_TEST_INT(stats.m_uiInterruptedQueues, 1);
+    NS_TEST_INT(stats.m_uiSkippedQueues, 0);
+    NS_TEST_INT(stats.m_uiSkippedCommands, 2);
+
+    // The priority and budgeted paths stop at the same point.
+    token.Reset();
+    rec.m_uiExecuted = 0;
+    NS_TEST_BOOL(rec.m_Queue.Execute().Succeeded());
+    NS_TEST_INT(rec.m_uiExecuted, 2);
+
+    token.Reset();
+    rec.m_uiExecuted = 0;
+    APCQueueExecutionStats budgetStats;
+    NS_TEST_BOOL(rec.m_Queue.ExecuteBudgeted(nsTime::MakeFromSeconds(10), &budgetStats).Succeeded());
+    NS_TEST_INT(rec.m_uiExecuted, 2);
+    NS_TEST_INT(budgetStats.m_uiCanceledCommands, 2);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Skip queued jobs")
+  {
+    threading::APCJobSystem jobSystem;
+    jobSystem.InitializeJobSystem({0, 0, 0, 0, false});
+
+    APCCancellationToken group, dependent;
+    group.AddDependent(dependent);
+    CancelingQueue first(group);
+    CancelingQueue second(dependent);
+    CancelingQueue third(dependent);
+
+    // Without workers nothing runs until Wait(), so all three are still queued when the token gets canceled.
+    jobSystem.AddJob(first.m_Queue);
+    jobSystem.AddJob(second.m_Queue);
+    jobSystem.AddJob(third.m_Queue);
+    NS_TEST_BOOL(jobSystem.CancelJob(third.m_Queue.GetJobID(), third.m_Queue).Succeeded());
+    group.Cancel();
+    jobSystem.Wait();
+    jobSystem.PublishFrameStats();
+
+    NS_TEST_INT(first.m_uiExecuted, 0);
+    NS_TEST_INT(second.m_uiExecuted, 0);
+    NS_TEST_INT(third.m_uiExecuted, 0);
+    NS_TEST_BOOL(third.m_Queue.GetJobState() == APCJobState::Idle);
+    NS_TEST_INT(group.GetStats().m_uiSkippedQueues, 1);
+    NS_TEST_INT(dependent.GetStats().m_uiSkippedQueues, 2);
+    NS_TEST_INT(dependent.GetStats().m_uiSkippedCommands, 8);
+
+    for (const threading::APCJobPoolFrameStats& poolStats : jobSystem.GetLastFrameStats().m_Pools)
+    {
+      if (poolStats.m_Runtype == Runtype::FreeThread_Layout)
+      {
+        NS_TEST_INT(poolStats.m_uiCanceledJobs, 3);
+        NS_TEST_INT(poolStats.m_uiCanceledCommands, 12);
+      }
+    }
+
+    // A new submission clears the request, the token decides on its own again.
+    group.Reset();
+    dependent.Reset();
+    jobSystem.AddJob(third.m_Queue);
+    jobSystem.Wait();
+    NS_TEST_INT(third.m_uiExecuted, 2);
+
+    jobSystem.Shutdown();
+  }
+}
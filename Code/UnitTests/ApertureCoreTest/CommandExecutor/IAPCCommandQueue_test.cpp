@@ -0,0 +1,149 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <Foundation/Threading/ThreadUtils.h>
+
+#include <APHTML/CommandExecutor/IAPCCommand.h>
+#include <APHTML/CommandExecutor/IAPCCommandList.h>
+#include <APHTML/CommandExecutor/IAPCCommandQueue.h>
+
+NS_CREATE_SIMPLE_TEST_GROUP(CommandExecutor);
+
+namespace
+{
+  using namespace aperture::core;
+
+  /// A queue with two lists of commands that record the order in which they ran.
+  struct RecordingQueue
+  {
+    IAPCCommandQueue m_Queue;
+    IAPCCommandList m_Lists[2];
+    IAPCCommand m_Commands[6];
+    nsHybridArray<nsUInt32, 16> m_Order;
+
+    RecordingQueue()
+    {
+      m_Queue.Reset(CommandType::Layout, Runtype::FreeThread_Layout);
+      for (IAPCCommandList& list : m_Lists)
+      {
+        list.Reset(&m_Queue, CommandType::Layout, Runtype::FreeThread_Layout);
+      }
+      for (nsUInt32 i = 0; i < 6; ++i)
+      {
+        m_Commands[i].Reset(CommandType::Layout, Runtype::FreeThread_Layout);
+        m_Commands[i].SetFunction([this, i]()
+          { m_Order.PushBack(i); });
+        m_Lists[i / 3].AddCommand(m_Commands[i]);
+      }
+      m_Queue.AddCommandList(m_Lists[0]);
+      m_Queue.AddCommandList(m_Lists[1]);
+    }
+  };
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(CommandExecutor, IAPCCommandQueue)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Insertion order")
+  {
+    RecordingQueue rec;
+    rec.m_Commands[4].SetPriority(CommandPriority::InputCritical);
+
+    NS_TEST_BOOL(rec.m_Queue.Execute(false).Succeeded());
+    NS_TEST_INT(rec.m_Order.GetCount(), 6);
+    for (nsUInt32 i = 0; i < rec.m_Order.GetCount(); ++i)
+    {
+      NS_TEST_INT(rec.m_Order[i], i);
+    }
+
+    rec.m_Order.Clear();
+    rec.m_Queue.ExecuteResidentCommandList(1);
+    NS_TEST_INT(rec.m_Order.GetCount(), 3);
+    NS_TEST_INT(rec.m_Order[0], 3);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Priority and deadlines")
+  {
+    RecordingQueue rec;
+    const nsTime now = nsTime::Now();
+    rec.m_Commands[0].SetPriority(CommandPriority::Deferrable);
+    rec.m_Commands[5].SetPriority(CommandPriority::InputCritical);
+    rec.m_Commands[3].SetDeadline(now + nsTime::MakeFromSeconds(2));
+    rec.m_Commands[2].SetDeadline(now + nsTime::MakeFromSeconds(1));
+
+    NS_TEST_BOOL(rec.m_Queue.Execute().Succeeded());
+
+    // Input critical first, then frame critical by deadline, then in insertion order, deferrable last.
+    const nsUInt32 expected[] = {5, 2, 3, 1, 4, 0};
+    NS_TEST_INT(rec.m_Order.GetCount(), 6);
+    for (nsUInt32 i = 0; i < rec.m_Order.GetCount(); ++i)
+    {
+      NS_TEST_INT(rec.m_Order[i], expected[i]);
+    }
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Budget")
+  {
+    RecordingQueue rec;
+    rec.m_Commands[1].SetFunction([&rec]()
+      {
+      rec.m_Order.PushBack(1);
+      nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(5)); });
+    rec.m_Commands[3].SetPriority(CommandPriority::Deferrable);
+    rec.m_Commands[4].SetPriority(CommandPriority::Deferrable);
+    // Already due, so it runs although the budget is used up.
+    rec.m_Commands[4].SetDeadline(nsTime::Now());
+
+    APCQueueExecutionStats stats;
+    NS_TEST_BOOL(rec.m_Queue.ExecuteBudgeted(nsTime::MakeFromMilliseconds(1), &stats).Succeeded());
+    NS_TEST_INT(stats.m_uiExecutedCommands, 5);
+    NS_TEST_INT(stats.m_uiDeferredCommands, 1);
+    NS_TEST_INT(stats.m_uiMissedDeadlines, 1);
+    NS_TEST_BOOL(stats.m_ExecutionTime >= nsTime::MakeFromMilliseconds(5));
+    NS_TEST_INT(rec.m_Queue.GetDeferredCommandCount(), 1);
+    NS_TEST_INT(rec.m_Order.GetCount(), 5);
+    NS_TEST_BOOL(!rec.m_Order.Contains(3));
+
+    // The next frame brings no new work, the carried over command runs through the queue's own budget.
+    rec.m_Order.Clear();
+    rec.m_Queue.ClearQueue();
+    rec.m_Queue.SetExecutionBudget(nsTime::MakeFromMilliseconds(100));
+    NS_TEST_BOOL(rec.m_Queue.Execute().Succeeded());
+    NS_TEST_INT(rec.m_Order.GetCount(), 1);
+    NS_TEST_INT(rec.m_Order[0], 3);
+    NS_TEST_INT(rec.m_Queue.GetLastExecutionStats().m_uiExecutedCommands, 1);
+    NS_TEST_INT(rec.m_Queue.GetLastExecutionStats().m_uiDeferredCommands, 0);
+    NS_TEST_INT(rec.m_Queue.GetDeferredCommandCount(), 0);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Budget without clearing the lists")
+  {
+    RecordingQueue rec;
+    rec.m_Commands[1].SetFunction([&rec]()
+      {
+      rec.m_Order.PushBack(1);
+      nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(5)); });
+    rec.m_Commands[3].SetPriority(CommandPriority::Deferrable);
+
+    NS_TEST_BOOL(rec.m_Queue.ExecuteBudgeted(nsTime::MakeFromMilliseconds(1)).Succeeded());
+    NS_TEST_INT(rec.m_Order.GetCount(), 5);
+    NS_TEST_INT(rec.m_Queue.GetDeferredCommandCount(), 1);
+    NS_TEST_INT(rec.m_Queue.GetCommandCount(), 6);
+
+    // The lists stay in the queue, the carried over command must not be scheduled a second time through its list.
+    rec.m_Order.Clear();
+    APCQueueExecutionStats stats;
+    NS_TEST_BOOL(rec.m_Queue.ExecuteBudgeted(nsTime::MakeFromMilliseconds(100), &stats).Succeeded());
+    NS_TEST_INT(stats.m_uiExecutedCommands, 6);
+    NS_TEST_INT(stats.m_uiDeferredCommands, 0);
+    NS_TEST_INT(rec.m_Order.GetCount(), 6);
+
+    nsUInt32 uiExecutions[6] = {};
+    for (nsUInt32 uiCommand : rec.m_Order)
+    {
+      ++uiExecutions[uiCommand];
+    }
+    for (nsUInt32 i = 0; i < 6; ++i)
+    {
+      NS_TEST_INT(uiExecutions[i], 1);
+    }
+  }
+}
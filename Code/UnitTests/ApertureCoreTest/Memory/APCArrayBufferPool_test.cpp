@@ -0,0 +1,175 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Memory/MemoryTracker.h>
+#include <Foundation/System/SystemInformation.h>
+#include <Foundation/Time/Time.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+#include <APHTML/Interfaces/Internal/APCArrayBufferPool.h>
+
+namespace
+{
+  enum ArrayBufferConstants
+  {
+    NUM_CHURN_ROUNDS = 20000,
+    NUM_CHURN_BUFFERS = 16,
+  };
+
+  bool IsZero(const void* pBuffer, size_t uiBytes)
+  {
+    const nsUInt8* pBytes = static_cast<const nsUInt8*>(pBuffer);
+    for (size_t i = 0; i < uiBytes; ++i)
+    {
+      if (pBytes[i] != 0)
+        return false;
+    }
+    return true;
+  }
+
+  /// Sizes of the typed arrays that a script streaming vertex data or decoding JSON creates.
+  size_t GetChurnSize(nsUInt32 uiRound)
+  {
+    const nsUInt32 uiHash = (uiRound * 2654435761u) >> 8;
+    return 64 + uiHash % (16 * 1024);
+  }
+} // namespace
+
+// Enable when needed
+#define NS_PERFORMANCE_TESTS_STATE nsTestBlock::DisabledNoWarning
+
+NS_CREATE_SIMPLE_TEST(Memory, APCArrayBufferPool)
+{
+  using aperture::core::APCArrayBufferPool;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Zeroed Memory")
+  {
+    const APCArrayBufferPool::Stats before = APCArrayBufferPool::GetStats();
+
+    nsUInt8* pBuffer = static_cast<nsUInt8*>(APCArrayBufferPool::Allocate(1000));
+    NS_TEST_BOOL(pBuffer != nullptr);
+    NS_TEST_BOOL(nsMemoryUtils::IsAligned(pBuffer, 16));
+    NS_TEST_BOOL(IsZero(pBuffer, 1024));
+
+    NS_TEST_INT(APCArrayBufferPool::GetStats().m_uiLiveBytes - before.m_uiLiveBytes, 1000);
+    NS_TEST_INT(APCArrayBufferPool::GetStats().m_uiLiveBuffers - before.m_uiLiveBuffers, 1);
+
+    nsMemoryUtils::PatternFill(pBuffer, 0xAB, 1000);
+    APCArrayBufferPool::Free(pBuffer, 1000);
+
+    NS_TEST_INT(APCArrayBufferPool::GetStats().m_uiLiveBytes, before.m_uiLiveBytes);
+    NS_TEST_INT(APCArrayBufferPool::GetStats().m_uiLiveBuffers, before.m_uiLiveBuffers);
+
+    // a buffer of the same size class reuses the block, and it is zero again
+    nsUInt8* pReused = static_cast<nsUInt8*>(APCArrayBufferPool::Allocate(600));
+    NS_TEST_BOOL(pReused == pBuffer);
+    NS_TEST_BOOL(IsZero(pReused, 1024));
+    APCArrayBufferPool::Free(pReused, 600);
+
+    // empty buffers are valid, too
+    void* pEmpty = APCArrayBufferPool::Allocate(0);
+    NS_TEST_BOOL(pEmpty != nullptr);
+    APCArrayBufferPool::Free(pEmpty, 0);
+
+    APCArrayBufferPool::Free(nullptr, 0);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Large Buffers")
+  {
+    const size_t uiBytes = 1024 * 1024 + 3;
+    const APCArrayBufferPool::Stats before = APCArrayBufferPool::GetStats();
+
+    nsUInt8* pBuffer = static_cast<nsUInt8*>(APCArrayBufferPool::Allocate(uiBytes));
+    NS_TEST_BOOL(nsMemoryUtils::IsAligned(pBuffer, nsSystemInformation::Get().GetMemoryPageSize()));
+    NS_TEST_BOOL(IsZero(pBuffer, uiBytes));
+    NS_TEST_BOOL(APCArrayBufferPool::GetStats().m_uiReservedBytes - before.m_uiReservedBytes >= uiBytes);
+
+    nsMemoryUtils::PatternFill(pBuffer, 0xCD, uiBytes);
+    APCArrayBufferPool::Free(pBuffer, uiBytes);
+
+    // large buffers are given back right away
+    NS_TEST_INT(APCArrayBufferPool::GetStats().m_uiReservedBytes, before.m_uiReservedBytes);
+    NS_TEST_INT(APCArrayBufferPool::GetStats().m_uiPooledBytes, before.m_uiPooledBytes);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Out of Memory")
+  {
+    const APCArrayBufferPool::Stats before = APCArrayBufferPool::GetStats();
+
+    {
+      nsTestLogInterface log;
+      nsTestLogSystemScope logSystemScope(&log);
+      log.ExpectMessage("Could not allocate", nsLogMsgType::ErrorMsg, 1);
+
+      // more than any address space has
+      NS_TEST_BOOL(APCArrayBufferPool::Allocate(size_t(1) << 62) == nullptr);
+    }
+
+    const APCArrayBufferPool::Stats after = APCArrayBufferPool::GetStats();
+    NS_TEST_INT(after.m_uiAllocations, before.m_uiAllocations);
+    NS_TEST_INT(after.m_uiLiveBuffers, before.m_uiLiveBuffers);
+    NS_TEST_INT(after.m_uiLiveBytes, before.m_uiLiveBytes);
+    NS_TEST_INT(after.m_uiReservedBytes, before.m_uiReservedBytes);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Memory Tracker")
+  {
+    void* pBuffer = APCArrayBufferPool::Allocate(5000);
+    APCArrayBufferPool::UpdateTrackerStats();
+
+    const nsAllocator::Stats stats = nsMemoryTracker::GetAllocatorStats(APCArrayBufferPool::GetAllocatorId());
+    NS_TEST_INT(stats.m_uiAllocationSize, APCArrayBufferPool::GetStats().m_uiLiveBytes);
+    NS_TEST_BOOL(stats.m_uiAllocationSize >= 5000);
+
+    APCArrayBufferPool::Free(pBuffer, 5000);
+    APCArrayBufferPool::UpdateTrackerStats();
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Typed Array Churn")
+  {
+    void* buffers[NUM_CHURN_BUFFERS] = {};
+    size_t sizes[NUM_CHURN_BUFFERS] = {};
+    nsAllocator* pAllocator = nsFoundation::GetAlignedAllocator();
+
+    // what V8EArrayBufferAlloc did before, plus the memset that V8 requires
+    const nsTime tA0 = nsTime::Now();
+    for (nsUInt32 uiRound = 0; uiRound < NUM_CHURN_ROUNDS; ++uiRound)
+    {
+      const nsUInt32 uiSlot = uiRound % NUM_CHURN_BUFFERS;
+      if (buffers[uiSlot] != nullptr)
+      {
+        pAllocator->Deallocate(buffers[uiSlot]);
+      }
+
+      sizes[uiSlot] = GetChurnSize(uiRound);
+      buffers[uiSlot] = pAllocator->Allocate(sizes[uiSlot], 16);
+      nsMemoryUtils::ZeroFill(static_cast<nsUInt8*>(buffers[uiSlot]), sizes[uiSlot]);
+      static_cast<nsUInt8*>(buffers[uiSlot])[0] = 1;
+    }
+    for (nsUInt32 uiSlot = 0; uiSlot < NUM_CHURN_BUFFERS; ++uiSlot)
+    {
+      pAllocator->Deallocate(buffers[uiSlot]);
+      buffers[uiSlot] = nullptr;
+    }
+    const nsTime tA1 = nsTime::Now();
+
+    const nsTime tB0 = nsTime::Now();
+    for (nsUInt32 uiRound = 0; uiRound < NUM_CHURN_ROUNDS; ++uiRound)
+    {
+      const nsUInt32 uiSlot = uiRound % NUM_CHURN_BUFFERS;
+      APCArrayBufferPool::Free(buffers[uiSlot], sizes[uiSlot]);
+
+      sizes[uiSlot] = GetChurnSize(uiRound);
+      buffers[uiSlot] = APCArrayBufferPool::Allocate(sizes[uiSlot]);
+      static_cast<nsUInt8*>(buffers[uiSlot])[0] = 1;
+    }
+    for (nsUInt32 uiSlot = 0; uiSlot < NUM_CHURN_BUFFERS; ++uiSlot)
+    {
+      APCArrayBufferPool::Free(buffers[uiSlot], sizes[uiSlot]);
+    }
+    const nsTime tB1 = nsTime::Now();
+
+    nsLog::Info("[test]{0} ArrayBuffers: aligned allocator and memset {1}ms, APCArrayBufferPool {2}ms, {3} KB reserved", NUM_CHURN_ROUNDS,
+      nsArgF((tA1 - tA0).GetMilliseconds(), 2), nsArgF((tB1 - tB0).GetMilliseconds(), 2), APCArrayBufferPool::GetStats().m_uiReservedBytes / 1024);
+  }
+}
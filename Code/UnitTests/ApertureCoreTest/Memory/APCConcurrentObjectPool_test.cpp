@@ -0,0 +1,279 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Time/Time.h>
+
+#include <APHTML/Interfaces/Internal/APCConcurrentObjectPool.h>
+#include <APHTML/Interfaces/Internal/APCObjectPool.h>
+
+#include <mutex>
+#include <thread>
+
+namespace
+{
+  enum ObjectPoolConstants
+  {
+    NUM_POOL_THREADS = 8,
+#if NS_ENABLED(NS_COMPILE_FOR_DEBUG)
+    NUM_POOL_ROUNDS = 200,
+#else
+    NUM_POOL_ROUNDS = 2000,
+#endif
+    NUM_POOL_BATCH = 100,
+  };
+
+  /// Stands in for a DOM or layout node.
+  struct PoolNode
+  {
+    PoolNode() = default;
+    PoolNode(nsUInt32 uiValue, std::atomic<nsInt32>* pAlive)
+      : m_uiValue(uiValue)
+      , m_pAlive(pAlive)
+    {
+      if (m_pAlive)
+        m_pAlive->fetch_add(1);
+    }
+
+    ~PoolNode()
+    {
+      if (m_pAlive)
+        m_pAlive->fetch_sub(1);
+    }
+
+    nsUInt32 m_uiValue = 0;
+    std::atomic<nsInt32>* m_pAlive = nullptr;
+    nsUInt8 m_Payload[48] = {};
+  };
+
+  /// Allocates and deletes batches on every thread. Every other batch is handed to the next thread, which deletes it.
+  template <typename NewFunc, typename DeleteFunc>
+  bool RunPoolThreads(NewFunc newFunc, DeleteFunc deleteFunc)
+  {
+    std::mutex handoverMutex;
+    nsDynamicArray<PoolNode*> handover[NUM_POOL_THREADS];
+    std::atomic<bool> bValid = true;
+
+    nsHybridArray<std::thread, NUM_POOL_THREADS> threads;
+    for (nsUInt32 t = 0; t < NUM_POOL_THREADS; ++t)
+    {
+      threads.PushBack(std::thread([&, t]()
+        {
+        PoolNode* batch[NUM_POOL_BATCH];
+
+        for (nsUInt32 uiRound = 0; uiRound < NUM_POOL_ROUNDS; ++uiRound)
+        {
+          for (nsUInt32 i = 0; i < NUM_POOL_BATCH; ++i)
+            batch[i] = newFunc(t * NUM_POOL_BATCH + i);
+
+          for (nsUInt32 i = 0; i < NUM_POOL_BATCH; ++i)
+          {
+            if (batch[i]->m_uiValue != t * NUM_POOL_BATCH + i)
+              bValid = false;
+          }
+
+          if (uiRound % 2 == 0)
+          {
+            std::lock_guard<std::mutex> lock(handoverMutex);
+            handover[(t + 1) % NUM_POOL_THREADS].PushBackRange(nsArrayPtr<PoolNode*>(batch));
+          }
+          else
+          {
+            for (nsUInt32 i = 0; i < NUM_POOL_BATCH; ++i)
+              deleteFunc(batch[i]);
+          }
+
+          nsDynamicArray<PoolNode*> received;
+          {
+            std::lock_guard<std::mutex> lock(handoverMutex);
+            received.Swap(handover[t]);
+          }
+
+          for (PoolNode* pNode : received)
+            deleteFunc(pNode);
+        } }));
+    }
+
+    for (std::thread& thread : threads)
+    {
+      thread.join();
+    }
+
+    for (nsUInt32 t = 0; t < NUM_POOL_THREADS; ++t)
+    {
+      for (PoolNode* pNode : handover[t])
+        deleteFunc(pNode);
+    }
+
+    return bValid;
+  }
+} // namespace
+
+// Enable when needed
+#define NS_PERFORMANCE_TESTS_STATE nsTestBlock::DisabledNoWarning
+
+NS_CREATE_SIMPLE_TEST(Memory, APCConcurrentObjectPool)
+{
+  using Pool = aperture::core::APCConcurrentObjectPool<PoolNode>;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "New and Delete")
+  {
+    std::atomic<nsInt32> iAlive = 0;
+    Pool pool;
+
+    nsDynamicArray<PoolNode*> nodes;
+    for (nsUInt32 i = 0; i < 1000; ++i)
+    {
+      nodes.PushBack(pool.New(i, &iAlive));
+    }
+
+    NS_TEST_INT(iAlive, 1000);
+    NS_TEST_INT(nodes[999]->m_uiValue, 999);
+    NS_TEST_BOOL(nsMemoryUtils::IsAligned(nodes[0], alignof(PoolNode)));
+
+    Pool::Stats stats = pool.GetStats();
+    NS_TEST_INT(stats.m_uiLiveObjects, 1000);
+    NS_TEST_INT(stats.m_uiPeakObjects, 1000);
+    NS_TEST_INT(stats.m_uiNumNodes, 4);
+    NS_TEST_INT(stats.m_uiCapacity, 1024);
+
+    for (PoolNode* pNode : nodes)
+    {
+      pool.Delete(pNode);
+    }
+
+    NS_TEST_INT(iAlive, 0);
+
+    stats = pool.GetStats();
+    NS_TEST_INT(stats.m_uiLiveObjects, 0);
+
+    // the peak is sampled when a magazine goes to the depot, so it may miss the deletes of the last two magazines
+    NS_TEST_BOOL(stats.m_uiPeakObjects <= 1000 && stats.m_uiPeakObjects >= 1000 - 2 * 32);
+
+    // freed objects are reused before the pool grows
+    for (nsUInt32 i = 0; i < 1000; ++i)
+    {
+      nodes[i] = pool.New();
+    }
+    NS_TEST_INT(pool.GetStats().m_uiNumNodes, 4);
+
+    for (PoolNode* pNode : nodes)
+    {
+      pool.Delete(pNode);
+    }
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Handles")
+  {
+    Pool pool;
+
+    PoolNode* pNode = pool.New(7u, nullptr);
+    const Pool::Handle handle = pool.GetHandle(pNode);
+    NS_TEST_BOOL(!handle.IsInvalidated());
+    NS_TEST_BOOL(pool.Get(handle) == pNode);
+
+    pool.Delete(handle);
+    NS_TEST_BOOL(pool.Get(handle) == nullptr);
+
+    // the same memory with a new object does not revive the old handle
+    PoolNode* pReused = pool.New(8u, nullptr);
+    NS_TEST_BOOL(pReused == pNode);
+    NS_TEST_BOOL(pool.Get(handle) == nullptr);
+    NS_TEST_BOOL(pool.GetHandle(pReused) != handle);
+
+    NS_TEST_BOOL(pool.Get(Pool::Handle()) == nullptr);
+
+    pool.Delete(pReused);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Threads")
+  {
+    std::atomic<nsInt32> iAlive = 0;
+    Pool pool;
+
+    const bool bValid = RunPoolThreads([&](nsUInt32 uiValue)
+      { return pool.New(uiValue, &iAlive); },
+      [&](PoolNode* pNode)
+      { pool.Delete(pNode); });
+
+    NS_TEST_BOOL(bValid);
+    NS_TEST_INT(iAlive, 0);
+
+    const Pool::Stats stats = pool.GetStats();
+    NS_TEST_INT(stats.m_uiLiveObjects, 0);
+    NS_TEST_BOOL(stats.m_uiPeakObjects >= NUM_POOL_BATCH);
+    NS_TEST_BOOL(stats.m_uiPeakObjects <= stats.m_uiCapacity);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Trim")
+  {
+    Pool pool;
+
+    nsDynamicArray<PoolNode*> nodes;
+    for (nsUInt32 i = 0; i < 2000; ++i)
+    {
+      nodes.PushBack(pool.New());
+    }
+
+    const Pool::Handle firstHandle = pool.GetHandle(nodes[0]);
+    PoolNode* pKept = nodes.PeekBack();
+    nodes.PopBack();
+
+    for (PoolNode* pNode : nodes)
+    {
+      pool.Delete(pNode);
+    }
+
+    NS_TEST_INT(pool.GetStats().m_uiNumNodes, 8);
+
+    // only the node of the object that is still alive stays
+    pool.FlushThreadCache();
+    pool.Trim();
+    NS_TEST_INT(pool.GetStats().m_uiNumNodes, 1);
+    NS_TEST_BOOL(pool.Get(firstHandle) == nullptr);
+
+    pool.Delete(pKept);
+    pool.FlushThreadCache();
+    pool.Trim();
+    NS_TEST_INT(pool.GetStats().m_uiNumNodes, 0);
+
+    // a node that is created again does not take the handles of the trimmed one
+    PoolNode* pNew = pool.New();
+    NS_TEST_INT(pool.GetHandle(pNew).m_uiIndex, firstHandle.m_uiIndex);
+    NS_TEST_BOOL(pool.Get(firstHandle) == nullptr);
+
+    pool.Delete(pNew);
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Concurrent Churn")
+  {
+    // the single-threaded ObjectPool behind a mutex, which is what sharing it between threads takes
+    aperture::core::ObjectPool<PoolNode> lockedPool;
+    std::mutex poolMutex;
+
+    const nsTime tLocked0 = nsTime::Now();
+    RunPoolThreads(
+      [&](nsUInt32 uiValue)
+      {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        return new (lockedPool.GetNextWithoutInitializing()) PoolNode(uiValue, nullptr);
+      },
+      [&](PoolNode* pNode)
+      {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        lockedPool.Delete(pNode);
+      });
+    const nsTime tLocked1 = nsTime::Now();
+
+    Pool pool;
+
+    const nsTime tConcurrent0 = nsTime::Now();
+    RunPoolThreads([&](nsUInt32 uiValue)
+      { return pool.New(uiValue, nullptr); },
+      [&](PoolNode* pNode)
+      { pool.Delete(pNode); });
+    const nsTime tConcurrent1 = nsTime::Now();
+
+    nsLog::Info("[test]{0} threads, {1} objects each: ObjectPool with mutex {2}ms, APCConcurrentObjectPool {3}ms", NUM_POOL_THREADS,
+      NUM_POOL_ROUNDS * NUM_POOL_BATCH, nsArgF((tLocked1 - tLocked0).GetMilliseconds(), 2), nsArgF((tConcurrent1 - tConcurrent0).GetMilliseconds(), 2));
+  }
+}
@@ -0,0 +1,286 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <Foundation/IO/OSFile.h>
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Time/Time.h>
+
+#include <APHTML/Interfaces/APCFileSystem.h>
+#include <APHTML/Interfaces/Internal/APCBuffer.h>
+
+namespace
+{
+  enum CoreBufferConstants
+  {
+    NUM_UI_FILES = 500,
+    NUM_UI_LOADS = 8,
+  };
+
+  /// Roughly the mix of a UI: many small html/css files, fewer scripts, some large images and fonts.
+  size_t GetUIFileSize(nsUInt32 uiFile)
+  {
+    const nsUInt32 uiHash = (uiFile * 2654435761u) >> 8;
+
+    switch (uiFile % 10)
+    {
+      case 0:
+      case 1:
+      case 2:
+      case 3:
+        return 1024 + uiHash % (16 * 1024);
+      case 4:
+      case 5:
+      case 6:
+        return 4096 + uiHash % (64 * 1024);
+      case 7:
+      case 8:
+        return 16 * 1024 + uiHash % (256 * 1024);
+      default:
+        return 64 * 1024 + uiHash % (1024 * 1024);
+    }
+  }
+
+  nsUInt64 Checksum(const nsUInt8* pData, size_t uiSize)
+  {
+    nsUInt64 uiSum = 0;
+    for (size_t i = 0; i < uiSize; i += 64)
+    {
+      uiSum += pData[i];
+    }
+    return uiSum;
+  }
+} // namespace
+
+// Enable when needed
+#define NS_PERFORMANCE_TESTS_STATE nsTestBlock::DisabledNoWarning
+
+NS_CREATE_SIMPLE_TEST(Memory, APCCoreBuffer)
+{
+  using aperture::core::CoreBuffer;
+  using aperture::core::CoreBufferPool;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Size and Capacity")
+  {
+    CoreBuffer<nsUInt32> buffer;
+    NS_TEST_BOOL(buffer.empty());
+    NS_TEST_INT(buffer.capacity(), 16);
+
+    // inline storage does not touch the pool
+    const CoreBufferPool::Stats before = CoreBufferPool::GetStats();
+    buffer.resize(16);
+    NS_TEST_INT(CoreBufferPool::GetStats().m_uiAllocations, before.m_uiAllocations);
+
+    for (nsUInt32 i = 0; i < 16; ++i)
+    {
+      buffer[i] = i;
+    }
+
+    // growing keeps the contents and at least doubles the capacity
+    for (nsUInt32 i = 16; i < 1000; ++i)
+    {
+      const nsUInt32 uiValue = i;
+      buffer.append(&uiValue, 1);
+    }
+
+    NS_TEST_INT(buffer.size(), 1000);
+    NS_TEST_INT(buffer.capacity(), 1024);
+    NS_TEST_BOOL(CoreBufferPool::GetStats().m_uiAllocations - before.m_uiAllocations <= 7);
+
+    bool bContentsKept = true;
+    for (nsUInt32 i = 0; i < 1000; ++i)
+    {
+      bContentsKept &= (buffer[i] == i);
+    }
+    NS_TEST_BOOL(bContentsKept);
+
+    buffer.clear();
+    NS_TEST_BOOL(buffer.empty());
+    NS_TEST_INT(buffer.capacity(), 1024);
+
+    const nsUInt32 values[] = {1, 2, 3};
+    buffer.assign(values, 3);
+    buffer.shrink_to_fit();
+    NS_TEST_INT(buffer.size(), 3);
+    NS_TEST_INT(buffer.capacity(), 16);
+    NS_TEST_INT(buffer[2], 3);
+
+    nsUInt32* pData = buffer.get(100);
+    NS_TEST_INT(buffer.size(), 100);
+    NS_TEST_INT(pData[1], 2);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Move")
+  {
+    CoreBuffer<nsUInt8> small;
+    small.assign(reinterpret_cast<const nsUInt8*>("inline"), 6);
+
+    CoreBuffer<nsUInt8> large(100000);
+    large[99999] = 42;
+    const nsUInt8* pLargeData = large.data();
+
+    CoreBuffer<nsUInt8> movedSmall(std::move(small));
+    NS_TEST_INT(movedSmall.size(), 6);
+    NS_TEST_INT(movedSmall[5], 'e');
+    NS_TEST_BOOL(small.empty());
+
+    CoreBuffer<nsUInt8> movedLarge;
+    movedLarge = std::move(large);
+    NS_TEST_BOOL(movedLarge.data() == pLargeData);
+    NS_TEST_INT(movedLarge[99999], 42);
+    NS_TEST_BOOL(large.empty());
+    NS_TEST_INT(large.capacity(), 64);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Pooling")
+  {
+    CoreBufferPool::Trim();
+
+    {
+      CoreBuffer<float> buffer(3000);
+      NS_TEST_INT(buffer.capacity(), 4096);
+    }
+
+    NS_TEST_INT(CoreBufferPool::GetStats().m_uiCachedBytes, 16384);
+
+    // a buffer of the same size class reuses the block without going to the heap
+    const CoreBufferPool::Stats before = CoreBufferPool::GetStats();
+    {
+      CoreBuffer<nsUInt8> buffer(10000);
+      NS_TEST_INT(buffer.capacity(), 16384);
+    }
+    const CoreBufferPool::Stats after = CoreBufferPool::GetStats();
+
+    NS_TEST_INT(after.m_uiAllocations - before.m_uiAllocations, 1);
+    NS_TEST_INT(after.m_uiHeapAllocations, before.m_uiHeapAllocations);
+
+    // blocks above the largest size class are never kept
+    {
+      CoreBuffer<nsUInt8> buffer((size_t)32 * 1024 * 1024);
+    }
+    NS_TEST_INT(CoreBufferPool::GetStats().m_uiCachedBytes, 16384);
+
+    // neither are blocks beyond the budget
+    CoreBufferPool::SetMaxCachedBytes(0);
+    {
+      CoreBuffer<nsUInt8> buffer(100);
+      buffer.reserve(1000);
+    }
+    NS_TEST_INT(CoreBufferPool::GetStats().m_uiCachedBytes, 16384);
+    CoreBufferPool::SetMaxCachedBytes(64 * 1024 * 1024);
+
+    CoreBufferPool::Trim();
+    NS_TEST_INT(CoreBufferPool::GetStats().m_uiCachedBytes, 0);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "GetFileData")
+  {
+    nsStringBuilder sFolder = nsOSFile::GetTempDataFolder("APCCoreBufferTest");
+    sFolder.Append("/");
+    NS_TEST_BOOL(nsOSFile::CreateDirectoryStructure(sFolder).Succeeded());
+
+    nsStringBuilder sFile = sFolder;
+    sFile.AppendPath("data.bin");
+
+    CoreBuffer<nsUInt8> content(5000);
+    for (nsUInt32 i = 0; i < 5000; ++i)
+    {
+      content[i] = static_cast<nsUInt8>(i * 7);
+    }
+
+    {
+      nsOSFile file;
+      NS_TEST_BOOL(file.Open(sFile, nsFileOpenMode::Write).Succeeded());
+      NS_TEST_BOOL(file.Write(content.data(), content.size()).Succeeded());
+    }
+
+    aperture::core::IAPCFileSystem fileSystem(sFolder.GetData());
+
+    CoreBuffer<nsUInt8> loaded = fileSystem.GetFileData("data.bin");
+    NS_TEST_INT(loaded.size(), 5000);
+    NS_TEST_BOOL(nsMemoryUtils::IsEqual(loaded.data(), content.data(), 5000));
+
+    NS_TEST_BOOL(fileSystem.GetFileData("does-not-exist.bin").empty());
+
+    nsOSFile::DeleteFolder(sFolder).IgnoreResult();
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Loading a 500-file UI")
+  {
+    nsStringBuilder sFolder = nsOSFile::GetTempDataFolder("APCCoreBufferBenchmark");
+    sFolder.Append("/");
+    NS_TEST_BOOL(nsOSFile::CreateDirectoryStructure(sFolder).Succeeded());
+
+    nsDynamicArray<nsUInt8> fileContent;
+    nsUInt64 uiTotalBytes = 0;
+    nsStringBuilder sFile;
+
+    for (nsUInt32 i = 0; i < NUM_UI_FILES; ++i)
+    {
+      fileContent.SetCount(static_cast<nsUInt32>(GetUIFileSize(i)), static_cast<nsUInt8>(i));
+      uiTotalBytes += fileContent.GetCount();
+
+      sFile.SetFormat("{}file{}.bin", sFolder, i);
+
+      nsOSFile file;
+      NS_TEST_BOOL(file.Open(sFile, nsFileOpenMode::Write).Succeeded());
+      NS_TEST_BOOL(file.Write(fileContent.GetData(), fileContent.GetCount()).Succeeded());
+    }
+
+    fileContent.Clear();
+    fileContent.Compact();
+
+    nsUInt64 uiChecksumA = 0;
+    nsUInt64 uiChecksumB = 0;
+    nsAllocator* pDefaultAllocator = nsFoundation::GetDefaultAllocator();
+
+    // reading into a fresh nsDynamicArray per file, which is what APCBuffer users did
+    const nsAllocator::Stats statsA0 = pDefaultAllocator->GetStats();
+    const nsTime tA0 = nsTime::Now();
+    for (nsUInt32 uiLoad = 0; uiLoad < NUM_UI_LOADS; ++uiLoad)
+    {
+      for (nsUInt32 i = 0; i < NUM_UI_FILES; ++i)
+      {
+        sFile.SetFormat("{}file{}.bin", sFolder, i);
+
+        nsOSFile file;
+        if (file.Open(sFile, nsFileOpenMode::Read).Succeeded())
+        {
+          aperture::core::APCBuffer data;
+          file.ReadAll(data);
+          uiChecksumA += Checksum(data.GetData(), data.GetCount());
+        }
+      }
+    }
+    const nsTime tA1 = nsTime::Now();
+    const nsAllocator::Stats statsA1 = pDefaultAllocator->GetStats();
+
+    // the same through IAPCFileSystem::GetFileData() and pooled CoreBuffers
+    aperture::core::IAPCFileSystem fileSystem(sFolder.GetData());
+    CoreBufferPool::Trim();
+
+    const CoreBufferPool::Stats statsB0 = CoreBufferPool::GetStats();
+    const nsTime tB0 = nsTime::Now();
+    for (nsUInt32 uiLoad = 0; uiLoad < NUM_UI_LOADS; ++uiLoad)
+    {
+      for (nsUInt32 i = 0; i < NUM_UI_FILES; ++i)
+      {
+        sFile.SetFormat("file{}.bin", i);
+
+        CoreBuffer<nsUInt8> data = fileSystem.GetFileData(sFile.GetData());
+        uiChecksumB += Checksum(data.data(), data.size());
+      }
+    }
+    const nsTime tB1 = nsTime::Now();
+    const CoreBufferPool::Stats statsB1 = CoreBufferPool::GetStats();
+
+    NS_TEST_INT(uiChecksumA, uiChecksumB);
+
+    nsLog::Info("[test]{0} loads of {1} files ({2} MB): nsDynamicArray {3}ms, {4} heap allocations", NUM_UI_LOADS, NUM_UI_FILES, nsArgF(uiTotalBytes / (1024.0 * 1024.0), 1),
+      nsArgF((tA1 - tA0).GetMilliseconds(), 2), statsA1.m_uiNumAllocations - statsA0.m_uiNumAllocations);
+    nsLog::Info("[test]{0} loads of {1} files: CoreBuffer {2}ms, {3} buffer allocations, {4} from the heap, {5} KB kept in the pool", NUM_UI_LOADS, NUM_UI_FILES,
+      nsArgF((tB1 - tB0).GetMilliseconds(), 2), statsB1.m_uiAllocations - statsB0.m_uiAllocations, statsB1.m_uiHeapAllocations - statsB0.m_uiHeapAllocations,
+      statsB1.m_uiCachedBytes / 1024);
+
+    CoreBufferPool::Trim();
+    nsOSFile::DeleteFolder(sFolder).IgnoreResult();
+  }
+}
@@ -0,0 +1,208 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <Foundation/Memory/AllocatorWithPolicy.h>
+#include <Foundation/Memory/Policies/AllocPolicyHeap.h>
+#include <Foundation/Threading/ThreadUtils.h>
+#include <Foundation/Utilities/Stats.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+#include <APHTML/Interfaces/APCMemoryAllocator.h>
+#include <APHTML/Interfaces/APCMemoryBudgets.h>
+#include <APHTML/Interfaces/APCViewHeap.h>
+
+#include <thread>
+
+NS_CREATE_SIMPLE_TEST(Memory, APCMemoryBudgets)
+{
+  using aperture::core::APCMemoryBudgetReport;
+  using aperture::core::APCMemoryBudgets;
+  using aperture::core::APCMemorySubsystem;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Subsystem Budgets")
+  {
+    APCMemoryBudgets budgets;
+
+    NS_TEST_INT(budgets.FindBudget("V8 Heap"), budgets.GetBudget(APCMemorySubsystem::V8Heap));
+    NS_TEST_INT(budgets.FindBudget("Does not exist"), APCMemoryBudgets::InvalidBudget);
+
+    const APCMemoryBudgets::BudgetId custom = budgets.AddBudget("Custom", 100);
+    NS_TEST_INT(custom, static_cast<nsUInt32>(APCMemorySubsystem::Count));
+
+    budgets.Update();
+    NS_TEST_INT(budgets.GetLastReport().GetCount(), static_cast<nsUInt32>(APCMemorySubsystem::Count) + 1);
+    NS_TEST_BOOL(!budgets.GetLastReport()[custom].IsOverBudget());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Eviction")
+  {
+    nsAllocatorWithPolicy<nsAllocPolicyHeap, nsAllocatorTrackingMode::AllocationStats> domAllocator("APCMemoryBudgetsTest");
+
+    APCMemoryBudgets budgets;
+    const APCMemoryBudgets::BudgetId dom = budgets.GetBudget(APCMemorySubsystem::DOMAndStyle);
+    budgets.AddAllocator(dom, domAllocator.GetId());
+    budgets.SetBudgetBytes(dom, 10000);
+
+    // e.g. the style cache, rebuilt from the DOM when needed
+    nsDynamicArray<void*> cachedBlocks;
+    for (nsUInt32 i = 0; i < 8; ++i)
+    {
+      cachedBlocks.PushBack(domAllocator.Allocate(1000, 8));
+    }
+
+    // memory that no allocator sees, in 1000 byte steps
+    nsUInt64 uiExternalBytes = 4000;
+    budgets.SetUsageCallback(dom, [&]()
+      { return uiExternalBytes; });
+
+    nsHybridArray<nsInt32, 4> callOrder;
+
+    budgets.AddEvictionCallback(dom, 10, [&](nsUInt64 uiBytes) -> nsUInt64
+      {
+      callOrder.PushBack(10);
+      nsUInt64 uiFreed = 0;
+      while (uiFreed < uiBytes && uiExternalBytes > 0)
+      {
+        uiExternalBytes -= 1000;
+        uiFreed += 1000;
+      }
+      return uiFreed; });
+
+    budgets.AddEvictionCallback(dom, 0, [&](nsUInt64 uiBytes) -> nsUInt64
+      {
+      callOrder.PushBack(0);
+      // frees at most 1000 bytes per frame
+      NS_IGNORE_UNUSED(uiBytes);
+      if (cachedBlocks.IsEmpty())
+        return 0;
+
+      domAllocator.Deallocate(cachedBlocks.PeekBack());
+      cachedBlocks.PopBack();
+      return 1000; });
+
+    const nsUInt32 uiNeverCalled = budgets.AddEvictionCallback(dom, 20, [&](nsUInt64) -> nsUInt64
+      {
+      callOrder.PushBack(20);
+      return 0; });
+
+    // within budget, nothing is evicted
+    uiExternalBytes = 2000;
+    budgets.Update();
+    NS_TEST_INT(budgets.GetLastReport()[dom].m_uiUsedBytes, 10000);
+    NS_TEST_INT(budgets.GetLastReport()[dom].m_uiEvictionCalls, 0);
+    NS_TEST_INT(callOrder.GetCount(), 0);
+
+    // 2000 bytes over: 1000 from the cheaper callback, the rest from the next one
+    uiExternalBytes = 4000;
+    budgets.Update();
+
+    const APCMemoryBudgetReport& report = budgets.GetLastReport()[dom];
+    NS_TEST_INT(report.m_uiUsedBytes, 12000);
+    NS_TEST_INT(report.m_uiPeakBytes, 12000);
+    NS_TEST_INT(report.m_uiEvictedBytes, 2000);
+    NS_TEST_INT(report.m_uiEvictionCalls, 2);
+    NS_TEST_BOOL(!report.IsOverBudget());
+    NS_TEST_INT(callOrder.GetCount(), 2);
+    NS_TEST_INT(callOrder[0], 0);
+    NS_TEST_INT(callOrder[1], 10);
+
+    NS_TEST_INT(cachedBlocks.GetCount(), 7);
+    NS_TEST_INT(uiExternalBytes, 3000);
+
+    nsVariant used = nsStats::GetStat("APCMemoryBudgets/DOM and Style/Used");
+    NS_TEST_BOOL(used.IsValid() && used.ConvertTo<nsUInt64>() == 12000);
+
+    // when nothing helps, the budget is reported as exceeded once
+    budgets.RemoveEvictionCallback(uiNeverCalled);
+    budgets.SetBudgetBytes(dom, 1000);
+    {
+      nsTestLogInterface log;
+      nsTestLogSystemScope logSystemScope(&log);
+      log.ExpectMessage("Memory budget 'DOM and Style' exceeded", nsLogMsgType::WarningMsg, 1);
+
+      budgets.Update();
+      budgets.Update();
+    }
+    NS_TEST_BOOL(budgets.GetLastReport()[dom].IsOverBudget());
+
+    nsStringBuilder sReport;
+    budgets.WriteReport(sReport);
+    NS_TEST_BOOL(sReport.FindSubString("DOM and Style: ") != nullptr);
+    NS_TEST_BOOL(sReport.FindSubString("OVER BUDGET") != nullptr);
+    NS_TEST_BOOL(sReport.FindSubString("V8 Heap: 0B, unlimited") != nullptr);
+
+    budgets.RemoveAllocator(dom, domAllocator.GetId());
+    for (void* pBlock : cachedBlocks)
+    {
+      domAllocator.Deallocate(pBlock);
+    }
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "View Heaps")
+  {
+    APCMemoryBudgets budgets;
+    const APCMemoryBudgets::BudgetId dom = budgets.GetBudget(APCMemorySubsystem::DOMAndStyle);
+
+    aperture::core::IAPCMemoryAllocator memoryAllocator;
+    memoryAllocator.SetHeapMode(aperture::core::APCHeapMode::PerView);
+    memoryAllocator.SetMemoryBudgets(&budgets);
+
+    nsAllocator* pHeap = memoryAllocator.CreateViewHeap("APCMemoryBudgetsTest.View");
+    pHeap->Allocate(4000, 8);
+    static_cast<aperture::core::APCViewHeap*>(pHeap)->UpdateTrackerStats();
+
+    budgets.Update();
+    NS_TEST_BOOL(budgets.GetLastReport()[dom].m_uiUsedBytes >= 4000);
+
+    // the heap releases the allocation and leaves the budget
+    memoryAllocator.DestroyViewHeap(pHeap);
+    budgets.Update();
+    NS_TEST_INT(budgets.GetLastReport()[dom].m_uiUsedBytes, 0);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Removing callbacks")
+  {
+    APCMemoryBudgets budgets;
+    const APCMemoryBudgets::BudgetId layout = budgets.GetBudget(APCMemorySubsystem::Layout);
+    budgets.SetBudgetBytes(layout, 1000);
+    budgets.SetUsageCallback(layout, []()
+      { return nsUInt64(2000); });
+
+    nsUInt32 uiRemovedCalls = 0;
+    nsUInt32 uiRemoved = 0;
+    budgets.AddEvictionCallback(layout, 0, [&](nsUInt64) -> nsUInt64
+      {
+      // e.g. a cache that shuts down another one when it is asked to evict
+      budgets.RemoveEvictionCallback(uiRemoved);
+      return 0; });
+    uiRemoved = budgets.AddEvictionCallback(layout, 10, [&](nsUInt64) -> nsUInt64
+      {
+      ++uiRemovedCalls;
+      return 0; });
+
+    budgets.Update();
+    NS_TEST_INT(uiRemovedCalls, 0);
+    NS_TEST_INT(budgets.GetLastReport()[layout].m_uiEvictionCalls, 1);
+
+    // removing a callback on another thread waits for the running Update(), after that the callback is never called again
+    std::atomic<bool> bRemoved = false;
+    std::thread remover;
+    nsUInt32 uiSlow = 0;
+    nsUInt32 uiSlowCalls = 0;
+    uiSlow = budgets.AddEvictionCallback(layout, 20, [&](nsUInt64) -> nsUInt64
+      {
+      ++uiSlowCalls;
+      remover = std::thread([&]()
+        {
+        budgets.RemoveEvictionCallback(uiSlow);
+        bRemoved = true; });
+      nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(20));
+      NS_TEST_BOOL(!bRemoved.load());
+      return 0; });
+
+    budgets.Update();
+    remover.join();
+    budgets.Update();
+    NS_TEST_INT(uiSlowCalls, 1);
+    NS_TEST_BOOL(bRemoved.load());
+  }
+}
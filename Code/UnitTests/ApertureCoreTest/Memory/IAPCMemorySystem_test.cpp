@@ -9,6 +9,50 @@
 #include <Foundation/Threading/Thread.h>
 
 #include <APHTML/Interfaces/APCPlatform.h>
+#include <APHTML/Interfaces/APCViewHeap.h>
+#include <APHTML/Interfaces/Internal/APCObjectTree.h>
+#include <APHTML/Interfaces/Internal/APCStlAllocator.h>
+#include <Foundation/Memory/MemoryTracker.h>
+#include <Foundation/Time/Time.h>
+
+namespace
+{
+  enum ViewHeapConstants
+  {
+    NUM_VIEW_NODES = 50000,
+    NUM_VIEW_LOADS = 10,
+  };
+
+  /// Stands in for the DOM, style and layout data of a view: many small objects of a few different sizes.
+  size_t GetViewNodeSize(nsUInt32 uiNode)
+  {
+    static constexpr size_t s_Sizes[] = {24, 48, 64, 96, 160, 32, 256, 40};
+    return s_Sizes[uiNode % NS_ARRAY_SIZE(s_Sizes)];
+  }
+
+  /// A document element that owns memory outside of the view heap.
+  struct OwningElement
+  {
+    // the tree's head and feet
+    OwningElement() = default;
+
+    OwningElement(nsUInt32& ref_uiDestroyed)
+      : m_pDestroyed(&ref_uiDestroyed)
+    {
+    }
+
+    ~OwningElement()
+    {
+      if (m_pDestroyed != nullptr)
+        ++(*m_pDestroyed);
+    }
+
+    nsUInt32* m_pDestroyed = nullptr;
+  };
+} // namespace
+
+// Enable when needed
+#define NS_PERFORMANCE_TESTS_STATE nsTestBlock::DisabledNoWarning
 
 NS_CREATE_SIMPLE_TEST_GROUP(Memory);
 
@@ -40,7 +84,245 @@ NS_CREATE_SIMPLE_TEST(Memory, IAPCMemory_WDAlloc)
 // NOTE(Mikael A.) This test block uses MiMalloc memory allocator.
 NS_CREATE_SIMPLE_TEST(Memory, IAPCMemory_MiMalloc)
 {
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "View Heap")
+  {
+    aperture::core::APCViewHeap heap("IAPCMemory_MiMalloc");
+
+    void* pSmall = heap.Allocate(24, 8);
+    void* pAligned = heap.Allocate(100, 64);
+    NS_TEST_BOOL(pSmall != nullptr);
+    NS_TEST_BOOL(nsMemoryUtils::IsAligned(pAligned, 64));
+    NS_TEST_BOOL(heap.AllocatedSize(pSmall) >= 24);
+
+    nsMemoryUtils::PatternFill(static_cast<nsUInt8*>(pAligned), 0xAB, 100);
+    pAligned = heap.Reallocate(pAligned, 100, 1000, 64);
+    NS_TEST_BOOL(nsMemoryUtils::IsAligned(pAligned, 64));
+    NS_TEST_INT(static_cast<nsUInt8*>(pAligned)[99], 0xAB);
+
+    heap.Deallocate(pSmall);
+
+    nsAllocator::Stats stats = heap.GetStats();
+    NS_TEST_INT(stats.m_uiNumAllocations, 3);
+    NS_TEST_INT(stats.m_uiNumDeallocations, 2);
+    NS_TEST_INT(stats.m_uiAllocationSize, heap.AllocatedSize(pAligned));
+
+    // the tracker knows the heap by name
+    heap.UpdateTrackerStats();
+    NS_TEST_BOOL(nsMemoryTracker::GetAllocatorName(heap.GetId()) == "IAPCMemory_MiMalloc");
+    NS_TEST_INT(nsMemoryTracker::GetAllocatorStats(heap.GetId()).m_uiNumAllocations, 3);
+
+    // everything left over is released at once
+    for (nsUInt32 i = 0; i < 100; ++i)
+    {
+      heap.Allocate(GetViewNodeSize(i), 8);
+    }
+
+    heap.Reset();
+    stats = nsMemoryTracker::GetAllocatorStats(heap.GetId());
+    NS_TEST_INT(stats.m_uiNumAllocations, 103);
+    NS_TEST_INT(stats.m_uiNumDeallocations, 103);
+    NS_TEST_INT(stats.m_uiAllocationSize, 0);
+
+    // and the heap can be used again
+    void* pAfterReset = heap.Allocate(32, 8);
+    NS_TEST_BOOL(pAfterReset != nullptr);
+    heap.Deallocate(pAfterReset);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Tracker Stats on Free")
+  {
+    aperture::core::APCViewHeap heap("IAPCMemory_MiMalloc");
+
+    nsDynamicArray<void*> nodes;
+    for (nsUInt32 i = 0; i < 4096; ++i)
+    {
+      nodes.PushBack(heap.Allocate(GetViewNodeSize(i), 8));
+    }
+    NS_TEST_BOOL(nsMemoryTracker::GetAllocatorStats(heap.GetId()).m_uiAllocationSize > 0);
+
+    for (void* pNode : nodes)
+    {
+      heap.Deallocate(pNode);
+    }
+    NS_TEST_INT(nsMemoryTracker::GetAllocatorStats(heap.GetId()).m_uiNumDeallocations, 4096);
+    NS_TEST_INT(nsMemoryTracker::GetAllocatorStats(heap.GetId()).m_uiAllocationSize, 0);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Document Tree")
+  {
+    using Allocator = aperture::core::APCStlAllocator<tree_node_<nsUInt32>>;
+
+    aperture::core::APCViewHeap heap("IAPCMemory_MiMalloc");
+
+    tree<nsUInt32, Allocator> nodes;
+    auto root = nodes.set_head(0);
+    for (nsUInt32 i = 1; i <= 10; ++i)
+    {
+      nodes.append_child(root, i);
+    }
+
+    // the nodes move into the heap, the head and feet included
+    nodes.set_allocator(Allocator(&heap));
+    NS_TEST_BOOL(nodes.get_allocator().GetAllocator() == &heap);
+    NS_TEST_INT(heap.GetStats().m_uiNumAllocations - heap.GetStats().m_uiNumDeallocations, 13);
+    NS_TEST_INT(nodes.size(), 11);
+    NS_TEST_INT(*nodes.begin(), 0);
+    NS_TEST_INT(nodes.number_of_children(nodes.begin()), 10);
+
+    nodes.append_child(nodes.begin(), 11);
+    NS_TEST_INT(heap.GetStats().m_uiNumAllocations - heap.GetStats().m_uiNumDeallocations, 14);
+
+    // and back out, so the heap can go first
+    nodes.set_allocator(Allocator());
+    NS_TEST_INT(heap.GetStats().m_uiNumAllocations, heap.GetStats().m_uiNumDeallocations);
+    NS_TEST_INT(nodes.size(), 12);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Releasing a Document Tree")
+  {
+    aperture::core::APCViewHeap heap("IAPCMemory_MiMalloc");
 
+    nsUInt32 uiDestroyed = 0;
+    {
+      using Allocator = aperture::core::APCStlAllocator<tree_node_<OwningElement>>;
+
+      tree<OwningElement, Allocator> elements{Allocator(&heap)};
+      auto root = elements.set_head(OwningElement(uiDestroyed));
+      for (nsUInt32 i = 0; i < 10; ++i)
+      {
+        elements.append_child(elements.append_child(root, OwningElement(uiDestroyed)), OwningElement(uiDestroyed));
+      }
+      uiDestroyed = 0;
+
+      // every element is destroyed, but no node goes back to the heap
+      const nsUInt64 uiNumDeallocations = heap.GetStats().m_uiNumDeallocations;
+      elements.release();
+      NS_TEST_INT(uiDestroyed, 21);
+      NS_TEST_INT(elements.size(), 0);
+      NS_TEST_INT(heap.GetStats().m_uiNumDeallocations, uiNumDeallocations);
+
+      // the tree stays usable
+      elements.set_head(OwningElement(uiDestroyed));
+      NS_TEST_INT(elements.size(), 1);
+      elements.set_allocator(Allocator());
+    }
+
+    heap.Reset();
+    NS_TEST_INT(heap.GetStats().m_uiAllocationSize, 0);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Heap Mode")
+  {
+    aperture::core::IAPCMemoryAllocator memoryAllocator;
+    NS_TEST_BOOL(memoryAllocator.GetHeapMode() == aperture::core::APCHeapMode::Shared);
+
+    nsAllocator* pShared = memoryAllocator.CreateViewHeap("SharedView");
+    NS_TEST_BOOL(pShared == nsFoundation::GetAlignedAllocator());
+    memoryAllocator.DestroyViewHeap(pShared);
+
+    memoryAllocator.SetHeapMode(aperture::core::APCHeapMode::PerView);
+
+    nsAllocator* pViewHeap = memoryAllocator.CreateViewHeap("PerView");
+    NS_TEST_BOOL(pViewHeap != nsFoundation::GetAlignedAllocator());
+    NS_TEST_BOOL(nsMemoryTracker::GetAllocatorName(pViewHeap->GetId()) == "PerView");
+
+    for (nsUInt32 i = 0; i < 1000; ++i)
+    {
+      pViewHeap->Allocate(GetViewNodeSize(i), 8);
+    }
+
+    NS_TEST_INT(pViewHeap->GetStats().m_uiNumAllocations, 1000);
+
+    // frees all 1000 allocations
+    memoryAllocator.DestroyViewHeap(pViewHeap);
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Unloading a View")
+  {
+    nsDynamicArray<void*> nodes;
+    nodes.SetCountUninitialized(NUM_VIEW_NODES);
+
+    nsAllocator* pAllocator = nsFoundation::GetAlignedAllocator();
+    nsTime tIndividual;
+
+    for (nsUInt32 uiLoad = 0; uiLoad < NUM_VIEW_LOADS; ++uiLoad)
+    {
+      for (nsUInt32 i = 0; i < NUM_VIEW_NODES; ++i)
+      {
+        nodes[i] = pAllocator->Allocate(GetViewNodeSize(i), 8);
+      }
+
+      const nsTime t0 = nsTime::Now();
+      for (nsUInt32 i = 0; i < NUM_VIEW_NODES; ++i)
+      {
+        pAllocator->Deallocate(nodes[i]);
+      }
+      tIndividual += nsTime::Now() - t0;
+    }
+
+    aperture::core::IAPCMemoryAllocator memoryAllocator;
+    memoryAllocator.SetHeapMode(aperture::core::APCHeapMode::PerView);
+    nsTime tBulk;
+
+    for (nsUInt32 uiLoad = 0; uiLoad < NUM_VIEW_LOADS; ++uiLoad)
+    {
+      nsAllocator* pViewHeap = memoryAllocator.CreateViewHeap("UnloadBenchmark");
+
+      for (nsUInt32 i = 0; i < NUM_VIEW_NODES; ++i)
+      {
+        nodes[i] = pViewHeap->Allocate(GetViewNodeSize(i), 8);
+      }
+
+      const nsTime t0 = nsTime::Now();
+      memoryAllocator.DestroyViewHeap(pViewHeap);
+      tBulk += nsTime::Now() - t0;
+    }
+
+    nsLog::Info("[test]Unloading a view of {0} allocations, average of {1}: one by one {2}ms, view heap {3}ms", NUM_VIEW_NODES, NUM_VIEW_LOADS,
+      nsArgF(tIndividual.GetMilliseconds() / NUM_VIEW_LOADS, 3), nsArgF(tBulk.GetMilliseconds() / NUM_VIEW_LOADS, 3));
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Unloading a Document")
+  {
+    using Allocator = aperture::core::APCStlAllocator<tree_node_<nsUInt32>>;
+
+    aperture::core::IAPCMemoryAllocator memoryAllocator;
+    memoryAllocator.SetHeapMode(aperture::core::APCHeapMode::PerView);
+
+    // the same teardown as ~BaseDocument, once with the nodes freed one by one, once with the view heap freeing them
+    nsTime tUnload[2];
+    for (nsUInt32 uiRelease = 0; uiRelease < 2; ++uiRelease)
+    {
+      for (nsUInt32 uiLoad = 0; uiLoad < NUM_VIEW_LOADS; ++uiLoad)
+      {
+        nsAllocator* pViewHeap = memoryAllocator.CreateViewHeap("UnloadDocumentBenchmark");
+        tree<nsUInt32, Allocator> nodes{Allocator(pViewHeap)};
+
+        // a shallow, wide document: a few hundred containers with a hundred or so elements each
+        auto root = nodes.set_head(0);
+        auto parent = root;
+        for (nsUInt32 i = 1; i < NUM_VIEW_NODES; ++i)
+        {
+          if (i % 128 == 0)
+            parent = nodes.append_child(root, i);
+          else
+            nodes.append_child(parent, i);
+        }
+
+        const nsTime t0 = nsTime::Now();
+        if (uiRelease == 1)
+          nodes.release();
+        else
+          nodes.clear();
+        nodes.set_allocator(Allocator());
+        memoryAllocator.DestroyViewHeap(pViewHeap);
+        tUnload[uiRelease] += nsTime::Now() - t0;
+      }
+    }
+
+    nsLog::Info("[test]Unloading a document of {0} nodes, average of {1}: clear {2}ms, release {3}ms", NUM_VIEW_NODES, NUM_VIEW_LOADS,
+      nsArgF(tUnload[0].GetMilliseconds() / NUM_VIEW_LOADS, 3), nsArgF(tUnload[1].GetMilliseconds() / NUM_VIEW_LOADS, 3));
+  }
 }
 // NOTE(Mikael A.) This test block uses simulated custom memory allocator, meant to simulate a custom memory allocator provided by the user.
 NS_CREATE_SIMPLE_TEST(Memory, IAPCMemory_CustomOverride)
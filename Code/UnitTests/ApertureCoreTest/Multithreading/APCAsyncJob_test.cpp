@@ -0,0 +1,188 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <Foundation/IO/OSFile.h>
+#include <Foundation/Threading/ThreadUtils.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+#include <APHTML/Multithreading/APCAsyncJob.h>
+#include <APHTML/Multithreading/APCJobSystem.h>
+
+namespace
+{
+  using namespace aperture::core;
+  using namespace aperture::core::threading;
+
+  /// Yields a couple of times before it finishes.
+  class YieldingJob : public APCAsyncJob
+  {
+  public:
+    YieldingJob()
+      : APCAsyncJob(CommandType::Layout, Runtype::FreeThread_Layout)
+    {
+    }
+
+  protected:
+    virtual void OnStart() override { m_uiYields = 0; }
+
+    virtual APCAsyncStep Resume() override
+    {
+      return ++m_uiYields < 8 ? Yield() : Done();
+    }
+
+  private:
+    nsUInt32 m_uiYields = 0;
+  };
+
+  /// Reads a file, waits for another job and then for the next frame.
+  class LoaderJob : public APCAsyncJob
+  {
+  public:
+    LoaderJob()
+      : APCAsyncJob(CommandType::Layout, Runtype::FreeThread_Layout)
+    {
+    }
+
+    nsString m_sFile;
+    APCAsyncJob* m_pDependency = nullptr;
+    nsDynamicArray<nsUInt8> m_Data;
+    nsResult m_ReadResult = NS_FAILURE;
+    bool m_bDependencyWasFinished = false;
+    bool m_bRanOnMainThread = false;
+
+  protected:
+    virtual void OnStart() override
+    {
+      m_uiState = 0;
+      m_Data.Clear();
+      m_bDependencyWasFinished = false;
+    }
+
+    virtual APCAsyncStep Resume() override
+    {
+      m_bRanOnMainThread |= nsThreadUtils::IsMainThread();
+      switch (m_uiState++)
+      {
+        case 0:
+          return AwaitFileRead(m_sFile, m_Data, m_ReadResult);
+        case 1:
+          return Await(*m_pDependency);
+        case 2:
+          m_bDependencyWasFinished = m_pDependency->IsFinished();
+          return AwaitNextFrame();
+        default:
+          return Done();
+      }
+    }
+
+  private:
+    nsUInt32 m_uiState = 0;
+  };
+
+  /// Advances frames until every job finished, false on timeout.
+  template <typename Jobs>
+  bool RunUntilFinished(APCJobSystem& ref_jobSystem, Jobs& ref_jobs)
+  {
+    const nsTime timeout = nsTime::Now() + nsTime::MakeFromSeconds(10);
+    while (nsTime::Now() < timeout)
+    {
+      bool bAllFinished = true;
+      for (APCAsyncJob& job : ref_jobs)
+      {
+        bAllFinished &= job.IsFinished();
+      }
+      if (bAllFinished)
+        return true;
+
+      ref_jobSystem.AdvanceFrame();
+      nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(1));
+    }
+    return false;
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Multithreading, APCAsyncJob)
+{
+  const nsString sFile = nsOSFile::GetTempDataFolder("ApertureCoreTest/APCAsyncJob.bin");
+  {
+    nsUInt8 data[1024];
+    for (nsUInt32 i = 0; i < NS_ARRAY_SIZE(data); ++i)
+    {
+      data[i] = static_cast<nsUInt8>(i);
+    }
+
+    nsOSFile file;
+    NS_TEST_BOOL(file.Open(sFile, nsFileOpenMode::Write).Succeeded());
+    NS_TEST_BOOL(file.Write(data, sizeof(data)).Succeeded());
+  }
+
+  // A single worker, loads waiting on the file thread must not hold on to it.
+  APCJobSystem jobSystem;
+  jobSystem.InitializeJobSystem({0, 0, 0, 1, false});
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Many loads on one worker")
+  {
+    YieldingJob dependency;
+    nsArrayPtr<LoaderJob> loaders = NS_DEFAULT_NEW_ARRAY(LoaderJob, 32);
+    for (LoaderJob& loader : loaders)
+    {
+      loader.m_sFile = sFile;
+      loader.m_pDependency = &dependency;
+    }
+    loaders[0].m_sFile = nsOSFile::GetTempDataFolder("ApertureCoreTest/DoesNotExist.bin");
+
+    NS_TEST_BOOL(dependency.Start(jobSystem).Succeeded());
+    for (LoaderJob& loader : loaders)
+    {
+      NS_TEST_BOOL(loader.Start(jobSystem).Succeeded());
+    }
+
+    NS_TEST_BOOL(RunUntilFinished(jobSystem, loaders));
+    NS_TEST_BOOL(dependency.IsFinished());
+    NS_TEST_INT(dependency.GetResumeCount(), 8);
+
+    NS_TEST_BOOL(loaders[0].m_ReadResult.Failed());
+    for (nsUInt32 i = 1; i < loaders.GetCount(); ++i)
+    {
+      const LoaderJob& loader = loaders[i];
+      NS_TEST_BOOL(loader.m_ReadResult.Succeeded());
+      NS_TEST_INT(loader.m_Data.GetCount(), 1024);
+      NS_TEST_INT(loader.m_Data.GetCount() == 1024 ? loader.m_Data[1023] : 0, 255);
+    }
+    for (LoaderJob& loader : loaders)
+    {
+      NS_TEST_INT(loader.GetResumeCount(), 4);
+      NS_TEST_BOOL(loader.m_bDependencyWasFinished);
+      NS_TEST_BOOL(!loader.m_bRanOnMainThread);
+    }
+
+    NS_DEFAULT_DELETE_ARRAY(loaders);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Restart")
+  {
+    YieldingJob dependency;
+    LoaderJob loader[1];
+    loader[0].m_sFile = sFile;
+    loader[0].m_pDependency = &dependency;
+
+    {
+      nsTestLogInterface log;
+      nsTestLogSystemScope logSystemScope(&log);
+      log.ExpectMessage("that is still running", nsLogMsgType::ErrorMsg);
+
+      NS_TEST_BOOL(loader[0].Start(jobSystem).Succeeded());
+      NS_TEST_BOOL(loader[0].Start(jobSystem).Failed());
+    }
+
+    // The dependency never ran, so it counts as finished.
+    NS_TEST_BOOL(RunUntilFinished(jobSystem, loader));
+    NS_TEST_INT(dependency.GetResumeCount(), 0);
+
+    NS_TEST_BOOL(loader[0].Start(jobSystem).Succeeded());
+    NS_TEST_BOOL(RunUntilFinished(jobSystem, loader));
+    NS_TEST_INT(loader[0].GetResumeCount(), 4);
+  }
+
+  jobSystem.Shutdown();
+  nsOSFile::DeleteFile(sFile).IgnoreResult();
+}
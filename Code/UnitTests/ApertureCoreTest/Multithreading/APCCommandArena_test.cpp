@@ -0,0 +1,139 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <Foundation/Configuration/CVar.h>
+#include <Foundation/Profiling/Profiling.h>
+
+#include <APHTML/CommandExecutor/APCCommandArena.h>
+#include <APHTML/Multithreading/APCJobSystem.h>
+
+namespace
+{
+  /// Builds one frame worth of jobs from the arena, the way V8EJobManager does it, runs them and recycles the arena.
+  void RunFrame(aperture::core::APCCommandArena& ref_arena, aperture::core::threading::APCJobSystem& ref_jobSystem, std::atomic<nsUInt32>* pCounter)
+  {
+    using namespace aperture::core;
+
+    for (nsUInt32 uiJob = 0; uiJob < 256; ++uiJob)
+    {
+      IAPCCommandQueue* pQueue = ref_arena.AllocateCommandQueue(CommandType::Scripting, Runtype::FreeThread_Scripting);
+      IAPCCommandList* pList = ref_arena.AllocateCommandList(*pQueue, CommandType::Scripting, Runtype::FreeThread_Scripting);
+
+      // Jobs with a different number of commands, so the lists need to keep the capacity they grew to.
+      for (nsUInt32 uiCommand = 0; uiCommand <= uiJob % 4; ++uiCommand)
+      {
+        IAPCCommand* pCommand = ref_arena.AllocateCommand(CommandType::Scripting, Runtype::FreeThread_Scripting);
+        pCommand->SetFunction([pCounter, uiCommand]()
+          { pCounter->fetch_add(uiCommand + 1, std::memory_order_relaxed); });
+        pList->AddCommand(*pCommand);
+      }
+
+      pQueue->AddCommandList(*pList);
+      ref_jobSystem.AddJob(*pQueue);
+    }
+
+    ref_jobSystem.Wait();
+    NS_TEST_BOOL(!ref_arena.HasPendingJobs());
+    ref_arena.Reset();
+  }
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Multithreading, APCCommandArena)
+{
+  // Per job (1 + 2 + 3 + 4) / 4, times 256 jobs.
+  constexpr nsUInt32 uiSumPerFrame = 64 * (1 + 3 + 6 + 10);
+
+  aperture::core::threading::APCJobSystem jobSystem;
+  jobSystem.InitializeJobSystem({0, 2, 0, 0, false});
+
+  aperture::core::APCCommandArena arena;
+  std::atomic<nsUInt32> uiCounter = 0;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Reset")
+  {
+    RunFrame(arena, jobSystem, &uiCounter);
+    NS_TEST_INT(uiCounter.load(), uiSumPerFrame);
+    NS_TEST_INT(arena.GetNumQueues(), 0);
+
+    // Recycled objects come back in their initial state.
+    aperture::core::IAPCCommandQueue* pQueue = arena.AllocateCommandQueue(aperture::core::CommandType::Layout, aperture::core::Runtype::FreeThread_Layout);
+    NS_TEST_BOOL(pQueue->GetType() == aperture::core::CommandType::Layout);
+    NS_TEST_BOOL(pQueue->GetRunType() == aperture::core::Runtype::FreeThread_Layout);
+    NS_TEST_BOOL(pQueue->GetJobState() == aperture::core::APCJobState::Idle);
+    NS_TEST_BOOL(arena.HasPendingJobs());
+
+    aperture::core::IAPCCommandList* pList = arena.AllocateCommandList(*pQueue, aperture::core::CommandType::Layout, aperture::core::Runtype::FreeThread_Layout);
+    NS_TEST_BOOL(pList->GetQueue() == pQueue);
+    NS_TEST_BOOL(pList->GetCommands().IsEmpty());
+
+    aperture::core::IAPCCommand* pCommand = arena.AllocateCommand(aperture::core::CommandType::Layout, aperture::core::Runtype::FreeThread_Layout);
+    NS_TEST_BOOL(pCommand->GetCommandType() == aperture::core::CommandType::Layout);
+    pList->AddCommand(*pCommand);
+    pQueue->AddCommandList(*pList);
+
+    // Pending until the job system hands it back.
+    jobSystem.AddJob(*pQueue);
+    jobSystem.Wait();
+    NS_TEST_BOOL(!arena.HasPendingJobs());
+    arena.Reset();
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Reset releases the functions of canceled queues")
+  {
+    using namespace aperture::core;
+
+    std::shared_ptr<nsUInt32> pOwned = std::make_shared<nsUInt32>(0);
+
+    APCCancellationToken token;
+    token.Cancel();
+
+    IAPCCommandQueue* pQueue = arena.AllocateCommandQueue(CommandType::Scripting, Runtype::FreeThread_Scripting);
+    IAPCCommandList* pList = arena.AllocateCommandList(*pQueue, CommandType::Scripting, Runtype::FreeThread_Scripting);
+    IAPCCommand* pCommand = arena.AllocateCommand(CommandType::Scripting, Runtype::FreeThread_Scripting);
+    pCommand->SetFunction([pOwned]()
+      { ++*pOwned; });
+    pList->AddCommand(*pCommand);
+    pQueue->AddCommandList(*pList);
+    pQueue->SetCancellationToken(&token);
+    NS_TEST_INT(pOwned.use_count(), 2);
+
+    jobSystem.AddJob(*pQueue);
+    jobSystem.Wait();
+    NS_TEST_BOOL(!arena.HasPendingJobs());
+    NS_TEST_INT(*pOwned, 0);
+    NS_TEST_INT(pOwned.use_count(), 2);
+
+    arena.Reset();
+    NS_TEST_INT(pOwned.use_count(), 1);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "No allocations in steady state")
+  {
+    nsAllocator* pDefaultAllocator = nsFoundation::GetDefaultAllocator();
+    nsAllocator* pAlignedAllocator = nsFoundation::GetAlignedAllocator();
+
+    // A thread's first recorded profiling scope allocates its scope buffer, which can happen at any time on a busy machine.
+    // The threshold only exists as a CVar, which is missing if profiling is compiled out.
+    const nsCVarFloat* pDiscardThreshold = static_cast<const nsCVarFloat*>(nsCVar::FindCVarByName("Profiling.DiscardThresholdMS"));
+    const nsTime previousDiscardThreshold = nsTime::MakeFromMilliseconds(pDiscardThreshold != nullptr ? pDiscardThreshold->GetValue() : 0.0f);
+    nsProfilingSystem::SetDiscardThreshold(nsTime::MakeFromHours(1));
+
+    // The first frame grows the arena and the command lists.
+    RunFrame(arena, jobSystem, &uiCounter);
+
+    const nsUInt64 uiDefaultAllocations = pDefaultAllocator->GetStats().m_uiNumAllocations;
+    const nsUInt64 uiAlignedAllocations = pAlignedAllocator->GetStats().m_uiNumAllocations;
+
+    uiCounter = 0;
+    for (nsUInt32 uiFrame = 0; uiFrame < 8; ++uiFrame)
+    {
+      RunFrame(arena, jobSystem, &uiCounter);
+    }
+
+    NS_TEST_INT(pDefaultAllocator->GetStats().m_uiNumAllocations, uiDefaultAllocations);
+    NS_TEST_INT(pAlignedAllocator->GetStats().m_uiNumAllocations, uiAlignedAllocations);
+    NS_TEST_INT(uiCounter.load(), uiSumPerFrame * 8);
+    nsProfilingSystem::SetDiscardThreshold(previousDiscardThreshold);
+  }
+
+  jobSystem.Shutdown();
+}
@@ -0,0 +1,210 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <Foundation/Threading/ThreadUtils.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+#include <APHTML/CommandExecutor/IAPCCommand.h>
+#include <APHTML/CommandExecutor/IAPCCommandList.h>
+#include <APHTML/CommandExecutor/IAPCCommandQueue.h>
+#include <APHTML/Multithreading/APCFrameGraph.h>
+
+namespace
+{
+  /// A queue that stamps the order in which it finished.
+  struct StampJob
+  {
+    aperture::core::IAPCCommandQueue m_Queue;
+    aperture::core::IAPCCommandList m_List;
+    aperture::core::IAPCCommand m_Command;
+    nsUInt32 m_uiStamp = 0;
+
+    StampJob()
+      : m_List(m_Queue)
+      , m_Command(aperture::core::CommandType::Layout, aperture::core::Runtype::FreeThread_Layout)
+    {
+      m_Queue.SetType(aperture::core::CommandType::Layout);
+      m_Queue.SetRunType(aperture::core::Runtype::FreeThread_Layout);
+      m_List.SetType(aperture::core::CommandType::Layout);
+      m_List.SetRunType(aperture::core::Runtype::FreeThread_Layout);
+      m_List.AddCommand(m_Command);
+    }
+
+    void Bind(std::atomic<nsUInt32>* pClock, nsTime sleep)
+    {
+      m_Command.SetFunction([this, pClock, sleep]()
+        {
+        nsThreadUtils::Sleep(sleep);
+        m_uiStamp = pClock->fetch_add(1) + 1; });
+      m_Queue.AddCommandList(m_List);
+    }
+  };
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Multithreading, APCFrameGraph)
+{
+  using namespace aperture::core::threading;
+
+  std::atomic<nsUInt32> clock = 0;
+  nsArrayPtr<StampJob> jobs = NS_DEFAULT_NEW_ARRAY(StampJob, 5);
+  for (nsUInt32 i = 0; i < jobs.GetCount(); ++i)
+  {
+    // Job 2 is the slow branch of the diamond, so it has to end up on the critical path.
+    jobs[i].Bind(&clock, nsTime::MakeFromMilliseconds(i == 2 ? 20 : 1));
+  }
+
+  // A -> {B, C} -> D, C has two queues.
+  CommandGroup groups[4];
+  groups[0].m_CommandQueues.PushBack(&jobs[0].m_Queue);
+  groups[1].m_CommandQueues.PushBack(&jobs[1].m_Queue);
+  groups[2].m_CommandQueues.PushBack(&jobs[2].m_Queue);
+  groups[2].m_CommandQueues.PushBack(&jobs[3].m_Queue);
+  groups[3].m_CommandQueues.PushBack(&jobs[4].m_Queue);
+
+  APCJobSystem jobSystem;
+  jobSystem.InitializeJobSystem({0, 0, 0, 4, false});
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Cycle")
+  {
+    nsTestLogInterface log;
+    nsTestLogSystemScope logSystemScope(&log);
+    log.ExpectMessage("Frame graph has a cycle", nsLogMsgType::ErrorMsg);
+    log.ExpectMessage("Cannot submit a frame graph that is not compiled", nsLogMsgType::ErrorMsg);
+
+    APCFrameGraph graph;
+    const APCFrameGraph::NodeIndex a = graph.AddGroup(groups[0]);
+    const APCFrameGraph::NodeIndex b = graph.AddGroup(groups[1]);
+    graph.AddDependency(a, b);
+    graph.AddDependency(b, a);
+    NS_TEST_BOOL(graph.Compile().Failed());
+    NS_TEST_BOOL(graph.Submit(jobSystem).Failed());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Diamond")
+  {
+    APCFrameGraph graph;
+    const APCFrameGraph::NodeIndex a = graph.AddGroup(groups[0]);
+    const APCFrameGraph::NodeIndex b = graph.AddGroup(groups[1]);
+    const APCFrameGraph::NodeIndex c = graph.AddGroup(groups[2]);
+    const APCFrameGraph::NodeIndex d = graph.AddGroup(groups[3]);
+    graph.AddDependency(a, b);
+    graph.AddDependency(a, c);
+    graph.AddDependency(b, d);
+    graph.AddDependency(c, d);
+    NS_TEST_BOOL(graph.Compile().Succeeded());
+
+    // The same graph runs several frames in a row.
+    for (nsUInt32 uiFrame = 0; uiFrame < 3; ++uiFrame)
+    {
+      clock = 0;
+      NS_TEST_BOOL(graph.Submit(jobSystem).Succeeded());
+      graph.Wait();
+      NS_TEST_BOOL(graph.IsFrameFinished());
+
+      NS_TEST_INT(jobs[0].m_uiStamp, 1);
+      NS_TEST_BOOL(jobs[1].m_uiStamp > 1 && jobs[1].m_uiStamp < 5);
+      NS_TEST_BOOL(jobs[2].m_uiStamp > 1 && jobs[2].m_uiStamp < 5);
+      NS_TEST_BOOL(jobs[3].m_uiStamp > 1 && jobs[3].m_uiStamp < 5);
+      NS_TEST_INT(jobs[4].m_uiStamp, 5);
+
+      const nsArrayPtr<const APCFrameGraph::NodeIndex> criticalPath = graph.GetCriticalPath();
+      NS_TEST_INT(criticalPath.GetCount(), 3);
+      if (criticalPath.GetCount() == 3)
+      {
+        NS_TEST_INT(criticalPath[0], a);
+        NS_TEST_INT(criticalPath[1], c);
+        NS_TEST_INT(criticalPath[2], d);
+      }
+
+      const APCFrameGraphStats& stats = graph.GetLastFrameStats();
+      NS_TEST_BOOL(stats.m_CriticalPathTime >= nsTime::MakeFromMilliseconds(20));
+      NS_TEST_BOOL(stats.m_TotalWorkTime >= stats.m_CriticalPathTime);
+      NS_TEST_BOOL(stats.m_FrameTime >= stats.m_CriticalPathTime);
+      NS_TEST_BOOL(graph.GetGroupCost(c) >= graph.GetGroupCost(b));
+    }
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Cancel a branch")
+  {
+    APCFrameGraph graph;
+    const APCFrameGraph::NodeIndex a = graph.AddGroup(groups[0]);
+    const APCFrameGraph::NodeIndex b = graph.AddGroup(groups[1]);
+    const APCFrameGraph::NodeIndex c = graph.AddGroup(groups[2]);
+    const APCFrameGraph::NodeIndex d = graph.AddGroup(groups[3]);
+    graph.AddDependency(a, b);
+    graph.AddDependency(a, c);
+    graph.AddDependency(c, d);
+    NS_TEST_BOOL(graph.Compile().Succeeded());
+
+    // Cancelling C also drops D, which only runs after C. B is on the other branch and runs.
+    aperture::core::APCCancellationToken token;
+    groups[2].SetCancellationToken(&token);
+    NS_TEST_BOOL(jobSystem.CancelJobGroup(groups[2]).Succeeded());
+
+    for (StampJob& job : jobs)
+    {
+      job.m_uiStamp = 0;
+    }
+    clock = 0;
+    NS_TEST_BOOL(graph.Submit(jobSystem).Succeeded());
+    graph.Wait();
+
+    NS_TEST_INT(jobs[0].m_uiStamp, 1);
+    NS_TEST_INT(jobs[1].m_uiStamp, 2);
+    NS_TEST_INT(jobs[2].m_uiStamp, 0);
+    NS_TEST_INT(jobs[3].m_uiStamp, 0);
+    NS_TEST_INT(jobs[4].m_uiStamp, 0);
+    NS_TEST_INT(graph.GetLastFrameStats().m_uiCanceledGroups, 2);
+    NS_TEST_INT(token.GetStats().m_uiSkippedQueues, 2);
+
+    // Without the token the next frame runs everything again.
+    token.Reset();
+    clock = 0;
+    NS_TEST_BOOL(graph.Submit(jobSystem).Succeeded());
+    graph.Wait();
+    NS_TEST_BOOL(jobs[4].m_uiStamp >= 4);
+    NS_TEST_INT(graph.GetLastFrameStats().m_uiCanceledGroups, 0);
+
+    groups[2].SetCancellationToken(nullptr);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Queue added after Compile")
+  {
+    StampJob lateJob;
+    lateJob.Bind(&clock, nsTime::MakeFromMilliseconds(1));
+
+    CommandGroup group;
+    group.m_CommandQueues.PushBack(&jobs[0].m_Queue);
+
+    APCFrameGraph graph;
+    const APCFrameGraph::NodeIndex a = graph.AddGroup(group);
+    const APCFrameGraph::NodeIndex b = graph.AddGroup(groups[1]);
+    graph.AddDependency(a, b);
+    NS_TEST_BOOL(graph.Compile().Succeeded());
+
+    // The group is a plain struct, the graph notices the new queue on Submit and binds it.
+    group.m_CommandQueues.PushBack(&lateJob.m_Queue);
+
+    for (StampJob& job : jobs)
+    {
+      job.m_uiStamp = 0;
+    }
+    clock = 0;
+    NS_TEST_BOOL(graph.Submit(jobSystem).Succeeded());
+    graph.Wait();
+    NS_TEST_BOOL(graph.IsFrameFinished());
+    NS_TEST_BOOL(jobs[0].m_uiStamp > 0 && jobs[0].m_uiStamp < 3);
+    NS_TEST_BOOL(lateJob.m_uiStamp > 0 && lateJob.m_uiStamp < 3);
+    NS_TEST_INT(jobs[1].m_uiStamp, 3);
+
+    // A queue that leaves the group is no longer bound to the graph.
+    group.m_CommandQueues.PopBack();
+    clock = 0;
+    NS_TEST_BOOL(graph.Submit(jobSystem).Succeeded());
+    graph.Wait();
+    NS_TEST_BOOL(lateJob.m_Queue.GetCompletionUserData() == nullptr);
+    NS_TEST_INT(jobs[1].m_uiStamp, 2);
+  }
+
+  jobSystem.Shutdown();
+  NS_DEFAULT_DELETE_ARRAY(jobs);
+}
@@ -0,0 +1,720 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <Foundation/Containers/Deque.h>
+#include <Foundation/IO/JSONReader.h>
+#include <Foundation/IO/MemoryStream.h>
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Threading/TaskSystem.h>
+#include <Foundation/Threading/ThreadUtils.h>
+#include <Foundation/Time/Time.h>
+#include <Foundation/Utilities/Stats.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+#include <APHTML/CommandExecutor/IAPCCommand.h>
+#include <APHTML/CommandExecutor/IAPCCommandList.h>
+#include <APHTML/CommandExecutor/IAPCCommandQueue.h>
+#include <APHTML/Multithreading/APCJobSystem.h>
+
+#if NS_ENABLED(NS_PLATFORM_LINUX)
+#  include <sys/resource.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+NS_CREATE_SIMPLE_TEST_GROUP(Multithreading);
+
+namespace
+{
+  enum constants
+  {
+#if NS_ENABLED(NS_COMPILE_FOR_DEBUG)
+    NUM_JOBS = 1024 * 4,
+    NUM_ROUNDS = 4,
+#else
+    NUM_JOBS = 1024 * 16,
+    NUM_ROUNDS = 16,
+#endif
+  };
+
+  /// A queue with a single command that bumps a counter, so lost or duplicated jobs show up in the sum.
+  struct CountingJob
+  {
+    aperture::core::IAPCCommandQueue m_Queue;
+    aperture::core::IAPCCommandList m_List;
+    aperture::core::IAPCCommand m_Command;
+
+    CountingJob()
+      : m_List(m_Queue)
+      , m_Command(aperture::core::CommandType::Composition, aperture::core::Runtype::FreeThread_Composition)
+    {
+      m_Queue.SetType(aperture::core::CommandType::Composition);
+      m_Queue.SetRunType(aperture::core::Runtype::FreeThread_Composition);
+      m_List.SetType(aperture::core::CommandType::Composition);
+      m_List.SetRunType(aperture::core::Runtype::FreeThread_Composition);
+      m_List.AddCommand(m_Command);
+    }
+
+    void Bind(std::atomic<nsUInt32>* pCounter)
+    {
+      m_Command.SetFunction([pCounter]()
+        { pCounter->fetch_add(1, std::memory_order_relaxed); });
+      m_Queue.AddCommandList(m_List);
+    }
+
+    /// Moves the job to another pool. Has to be called before Bind().
+    void SetType(aperture::core::CommandType type, aperture::core::Runtype runtype)
+    {
+      m_Queue.SetType(type);
+      m_Queue.SetRunType(runtype);
+      m_List.SetType(type);
+      m_List.SetRunType(runtype);
+      // Retyping a command locks the queue through its parent list.
+      m_Command.SetParentCommandList(m_List);
+      m_Command.SetCommandType(type);
+      m_Command.SetRunType(runtype);
+    }
+
+    /// Spreads jobs round-robin over all four pools.
+    void SetTypeByIndex(nsUInt32 uiIndex)
+    {
+      const aperture::core::CommandType types[] = {aperture::core::CommandType::Composition, aperture::core::CommandType::Scripting, aperture::core::CommandType::Rendering, aperture::core::CommandType::Layout};
+      const aperture::core::Runtype runtypes[] = {aperture::core::Runtype::FreeThread_Composition, aperture::core::Runtype::FreeThread_Scripting, aperture::core::Runtype::FreeThread_Rendering, aperture::core::Runtype::FreeThread_Layout};
+      SetType(types[uiIndex % 4], runtypes[uiIndex % 4]);
+    }
+  };
+
+  /// Voluntary plus involuntary context switches of the whole process so far. Always 0 where the platform does not report them.
+  nsUInt64 GetContextSwitches()
+  {
+#if NS_ENABLED(NS_PLATFORM_LINUX)
+    rusage usage = {};
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+      return static_cast<nsUInt64>(usage.ru_nvcsw) + static_cast<nsUInt64>(usage.ru_nivcsw);
+#endif
+    return 0;
+  }
+
+  /// The pre work-stealing design: every worker of a Runtype pops from one shared deque and sleeps on one shared condition variable.
+  /// Guarded by a mutex here, since the unguarded original loses and duplicates jobs and would not finish the benchmark.
+  class SharedDequeJobSystem
+  {
+  public:
+    explicit SharedDequeJobSystem(nsUInt32 uiThreads)
+    {
+      for (nsUInt32 i = 0; i < uiThreads; ++i)
+      {
+        m_Threads.PushBack(std::thread([this]()
+          { Run(); }));
+      }
+    }
+
+    ~SharedDequeJobSystem()
+    {
+      {
+        std::scoped_lock<std::mutex> lock(m_Mutex);
+        m_bShutdown = true;
+      }
+      m_WakeCondition.notify_all();
+      for (std::thread& thread : m_Threads)
+      {
+        thread.join();
+      }
+    }
+
+    void AddJob(aperture::core::IAPCCommandQueue* pQueue)
+    {
+      m_uiInFlight.fetch_add(1);
+      {
+        std::scoped_lock<std::mutex> lock(m_Mutex);
+        m_Jobs.PushBack(pQueue);
+      }
+      m_WakeCondition.notify_all();
+    }
+
+    void Wait()
+    {
+      while (m_uiInFlight.load() > 0)
+      {
+        std::this_thread::yield();
+      }
+    }
+
+  private:
+    void Run()
+    {
+      while (true)
+      {
+        aperture::core::IAPCCommandQueue* pQueue = nullptr;
+        {
+          std::unique_lock<std::mutex> lock(m_Mutex);
+          m_WakeCondition.wait(lock, [this]()
+            { return m_bShutdown || !m_Jobs.IsEmpty(); });
+          if (m_bShutdown)
+            return;
+
+          pQueue = m_Jobs.PeekBack();
+          m_Jobs.PopBack();
+        }
+        pQueue->Execute().IgnoreResult();
+        m_uiInFlight.fetch_sub(1);
+      }
+    }
+
+    std::mutex m_Mutex;
+    std::condition_variable m_WakeCondition;
+    nsDeque<aperture::core::IAPCCommandQueue*> m_Jobs;
+    nsHybridArray<std::thread, 32> m_Threads;
+    std::atomic<nsUInt32> m_uiInFlight = 0;
+    bool m_bShutdown = false;
+  };
+} // namespace
+
+// Enable when needed
+#define NS_PERFORMANCE_TESTS_STATE nsTestBlock::DisabledNoWarning
+
+NS_CREATE_SIMPLE_TEST(Multithreading, APCWorkStealingDeque)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Owner Push/Pop is LIFO")
+  {
+    aperture::core::threading::APCWorkStealingDeque<nsUInt32*> deque(2);
+    nsUInt32 values[64];
+    for (nsUInt32 i = 0; i < 64; ++i)
+    {
+      deque.Push(&values[i]);
+    }
+    NS_TEST_INT(deque.GetCount(), 64);
+
+    for (nsUInt32 i = 64; i > 0; --i)
+    {
+      nsUInt32* pValue = nullptr;
+      NS_TEST_BOOL(deque.Pop(pValue));
+      NS_TEST_BOOL(pValue == &values[i - 1]);
+    }
+
+    nsUInt32* pValue = nullptr;
+    NS_TEST_BOOL(!deque.Pop(pValue));
+    NS_TEST_BOOL(!deque.Steal(pValue));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Concurrent steals see every item exactly once")
+  {
+    constexpr nsUInt32 uiNumItems = 1024 * 16;
+    constexpr nsUInt32 uiNumThieves = 4;
+
+    aperture::core::threading::APCWorkStealingDeque<nsUInt32*> deque(16);
+    nsDynamicArray<nsUInt32> items;
+    items.SetCount(uiNumItems);
+    std::atomic<nsUInt32> hits[uiNumItems] = {};
+    std::atomic<bool> bDone = false;
+
+    auto consume = [&](nsUInt32* pItem)
+    { hits[pItem - items.GetData()].fetch_add(1, std::memory_order_relaxed); };
+
+    nsHybridArray<std::thread, uiNumThieves> thieves;
+    for (nsUInt32 t = 0; t < uiNumThieves; ++t)
+    {
+      thieves.PushBack(std::thread([&]()
+        {
+        nsUInt32* pItem = nullptr;
+        while (!bDone.load() || !deque.IsEmpty())
+        {
+          if (deque.Steal(pItem))
+            consume(pItem);
+        } }));
+    }
+
+    for (nsUInt32 i = 0; i < uiNumItems; ++i)
+    {
+      deque.Push(&items[i]);
+
+      nsUInt32* pItem = nullptr;
+      if ((i % 3) == 0 && deque.Pop(pItem))
+        consume(pItem);
+    }
+
+    nsUInt32* pItem = nullptr;
+    while (deque.Pop(pItem))
+      consume(pItem);
+
+    bDone = true;
+    for (std::thread& thief : thieves)
+      thief.join();
+
+    nsUInt32 uiWrong = 0;
+    for (nsUInt32 i = 0; i < uiNumItems; ++i)
+    {
+      uiWrong += hits[i].load() != 1 ? 1 : 0;
+    }
+    NS_TEST_INT(uiWrong, 0);
+  }
+}
+
+NS_CREATE_SIMPLE_TEST(Multithreading, APCJobSystem)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "No lost or duplicated jobs")
+  {
+    std::atomic<nsUInt32> uiCounter = 0;
+    nsArrayPtr<CountingJob> jobs = NS_DEFAULT_NEW_ARRAY(CountingJob, 1024);
+    for (CountingJob& job : jobs)
+    {
+      job.Bind(&uiCounter);
+    }
+
+    aperture::core::threading::APCJobSystem jobSystem;
+    jobSystem.InitializeJobSystem({4, 0, 0, 0, false});
+
+    for (nsUInt32 round = 0; round < 8; ++round)
+    {
+      for (CountingJob& job : jobs)
+      {
+        jobSystem.AddJob(job.m_Queue);
+      }
+      jobSystem.Wait();
+    }
+
+    NS_TEST_INT(uiCounter.load(), 1024 * 8);
+    jobSystem.Shutdown();
+    NS_DEFAULT_DELETE_ARRAY(jobs);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Waiting on another job system")
+  {
+    aperture::core::threading::APCJobSystem systemA;
+    aperture::core::threading::APCJobSystem systemB;
+    systemA.InitializeJobSystem({1, 0, 0, 0, false});
+    systemB.InitializeJobSystem({1, 0, 0, 0, false});
+
+    std::atomic<nsUInt32> uiCounterA = 0;
+    std::atomic<nsUInt32> uiCounterB = 0;
+    nsArrayPtr<CountingJob> jobsA = NS_DEFAULT_NEW_ARRAY(CountingJob, 64);
+    nsArrayPtr<CountingJob> jobsB = NS_DEFAULT_NEW_ARRAY(CountingJob, 64);
+    for (nsUInt32 i = 0; i < 64; ++i)
+    {
+      jobsA[i].Bind(&uiCounterA);
+      jobsB[i].Bind(&uiCounterB);
+    }
+
+    // Runs on the worker of A, which fills its own deque and then helps B. It must not hand A's jobs to B while doing so.
+    CountingJob waiter;
+    waiter.m_Command.SetFunction([&]()
+      {
+      for (CountingJob& job : jobsA)
+        systemA.AddJob(job.m_Queue);
+      for (CountingJob& job : jobsB)
+        systemB.AddJob(job.m_Queue);
+      systemB.Wait(); });
+    waiter.m_Queue.AddCommandList(waiter.m_List);
+
+    systemA.AddJob(waiter.m_Queue);
+    systemA.Wait();
+    systemB.Wait();
+
+    NS_TEST_INT(uiCounterA.load(), 64);
+    NS_TEST_INT(uiCounterB.load(), 64);
+    NS_TEST_INT(systemA.QueuedJobs(), 0);
+    NS_TEST_INT(systemB.QueuedJobs(), 0);
+
+    systemA.Shutdown();
+    systemB.Shutdown();
+    NS_DEFAULT_DELETE_ARRAY(jobsA);
+    NS_DEFAULT_DELETE_ARRAY(jobsB);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Elastic pools")
+  {
+    const nsUInt32 uiHardwareThreads = nsMath::Max(std::thread::hardware_concurrency(), 1u);
+    const nsUInt32 uiCeiling = nsMath::Min(3u, nsMath::Max(uiHardwareThreads, 1u));
+
+    aperture::core::threading::APCJobSystemConfig config;
+    config.m_Composition_threadcount = 1;
+    config.m_allowCreationOfNewThreadsOnOverfill = true;
+    config.m_maxThreadsPerRuntype = 3;
+    config.m_growthBacklogTime = nsTime::MakeFromMilliseconds(1);
+    config.m_idleRetireTime = nsTime::MakeFromMilliseconds(20);
+
+    aperture::core::threading::APCJobSystem jobSystem;
+    jobSystem.InitializeJobSystem(config);
+    NS_TEST_INT(jobSystem.GetThreadCount(aperture::core::Runtype::FreeThread_Composition), 1);
+
+    std::atomic<nsUInt32> uiCounter = 0;
+    nsArrayPtr<CountingJob> jobs = NS_DEFAULT_NEW_ARRAY(CountingJob, 64);
+    for (CountingJob& job : jobs)
+    {
+      job.m_Command.SetFunction([&uiCounter]()
+        {
+        nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(1));
+        uiCounter.fetch_add(1); });
+      job.m_Queue.AddCommandList(job.m_List);
+    }
+
+    // Sustained backlog, the pool has to grow, but never beyond its ceiling or the hardware.
+    nsUInt32 uiPeakThreads = 0;
+    for (nsUInt32 round = 0; round < 4; ++round)
+    {
+      for (CountingJob& job : jobs)
+      {
+        jobSystem.AddJob(job.m_Queue);
+      }
+      while (jobSystem.GetQueuedJobCount(aperture::core::Runtype::FreeThread_Composition) > 0)
+      {
+        uiPeakThreads = nsMath::Max(uiPeakThreads, jobSystem.GetThreadCount(aperture::core::Runtype::FreeThread_Composition));
+        nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(1));
+      }
+      jobSystem.Wait();
+    }
+    NS_TEST_INT(uiCounter.load(), 64 * 4);
+    NS_TEST_BOOL(uiPeakThreads <= uiCeiling);
+    if (uiHardwareThreads > 1)
+    {
+      NS_TEST_BOOL(uiPeakThreads > 1);
+    }
+
+    // Idle grown threads retire, the configured one stays.
+    const nsTime tTimeout = nsTime::Now() + nsTime::MakeFromSeconds(5);
+    while (jobSystem.GetThreadCount(aperture::core::Runtype::FreeThread_Composition) > 1 && nsTime::Now() < tTimeout)
+    {
+      nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(5));
+    }
+    NS_TEST_INT(jobSystem.GetThreadCount(aperture::core::Runtype::FreeThread_Composition), 1);
+
+    // Retired slots are reused when the backlog comes back.
+    uiCounter = 0;
+    for (CountingJob& job : jobs)
+    {
+      jobSystem.AddJob(job.m_Queue);
+    }
+    jobSystem.Wait();
+    NS_TEST_INT(uiCounter.load(), 64);
+
+    jobSystem.Shutdown();
+    NS_DEFAULT_DELETE_ARRAY(jobs);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Task system backend")
+  {
+    std::atomic<nsUInt32> uiCounter = 0;
+    nsArrayPtr<CountingJob> jobs = NS_DEFAULT_NEW_ARRAY(CountingJob, 1024);
+    for (nsUInt32 i = 0; i < jobs.GetCount(); ++i)
+    {
+      jobs[i].SetTypeByIndex(i);
+      jobs[i].Bind(&uiCounter);
+    }
+
+    aperture::core::threading::APCJobSystemConfig config;
+    config.m_Script_threadcount = 1;
+    config.m_backend = aperture::core::threading::APCJobSystemBackend::TaskSystem;
+
+    aperture::core::threading::APCJobSystem jobSystem;
+    jobSystem.InitializeJobSystem(config);
+    NS_TEST_BOOL(jobSystem.GetBackend() == aperture::core::threading::APCJobSystemBackend::TaskSystem);
+
+    nsUInt32 uiPeakScriptDrainers = 0;
+    for (nsUInt32 round = 0; round < 8; ++round)
+    {
+      for (CountingJob& job : jobs)
+      {
+        jobSystem.AddJob(job.m_Queue);
+        uiPeakScriptDrainers = nsMath::Max(uiPeakScriptDrainers, jobSystem.GetThreadCount(aperture::core::Runtype::FreeThread_Scripting));
+      }
+      jobSystem.Wait();
+    }
+
+    NS_TEST_INT(uiCounter.load(), 1024 * 8);
+    NS_TEST_BOOL(uiPeakScriptDrainers <= 1);
+    // No thread of its own ever ran a job.
+    NS_TEST_INT(jobSystem.ActiveThreads(), 0);
+
+    // Jobs submitted from within a drain task end up in the same pool and get picked up as well.
+    uiCounter = 0;
+    jobs[0].m_Command.SetFunction([&]()
+      {
+      for (nsUInt32 i = 1; i < jobs.GetCount(); ++i)
+      {
+        jobSystem.AddJob(jobs[i].m_Queue);
+      } });
+    jobSystem.AddJob(jobs[0].m_Queue);
+    jobSystem.Wait();
+    NS_TEST_INT(uiCounter.load(), 1023);
+
+    jobSystem.Shutdown();
+    NS_TEST_INT(jobSystem.GetThreadCount(aperture::core::Runtype::FreeThread_Composition), 0);
+    NS_DEFAULT_DELETE_ARRAY(jobs);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Histogram")
+  {
+    aperture::core::threading::APCTimeHistogram histogram;
+    NS_TEST_BOOL(histogram.GetPercentile(0.5).IsZero());
+
+    for (nsUInt32 i = 0; i < 90; ++i)
+    {
+      histogram.Add(nsTime::MakeFromMicroseconds(3));
+    }
+    for (nsUInt32 i = 0; i < 10; ++i)
+    {
+      histogram.Add(nsTime::MakeFromMilliseconds(3));
+    }
+
+    NS_TEST_INT(histogram.m_uiCount, 100);
+    NS_TEST_INT(aperture::core::threading::APCTimeHistogram::GetBucketIndex(nsTime::MakeFromMicroseconds(3)), 2);
+    NS_TEST_BOOL(histogram.GetPercentile(0.5) == nsTime::MakeFromMicroseconds(4));
+    NS_TEST_BOOL(histogram.GetPercentile(0.95) == nsTime::MakeFromMilliseconds(3));
+    NS_TEST_BOOL(histogram.m_Max == nsTime::MakeFromMilliseconds(3));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Frame stats")
+  {
+    std::atomic<nsUInt32> uiCounter = 0;
+    nsArrayPtr<CountingJob> jobs = NS_DEFAULT_NEW_ARRAY(CountingJob, 256);
+    for (CountingJob& job : jobs)
+    {
+      job.Bind(&uiCounter);
+    }
+
+    aperture::core::threading::APCJobSystem jobSystem;
+    jobSystem.InitializeJobSystem({2, 0, 0, 0, false});
+    jobSystem.SetFrameStatsHistorySize(2);
+
+    for (nsUInt32 uiFrame = 0; uiFrame < 3; ++uiFrame)
+    {
+      for (CountingJob& job : jobs)
+      {
+        jobSystem.AddJob(job.m_Queue);
+      }
+      NS_TEST_INT(jobSystem.GetQueuedJobCount(aperture::core::Runtype::FreeThread_Composition) <= 256, 1);
+      jobSystem.Wait();
+      jobSystem.PublishFrameStats();
+
+      const aperture::core::threading::APCJobSystemFrameStats& stats = jobSystem.GetLastFrameStats();
+      NS_TEST_INT(stats.m_uiFrame, uiFrame);
+
+      // Pool 0 is the composition pool.
+      const aperture::core::threading::APCJobPoolFrameStats& poolStats = stats.m_Pools[0];
+      NS_TEST_BOOL(poolStats.m_Runtype == aperture::core::Runtype::FreeThread_Composition);
+      NS_TEST_INT(poolStats.m_uiJobsExecuted, 256);
+      NS_TEST_INT(poolStats.m_Latency.m_uiCount, 256);
+      NS_TEST_BOOL(poolStats.m_uiMaxQueueDepth >= 1 && poolStats.m_uiMaxQueueDepth <= 256);
+      NS_TEST_INT(stats.m_Workers.GetCount(), 2);
+
+      nsUInt32 uiWorkerJobs = 0;
+      for (const aperture::core::threading::APCJobWorkerFrameStats& workerStats : stats.m_Workers)
+      {
+        uiWorkerJobs += workerStats.m_uiJobsExecuted;
+        NS_TEST_BOOL(workerStats.m_fUtilization >= 0.0f && workerStats.m_fUtilization <= 1.0f);
+      }
+      NS_TEST_BOOL(uiWorkerJobs <= 256);
+    }
+    NS_TEST_INT(nsStats::GetStat("APCJobSystem/FreeThread_Composition/Jobs").ConvertTo<nsUInt32>(), 256);
+
+    nsDefaultMemoryStreamStorage storage;
+    nsMemoryStreamWriter writer(&storage);
+    NS_TEST_BOOL(jobSystem.WriteChromeTrace(writer).Succeeded());
+
+    nsMemoryStreamReader reader(&storage);
+    nsJSONReader json;
+    NS_TEST_BOOL(json.Parse(reader).Succeeded());
+    const nsVariant* pEvents = json.GetTopLevelObject().GetValue("traceEvents");
+    NS_TEST_BOOL(pEvents != nullptr && pEvents->IsA<nsVariantArray>());
+    if (pEvents != nullptr && pEvents->IsA<nsVariantArray>())
+    {
+      // Two frames in the history, three counters for the pool and one per worker.
+      NS_TEST_INT(pEvents->Get<nsVariantArray>().GetCount(), 2 * (3 + 2));
+    }
+
+    jobSystem.Shutdown();
+    NS_DEFAULT_DELETE_ARRAY(jobs);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Thread policy")
+  {
+    using namespace aperture::core::threading;
+
+    std::atomic<nsUInt64> uiAffinity = 0;
+    std::atomic<nsInt32> iNice = -100;
+    std::atomic<bool> bDone = false;
+    CountingJob job;
+    job.Bind(nullptr);
+    job.m_Command.SetFunction([&]()
+      {
+      uiAffinity = APCThreadPolicy::GetCurrentThreadAffinity();
+#if NS_ENABLED(NS_PLATFORM_LINUX)
+      iNice = getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+#endif
+      bDone = true; });
+
+    APCJobSystemConfig config = {1, 0, 0, 0, false};
+    config.m_Composition_policy.m_uiAffinityMask = 1;
+    config.m_Composition_policy.m_priority = APCThreadPriority::BelowNormal;
+    config.m_Composition_policy.m_sThreadName = "APC Test";
+
+    APCJobSystem jobSystem;
+    jobSystem.InitializeJobSystem(config);
+
+    // Wait() would run the job on this thread, so let the worker pick it up.
+    jobSystem.AddJob(job.m_Queue);
+    while (!bDone)
+    {
+      nsThreadUtils::YieldTimeSlice();
+    }
+    jobSystem.Wait();
+    jobSystem.PublishFrameStats();
+
+#if NS_ENABLED(NS_PLATFORM_LINUX)
+    NS_TEST_INT(uiAffinity, 1);
+    NS_TEST_INT(iNice, 5);
+#endif
+    const APCJobSystemFrameStats& stats = jobSystem.GetLastFrameStats();
+    NS_TEST_INT(stats.m_Workers.GetCount(), 1);
+    if (!stats.m_Workers.IsEmpty())
+    {
+      NS_TEST_INT(stats.m_Workers[0].m_uiAffinityMask, 1);
+      NS_TEST_BOOL(stats.m_Workers[0].m_Priority == APCThreadPriority::BelowNormal);
+    }
+    jobSystem.Shutdown();
+
+    // A policy that only allows reserved cores leaves the thread alone.
+    nsTestLogInterface log;
+    nsTestLogSystemScope logSystemScope(&log, true);
+    log.ExpectMessage("only contains reserved cores", nsLogMsgType::WarningMsg);
+
+    config.m_Composition_policy.m_priority = APCThreadPriority::Default;
+    config.m_reservedCoreMask = 1;
+    jobSystem.InitializeJobSystem(config);
+    bDone = false;
+    jobSystem.AddJob(job.m_Queue);
+    while (!bDone)
+    {
+      nsThreadUtils::YieldTimeSlice();
+    }
+    jobSystem.Wait();
+    jobSystem.PublishFrameStats();
+    if (!jobSystem.GetLastFrameStats().m_Workers.IsEmpty())
+    {
+      NS_TEST_INT(jobSystem.GetLastFrameStats().m_Workers[0].m_uiAffinityMask, 0);
+    }
+    jobSystem.Shutdown();
+  }
+}
+
+NS_CREATE_SIMPLE_TEST(Multithreading, APCJobSystemContention)
+{
+  const nsUInt32 threadCounts[] = {1, 2, 4, 8, 16, 32};
+
+  std::atomic<nsUInt32> uiCounter = 0;
+  // Jobs point into themselves, so they are allocated once and never relocated.
+  nsArrayPtr<CountingJob> jobs = NS_DEFAULT_NEW_ARRAY(CountingJob, NUM_JOBS);
+  for (CountingJob& job : jobs)
+  {
+    job.Bind(&uiCounter);
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Shared deque vs. work-stealing throughput")
+  {
+    for (nsUInt32 uiThreads : threadCounts)
+    {
+      double fSharedJobsPerMs = 0.0;
+      {
+        SharedDequeJobSystem jobSystem(uiThreads);
+        uiCounter = 0;
+
+        const nsTime t0 = nsTime::Now();
+        for (nsUInt32 round = 0; round < NUM_ROUNDS; ++round)
+        {
+          for (CountingJob& job : jobs)
+          {
+            jobSystem.AddJob(&job.m_Queue);
+          }
+          jobSystem.Wait();
+        }
+        const nsTime t1 = nsTime::Now();
+
+        NS_TEST_INT(uiCounter.load(), NUM_JOBS * NUM_ROUNDS);
+        fSharedJobsPerMs = (NUM_JOBS * NUM_ROUNDS) / (t1 - t0).GetMilliseconds();
+      }
+
+      double fStealingJobsPerMs = 0.0;
+      {
+        aperture::core::threading::APCJobSystem jobSystem;
+        jobSystem.InitializeJobSystem({static_cast<nsUInt8>(uiThreads), 0, 0, 0, false});
+        uiCounter = 0;
+
+        const nsTime t0 = nsTime::Now();
+        for (nsUInt32 round = 0; round < NUM_ROUNDS; ++round)
+        {
+          for (CountingJob& job : jobs)
+          {
+            jobSystem.AddJob(job.m_Queue);
+          }
+          jobSystem.Wait();
+        }
+        const nsTime t1 = nsTime::Now();
+
+        NS_TEST_INT(uiCounter.load(), NUM_JOBS * NUM_ROUNDS);
+        fStealingJobsPerMs = (NUM_JOBS * NUM_ROUNDS) / (t1 - t0).GetMilliseconds();
+        jobSystem.Shutdown();
+      }
+
+      nsLog::Info("[test]APCJobSystem {0} threads: shared deque {1} jobs/ms, work-stealing {2} jobs/ms ({3}x)", uiThreads, nsArgF(fSharedJobsPerMs, 1), nsArgF(fStealingJobsPerMs, 1), nsArgF(fStealingJobsPerMs / fSharedJobsPerMs, 2));
+    }
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Dedicated threads vs. task system backend")
+  {
+    // A game frame: nsTaskSystem runs the game's ParallelFor while the UI jobs of all four pools run next to it.
+    constexpr nsUInt32 uiFrames = NUM_ROUNDS * 8;
+    for (nsUInt32 i = 0; i < jobs.GetCount(); ++i)
+    {
+      jobs[i].SetTypeByIndex(i);
+    }
+
+    nsDynamicArray<nsUInt32> gameData;
+    gameData.SetCount(NUM_JOBS * 4);
+    auto runFrames = [&](aperture::core::threading::APCJobSystem& ref_jobSystem, nsUInt64& out_uiContextSwitches) -> nsTime
+    {
+      uiCounter = 0;
+      const nsUInt64 uiSwitchesBefore = GetContextSwitches();
+      const nsTime t0 = nsTime::Now();
+      for (nsUInt32 uiFrame = 0; uiFrame < uiFrames; ++uiFrame)
+      {
+        for (CountingJob& job : jobs)
+        {
+          ref_jobSystem.AddJob(job.m_Queue);
+        }
+        nsTaskSystem::ParallelForSingle(gameData.GetArrayPtr(), [](nsUInt32& ref_uiItem)
+          { ref_uiItem = ref_uiItem * 1664525u + 1013904223u; });
+        ref_jobSystem.Wait();
+      }
+      const nsTime t1 = nsTime::Now();
+      out_uiContextSwitches = GetContextSwitches() - uiSwitchesBefore;
+      NS_TEST_INT(uiCounter.load(), NUM_JOBS * uiFrames);
+      return t1 - t0;
+    };
+
+    const nsUInt8 uiThreadsPerPool = static_cast<nsUInt8>(nsMath::Max(std::thread::hardware_concurrency() / 4, 1u));
+
+    nsUInt64 uiDedicatedSwitches = 0;
+    nsTime dedicatedTime;
+    {
+      aperture::core::threading::APCJobSystem jobSystem;
+      jobSystem.InitializeJobSystem({uiThreadsPerPool, uiThreadsPerPool, uiThreadsPerPool, uiThreadsPerPool, false});
+      dedicatedTime = runFrames(jobSystem, uiDedicatedSwitches);
+      jobSystem.Shutdown();
+    }
+
+    nsUInt64 uiTaskSystemSwitches = 0;
+    nsTime taskSystemTime;
+    {
+      aperture::core::threading::APCJobSystemConfig config;
+      config.m_backend = aperture::core::threading::APCJobSystemBackend::TaskSystem;
+      aperture::core::threading::APCJobSystem jobSystem;
+      jobSystem.InitializeJobSystem(config);
+      taskSystemTime = runFrames(jobSystem, uiTaskSystemSwitches);
+      jobSystem.Shutdown();
+    }
+
+    nsLog::Info("[test]APCJobSystem {0} frames, dedicated threads ({1} per pool): {2}ms, {3} context switches; task system backend: {4}ms, {5} context switches",
+      uiFrames, uiThreadsPerPool, nsArgF(dedicatedTime.GetMilliseconds(), 1), uiDedicatedSwitches, nsArgF(taskSystemTime.GetMilliseconds(), 1), uiTaskSystemSwitches);
+  }
+
+  NS_DEFAULT_DELETE_ARRAY(jobs);
+}
@@ -0,0 +1,172 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Time/Time.h>
+
+#include <APHTML/Interfaces/Internal/APCRingBuffer.h>
+#include <APHTML/Interfaces/Internal/APCThreadSafeQueue.h>
+
+namespace
+{
+  enum constants
+  {
+#if NS_ENABLED(NS_COMPILE_FOR_DEBUG)
+    NUM_ITEMS = 1024 * 128,
+#else
+    NUM_ITEMS = 1024 * 1024 * 4,
+#endif
+  };
+
+  /// Pushes 1..uiCount from every producer and pops from every consumer, returns the sum of everything popped.
+  template <typename Queue>
+  nsUInt64 RunProducersConsumers(Queue& ref_queue, nsUInt32 uiProducers, nsUInt32 uiConsumers, nsUInt32 uiCount)
+  {
+    std::atomic<nsUInt64> uiSum = 0;
+    std::atomic<nsUInt32> uiPopped = 0;
+    const nsUInt32 uiTotal = uiProducers * uiCount;
+
+    nsHybridArray<std::thread, 16> threads;
+    for (nsUInt32 p = 0; p < uiProducers; ++p)
+    {
+      threads.PushBack(std::thread([&]()
+        {
+        for (nsUInt32 i = 1; i <= uiCount; ++i)
+        {
+          while (!ref_queue.try_push(i))
+            std::this_thread::yield();
+        } }));
+    }
+
+    for (nsUInt32 c = 0; c < uiConsumers; ++c)
+    {
+      threads.PushBack(std::thread([&]()
+        {
+        nsUInt64 uiLocalSum = 0;
+        nsUInt32 uiValue = 0;
+        while (uiPopped.load(std::memory_order_relaxed) < uiTotal)
+        {
+          if (ref_queue.try_pop(uiValue))
+          {
+            uiLocalSum += uiValue;
+            uiPopped.fetch_add(1, std::memory_order_relaxed);
+          }
+          else
+          {
+            std::this_thread::yield();
+          }
+        }
+        uiSum += uiLocalSum; }));
+    }
+
+    for (std::thread& thread : threads)
+    {
+      thread.join();
+    }
+    return uiSum.load();
+  }
+
+  /// ThreadSafeQueue is unbounded and has no try_push, this gives it the same interface as the ring buffers.
+  template <typename T>
+  struct MutexQueue : public aperture::core::ThreadSafeQueue<T>
+  {
+    bool try_push(T val)
+    {
+      this->push(val);
+      return true;
+    }
+  };
+
+  constexpr nsUInt64 ExpectedSum(nsUInt32 uiProducers, nsUInt32 uiCount)
+  {
+    return static_cast<nsUInt64>(uiProducers) * uiCount * (uiCount + 1ull) / 2;
+  }
+} // namespace
+
+// Enable when needed
+#define NS_PERFORMANCE_TESTS_STATE nsTestBlock::DisabledNoWarning
+
+NS_CREATE_SIMPLE_TEST(Multithreading, APCRingBuffer)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "SPSC")
+  {
+    aperture::core::SPSCRingBuffer<nsUInt32> queue(5);
+    NS_TEST_INT(queue.capacity(), 8);
+
+    nsUInt32 uiValue = 0;
+    NS_TEST_BOOL(!queue.try_pop(uiValue));
+    NS_TEST_BOOL(!queue.try_front(uiValue));
+
+    for (nsUInt32 i = 0; i < 8; ++i)
+    {
+      NS_TEST_BOOL(queue.try_push(i));
+    }
+    NS_TEST_BOOL(!queue.try_push(8u));
+    NS_TEST_INT(queue.size_approx(), 8);
+
+    NS_TEST_BOOL(queue.try_front(uiValue));
+    NS_TEST_INT(uiValue, 0);
+    for (nsUInt32 i = 0; i < 8; ++i)
+    {
+      NS_TEST_BOOL(queue.try_pop(uiValue));
+      NS_TEST_INT(uiValue, i);
+    }
+    NS_TEST_BOOL(queue.empty_approx());
+
+    NS_TEST_INT(RunProducersConsumers(queue, 1, 1, 1024 * 64), ExpectedSum(1, 1024 * 64));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "MPMC")
+  {
+    aperture::core::MPMCRingBuffer<nsUInt32> queue(1);
+    NS_TEST_INT(queue.capacity(), 2);
+
+    nsUInt32 uiValue = 0;
+    NS_TEST_BOOL(queue.try_push(1u));
+    NS_TEST_BOOL(queue.try_push(2u));
+    NS_TEST_BOOL(!queue.try_push(3u));
+    NS_TEST_BOOL(queue.try_pop(uiValue));
+    NS_TEST_INT(uiValue, 1);
+    NS_TEST_BOOL(queue.try_pop(uiValue));
+    NS_TEST_INT(uiValue, 2);
+    NS_TEST_BOOL(!queue.try_pop(uiValue));
+
+    aperture::core::MPMCRingBuffer<nsUInt32> bigQueue(256);
+    NS_TEST_INT(RunProducersConsumers(bigQueue, 4, 4, 1024 * 16), ExpectedSum(4, 1024 * 16));
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "SPSC vs. ThreadSafeQueue")
+  {
+    MutexQueue<nsUInt32> mutexQueue;
+    const nsTime t0 = nsTime::Now();
+    NS_TEST_INT(RunProducersConsumers(mutexQueue, 1, 1, NUM_ITEMS), ExpectedSum(1, NUM_ITEMS));
+    const nsTime t1 = nsTime::Now();
+
+    aperture::core::SPSCRingBuffer<nsUInt32> ringQueue(1024);
+    const nsTime t2 = nsTime::Now();
+    NS_TEST_INT(RunProducersConsumers(ringQueue, 1, 1, NUM_ITEMS), ExpectedSum(1, NUM_ITEMS));
+    const nsTime t3 = nsTime::Now();
+
+    nsLog::Info("[test]1P/1C ThreadSafeQueue: {0}ms, SPSCRingBuffer: {1}ms", nsArgF((t1 - t0).GetMilliseconds(), 2), nsArgF((t3 - t2).GetMilliseconds(), 2));
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "MPMC vs. ThreadSafeQueue")
+  {
+    const nsUInt32 threadCounts[] = {1, 2, 4, 8};
+    for (nsUInt32 uiThreads : threadCounts)
+    {
+      const nsUInt32 uiCount = NUM_ITEMS / uiThreads;
+
+      MutexQueue<nsUInt32> mutexQueue;
+      const nsTime t0 = nsTime::Now();
+      NS_TEST_INT(RunProducersConsumers(mutexQueue, uiThreads, uiThreads, uiCount), ExpectedSum(uiThreads, uiCount));
+      const nsTime t1 = nsTime::Now();
+
+      aperture::core::MPMCRingBuffer<nsUInt32> ringQueue(1024);
+      const nsTime t2 = nsTime::Now();
+      NS_TEST_INT(RunProducersConsumers(ringQueue, uiThreads, uiThreads, uiCount), ExpectedSum(uiThreads, uiCount));
+      const nsTime t3 = nsTime::Now();
+
+      nsLog::Info("[test]{0}P/{0}C ThreadSafeQueue: {1}ms, MPMCRingBuffer: {2}ms", uiThreads, nsArgF((t1 - t0).GetMilliseconds(), 2), nsArgF((t3 - t2).GetMilliseconds(), 2));
+    }
+  }
+}
@@ -0,0 +1,155 @@
+#include <ApertureCoreTest/ApertureCoreTestPCH.h>
+
+#include <APHTML/Multithreading/APCTimerWheel.h>
+
+#include <memory>
+
+namespace
+{
+  using namespace aperture::core::threading;
+
+  struct FiredTimer
+  {
+    nsUInt32 m_uiId = 0;
+    nsTime m_Due;
+  };
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(Multithreading, APCTimerWheel)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Never early, at most one step late")
+  {
+    APCTimerWheel<FiredTimer> wheel;
+
+    // Spread over all levels and past the end of the wheel, which spans about 4.6 hours.
+    const double delaysInMs[] = {0.0, 0.5, 1.0, 7.0, 63.0, 64.0, 65.0, 1000.0, 4095.0, 4096.0, 4097.0, 262144.0, 300000.0, 16777215.0, 16777216.0, 36000000.0};
+    for (nsUInt32 i = 0; i < NS_ARRAY_SIZE(delaysInMs); ++i)
+    {
+      wheel.Insert(nsTime::MakeFromMilliseconds(delaysInMs[i]), {i, nsTime::MakeFromMilliseconds(delaysInMs[i])});
+    }
+    NS_TEST_INT(wheel.GetCount(), NS_ARRAY_SIZE(delaysInMs));
+
+    nsUInt32 uiFired = 0;
+    bool bInOrder = true;
+    bool bOnTime = true;
+    nsTime lastDue;
+    auto onFire = [&](FiredTimer& ref_timer)
+    {
+      bOnTime &= ref_timer.m_Due <= wheel.GetCurrentTime() && wheel.GetCurrentTime() - ref_timer.m_Due <= wheel.GetResolution();
+      bInOrder &= ref_timer.m_Due >= lastDue;
+      lastDue = ref_timer.m_Due;
+      ++uiFired;
+    };
+
+    // 1 ms frames close to the next timer, big jumps in between.
+    nsTime now;
+    for (nsUInt32 uiFrame = 0; uiFrame < 10000 && !wheel.IsEmpty(); ++uiFrame)
+    {
+      const nsTime nextDue = nsTime::MakeFromMilliseconds(delaysInMs[uiFired]);
+      now = nsMath::Max(now + nsTime::MakeFromMilliseconds(1), nextDue - nsTime::MakeFromMilliseconds(3));
+      wheel.Advance(now, onFire);
+    }
+    NS_TEST_INT(uiFired, NS_ARRAY_SIZE(delaysInMs));
+    NS_TEST_BOOL(bInOrder);
+    NS_TEST_BOOL(bOnTime);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "One big jump")
+  {
+    APCTimerWheel<FiredTimer> wheel;
+    for (nsUInt32 i = 0; i < 1000; ++i)
+    {
+      wheel.Insert(nsTime::MakeFromMilliseconds(i * 37.0), {i, nsTime::MakeFromMilliseconds(i * 37.0)});
+    }
+
+    nsUInt32 uiFired = 0;
+    bool bInOrder = true;
+    nsUInt32 uiLastId = 0;
+    NS_TEST_INT(wheel.Advance(nsTime::MakeFromSeconds(20), [&](FiredTimer& ref_timer)
+                  {
+                    bInOrder &= uiFired == 0 || ref_timer.m_uiId > uiLastId;
+                    uiLastId = ref_timer.m_uiId;
+                    ++uiFired; }),
+      541);
+    NS_TEST_BOOL(bInOrder);
+    NS_TEST_INT(wheel.GetCount(), 459);
+    NS_TEST_INT(wheel.Advance(nsTime::MakeFromSeconds(40), [](FiredTimer&) {}), 459);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Cancel and handle reuse")
+  {
+    APCTimerWheel<std::unique_ptr<nsUInt32>> wheel;
+    const APCTimerHandle a = wheel.Insert(nsTime::MakeFromMilliseconds(10), std::make_unique<nsUInt32>(1));
+    const APCTimerHandle b = wheel.Insert(nsTime::MakeFromSeconds(100), std::make_unique<nsUInt32>(2));
+    const APCTimerHandle c = wheel.Insert(nsTime::MakeFromMilliseconds(20), std::make_unique<nsUInt32>(3));
+
+    std::unique_ptr<nsUInt32> pCanceled;
+    NS_TEST_BOOL(wheel.Cancel(b, &pCanceled));
+    NS_TEST_BOOL(pCanceled != nullptr && *pCanceled == 2);
+    NS_TEST_BOOL(!wheel.Cancel(b));
+    NS_TEST_BOOL(!wheel.IsPending(b));
+
+    // The freed node is reused, the old handle must not reach the new timer.
+    const APCTimerHandle d = wheel.Insert(nsTime::MakeFromMilliseconds(30), std::make_unique<nsUInt32>(4));
+    NS_TEST_INT(d.m_uiIndex, b.m_uiIndex);
+    NS_TEST_BOOL(d != b);
+    NS_TEST_BOOL(!wheel.Cancel(b));
+    NS_TEST_BOOL(wheel.IsPending(d));
+
+    nsUInt32 uiSum = 0;
+    wheel.Advance(nsTime::MakeFromMilliseconds(25), [&](std::unique_ptr<nsUInt32>& ref_pValue)
+      { uiSum += *ref_pValue; });
+    NS_TEST_INT(uiSum, 4);
+    NS_TEST_BOOL(!wheel.IsPending(a));
+    NS_TEST_BOOL(!wheel.Cancel(c));
+    NS_TEST_INT(wheel.GetCount(), 1);
+    NS_TEST_INT(**wheel.GetPayload(d), 4);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Re-arm from the callback")
+  {
+    // What setInterval does: every fired timer inserts itself again.
+    APCTimerWheel<FiredTimer> wheel;
+    wheel.Insert(nsTime::MakeFromMilliseconds(16), {0, nsTime::MakeFromMilliseconds(16)});
+    APCTimerHandle zeroDelay = wheel.Insert(nsTime::MakeZero(), {1, nsTime::MakeZero()});
+
+    nsUInt32 uiIntervalRuns = 0;
+    nsUInt32 uiZeroDelayRuns = 0;
+    nsTime now;
+    for (nsUInt32 uiFrame = 0; uiFrame < 100; ++uiFrame)
+    {
+      now += nsTime::MakeFromMilliseconds(5);
+      wheel.Advance(now, [&](FiredTimer& ref_timer)
+        {
+          if (ref_timer.m_uiId == 0)
+          {
+            ++uiIntervalRuns;
+            wheel.Insert(ref_timer.m_Due + nsTime::MakeFromMilliseconds(16), {0, ref_timer.m_Due + nsTime::MakeFromMilliseconds(16)});
+          }
+          else
+          {
+            // Due right away again, must wait for the next Advance() instead of looping here.
+            ++uiZeroDelayRuns;
+            zeroDelay = wheel.Insert(nsTime::MakeZero(), {1, nsTime::MakeZero()});
+          } });
+    }
+    NS_TEST_INT(uiIntervalRuns, 31);
+    NS_TEST_INT(uiZeroDelayRuns, 100);
+    NS_TEST_BOOL(wheel.Cancel(zeroDelay));
+    NS_TEST_INT(wheel.GetCount(), 1);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Start time")
+  {
+    // Anchored at a large clock value, nothing is walked from zero.
+    const nsTime start = nsTime::MakeFromHours(240);
+    APCTimerWheel<FiredTimer> wheel(nsTime::MakeFromMilliseconds(1), start);
+    wheel.Insert(start + nsTime::MakeFromMilliseconds(50), {});
+    NS_TEST_INT(wheel.Advance(start + nsTime::MakeFromMilliseconds(49), [](FiredTimer&) {}), 0);
+    NS_TEST_INT(wheel.Advance(start + nsTime::MakeFromMilliseconds(50), [](FiredTimer&) {}), 1);
+
+    wheel.Clear(start + nsTime::MakeFromHours(1));
+    NS_TEST_BOOL(wheel.IsEmpty());
+    NS_TEST_BOOL(wheel.GetCurrentTime() == start + nsTime::MakeFromHours(1));
+  }
+}
@@ -2,19 +2,9 @@
 #include <Foundation/IO/FileSystem/FileSystem.h>
 #include <Foundation/IO/OSFile.h>
 
-aperture::core::APCBuffer APHTMLTEST_APCFileSystem::GetFileData(const char* in_filepath)
+aperture::core::CoreBuffer<nsUInt8> APHTMLTEST_APCFileSystem::GetFileData(const char* in_filepath)
 {
-  nsOSFile apcfile;
-  nsStringBuilder filep(this->m_uiresources);
-  filep.Append(in_filepath);
-  apcfile.Open(filep, nsFileOpenMode::Read);
-  if (apcfile.IsOpen())
-  {
-    nsDataBuffer dataBuffer;
-    apcfile.ReadAll(dataBuffer);
-    apcfile.Close();
-    return dataBuffer;
-  }
+  return aperture::core::IAPCFileSystem::GetFileData(in_filepath);
 }
 
 bool APHTMLTEST_APCFileSystem::FileExists(const nsString& in_filepath)
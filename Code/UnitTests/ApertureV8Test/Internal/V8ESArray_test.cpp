@@ -0,0 +1,199 @@
+#include <FoundationTest/FoundationTestPCH.h>
+
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Time/Time.h>
+
+#include <V8Engine/System/Internal/V8ESArray.h>
+
+#include <memory>
+
+namespace
+{
+  enum SArrayConstants
+  {
+    NUM_HANDLES = 1000000,
+    NUM_CHURN_ROUNDS = 4,
+  };
+
+  using HandleTable = aperture::v8::internal::SArray<nsUInt32>;
+  using HandleIndex = aperture::v8::internal::TIndex<nsUInt32>;
+} // namespace
+
+// Enable when needed
+#define NS_PERFORMANCE_TESTS_STATE nsTestBlock::DisabledNoWarning
+
+NS_CREATE_SIMPLE_TEST_GROUP(Internal);
+
+NS_CREATE_SIMPLE_TEST(Internal, V8ESArray)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Add and Remove")
+  {
+    HandleTable table;
+    const HandleIndex a = table.add(1);
+    const HandleIndex b = table.add(2);
+    const HandleIndex c = table.add(3);
+
+    NS_TEST_INT(table.size(), 3);
+    NS_TEST_INT(table.get_value(b), 2);
+    NS_TEST_BOOL(table.get_first_index() == a);
+    NS_TEST_BOOL(table.get_last_index() == c);
+
+    NS_TEST_BOOL(table.remove_at(b));
+    NS_TEST_BOOL(!table.is_valid_index(b));
+    NS_TEST_BOOL(!table.remove_at(b));
+    NS_TEST_BOOL(table.get_next_index(a) == c);
+
+    // the slot is reused with a new revision, the old index stays invalid
+    const HandleIndex d = table.add(4);
+    NS_TEST_INT(d.get_index(), b.get_index());
+    NS_TEST_BOOL(d != b);
+    NS_TEST_BOOL(!table.is_valid_index(b));
+    NS_TEST_INT(table.get_value(d), 4);
+
+    table.clear();
+    NS_TEST_BOOL(table.is_empty());
+    NS_TEST_BOOL(!table.is_valid_index(a));
+    NS_TEST_BOOL(!table.get_first_index().is_valid());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Growth")
+  {
+    HandleTable table;
+    NS_TEST_INT(table.capacity(), 8);
+
+    nsDynamicArray<HandleIndex> indices;
+    for (nsUInt32 i = 0; i < 1000; ++i)
+    {
+      indices.PushBack(table.add(i));
+    }
+
+    // grows geometrically and keeps every item
+    NS_TEST_INT(table.capacity(), 1024);
+
+    bool bAllKept = true;
+    for (nsUInt32 i = 0; i < 1000; ++i)
+    {
+      bAllKept &= table.is_valid_index(indices[i]) && table.get_value(indices[i]) == i;
+    }
+    NS_TEST_BOOL(bAllKept);
+
+    nsUInt32 uiCount = 0;
+    for (nsUInt32 uiValue : table)
+    {
+      bAllKept &= (uiValue == uiCount);
+      ++uiCount;
+    }
+    NS_TEST_INT(uiCount, 1000);
+    NS_TEST_BOOL(bAllKept);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Reserve")
+  {
+    HandleTable table;
+    table.add(7);
+    table.reserve(5000);
+    NS_TEST_INT(table.capacity(), 5000);
+
+    for (nsUInt32 i = 1; i < 5000; ++i)
+    {
+      table.add(i);
+    }
+    NS_TEST_INT(table.capacity(), 5000);
+    NS_TEST_INT(table.get_first_value(), 7);
+
+    table.reserve(100);
+    NS_TEST_INT(table.capacity(), 5000);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Non-trivial Values")
+  {
+    nsConstructionCounter::Reset();
+
+    {
+      aperture::v8::internal::SArray<nsConstructionCounter> table;
+      nsDynamicArray<HandleIndex> indices;
+
+      for (nsInt32 i = 0; i < 100; ++i)
+      {
+        indices.PushBack(table.add(nsConstructionCounter(i)));
+      }
+
+      bool bAllKept = true;
+      for (nsInt32 i = 0; i < 100; ++i)
+      {
+        bAllKept &= table.get_value(indices[i]).m_iData == i;
+      }
+      NS_TEST_BOOL(bAllKept);
+
+      table.remove_at(indices[50]);
+      NS_TEST_INT(table.size(), 99);
+    }
+
+    NS_TEST_BOOL(nsConstructionCounter::HasAllDestructed());
+
+    // move-only values survive relocation
+    aperture::v8::internal::SArray<std::unique_ptr<nsUInt32>> table;
+    const HandleIndex first = table.add(std::make_unique<nsUInt32>(42));
+    for (nsUInt32 i = 0; i < 100; ++i)
+    {
+      table.add(std::make_unique<nsUInt32>(i));
+    }
+
+    NS_TEST_BOOL(table.get_value(first) != nullptr);
+    NS_TEST_INT(*table.get_value(first), 42);
+
+    table.remove_at(first);
+    NS_TEST_BOOL(table.get_first_value() != nullptr);
+    NS_TEST_INT(*table.get_first_value(), 0);
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Handle Churn")
+  {
+    nsDynamicArray<HandleIndex> indices;
+    indices.SetCount(NUM_HANDLES);
+
+    HandleTable grownTable;
+    const nsTime tGrow0 = nsTime::Now();
+    for (nsUInt32 i = 0; i < NUM_HANDLES; ++i)
+    {
+      indices[i] = grownTable.add(i);
+    }
+    const nsTime tGrow1 = nsTime::Now();
+
+    HandleTable reservedTable;
+    const nsTime tReserve0 = nsTime::Now();
+    reservedTable.reserve(NUM_HANDLES);
+    for (nsUInt32 i = 0; i < NUM_HANDLES; ++i)
+    {
+      reservedTable.add(i);
+    }
+    const nsTime tReserve1 = nsTime::Now();
+
+    // removes every other handle in a scattered order and adds a replacement for it, like objects dying and being created
+    const nsTime tChurn0 = nsTime::Now();
+    for (nsUInt32 uiRound = 0; uiRound < NUM_CHURN_ROUNDS; ++uiRound)
+    {
+      for (nsUInt32 i = uiRound & 1; i < NUM_HANDLES; i += 2)
+      {
+        const nsUInt32 uiSlot = (i * 2654435761u) % NUM_HANDLES;
+        grownTable.remove_at(indices[uiSlot]);
+        indices[uiSlot] = grownTable.add(uiSlot);
+      }
+    }
+    const nsTime tChurn1 = nsTime::Now();
+
+    NS_TEST_INT(grownTable.size(), NUM_HANDLES);
+    NS_TEST_INT(grownTable.capacity(), 1024 * 1024);
+
+    bool bAllValid = true;
+    for (nsUInt32 i = 0; i < NUM_HANDLES; ++i)
+    {
+      bAllValid &= grownTable.is_valid_index(indices[i]) && grownTable.get_value(indices[i]) == i;
+    }
+    NS_TEST_BOOL(bAllValid);
+
+    nsLog::Info("[test]{0} handles: adding {1}ms, adding after reserve {2}ms, {3} rounds of remove/add churn {4}ms", NUM_HANDLES,
+      nsArgF((tGrow1 - tGrow0).GetMilliseconds(), 2), nsArgF((tReserve1 - tReserve0).GetMilliseconds(), 2), NUM_CHURN_ROUNDS,
+      nsArgF((tChurn1 - tChurn0).GetMilliseconds(), 2));
+  }
+}
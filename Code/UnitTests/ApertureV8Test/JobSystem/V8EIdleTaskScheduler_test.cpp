@@ -0,0 +1,101 @@
+#include <FoundationTest/FoundationTestPCH.h>
+
+#include <Foundation/Threading/ThreadUtils.h>
+
+#include <V8Engine/System/JobSystem/V8EIdleTaskScheduler.h>
+
+namespace
+{
+  struct IdleRecord
+  {
+    nsUInt32 m_uiRuns = 0;
+    double m_fLastDeadline = 0.0;
+  };
+
+  /// Works for a fixed time, as if it was finalizing part of a GC cycle.
+  class SleepingIdleTask : public ::v8::IdleTask
+  {
+  public:
+    SleepingIdleTask(IdleRecord& ref_record, nsTime p_duration)
+      : m_Record(ref_record)
+      , m_Duration(p_duration)
+    {
+    }
+
+    virtual void Run(double p_fDeadlineInSeconds) override
+    {
+      m_Record.m_uiRuns++;
+      m_Record.m_fLastDeadline = p_fDeadlineInSeconds;
+      nsThreadUtils::Sleep(m_Duration);
+    }
+
+  private:
+    IdleRecord& m_Record;
+    nsTime m_Duration;
+  };
+} // namespace
+
+NS_CREATE_SIMPLE_TEST(JobSystem, V8EIdleTaskScheduler)
+{
+  // No platform, the scheduler measures on nsTime::Now().
+  aperture::v8::jobsystem::V8EIdleTaskScheduler scheduler;
+  IdleRecord record;
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "No budget, no idle tasks")
+  {
+    for (nsUInt32 i = 0; i < 8; ++i)
+    {
+      scheduler.PostIdleTask(std::make_unique<SleepingIdleTask>(record, nsTime::MakeFromMilliseconds(2)));
+    }
+
+    scheduler.BeginFrame(nsTime::MakeZero());
+    NS_TEST_INT(scheduler.RunIdleTasks(), 0);
+    scheduler.EndFrame();
+    NS_TEST_INT(record.m_uiRuns, 0);
+    NS_TEST_INT(scheduler.GetLastFrameStats().m_uiTasksPending, 8);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Stay within the frame budget")
+  {
+    // Sleeping takes at least as long as asked, so a 10 ms frame fits at most 4 tasks of 2 ms with a 1 ms minimum slice.
+    scheduler.BeginFrame(nsTime::MakeFromMilliseconds(10));
+    const nsTime deadline = scheduler.GetTime() + scheduler.GetRemainingFrameTime();
+    const nsUInt32 uiRun = scheduler.RunIdleTasks();
+    scheduler.EndFrame();
+
+    NS_TEST_BOOL(uiRun >= 1 && uiRun <= 5);
+    NS_TEST_INT(record.m_uiRuns, uiRun);
+    NS_TEST_DOUBLE(record.m_fLastDeadline, deadline.GetSeconds(), 0.001);
+
+    const aperture::v8::jobsystem::V8EIdleFrameStats& stats = scheduler.GetLastFrameStats();
+    NS_TEST_INT(stats.m_uiTasksRun, uiRun);
+    NS_TEST_INT(stats.m_uiTasksPending, 8 - uiRun);
+    NS_TEST_BOOL(stats.m_IdleTimeAvailable <= nsTime::MakeFromMilliseconds(10));
+    NS_TEST_BOOL(stats.m_IdleTimeUsed >= nsTime::MakeFromMilliseconds(2) * uiRun);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Leftovers run in later frames")
+  {
+    for (nsUInt32 uiFrame = 0; uiFrame < 20 && scheduler.GetPendingTaskCount() > 0; ++uiFrame)
+    {
+      scheduler.BeginFrame(nsTime::MakeFromMilliseconds(10));
+      scheduler.RunIdleTasks();
+      scheduler.EndFrame();
+    }
+    NS_TEST_INT(record.m_uiRuns, 8);
+    NS_TEST_INT(scheduler.GetPendingTaskCount(), 0);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Minimum idle slice")
+  {
+    scheduler.PostIdleTask(std::make_unique<SleepingIdleTask>(record, nsTime::MakeZero()));
+    scheduler.SetMinimumIdleSlice(nsTime::MakeFromMilliseconds(50));
+    scheduler.BeginFrame(nsTime::MakeFromMilliseconds(10));
+    NS_TEST_INT(scheduler.RunIdleTasks(), 0);
+
+    scheduler.SetMinimumIdleSlice(nsTime::MakeFromMilliseconds(1));
+    NS_TEST_INT(scheduler.RunIdleTasks(), 1);
+    scheduler.EndFrame();
+    NS_TEST_INT(record.m_uiRuns, 9);
+  }
+}
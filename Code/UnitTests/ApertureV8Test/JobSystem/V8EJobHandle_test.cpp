@@ -0,0 +1,308 @@
+#include <FoundationTest/FoundationTestPCH.h>
+
+#include <Foundation/Threading/ThreadUtils.h>
+#include <Foundation/Time/Time.h>
+
+#include <APHTML/APEngine.h>
+#include <V8Engine/Core/V8EngineMain.h>
+#include <V8Engine/System/JobSystem/V8EJobManager.h>
+
+#include <atomic>
+
+namespace
+{
+  /// Splits a fixed amount of work items between as many workers as the job gets, at most 4.
+  class CountingJobTask : public ::v8::JobTask
+  {
+  public:
+    explicit CountingJobTask(nsUInt32 p_uiItems)
+      : m_uiRemaining(p_uiItems)
+    {
+    }
+
+    virtual void Run(::v8::JobDelegate* p_pDelegate) override
+    {
+      const nsUInt32 uiRunning = m_uiRunning.fetch_add(1) + 1;
+      nsUInt32 uiMax = m_uiMaxRunning.load();
+      while (uiRunning > uiMax && !m_uiMaxRunning.compare_exchange_weak(uiMax, uiRunning))
+      {
+      }
+
+      // Two workers of the same job never share a task ID.
+      const nsUInt8 uiTaskId = p_pDelegate->GetTaskId();
+      if (uiTaskId >= 32 || (m_uiTaskIdsInUse.fetch_or(1u << uiTaskId) & (1u << uiTaskId)) != 0)
+      {
+        m_bTaskIdClash = true;
+      }
+      if (p_pDelegate->IsJoiningThread())
+      {
+        m_bJoiningThreadRan = true;
+      }
+
+      while (!p_pDelegate->ShouldYield())
+      {
+        nsUInt32 uiRemaining = m_uiRemaining.load();
+        if (uiRemaining == 0 || !m_uiRemaining.compare_exchange_weak(uiRemaining, uiRemaining - 1))
+        {
+          if (uiRemaining == 0)
+            break;
+          continue;
+        }
+        nsThreadUtils::YieldTimeSlice();
+        m_uiProcessed.fetch_add(1);
+      }
+
+      if (uiTaskId < 32)
+      {
+        m_uiTaskIdsInUse.fetch_and(~(1u << uiTaskId));
+      }
+      m_uiRunning.fetch_sub(1);
+    }
+
+    virtual size_t GetMaxConcurrency(size_t p_uiWorkerCount) const override
+    {
+      return nsMath::Min<size_t>(m_uiRemaining.load() + p_uiWorkerCount, 4);
+    }
+
+    std::atomic<nsUInt32> m_uiRemaining;
+    std::atomic<nsUInt32> m_uiProcessed = 0;
+    std::atomic<nsUInt32> m_uiRunning = 0;
+    std::atomic<nsUInt32> m_uiMaxRunning = 0;
+    std::atomic<nsUInt32> m_uiTaskIdsInUse = 0;
+    std::atomic<bool> m_bTaskIdClash = false;
+    std::atomic<bool> m_bJoiningThreadRan = false;
+  };
+
+  /// Never runs out of work, only stops when it is told to yield.
+  class EndlessJobTask : public ::v8::JobTask
+  {
+  public:
+    virtual void Run(::v8::JobDelegate* p_pDelegate) override
+    {
+      m_uiRuns.fetch_add(1);
+      while (!p_pDelegate->ShouldYield())
+      {
+        nsThreadUtils::YieldTimeSlice();
+      }
+    }
+
+    virtual size_t GetMaxConcurrency(size_t p_uiWorkerCount) const override { return 2; }
+
+    std::atomic<nsUInt32> m_uiRuns = 0;
+  };
+
+  /// Counts its runs and works for a fixed time.
+  class CountingIdleTask : public ::v8::IdleTask
+  {
+  public:
+    CountingIdleTask(nsUInt32& ref_uiRuns, nsTime p_duration)
+      : m_uiRuns(ref_uiRuns)
+      , m_Duration(p_duration)
+    {
+    }
+
+    virtual void Run(double p_fDeadlineInSeconds) override
+    {
+      m_uiRuns++;
+      nsThreadUtils::Sleep(m_Duration);
+    }
+
+  private:
+    nsUInt32& m_uiRuns;
+    nsTime m_Duration;
+  };
+
+  struct GCPauseStats
+  {
+    nsTime m_Start;
+    nsTime m_Total;
+    nsTime m_Longest;
+    nsUInt32 m_uiCount = 0;
+  };
+
+  void OnGCPrologue(::v8::Isolate* p_pIsolate, ::v8::GCType p_type, ::v8::GCCallbackFlags p_flags, void* p_pData)
+  {
+    static_cast<GCPauseStats*>(p_pData)->m_Start = nsTime::Now();
+  }
+
+  void OnGCEpilogue(::v8::Isolate* p_pIsolate, ::v8::GCType p_type, ::v8::GCCallbackFlags p_flags, void* p_pData)
+  {
+    GCPauseStats& stats = *static_cast<GCPauseStats*>(p_pData);
+    const nsTime pause = nsTime::Now() - stats.m_Start;
+    stats.m_Total += pause;
+    stats.m_Longest = nsMath::Max(stats.m_Longest, pause);
+    stats.m_uiCount++;
+  }
+
+  /// Runs an allocation heavy script in a fresh isolate and measures the time the script thread spends in GC pauses.
+  GCPauseStats RunAllocationScript()
+  {
+    GCPauseStats stats;
+
+    ::v8::Isolate::CreateParams createParams;
+    createParams.array_buffer_allocator = ::v8::ArrayBuffer::Allocator::NewDefaultAllocator();
+    ::v8::Isolate* pIsolate = ::v8::Isolate::New(createParams);
+    pIsolate->AddGCPrologueCallback(OnGCPrologue, &stats);
+    pIsolate->AddGCEpilogueCallback(OnGCEpilogue, &stats);
+    {
+      ::v8::Isolate::Scope isolateScope(pIsolate);
+      ::v8::HandleScope handleScope(pIsolate);
+      ::v8::Local<::v8::Context> context = ::v8::Context::New(pIsolate);
+      ::v8::Context::Scope contextScope(context);
+
+      // Keeps a large, changing set of objects alive, so old generation marking has real work to do.
+      ::v8::Local<::v8::String> source = ::v8::String::NewFromUtf8Literal(pIsolate,
+        "let live = [];"
+        "for (let i = 0; i < 3000000; ++i) {"
+        "  const node = { id: i, name: 'node' + i, children: [i, i + 1, i + 2] };"
+        "  live[i % 200000] = node;"
+        "}"
+        "live.length;");
+      ::v8::Local<::v8::Script> script = ::v8::Script::Compile(context, source).ToLocalChecked();
+      script->Run(context).ToLocalChecked();
+    }
+    pIsolate->RemoveGCPrologueCallback(OnGCPrologue, &stats);
+    pIsolate->RemoveGCEpilogueCallback(OnGCEpilogue, &stats);
+    pIsolate->Dispose();
+    delete createParams.array_buffer_allocator;
+    return stats;
+  }
+} // namespace
+
+#define NS_PERFORMANCE_TESTS_STATE nsTestBlock::DisabledNoWarning
+
+NS_CREATE_SIMPLE_TEST_GROUP(JobSystem);
+NS_CREATE_SIMPLE_TEST(JobSystem, V8EJobHandle)
+{
+  if (!aperture::ApertureSDK::IsSDKActive())
+  {
+    aperture::ApertureSDK::SetScriptThreadCount(2);
+    aperture::ApertureSDK::Initialize();
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Jobs")
+  {
+    // Jobs only need the platform and the script workers, V8 itself stays uninitialized.
+    aperture::v8::jobsystem::V8EJobManager jobManager;
+    NS_TEST_BOOL(jobManager.Initialize());
+    aperture::v8::jobsystem::V8EPlatform platform(aperture::ApertureSDK::GetScriptThreadCount(), ::v8::platform::IdleTaskSupport::kEnabled, ::v8::platform::InProcessStackDumping::kEnabled, nullptr, ::v8::platform::PriorityMode::kApply);
+    jobManager.SetPlatform(&platform);
+    ::v8::Platform& v8Platform = platform;
+
+    NS_TEST_BOOL(v8Platform.GetTracingController() != nullptr);
+
+    {
+      auto pTask = std::make_unique<CountingJobTask>(1000);
+      CountingJobTask& task = *pTask;
+      std::unique_ptr<::v8::JobHandle> pHandle = v8Platform.PostJob(::v8::TaskPriority::kUserVisible, std::move(pTask));
+      NS_TEST_BOOL(pHandle->IsValid());
+      NS_TEST_BOOL(pHandle->UpdatePriorityEnabled());
+
+      pHandle->Join();
+      NS_TEST_BOOL(!pHandle->IsValid());
+      NS_TEST_INT(task.m_uiProcessed.load(), 1000);
+      NS_TEST_INT(task.m_uiRunning.load(), 0);
+      NS_TEST_BOOL(task.m_uiMaxRunning.load() <= 3);
+      NS_TEST_BOOL(!task.m_bTaskIdClash);
+    }
+
+    // Without workers, the joining thread does all the work.
+    {
+      const nsUInt32 uiMaxJobWorkers = platform.GetMaxJobWorkers();
+      platform.SetMaxJobWorkers(0);
+      auto pTask = std::make_unique<CountingJobTask>(100);
+      CountingJobTask& task = *pTask;
+      std::unique_ptr<::v8::JobHandle> pHandle = v8Platform.PostJob(::v8::TaskPriority::kBestEffort, std::move(pTask));
+      pHandle->UpdatePriority(::v8::TaskPriority::kUserBlocking);
+      pHandle->Join();
+      NS_TEST_INT(task.m_uiProcessed.load(), 100);
+      NS_TEST_INT(task.m_uiMaxRunning.load(), 1);
+      NS_TEST_BOOL(task.m_bJoiningThreadRan);
+      platform.SetMaxJobWorkers(uiMaxJobWorkers);
+    }
+
+    {
+      auto pTask = std::make_unique<EndlessJobTask>();
+      EndlessJobTask& task = *pTask;
+      std::unique_ptr<::v8::JobHandle> pHandle = v8Platform.PostJob(::v8::TaskPriority::kUserVisible, std::move(pTask));
+      const nsTime timeout = nsTime::Now() + nsTime::MakeFromSeconds(10);
+      while (task.m_uiRuns.load() == 0 && nsTime::Now() < timeout)
+      {
+        nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(1));
+      }
+      NS_TEST_BOOL(pHandle->IsActive());
+
+      // Cancel() only returns once no worker runs the task anymore.
+      pHandle->Cancel();
+      NS_TEST_BOOL(!pHandle->IsValid());
+      NS_TEST_BOOL(task.m_uiRuns.load() > 0);
+    }
+
+    jobManager.EndFrame();
+    jobManager.EndFrame();
+    jobManager.Shutdown();
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Idle tasks run at the end of the frame")
+  {
+    aperture::v8::jobsystem::V8EJobManager jobManager;
+    NS_TEST_BOOL(jobManager.Initialize());
+    aperture::v8::jobsystem::V8EPlatform platform(aperture::ApertureSDK::GetScriptThreadCount(), ::v8::platform::IdleTaskSupport::kEnabled, ::v8::platform::InProcessStackDumping::kEnabled, nullptr, ::v8::platform::PriorityMode::kApply);
+    jobManager.SetPlatform(&platform);
+
+    // Posted the way V8 posts them, through the task runner.
+    aperture::v8::jobsystem::V8EWorkerTaskRunner taskRunner(aperture::ApertureSDK::GetScriptThreadCount(), nullptr);
+    taskRunner.SetJobManager(&jobManager);
+    NS_TEST_BOOL(taskRunner.IdleTasksEnabled());
+
+    nsUInt32 uiRuns = 0;
+    for (nsUInt32 i = 0; i < 8; ++i)
+    {
+      taskRunner.PostIdleTask(std::make_unique<CountingIdleTask>(uiRuns, nsTime::MakeFromMilliseconds(2)));
+    }
+    const aperture::v8::jobsystem::V8EIdleTaskScheduler& idleTasks = jobManager.GetIdleTaskScheduler();
+    NS_TEST_INT(idleTasks.GetPendingTaskCount(), 8);
+
+    // A frame without time left runs none of them.
+    jobManager.EndFrame();
+    NS_TEST_INT(uiRuns, 0);
+    NS_TEST_INT(idleTasks.GetLastFrameStats().m_uiTasksPending, 8);
+
+    // 10 ms left fit some of them, the rest runs in later frames.
+    jobManager.EndFrame(nsTime::MakeFromMilliseconds(10));
+    NS_TEST_BOOL(uiRuns >= 1 && uiRuns <= 5);
+    NS_TEST_INT(idleTasks.GetLastFrameStats().m_uiTasksRun, uiRuns);
+    NS_TEST_INT(idleTasks.GetPendingTaskCount(), 8 - uiRuns);
+
+    for (nsUInt32 uiFrame = 0; uiFrame < 20 && idleTasks.GetPendingTaskCount() > 0; ++uiFrame)
+    {
+      jobManager.EndFrame(nsTime::MakeFromMilliseconds(10));
+    }
+    NS_TEST_INT(uiRuns, 8);
+    NS_TEST_INT(idleTasks.GetPendingTaskCount(), 0);
+
+    jobManager.Shutdown();
+  }
+
+  // V8 can only be initialized once per process, run this block on its own with -filter "JobSystem".
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "GC pauses")
+  {
+    aperture::v8::V8EEngineMain engineMain;
+    NS_TEST_BOOL(engineMain.InitializeV8Engine() == true);
+    engineMain.GetV8EJobManager()->Initialize();
+    engineMain.GetV8EJobManager()->SetPlatform(engineMain.GetV8EEnginePlatform());
+    aperture::v8::jobsystem::V8EPlatform& platform = *engineMain.GetV8EEnginePlatform();
+
+    // No job workers is what the platform did before it had jobs: all GC work on the script thread.
+    const nsUInt32 uiMaxJobWorkers = platform.GetMaxJobWorkers();
+    platform.SetMaxJobWorkers(0);
+    const GCPauseStats serial = RunAllocationScript();
+    platform.SetMaxJobWorkers(uiMaxJobWorkers);
+    const GCPauseStats parallel = RunAllocationScript();
+
+    nsLog::Info("[test]GC pauses without job workers: {0} pauses, {1} ms total, {2} ms longest", serial.m_uiCount, nsArgF(serial.m_Total.GetMilliseconds(), 2), nsArgF(serial.m_Longest.GetMilliseconds(), 2));
+    nsLog::Info("[test]GC pauses with {0} job workers: {1} pauses, {2} ms total, {3} ms longest", uiMaxJobWorkers, parallel.m_uiCount, nsArgF(parallel.m_Total.GetMilliseconds(), 2), nsArgF(parallel.m_Longest.GetMilliseconds(), 2));
+
+    engineMain.ShutdownV8Engine();
+  }
+}
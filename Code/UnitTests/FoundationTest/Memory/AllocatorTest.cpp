@@ -1,8 +1,91 @@
 #include <FoundationTest/FoundationTestPCH.h>
 
 #include <Foundation/Memory/CommonAllocators.h>
+#include <Foundation/Memory/FrameAllocator.h>
 #include <Foundation/Memory/LargeBlockAllocator.h>
 #include <Foundation/Memory/LinearAllocator.h>
+#include <Foundation/Threading/TaskSystem.h>
+#include <Foundation/Threading/Thread.h>
+
+namespace
+{
+  /// Allocates from its frame allocator, idles until it is told to exit and allocates once more right before it exits.
+  class FrameAllocatorTestThread : public nsThread
+  {
+  public:
+    FrameAllocatorTestThread()
+      : nsThread("FrameAllocator Test Thread")
+    {
+    }
+
+    nsAllocator* m_pAllocator = nullptr;
+    nsAtomicInteger32 m_iAllocated;
+    nsAtomicInteger32 m_iExit;
+
+  private:
+    virtual nsUInt32 Run() override
+    {
+      m_pAllocator = nsFrameAllocator::GetCurrentThreadAllocator();
+      NS_NEW(m_pAllocator, nsConstructionCounter);
+      m_iAllocated = 1;
+
+      while (m_iExit == 0)
+      {
+        nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(1));
+      }
+
+      NS_NEW(m_pAllocator, nsConstructionCounter);
+      return 0;
+    }
+  };
+
+  /// Keeps allocating from its frame allocator until it is told to exit and checks that its previous allocation is still intact.
+  class FrameAllocatorSwapTestThread : public nsThread
+  {
+  public:
+    FrameAllocatorSwapTestThread()
+      : nsThread("FrameAllocator Swap Test Thread")
+    {
+    }
+
+    nsAtomicInteger32 m_iIterations;
+    nsAtomicInteger32 m_iCorruptions;
+    nsAtomicInteger32 m_iExit;
+
+  private:
+    virtual nsUInt32 Run() override
+    {
+      nsAllocator* pAllocator = nsFrameAllocator::GetCurrentThreadAllocator();
+      nsUInt32* pPrevious = nullptr;
+
+      for (nsUInt32 i = 0; m_iExit == 0; ++i)
+      {
+        // the previous allocation is at most one frame old, the main thread swaps only once per iteration
+        if (pPrevious != nullptr)
+        {
+          for (nsUInt32 j = 0; j < 64; ++j)
+          {
+            if (pPrevious[j] != i - 1)
+            {
+              m_iCorruptions.Increment();
+              break;
+            }
+          }
+        }
+
+        pPrevious = NS_NEW_RAW_BUFFER(pAllocator, nsUInt32, 64);
+        for (nsUInt32 j = 0; j < 64; ++j)
+        {
+          pPrevious[j] = i;
+        }
+
+        m_iIterations.Increment();
+      }
+
+      return 0;
+    }
+  };
+} // namespace
 
 struct alignas(NS_ALIGNMENT_MINIMUM) NonAlignedVector
 {
@@ -242,4 +325,125 @@ NS_CREATE_SIMPLE_TEST(Memory, Allocator)
 
     NS_TEST_BOOL(nsConstructionCounter::HasDestructed(50));
   }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "FrameAllocator Thread Allocators")
+  {
+    nsAllocator* pAllocator = nsFrameAllocator::GetCurrentThreadAllocator();
+    NS_TEST_BOOL(pAllocator != nullptr);
+    NS_TEST_BOOL(pAllocator == nsFrameAllocator::GetCurrentThreadAllocator());
+    NS_TEST_BOOL(pAllocator != nsFrameAllocator::GetCurrentAllocator());
+
+    NS_NEW(pAllocator, nsConstructionCounter);
+    NS_TEST_BOOL(nsConstructionCounter::HasConstructed(1));
+
+    // memory of this frame survives the next one
+    nsFrameAllocator::Swap();
+    NS_TEST_BOOL(nsFrameAllocator::GetCurrentThreadAllocator() == pAllocator);
+    NS_TEST_BOOL(nsConstructionCounter::HasDestructed(0));
+
+    nsFrameAllocator::Swap();
+    NS_TEST_BOOL(nsConstructionCounter::HasDestructed(1));
+
+    // every worker allocates from its own allocator, the data stays valid for the rest of the frame
+    nsDynamicArray<nsUInt32*> results;
+    results.SetCount(1000);
+    nsAtomicInteger32 iMismatches;
+
+    nsTaskSystem::ParallelForIndexed(0, results.GetCount(), [&](nsUInt32 uiStartIndex, nsUInt32 uiEndIndex)
+      {
+        nsAllocator* pThreadAllocator = nsFrameAllocator::GetCurrentThreadAllocator();
+
+        for (nsUInt32 i = uiStartIndex; i < uiEndIndex; ++i)
+        {
+          if (nsFrameAllocator::GetCurrentThreadAllocator() != pThreadAllocator)
+          {
+            iMismatches.Increment();
+          }
+
+          results[i] = NS_NEW_RAW_BUFFER(pThreadAllocator, nsUInt32, 16);
+          for (nsUInt32 j = 0; j < 16; ++j)
+          {
+            results[i][j] = i * 16 + j;
+          }
+        } });
+
+    NS_TEST_INT(iMismatches, 0);
+
+    bool bAllValid = true;
+    for (nsUInt32 i = 0; i < results.GetCount(); ++i)
+    {
+      for (nsUInt32 j = 0; j < 16; ++j)
+      {
+        bAllValid &= (results[i][j] == i * 16 + j);
+      }
+    }
+    NS_TEST_BOOL(bAllValid);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "FrameAllocator Idle And Exited Threads")
+  {
+    FrameAllocatorTestThread idleThread;
+    idleThread.Start();
+
+    while (idleThread.m_iAllocated == 0)
+    {
+      nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(1));
+    }
+
+    NS_TEST_BOOL(nsConstructionCounter::HasConstructed(1));
+
+    // the memory of a thread that does not allocate anymore is released all the same
+    nsFrameAllocator::Swap();
+    NS_TEST_BOOL(nsConstructionCounter::HasDestructed(0));
+    nsFrameAllocator::Swap();
+    NS_TEST_BOOL(nsConstructionCounter::HasDestructed(1));
+
+    // the next frame may still read the memory of a thread that exits, so its allocator must not be handed out right away
+    idleThread.m_iExit = 1;
+    idleThread.Join();
+
+    FrameAllocatorTestThread nextThread;
+    nextThread.Start();
+
+    while (nextThread.m_iAllocated == 0)
+    {
+      nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(1));
+    }
+
+    NS_TEST_BOOL(nextThread.m_pAllocator != idleThread.m_pAllocator);
+    NS_TEST_BOOL(nsConstructionCounter::HasDone(2, 0));
+
+    nextThread.m_iExit = 1;
+    nextThread.Join();
+
+    nsFrameAllocator::Swap();
+    nsFrameAllocator::Swap();
+    NS_TEST_BOOL(nsConstructionCounter::HasDestructed(3));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "FrameAllocator Allocating Across Swap")
+  {
+    FrameAllocatorSwapTestThread thread;
+    thread.Start();
+
+    // swaps while the thread allocates, but waits for one full iteration in between
+    for (nsUInt32 uiFrame = 0; uiFrame < 200; ++uiFrame)
+    {
+      nsFrameAllocator::Swap();
+
+      const nsInt32 iIterations = thread.m_iIterations;
+      while (thread.m_iIterations < iIterations + 2)
+      {
+        nsThreadUtils::YieldTimeSlice();
+      }
+    }
+
+    thread.m_iExit = 1;
+    thread.Join();
+
+    NS_TEST_INT(thread.m_iCorruptions, 0);
+
+    nsFrameAllocator::Swap();
+    nsFrameAllocator::Swap();
+  }
 }
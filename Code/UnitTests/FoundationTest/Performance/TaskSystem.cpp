@@ -0,0 +1,177 @@
+#include <FoundationTest/FoundationTestPCH.h>
+
+#include <Foundation/Logging/Log.h>
+#include <Foundation/Threading/TaskSystem.h>
+#include <Foundation/Time/Time.h>
+
+namespace
+{
+  enum TaskSystemConstants
+  {
+#if NS_ENABLED(NS_COMPILE_FOR_DEBUG)
+    NUM_TASKS = 1024 * 64,
+    NUM_SPAWNERS = 64,
+#else
+    NUM_TASKS = 1024 * 1024,
+    NUM_SPAWNERS = 1024,
+#endif
+    NUM_INVOCATIONS = NUM_TASKS * 4,
+  };
+
+  class TinyTask final : public nsTask
+  {
+  public:
+    TinyTask(nsAtomicInteger32* pCounter)
+      : m_pCounter(pCounter)
+    {
+    }
+
+  private:
+    virtual void Execute() override { m_pCounter->Increment(); }
+    virtual void ExecuteWithMultiplicity(nsUInt32 uiInvocation) const override { m_pCounter->Add(uiInvocation & 1); }
+
+    nsAtomicInteger32* m_pCounter;
+  };
+
+  /// Starts its share of tiny tasks from inside a worker thread, which puts them into the worker's own queues.
+  class SpawnerTask final : public nsTask
+  {
+  public:
+    SpawnerTask(nsAtomicInteger32* pCounter, nsUInt32 uiNumTasks)
+      : m_pCounter(pCounter)
+      , m_uiNumTasks(uiNumTasks)
+    {
+      ConfigureTask("Spawner", nsTaskNesting::Maybe);
+    }
+
+  private:
+    virtual void Execute() override
+    {
+      const nsTaskGroupID group = nsTaskSystem::CreateTaskGroup(nsTaskPriority::ThisFrame);
+
+      for (nsUInt32 i = 0; i < m_uiNumTasks; ++i)
+      {
+        nsTaskSystem::AddTaskToGroup(group, NS_DEFAULT_NEW(TinyTask, m_pCounter));
+      }
+
+      nsTaskSystem::StartTaskGroup(group);
+      nsTaskSystem::WaitForGroup(group);
+    }
+
+    nsAtomicInteger32* m_pCounter;
+    nsUInt32 m_uiNumTasks;
+  };
+} // namespace
+
+// Enable when needed
+#define NS_PERFORMANCE_TESTS_STATE nsTestBlock::DisabledNoWarning
+
+NS_CREATE_SIMPLE_TEST(Performance, TaskSystem)
+{
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Single Tasks")
+  {
+    nsAtomicInteger32 counter;
+
+    nsTime t0 = nsTime::Now();
+
+    const nsTaskGroupID group = nsTaskSystem::CreateTaskGroup(nsTaskPriority::ThisFrame);
+    for (nsUInt32 i = 0; i < NUM_TASKS; ++i)
+    {
+      nsTaskSystem::AddTaskToGroup(group, NS_DEFAULT_NEW(TinyTask, &counter));
+    }
+
+    nsTaskSystem::StartTaskGroup(group);
+    nsTaskSystem::WaitForGroup(group);
+
+    nsTime t1 = nsTime::Now();
+    NS_TEST_INT(counter, NUM_TASKS);
+    nsLog::Info("[test]Single Tasks {0}ns per task", nsArgF((t1 - t0).GetNanoseconds() / static_cast<double>(NUM_TASKS), 1));
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Spawned From Workers")
+  {
+    nsAtomicInteger32 counter;
+
+    nsTime t0 = nsTime::Now();
+
+    const nsTaskGroupID group = nsTaskSystem::CreateTaskGroup(nsTaskPriority::ThisFrame);
+    for (nsUInt32 i = 0; i < NUM_SPAWNERS; ++i)
+    {
+      nsTaskSystem::AddTaskToGroup(group, NS_DEFAULT_NEW(SpawnerTask, &counter, NUM_TASKS / NUM_SPAWNERS));
+    }
+
+    nsTaskSystem::StartTaskGroup(group);
+    nsTaskSystem::WaitForGroup(group);
+
+    nsTime t1 = nsTime::Now();
+    NS_TEST_INT(counter, NUM_TASKS);
+    nsLog::Info("[test]Spawned From Workers {0}ns per task", nsArgF((t1 - t0).GetNanoseconds() / static_cast<double>(NUM_TASKS), 1));
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Multiplicity")
+  {
+    nsAtomicInteger32 counter;
+
+    nsSharedPtr<nsTask> pTask = NS_DEFAULT_NEW(TinyTask, &counter);
+    pTask->SetMultiplicity(NUM_INVOCATIONS);
+
+    nsTime t0 = nsTime::Now();
+
+    nsTaskSystem::WaitForGroup(nsTaskSystem::StartSingleTask(pTask, nsTaskPriority::ThisFrame));
+
+    nsTime t1 = nsTime::Now();
+    NS_TEST_INT(counter, NUM_INVOCATIONS / 2);
+    nsLog::Info("[test]Multiplicity {0}ns per invocation", nsArgF((t1 - t0).GetNanoseconds() / static_cast<double>(NUM_INVOCATIONS), 1));
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Light Tasks")
+  {
+    nsAtomicInteger32 counter;
+
+    nsTime t0 = nsTime::Now();
+
+    for (nsUInt32 i = 0; i < NUM_TASKS; ++i)
+    {
+      nsTaskSystem::StartLightTask([&counter]()
+        { counter.Increment(); });
+    }
+
+    nsTaskSystem::WaitForCondition([&counter]()
+      { return counter == NUM_TASKS; });
+
+    nsTime t1 = nsTime::Now();
+    NS_TEST_INT(counter, NUM_TASKS);
+    nsLog::Info("[test]Light Tasks {0}ns per task", nsArgF((t1 - t0).GetNanoseconds() / static_cast<double>(NUM_TASKS), 1));
+  }
+
+  NS_TEST_BLOCK(NS_PERFORMANCE_TESTS_STATE, "Light Task Continuations")
+  {
+    nsAtomicInteger32 counter;
+    nsDynamicArray<nsLightTaskHandle> chains;
+
+    nsTime t0 = nsTime::Now();
+
+    for (nsUInt32 chain = 0; chain < NUM_SPAWNERS; ++chain)
+    {
+      nsLightTaskHandle hTask = nsTaskSystem::StartLightTask([&counter]()
+        { counter.Increment(); });
+
+      for (nsUInt32 i = 1; i < NUM_TASKS / NUM_SPAWNERS; ++i)
+      {
+        hTask = hTask.Then([&counter]()
+          { counter.Increment(); });
+      }
+
+      chains.PushBack(hTask);
+    }
+
+    for (nsLightTaskHandle hTask : chains)
+    {
+      nsTaskSystem::WaitForLightTask(hTask);
+    }
+
+    nsTime t1 = nsTime::Now();
+    NS_TEST_INT(counter, NUM_TASKS);
+    nsLog::Info("[test]Light Task Continuations {0}ns per task", nsArgF((t1 - t0).GetNanoseconds() / static_cast<double>(NUM_TASKS), 1));
+  }
+}
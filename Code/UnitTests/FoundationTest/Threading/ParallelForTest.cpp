@@ -76,6 +76,142 @@ NS_CREATE_SIMPLE_TEST(Threading, ParallelFor)
     NS_TEST_INT(uiNumbersSum, uiNumbersCheckSum);
   }
 
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Parallel For (Indexed, Adaptive)")
+  {
+    constexpr nsUInt32 uiStartIndex = 100;
+    constexpr nsUInt32 uiNumItems = 20000;
+
+    nsParallelForAdaptiveGrainSize grainSize;
+
+    nsParallelForParams adaptiveParams;
+    adaptiveParams.m_pAdaptiveGrainSize = &grainSize;
+    adaptiveParams.m_AdaptiveChunkDuration = nsTime::MakeFromMicroseconds(20);
+
+    nsDynamicArray<nsUInt32> visits;
+    visits.SetCount(uiStartIndex + uiNumItems);
+
+    nsDynamicArray<nsUInt32> hashes;
+    hashes.SetCount(uiStartIndex + uiNumItems);
+
+    // the second run starts out with the cost measured by the first one
+    for (nsUInt32 uiRun = 1; uiRun <= 2; ++uiRun)
+    {
+      nsTaskSystem::ParallelForIndexed(
+        uiStartIndex, uiNumItems,
+        [&visits, &hashes](nsUInt32 uiChunkStartIndex, nsUInt32 uiChunkEndIndex)
+        {
+          for (nsUInt32 uiIndex = uiChunkStartIndex; uiIndex < uiChunkEndIndex; ++uiIndex)
+          {
+            // chunks never overlap, so every item is only touched by a single thread
+            ++visits[uiIndex];
+
+            // give each item some work, so that there is something to measure
+            nsUInt32 uiHash = hashes[uiIndex];
+            for (nsUInt32 i = 0; i < 100; ++i)
+            {
+              uiHash = uiHash * 31 + i;
+            }
+            hashes[uiIndex] = uiHash;
+          }
+        },
+        "ParallelForIndexed Adaptive Test", nsTaskNesting::Never, adaptiveParams);
+
+      nsUInt32 uiNumWrongVisits = 0;
+      for (nsUInt32 i = 0; i < visits.GetCount(); ++i)
+      {
+        uiNumWrongVisits += (visits[i] != (i < uiStartIndex ? 0 : uiRun)) ? 1 : 0;
+      }
+
+      NS_TEST_INT(uiNumWrongVisits, 0);
+      NS_TEST_BOOL(grainSize.m_iPicosecondsPerItem > 0);
+    }
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Parallel For (Indexed, Adaptive, Skewed Costs)")
+  {
+    constexpr nsUInt32 uiNumItems = 20000;
+    constexpr nsUInt32 uiFirstExpensiveItem = 18000;
+
+    nsParallelForAdaptiveGrainSize grainSize;
+
+    nsParallelForParams adaptiveParams;
+    adaptiveParams.m_pAdaptiveGrainSize = &grainSize;
+    adaptiveParams.m_AdaptiveChunkDuration = nsTime::MakeFromMicroseconds(100);
+
+    nsDynamicArray<nsUInt32> hashes;
+    hashes.SetCount(uiNumItems);
+
+    // the chunks that were handed to the callback, as [start, end) pairs
+    nsDynamicArray<nsUInt32> chunks;
+
+    auto RunItems = [&](bool bSkewed)
+    {
+      chunks.Clear();
+
+      nsTaskSystem::ParallelForIndexed(
+        0, uiNumItems,
+        [&](nsUInt32 uiChunkStartIndex, nsUInt32 uiChunkEndIndex)
+        {
+          for (nsUInt32 uiIndex = uiChunkStartIndex; uiIndex < uiChunkEndIndex; ++uiIndex)
+          {
+            nsUInt32 uiHash = hashes[uiIndex];
+            for (nsUInt32 i = 0; i < 100; ++i)
+            {
+              uiHash = uiHash * 31 + i;
+            }
+            hashes[uiIndex] = uiHash;
+
+            if (bSkewed && uiIndex >= uiFirstExpensiveItem)
+            {
+              const nsTime start = nsTime::Now();
+              while (nsTime::Now() - start < nsTime::MakeFromMicroseconds(10))
+              {
+              }
+            }
+          }
+
+          NS_LOCK(dataAccessMutex);
+          chunks.PushBack(uiChunkStartIndex);
+          chunks.PushBack(uiChunkEndIndex);
+        },
+        "ParallelForIndexed Adaptive Skewed Test", nsTaskNesting::Never, adaptiveParams);
+    };
+
+    // calibrate with cheap items only, the chunks grow from the bin size to many items each
+    RunItems(false);
+
+    const nsInt64 iCheapPicosecondsPerItem = grainSize.m_iPicosecondsPerItem;
+    NS_TEST_BOOL(iCheapPicosecondsPerItem > 0);
+
+    // the grain size that the cheap items alone lead to
+    const nsInt64 iTargetChunkPicoseconds = static_cast<nsInt64>(adaptiveParams.m_AdaptiveChunkDuration.GetNanoseconds() * 1000.0);
+    const nsUInt32 uiCalibratedGrainSize = static_cast<nsUInt32>(nsMath::Max<nsInt64>(1, iTargetChunkPicoseconds / nsMath::Max<nsInt64>(1, iCheapPicosecondsPerItem)));
+    NS_TEST_BOOL(uiCalibratedGrainSize > 1);
+
+    nsUInt32 uiLargestCheapChunk = 0;
+    for (nsUInt32 i = 0; i < chunks.GetCount(); i += 2)
+    {
+      uiLargestCheapChunk = nsMath::Max(uiLargestCheapChunk, chunks[i + 1] - chunks[i]);
+    }
+    NS_TEST_BOOL(uiLargestCheapChunk > 1);
+
+    // the expensive items cost about a hundred times more, the chunks that cover them have to be much smaller
+    RunItems(true);
+
+    nsUInt32 uiNumExpensiveChunks = 0;
+    for (nsUInt32 i = 0; i < chunks.GetCount(); i += 2)
+    {
+      uiNumExpensiveChunks += (chunks[i] >= uiFirstExpensiveItem) ? 1 : 0;
+    }
+
+    // with the calibrated grain size, the expensive items would have been handed out in only a few chunks of 10 ms and more
+    const nsUInt32 uiNumExpensiveItems = uiNumItems - uiFirstExpensiveItem;
+    const nsUInt32 uiNumCalibratedChunks = (uiNumExpensiveItems + uiCalibratedGrainSize - 1) / uiCalibratedGrainSize;
+
+    NS_TEST_BOOL(uiNumExpensiveChunks >= 4 * uiNumCalibratedChunks);
+    NS_TEST_BOOL(uiNumExpensiveItems / nsMath::Max(1u, uiNumExpensiveChunks) * 4 <= uiCalibratedGrainSize);
+  }
+
   NS_TEST_BLOCK(nsTestBlock::Enabled, "Parallel For (Array)")
   {
     // reset
@@ -0,0 +1,144 @@
+#include <FoundationTest/FoundationTestPCH.h>
+
+#include <Foundation/Threading/TaskGraph.h>
+#include <Foundation/Threading/ThreadUtils.h>
+#include <Foundation/Utilities/DGMLWriter.h>
+#include <TestFramework/Utilities/TestLogInterface.h>
+
+NS_CREATE_SIMPLE_TEST(Threading, TaskGraph)
+{
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Dependencies")
+  {
+    // A -> B, A -> C, B + C -> D
+    nsAtomicInteger32 order;
+    nsInt32 iOrderA = -1, iOrderB = -1, iOrderC = -1, iOrderD = -1;
+
+    nsTaskGraph graph("Diamond");
+    const nsUInt32 a = graph.AddNode("A", [&]()
+      { iOrderA = order.Increment(); });
+    const nsUInt32 b = graph.AddNode("B", [&]()
+      { iOrderB = order.Increment(); });
+    const nsUInt32 c = graph.AddNode("C", [&]()
+      { iOrderC = order.Increment(); });
+    const nsUInt32 d = graph.AddNode("D", [&]()
+      { iOrderD = order.Increment(); });
+
+    graph.AddDependency(b, a);
+    graph.AddDependency(c, a);
+    graph.AddDependency(d, b);
+    graph.AddDependency(d, c);
+    graph.AddDependency(d, c);
+
+    NS_TEST_INT(graph.GetNodeCount(), 4);
+    NS_TEST_BOOL(graph.Finalize().Succeeded());
+    NS_TEST_BOOL(graph.IsFinished());
+
+    graph.Launch();
+    graph.WaitForFinish();
+
+    NS_TEST_BOOL(graph.IsFinished());
+    NS_TEST_INT(order, 4);
+    NS_TEST_INT(iOrderA, 1);
+    NS_TEST_BOOL(iOrderB > iOrderA);
+    NS_TEST_BOOL(iOrderC > iOrderA);
+    NS_TEST_INT(iOrderD, 4);
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Relaunch")
+  {
+    // a wide fan-in, launched repeatedly like a per-frame workload
+    nsAtomicInteger32 counter;
+    nsInt32 iSumAtEnd = 0;
+    nsUInt32 uiFrame = 0;
+
+    nsTaskGraph graph("Frame");
+    const nsUInt32 end = graph.AddNode("End", [&]()
+      { iSumAtEnd = counter; });
+
+    for (nsUInt32 i = 0; i < 64; ++i)
+    {
+      const nsUInt32 node = graph.AddNode("Work", [&]()
+        { counter.Add(uiFrame); });
+      graph.AddDependency(end, node);
+    }
+
+    NS_TEST_BOOL(graph.Finalize().Succeeded());
+
+    for (uiFrame = 1; uiFrame <= 20; ++uiFrame)
+    {
+      counter = 0;
+
+      graph.Launch();
+      graph.WaitForFinish();
+
+      NS_TEST_INT(iSumAtEnd, 64 * uiFrame);
+    }
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Cycle")
+  {
+    nsTaskGraph graph("Cycle");
+    const nsUInt32 a = graph.AddNode("A", []() {});
+    const nsUInt32 b = graph.AddNode("B", []() {});
+    const nsUInt32 c = graph.AddNode("C", []() {});
+
+    graph.AddDependency(b, a);
+    graph.AddDependency(c, b);
+    NS_TEST_BOOL(graph.Finalize().Succeeded());
+
+    graph.AddDependency(b, c);
+
+    nsTestLogInterface log;
+    nsTestLogSystemScope logSystemScope(&log);
+    log.ExpectMessage("is part of a dependency cycle", nsLogMsgType::ErrorMsg);
+
+    NS_TEST_BOOL(graph.Finalize().Failed());
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Critical Path")
+  {
+    // A -> Slow -> End, A -> Fast -> End
+    nsTaskGraph graph("Critical Path");
+    const nsUInt32 a = graph.AddNode("A", []() {});
+    const nsUInt32 slow = graph.AddNode("Slow", []()
+      { nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(20)); });
+    const nsUInt32 fast = graph.AddNode("Fast", []() {});
+    const nsUInt32 end = graph.AddNode("End", []() {});
+
+    graph.AddDependency(slow, a);
+    graph.AddDependency(fast, a);
+    graph.AddDependency(end, slow);
+    graph.AddDependency(end, fast);
+
+    NS_TEST_BOOL(graph.Finalize().Succeeded());
+
+    graph.Launch();
+    graph.WaitForFinish();
+
+    NS_TEST_BOOL(graph.GetNodeDuration(slow) >= nsTime::MakeFromMilliseconds(15));
+
+    nsDynamicArray<nsUInt32> path;
+    const nsTime duration = graph.GetCriticalPath(path);
+
+    NS_TEST_BOOL(duration >= graph.GetNodeDuration(slow));
+    NS_TEST_INT(path.GetCount(), 3);
+    if (path.GetCount() == 3)
+    {
+      NS_TEST_INT(path[0], a);
+      NS_TEST_INT(path[1], slow);
+      NS_TEST_INT(path[2], end);
+    }
+
+    // the snapshot of the task system includes all task graphs that have nodes
+    nsTaskGraph emptyGraph("Empty Graph");
+
+    nsDGMLGraph dgml;
+    nsTaskSystem::WriteStateSnapshotToDGML(dgml);
+
+    nsStringBuilder sDgml;
+    NS_TEST_BOOL(nsDGMLGraphWriter::WriteGraphToString(sDgml, dgml).Succeeded());
+    NS_TEST_BOOL(sDgml.FindSubString("Critical Path (critical path") != nullptr);
+    NS_TEST_BOOL(sDgml.FindSubString("CriticalPath=\"true\"") != nullptr);
+    NS_TEST_BOOL(sDgml.FindSubString("Empty Graph") == nullptr);
+  }
+}
@@ -2,6 +2,7 @@
 
 #include <Foundation/IO/FileSystem/DataDirTypeFolder.h>
 #include <Foundation/IO/FileSystem/FileWriter.h>
+#include <Foundation/Threading/DelegateTask.h>
 #include <Foundation/Threading/TaskSystem.h>
 #include <Foundation/Time/Time.h>
 #include <Foundation/Utilities/DGMLWriter.h>
@@ -374,6 +375,65 @@ NS_CREATE_SIMPLE_TEST(Threading, TaskSystem)
     }
   }
 
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Own Queue Order")
+  {
+    // only the main thread works on these, so all of them are taken from its own deque, in the order they were queued
+    for (nsTaskPriority::Enum priority : {nsTaskPriority::ThisFrameMainThread, nsTaskPriority::SomeFrameMainThread})
+    {
+      nsHybridArray<nsUInt32, 8> order;
+
+      for (nsUInt32 i = 0; i < 8; ++i)
+      {
+        nsSharedPtr<nsTask> pTask = NS_DEFAULT_NEW(nsDelegateTask<void>, "Order", nsTaskNesting::Never, [&order, i]()
+          { order.PushBack(i); });
+        nsTaskSystem::StartSingleTask(pTask, priority);
+      }
+
+      // 'SomeFrameMainThread' tasks may be spread over several frames
+      for (nsUInt32 uiFrame = 0; uiFrame < 1000 && order.GetCount() < 8; ++uiFrame)
+      {
+        nsTaskSystem::FinishFrameTasks();
+      }
+
+      NS_TEST_INT(order.GetCount(), 8);
+      for (nsUInt32 i = 0; i < order.GetCount(); ++i)
+      {
+        NS_TEST_INT(order[i], i);
+      }
+    }
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Unblocked Groups First")
+  {
+    nsHybridArray<nsUInt32, 8> order;
+
+    for (nsUInt32 i = 0; i < 4; ++i)
+    {
+      nsSharedPtr<nsTask> pTask = NS_DEFAULT_NEW(nsDelegateTask<void>, "Queued", nsTaskNesting::Never, [&order, i]()
+        { order.PushBack(i); });
+      nsTaskSystem::StartSingleTask(pTask, nsTaskPriority::ThisFrameMainThread);
+    }
+
+    nsSharedPtr<nsTestTask> pDependency = NS_DEFAULT_NEW(nsTestTask);
+    pDependency->m_uiIterations = 5;
+    const nsTaskGroupID dependency = nsTaskSystem::StartSingleTask(pDependency, nsTaskPriority::ThisFrame);
+
+    nsSharedPtr<nsTask> pUnblocked = NS_DEFAULT_NEW(nsDelegateTask<void>, "Unblocked", nsTaskNesting::Never, [&order]()
+      { order.PushBack(100); });
+    nsTaskSystem::StartSingleTask(pUnblocked, nsTaskPriority::ThisFrameMainThread, dependency);
+
+    // the dependency finishes on a worker thread, which queues the unblocked task behind the ones the main thread queued before
+    while (!nsTaskSystem::IsTaskGroupFinished(dependency))
+    {
+      nsThreadUtils::Sleep(nsTime::MakeFromMilliseconds(1));
+    }
+
+    nsTaskSystem::FinishFrameTasks();
+
+    NS_TEST_INT(order.GetCount(), 5);
+    NS_TEST_INT(order[0], 100);
+  }
+
   NS_TEST_BLOCK(nsTestBlock::Enabled, "Canceling Tasks")
   {
     const nsUInt32 uiNumTasks = 20;
@@ -550,6 +610,85 @@ NS_CREATE_SIMPLE_TEST(Threading, TaskSystem)
     NS_TEST_BOOL(t[2]->IsMultiplicityDone());
   }
 
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Light Tasks")
+  {
+    nsAtomicInteger32 iCounter;
+
+    nsDynamicArray<nsLightTaskHandle> tasks;
+    for (nsUInt32 i = 0; i < 1000; ++i)
+    {
+      tasks.PushBack(nsTaskSystem::StartLightTask([&iCounter]()
+        { iCounter.Increment(); }));
+    }
+
+    for (nsLightTaskHandle hTask : tasks)
+    {
+      nsTaskSystem::WaitForLightTask(hTask);
+      NS_TEST_BOOL(nsTaskSystem::IsLightTaskFinished(hTask));
+    }
+
+    NS_TEST_INT(iCounter, 1000);
+
+    // the pool recycles the finished tasks, the old handles must not be affected by that
+    nsLightTaskHandle hReused = nsTaskSystem::StartLightTask([&iCounter]()
+      { iCounter.Increment(); });
+    nsTaskSystem::WaitForLightTask(hReused);
+
+    for (nsLightTaskHandle hTask : tasks)
+    {
+      NS_TEST_BOOL(hTask == hReused || nsTaskSystem::IsLightTaskFinished(hTask));
+    }
+
+    NS_TEST_INT(iCounter, 1001);
+    NS_TEST_BOOL(nsTaskSystem::IsLightTaskFinished(nsLightTaskHandle()));
+  }
+
+  NS_TEST_BLOCK(nsTestBlock::Enabled, "Light Task Continuations")
+  {
+    nsAtomicInteger32 iStep;
+    nsAtomicInteger32 iWrongOrder;
+
+    // a chain, every task has to see its predecessor's step
+    nsLightTaskHandle hTask = nsTaskSystem::StartLightTask([&]()
+      { iWrongOrder.Add(iStep.CompareAndSwap(0, 1) == 0 ? 0 : 1); });
+
+    for (nsInt32 i = 1; i < 100; ++i)
+    {
+      hTask = hTask.Then([&, i]()
+        { iWrongOrder.Add(iStep.CompareAndSwap(i, i + 1) == i ? 0 : 1); });
+    }
+
+    nsTaskSystem::WaitForLightTask(hTask);
+    NS_TEST_INT(iStep, 100);
+    NS_TEST_INT(iWrongOrder, 0);
+
+    // many continuations of one task, added while it may already be running
+    nsAtomicInteger32 iContinuations;
+    nsLightTaskHandle hRoot = nsTaskSystem::StartLightTask([&iStep]()
+      { iStep.Increment(); });
+
+    nsDynamicArray<nsLightTaskHandle> continuations;
+    for (nsUInt32 i = 0; i < 50; ++i)
+    {
+      continuations.PushBack(hRoot.Then([&]()
+        { iWrongOrder.Add(iStep == 101 ? 0 : 1);
+          iContinuations.Increment(); }));
+    }
+
+    for (nsLightTaskHandle hContinuation : continuations)
+    {
+      nsTaskSystem::WaitForLightTask(hContinuation);
+    }
+
+    NS_TEST_INT(iContinuations, 50);
+    NS_TEST_INT(iWrongOrder, 0);
+
+    // continuations of finished tasks start right away
+    nsTaskSystem::WaitForLightTask(hRoot.Then([&iContinuations]()
+      { iContinuations.Increment(); }));
+    NS_TEST_INT(iContinuations, 51);
+  }
+
   // capture profiling info for testing
   /*nsStringBuilder sOutputPath = nsTestFramework::GetInstance()->GetAbsOutputPath();
 